@@ -1,4 +1,5 @@
 #include "network_tools.h" 
+#include "network_modules.h"
 #include <windows.h>
 #include <commctrl.h>
 #include <stdio.h>
@@ -36,6 +37,31 @@
 
 // IP归属地复选框
 #define ID_CHECK_LOCATION   118
+// [新增] UDP 扫描模式复选框
+#define ID_CHECK_UDP        119
+// [新增] 服务识别复选框
+#define ID_CHECK_SERVICE    123
+// [新增] 扫描速率与网段并发上限
+#define ID_EDIT_PPS         124
+#define ID_EDIT_SUBNET_CAP  125
+// [新增] 自适应超时下限
+#define ID_EDIT_MIN_TIMEOUT 126
+// [新增] 多机分片与结果合并
+#define ID_EDIT_SHARD       127
+#define ID_BTN_MERGE        128
+#define ID_BTN_PROXY_TEST   130
+#define ID_EDIT_TCPING_PORT 131
+#define ID_CHECK_MONITOR    132
+#define ID_EDIT_MONITOR_SEC 133
+#define ID_BTN_TRACE        134
+// [新增] 存活主机探测复选框
+#define ID_CHECK_DISCOVERY  129
+// [新增] 探测源地址 (多个本机地址或网卡名)
+#define ID_EDIT_SOURCE      135
+// [新增] 增量扫描复选框
+#define ID_CHECK_DELTA      136
+// [新增] 代理检测经代理访问的测试目标 (主机[:端口])
+#define ID_EDIT_PROXY_TARGET 137
 
 // 右键菜单 ID
 #define IDM_COPY            201
@@ -43,6 +69,17 @@
 #define IDM_DEL_OFFLINE     203
 #define IDM_DEL_SELECTED    204 
 #define IDM_REMOVE_DUPLICATE 205 // [新增] 去重菜单ID
+#define IDM_DUMP_METRICS    206 // [新增] 导出运行指标
+
+// [新增] 状态栏第二栏按固定频率采样运行指标，逐探测不再单独刷新界面
+#define ID_TIMER_METRICS    301
+#define METRICS_REFRESH_MS  250
+#define METRICS_PANE_WIDTH  600
+#define METRICS_DUMP_FILE   L"netools_metrics.jsonl"
+
+// [新增] 结果边到达边追加到日志，导出与复制从日志流式读取；崩溃后可用 netools_cli export 找回
+#define RESULT_LOG_FILE     L"netools_results.dat"
+#define EXPORT_BUF_SIZE     (1024 * 1024)
 
 HINSTANCE hInst;
 HWND hMainWnd, hList, hStatus;
@@ -56,6 +93,12 @@ TaskType g_currentTask = 0;
 int g_sortColumn = -1;      
 BOOL g_sortAscending = TRUE; 
 
+int g_taskRunning = 0;
+MetricsSnapshot g_lastSample;   // 上一次采样，用于计算速率
+
+ResultLog* g_resultLog = NULL;
+unsigned int g_nextRowId = 0;   // 本任务的行号，即插入顺序；删除行后也不复用
+
 LRESULT CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);
 
 void EnableDPIAwareness() {
@@ -90,28 +133,54 @@ wchar_t* get_alloc_text(HWND hwnd) {
     return buf;
 }
 
-void add_list_row(const wchar_t* pipedData) {
-    wchar_t* copy = _wcsdup(pipedData);
+// [新增] 文本框内容转为 UTF-8，供按字节扫描的提取模块使用
+char* get_alloc_text_utf8(HWND hwnd) {
+    wchar_t* text = get_alloc_text(hwnd);
+    if (!text) return NULL;
+    int len = WideCharToMultiByte(CP_UTF8, 0, text, -1, NULL, 0, NULL, NULL);
+    char* utf8 = len > 0 ? (char*)malloc(len) : NULL;
+    if (utf8) WideCharToMultiByte(CP_UTF8, 0, text, -1, utf8, len, NULL, NULL);
+    free(text);
+    return utf8;
+}
+
+// 整个文件读入内存并补结尾 0，失败返回 NULL
+char* read_file_bytes(const wchar_t* path) {
+    FILE* f;
+    if (_wfopen_s(&f, path, L"rb") != 0) return NULL;
+    fseek(f, 0, SEEK_END);
+    long sz = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char* buffer = sz >= 0 ? (char*)malloc(sz + 1) : NULL;
+    if (buffer) buffer[fread(buffer, 1, sz, f)] = 0;
+    fclose(f);
+    return buffer;
+}
+
+// 消息文本归界面所有，直接原地切分
+void add_list_row(wchar_t* pipedData) {
     wchar_t* ctx;
-    wchar_t* token = wcstok_s(copy, L"|", &ctx);
+    wchar_t* token = wcstok_s(pipedData, L"|", &ctx);
+    const wchar_t* fields[RESLOG_MAX_FIELDS];
+    int count = 0;
+    fields[count++] = token ? token : L"";
     
     LVITEMW lvItem = {0};
-    lvItem.mask = LVIF_TEXT;
+    lvItem.mask = LVIF_TEXT | LVIF_PARAM;
     lvItem.iItem = ListView_GetItemCount(hList);
     lvItem.iSubItem = 0;
     lvItem.pszText = token ? token : L"";
+    lvItem.lParam = g_nextRowId; // 插入顺序，排序后仍可据此找回原行
     
     ListView_InsertItem(hList, &lvItem);
     
     int col = 1;
     while ((token = wcstok_s(NULL, L"|", &ctx))) {
-        if (wcscmp(token, L"-") == 0) {
-            ListView_SetItemText(hList, lvItem.iItem, col++, L"");
-        } else {
-            ListView_SetItemText(hList, lvItem.iItem, col++, token);
-        }
+        if (wcscmp(token, L"-") == 0) token = L"";
+        ListView_SetItemText(hList, lvItem.iItem, col++, token);
+        if (count < RESLOG_MAX_FIELDS) fields[count++] = token;
     }
-    free(copy);
+    reslog_append(g_resultLog, RESLOG_ROW, g_nextRowId++, fields, count);
 }
 
 // 列表排序比较回调函数
@@ -132,6 +201,12 @@ int CALLBACK CompareListViewItems(LPARAM lParam1, LPARAM lParam2, LPARAM lParamS
     else if ((g_currentTask == TASK_SCAN || g_currentTask == TASK_SINGLE_SCAN) && col == 1) {
         isNumeric = 1;
     }
+    else if (g_currentTask == TASK_TRACE && (col == 1 || col == 3)) {
+        isNumeric = 1;
+    }
+    else if (g_currentTask == TASK_PROXY_TEST && col >= 1) {
+        isNumeric = (col != 2);
+    }
 
     // IP归属地列（文本）将自动进入 else 分支使用 wcscmp 进行字典序排序，因此无需额外修改即可支持排序
     if (isNumeric) {
@@ -148,6 +223,15 @@ int CALLBACK CompareListViewItems(LPARAM lParam1, LPARAM lParam2, LPARAM lParamS
                  if (v1 > v2) result = 1;
                  else if (v1 < v2) result = -1;
              }
+        } else if (g_currentTask == TASK_PROXY_TEST && col >= 3) {
+            // 不可用代理 (空白) 始终排在最后
+            int isInvalid1 = (wcslen(buf1) == 0);
+            int isInvalid2 = (wcslen(buf2) == 0);
+            if (isInvalid1 != isInvalid2) return isInvalid1 ? 1 : -1;
+            int v1 = _wtoi(buf1);
+            int v2 = _wtoi(buf2);
+            if (v1 > v2) result = 1;
+            else if (v1 < v2) result = -1;
         } else {
             int p1 = _wtoi(buf1);
             int p2 = _wtoi(buf2);
@@ -160,40 +244,68 @@ int CALLBACK CompareListViewItems(LPARAM lParam1, LPARAM lParam2, LPARAM lParamS
     return g_sortAscending ? result : -result;
 }
 
+// [新增] 列表中的行按显示顺序写出：优先取结果日志，日志不可用或缺行时逐格读取列表
+int write_list_rows(RowWriter* w, const ResultLogView* view, int selectedOnly) {
+    HWND hHeader = ListView_GetHeader(hList);
+    int cols = Header_GetItemCount(hHeader);
+    char keys[RESLOG_MAX_FIELDS][64];
+    wchar_t cell[1024];
+    for (int j = 0; j < cols && j < RESLOG_MAX_FIELDS; j++) {
+        HDITEMW hdi = { HDI_TEXT, 0, cell, NULL, 1023, 0 };
+        cell[0] = 0;
+        Header_GetItem(hHeader, j, &hdi);
+        keys[j][wide_to_utf8(cell, keys[j], 63)] = 0;
+    }
+    if (cols > RESLOG_MAX_FIELDS) cols = RESLOG_MAX_FIELDS;
+
+    int rows = 0, item = -1;
+    while ((item = ListView_GetNextItem(hList, item, selectedOnly ? LVNI_SELECTED : LVNI_ALL)) != -1) {
+        LVITEMW lvItem = {0};
+        lvItem.mask = LVIF_PARAM;
+        lvItem.iItem = item;
+        ListView_GetItem(hList, &lvItem);
+        rows++;
+        if (view && reslog_write_row(view, w, (unsigned int)lvItem.lParam)) continue;
+        for (int j = 0; j < cols; j++) {
+            cell[0] = 0;
+            ListView_GetItemText(hList, item, j, cell, 1024);
+            writer_wstr(w, keys[j], cell);
+        }
+        writer_end_row(w);
+    }
+    return rows;
+}
+
+ResultLogView* load_result_log() {
+    if (!g_resultLog) return NULL;
+    reslog_flush(g_resultLog);
+    return reslog_load(RESULT_LOG_FILE);
+}
+
+// [修改] 选中行写成制表符分隔的 UTF-8 文本，一次转换后放入剪贴板
 void CopyListViewSelection() {
-    int count = ListView_GetSelectedCount(hList);
-    if (count == 0) return;
-    int bufSize = count * 256; 
-    wchar_t* buffer = (wchar_t*)malloc(bufSize * sizeof(wchar_t));
-    buffer[0] = 0;
-    int item = -1;
-    while ((item = ListView_GetNextItem(hList, item, LVNI_SELECTED)) != -1) {
-        wchar_t line[1024] = {0};
-        wchar_t cell[256];
-        HWND hHeader = ListView_GetHeader(hList);
-        int cols = Header_GetItemCount(hHeader);
-        for (int i = 0; i < cols; i++) {
-            ListView_GetItemText(hList, item, i, cell, 256);
-            wcscat_s(line, 1024, cell);
-            if (i < cols - 1) wcscat_s(line, 1024, L"\t");
-        }
-        wcscat_s(line, 1024, L"\r\n");
-        if (wcslen(buffer) + wcslen(line) >= bufSize) {
-            bufSize *= 2;
-            buffer = (wchar_t*)realloc(buffer, bufSize * sizeof(wchar_t));
-        }
-        wcscat_s(buffer, bufSize, line);
-    }
-    if (OpenClipboard(hMainWnd)) {
-        EmptyClipboard();
-        size_t size = (wcslen(buffer) + 1) * sizeof(wchar_t);
-        HGLOBAL hGlob = GlobalAlloc(GMEM_MOVEABLE, size);
-        memcpy(GlobalLock(hGlob), buffer, size);
+    if (ListView_GetSelectedCount(hList) == 0) return;
+    RowWriter w;
+    if (!writer_init(&w, NULL, OUTPUT_TSV, 65536)) return;
+    ResultLogView* view = load_result_log();
+    write_list_rows(&w, view, 1);
+    reslog_view_free(view);
+
+    int wlen = w.failed ? 0 : MultiByteToWideChar(CP_UTF8, 0, w.buf, (int)w.len, NULL, 0);
+    HGLOBAL hGlob = wlen > 0 ? GlobalAlloc(GMEM_MOVEABLE, (wlen + 1) * sizeof(wchar_t)) : NULL;
+    if (hGlob) {
+        wchar_t* text = (wchar_t*)GlobalLock(hGlob);
+        MultiByteToWideChar(CP_UTF8, 0, w.buf, (int)w.len, text, wlen);
+        text[wlen] = 0;
         GlobalUnlock(hGlob);
-        SetClipboardData(CF_UNICODETEXT, hGlob);
-        CloseClipboard();
+        if (OpenClipboard(hMainWnd)) {
+            EmptyClipboard();
+            if (SetClipboardData(CF_UNICODETEXT, hGlob)) hGlob = NULL;
+            CloseClipboard();
+        }
+        if (hGlob) GlobalFree(hGlob);
     }
-    free(buffer);
+    writer_free(&w);
 }
 
 void DeleteOfflineItems() {
@@ -271,43 +383,225 @@ void RemoveDuplicateItems() {
     MessageBoxW(hMainWnd, msg, L"完成", MB_OK);
 }
 
-void export_csv() {
+// [修改] 导出为 CSV (带引号转义) 或 NDJSON，经 1 MB 缓冲整块写出
+void export_results() {
     wchar_t path[MAX_PATH] = {0};
     OPENFILENAMEW ofn = {0};
     ofn.lStructSize = sizeof(ofn);
     ofn.hwndOwner = hMainWnd;
-    ofn.lpstrFilter = L"CSV Files (*.csv)\0*.csv\0All Files\0*.*\0";
+    ofn.lpstrFilter = L"CSV Files (*.csv)\0*.csv\0NDJSON Files (*.ndjson)\0*.ndjson\0All Files\0*.*\0";
     ofn.lpstrFile = path;
     ofn.nMaxFile = MAX_PATH;
+    ofn.lpstrDefExt = L"csv";
     ofn.Flags = OFN_OVERWRITEPROMPT;
     
-    if (GetSaveFileNameW(&ofn)) {
-        FILE* fp;
-        if (_wfopen_s(&fp, path, L"w, ccs=UTF-8") == 0) { 
-            int rowCount = ListView_GetItemCount(hList);
-            HWND hHeader = ListView_GetHeader(hList);
-            int colCount = Header_GetItemCount(hHeader);
-            wchar_t buf[256];
-            for (int j = 0; j < colCount; j++) {
-                HDITEMW hdi = { HDI_TEXT, 0, buf, NULL, 255, 0 };
-                Header_GetItem(hHeader, j, &hdi);
-                fwprintf(fp, L"%s%s", j == 0 ? L"" : L",", buf);
-            }
-            fwprintf(fp, L"\n");
-            for (int i = 0; i < rowCount; i++) {
-                for (int j = 0; j < colCount; j++) {
-                    ListView_GetItemText(hList, i, j, buf, sizeof(buf)/sizeof(wchar_t));
-                    fwprintf(fp, L"%s%s", j == 0 ? L"" : L",", buf);
-                }
-                fwprintf(fp, L"\n");
-            }
-            fclose(fp);
-            MessageBoxW(hMainWnd, L"文件导出成功！", L"成功", MB_OK);
+    if (!GetSaveFileNameW(&ofn)) return;
+    int format = ofn.nFilterIndex == 2 ? OUTPUT_NDJSON : OUTPUT_CSV;
+    FILE* fp;
+    if (_wfopen_s(&fp, path, L"wb") != 0) {
+        MessageBoxW(hMainWnd, L"无法创建导出文件。", L"错误", MB_ICONERROR);
+        return;
+    }
+    RowWriter w;
+    if (!writer_init(&w, fp, format, EXPORT_BUF_SIZE)) { fclose(fp); return; }
+    ResultLogView* view = load_result_log();
+    if (format == OUTPUT_CSV) {
+        writer_raw(&w, "\xEF\xBB\xBF");   // BOM，Excel 据此按 UTF-8 打开
+        // 表头取自列表，与逐格读取的回退路径保持一致
+        HWND hHeader = ListView_GetHeader(hList);
+        int cols = Header_GetItemCount(hHeader);
+        wchar_t buf[256];
+        for (int j = 0; j < cols; j++) {
+            HDITEMW hdi = { HDI_TEXT, 0, buf, NULL, 255, 0 };
+            buf[0] = 0;
+            Header_GetItem(hHeader, j, &hdi);
+            writer_wstr(&w, "", buf);
         }
+        writer_end_row(&w);
     }
+    write_list_rows(&w, view, 0);
+    reslog_view_free(view);
+    writer_flush(&w);
+    int failed = w.failed;
+    writer_free(&w);
+    if (fclose(fp) != 0) failed = 1;
+    if (failed) MessageBoxW(hMainWnd, L"写入导出文件失败，磁盘可能已满。", L"错误", MB_ICONERROR);
+    else MessageBoxW(hMainWnd, L"文件导出成功！", L"成功", MB_OK);
+}
+
+// [新增] 合并多个节点导出的分片结果 (CSV)，按 地址+端口 去重
+void merge_csv() {
+    wchar_t files[8192] = {0};
+    OPENFILENAMEW ofn = {0};
+    ofn.lStructSize = sizeof(ofn);
+    ofn.hwndOwner = hMainWnd;
+    ofn.lpstrFilter = L"CSV Files (*.csv)\0*.csv\0All Files\0*.*\0";
+    ofn.lpstrFile = files;
+    ofn.nMaxFile = 8192;
+    ofn.lpstrTitle = L"选择要合并的分片结果 (可多选)";
+    ofn.Flags = OFN_ALLOWMULTISELECT | OFN_EXPLORER | OFN_FILEMUSTEXIST;
+    if (!GetOpenFileNameW(&ofn)) return;
+
+    // 多选时缓冲区为 "目录\0文件1\0文件2\0\0"，单选时为完整路径
+    const wchar_t* inputs[64];
+    wchar_t paths[64][MAX_PATH];
+    int count = 0;
+    const wchar_t* dir = files;
+    const wchar_t* name = files + wcslen(files) + 1;
+    if (*name == 0) {
+        inputs[count++] = files;
+    } else {
+        for (; *name && count < 64; name += wcslen(name) + 1) {
+            swprintf_s(paths[count], MAX_PATH, L"%s\\%s", dir, name);
+            inputs[count] = paths[count];
+            count++;
+        }
+    }
+
+    wchar_t output[MAX_PATH] = L"merged.csv";
+    OPENFILENAMEW sfn = {0};
+    sfn.lStructSize = sizeof(sfn);
+    sfn.hwndOwner = hMainWnd;
+    sfn.lpstrFilter = L"CSV Files (*.csv)\0*.csv\0All Files\0*.*\0";
+    sfn.lpstrFile = output;
+    sfn.nMaxFile = MAX_PATH;
+    sfn.Flags = OFN_OVERWRITEPROMPT;
+    if (!GetSaveFileNameW(&sfn)) return;
+
+    int rows = merge_result_files(inputs, count, output);
+    wchar_t msg[128];
+    if (rows < 0) swprintf_s(msg, 128, L"合并失败，请检查文件格式与可用内存。");
+    else swprintf_s(msg, 128, L"已合并 %d 个文件，去重后共 %d 条结果。", count, rows);
+    MessageBoxW(hMainWnd, msg, rows < 0 ? L"错误" : L"完成", rows < 0 ? MB_ICONERROR : MB_OK);
+}
+
+// [新增] 以上一次端口扫描的开放 TCP 端口作为候选代理，格式 "host:port" / "[IPv6]:port"
+wchar_t* collect_proxy_candidates(TaskType prevTask) {
+    if (prevTask != TASK_SCAN && prevTask != TASK_SINGLE_SCAN) return NULL;
+    int count = ListView_GetItemCount(hList);
+    if (count == 0) return NULL;
+
+    wchar_t* out = (wchar_t*)malloc(count * 300 * sizeof(wchar_t) + sizeof(wchar_t));
+    if (!out) return NULL;
+    int len = 0;
+    for (int i = 0; i < count; i++) {
+        wchar_t host[256] = {0}, port[32] = {0};
+        ListView_GetItemText(hList, i, 0, host, 256);
+        ListView_GetItemText(hList, i, 1, port, 32);
+        if (!host[0] || _wtoi(port) <= 0 || wcschr(port, L'/')) continue;   // 跳过 UDP 结果
+        if (wcschr(host, L':')) len += swprintf_s(out + len, 300, L"[%s]:%d\n", host, _wtoi(port));
+        else len += swprintf_s(out + len, 300, L"%s:%d\n", host, _wtoi(port));
+    }
+    out[len] = 0;
+    if (len == 0) { free(out); return NULL; }
+    return out;
+}
+
+// [新增] 按插入顺序找到行：未排序时即为同一下标，否则退回线性查找
+int find_list_row(int order) {
+    LVITEMW lvItem = {0};
+    lvItem.mask = LVIF_PARAM;
+    lvItem.iItem = order;
+    if (ListView_GetItem(hList, &lvItem) && lvItem.lParam == order) return order;
+    LVFINDINFOW find = {0};
+    find.flags = LVFI_PARAM;
+    find.lParam = order;
+    return ListView_FindItem(hList, -1, &find);
+}
+
+// [新增] 批量原地刷新："行号|列2|列3...\n" 每行一条
+void update_list_rows(wchar_t* batch) {
+    wchar_t* lineCtx;
+    SendMessageW(hList, WM_SETREDRAW, FALSE, 0);
+    for (wchar_t* line = wcstok_s(batch, L"\n", &lineCtx); line; line = wcstok_s(NULL, L"\n", &lineCtx)) {
+        wchar_t* ctx;
+        wchar_t* token = wcstok_s(line, L"|", &ctx);
+        int order = token ? _wtoi(token) : -1;
+        int row = order >= 0 ? find_list_row(order) : -1;
+        if (row < 0) continue;
+        const wchar_t* fields[RESLOG_MAX_FIELDS];
+        int col = 1, count = 0;
+        while ((token = wcstok_s(NULL, L"|", &ctx))) {
+            if (wcscmp(token, L"-") == 0) token = L"";
+            ListView_SetItemText(hList, row, col++, token);
+            if (count < RESLOG_MAX_FIELDS - 1) fields[count++] = token;
+        }
+        reslog_append(g_resultLog, RESLOG_UPDATE, (unsigned int)order, fields, count);
+    }
+    SendMessageW(hList, WM_SETREDRAW, TRUE, 0);
+    InvalidateRect(hList, NULL, FALSE);
+}
+
+// 状态栏分两栏：左侧为阶段提示，右侧为运行指标
+void layout_status_parts() {
+    RECT rc = {0};
+    if (!hStatus) return;
+    GetClientRect(hStatus, &rc);
+    int parts[2];
+    parts[0] = rc.right > METRICS_PANE_WIDTH * 2 ? rc.right - METRICS_PANE_WIDTH : rc.right / 2;
+    parts[1] = -1;
+    SendMessageW(hStatus, SB_SETPARTS, 2, (LPARAM)parts);
+}
+
+void update_metrics_pane() {
+    MetricsSnapshot now;
+    metrics_snapshot(&now);
+    unsigned long long dt = now.tickMs - g_lastSample.tickMs;
+    long long sent = now.counters[METRIC_PROBES_SENT] - g_lastSample.counters[METRIC_PROBES_SENT];
+    long long total = now.counters[METRIC_WORK_TOTAL];
+    long long done = now.counters[METRIC_WORK_DONE];
+    // 清零前已投递的旧消息随后取出，会使差值短暂为负
+    long long queued = now.counters[METRIC_UI_POSTED] - now.counters[METRIC_UI_DRAINED];
+
+    wchar_t text[256];
+    int len = 0;
+    if (total > 0) {
+        len += swprintf_s(text, 256, L"进度 %lld/%lld (%lld%%) | ", done, total, done * 100 / total);
+    }
+    len += swprintf_s(text + len, 256 - len, L"%lld pps | 在途 %lld | 超时 %lld | 结果 %lld | 界面队列 %lld",
+                      dt > 0 ? sent * 1000 / (long long)dt : 0, now.counters[METRIC_INFLIGHT],
+                      now.counters[METRIC_TIMEOUTS], now.counters[METRIC_RESULTS], queued > 0 ? queued : 0);
+    if (now.counters[METRIC_LOCAL_ERRORS] > 0) {
+        len += swprintf_s(text + len, 256 - len, L" | 本地错误 %lld", now.counters[METRIC_LOCAL_ERRORS]);
+    }
+    if (metrics_hist_count(&now, METRIC_HIST_RTT) > 0) {
+        swprintf_s(text + len, 256 - len, L" | RTT p50 %.1f ms", metrics_percentile(&now, METRIC_HIST_RTT, 50) / 1000.0);
+    }
+    SendMessageW(hStatus, SB_SETTEXTW, 1, (LPARAM)text);
+    g_lastSample = now;
+}
+
+void dump_metrics() {
+    MetricsSnapshot now;
+    metrics_snapshot(&now);
+    if (metrics_dump(METRICS_DUMP_FILE, &now)) {
+        MessageBoxW(hMainWnd, L"运行指标已追加到 " METRICS_DUMP_FILE L"。", L"提示", MB_OK);
+    } else {
+        MessageBoxW(hMainWnd, L"无法写入 " METRICS_DUMP_FILE L"。", L"错误", MB_ICONERROR);
+    }
+}
+
+// 每个任务重新开始结果日志，先记下列名
+void open_result_log() {
+    reslog_close(g_resultLog);
+    g_resultLog = reslog_create(RESULT_LOG_FILE);
+    g_nextRowId = 0;
+    HWND hHeader = ListView_GetHeader(hList);
+    int cols = Header_GetItemCount(hHeader);
+    wchar_t names[RESLOG_MAX_FIELDS][64];
+    const wchar_t* fields[RESLOG_MAX_FIELDS];
+    if (cols > RESLOG_MAX_FIELDS) cols = RESLOG_MAX_FIELDS;
+    for (int j = 0; j < cols; j++) {
+        HDITEMW hdi = { HDI_TEXT, 0, names[j], NULL, 63, 0 };
+        names[j][0] = 0;
+        Header_GetItem(hHeader, j, &hdi);
+        fields[j] = names[j];
+    }
+    reslog_append(g_resultLog, RESLOG_HEADER, 0, fields, cols);
 }
 
 void start_task(TaskType type) {
+    TaskType prevTask = g_currentTask;
     reset_stop_task();
     g_currentTask = type;
     g_sortColumn = -1;
@@ -318,39 +612,88 @@ void start_task(TaskType type) {
     memset(p, 0, sizeof(ThreadParams));
 
     p->hwndNotify = hMainWnd;
+    wchar_t* candidates = (type == TASK_PROXY_TEST) ? collect_proxy_candidates(prevTask) : NULL;
     p->retryCount = GetDlgItemInt(hMainWnd, ID_EDIT_COUNT, NULL, FALSE);
+    p->tcpingPort = GetDlgItemInt(hMainWnd, ID_EDIT_TCPING_PORT, NULL, FALSE);
+    if (p->tcpingPort > 65535) p->tcpingPort = 0;
+    if (type == TASK_PING && IsDlgButtonChecked(hMainWnd, ID_CHECK_MONITOR) == BST_CHECKED) {
+        int sec = GetDlgItemInt(hMainWnd, ID_EDIT_MONITOR_SEC, NULL, FALSE);
+        p->monitorIntervalMs = (sec > 0 ? sec : 1) * 1000;
+    }
     p->timeoutMs = GetDlgItemInt(hMainWnd, ID_EDIT_TIMEOUT, NULL, FALSE);
+    p->minTimeoutMs = GetDlgItemInt(hMainWnd, ID_EDIT_MIN_TIMEOUT, NULL, FALSE);
     
     // 获取归属地复选框状态
     p->showLocation = (IsDlgButtonChecked(hMainWnd, ID_CHECK_LOCATION) == BST_CHECKED);
+    p->udpScan = (IsDlgButtonChecked(hMainWnd, ID_CHECK_UDP) == BST_CHECKED);
+    p->serviceDetect = (IsDlgButtonChecked(hMainWnd, ID_CHECK_SERVICE) == BST_CHECKED);
+    p->hostDiscovery = (IsDlgButtonChecked(hMainWnd, ID_CHECK_DISCOVERY) == BST_CHECKED);
+    p->deltaScan = (type == TASK_SCAN && IsDlgButtonChecked(hMainWnd, ID_CHECK_DELTA) == BST_CHECKED);
+    p->pps = GetDlgItemInt(hMainWnd, ID_EDIT_PPS, NULL, FALSE);
+    p->subnetCap = GetDlgItemInt(hMainWnd, ID_EDIT_SUBNET_CAP, NULL, FALSE);
+    if (type == TASK_PROXY_TEST) p->proxyTestTarget = get_alloc_text(GetDlgItem(hMainWnd, ID_EDIT_PROXY_TARGET));
+
+    // [新增] 源地址：填写多个本机地址或网卡名后，探测轮流从各地址发出
+    char* sourceSpec = get_alloc_text_utf8(GetDlgItem(hMainWnd, ID_EDIT_SOURCE));
+    if (sourceSpec && sourceSpec[0]) {
+        char bad[128];
+        int n = -1;
+        p->sources = (ProbeSources*)arena_alloc(&p->arena, sizeof(ProbeSources));
+        if (p->sources) n = source_parse(sourceSpec, p->sources, bad, sizeof(bad));
+        if (n < 0) {
+            wchar_t wbad[128], msg[256];
+            utf8_to_wide_buf(p->sources ? bad : "", wbad, 128);
+            swprintf_s(msg, 256, L"源地址 \"%s\" 不是本机地址或网卡名，请检查后重试。", wbad);
+            MessageBoxW(hMainWnd, msg, L"错误", MB_ICONERROR);
+            free(sourceSpec);
+            free(candidates);
+            free_thread_params(p);
+            g_currentTask = prevTask;
+            return;
+        }
+        if (n == 0) p->sources = NULL;
+        else p->sources->mode = PROBE_SOURCE_ROUND_ROBIN;
+    }
+    free(sourceSpec);
+
+    // [新增] 分片 "i/N"：本机负责第 i 片，共 N 片，i 从 1 起 (与 netools_cli --shard 相同)
+    if (type == TASK_SCAN) {
+        wchar_t shard[32] = {0};
+        int idx = 0, total = 0;
+        GetDlgItemTextW(hMainWnd, ID_EDIT_SHARD, shard, 32);
+        if (swscanf_s(shard, L"%d/%d", &idx, &total) == 2 && total > 1 && idx >= 1 && idx <= total) {
+            p->shardIndex = idx - 1;
+            p->shardCount = total;
+        }
+    }
 
     if (type == TASK_SINGLE_SCAN) {
         p->targetInput = get_alloc_text(hEditSingleIp); 
         p->portsInput = get_alloc_text(hEditSinglePort);
+    } else if (candidates) {
+        p->targetInput = candidates;
     } else {
         p->portsInput = get_alloc_text(hEditPorts);
         if (IsDlgButtonChecked(hMainWnd, ID_RADIO_FILE)) {
             wchar_t* path = get_alloc_text(hEditFile);
-            FILE* f;
-            if (_wfopen_s(&f, path, L"rb") == 0) {
-                fseek(f, 0, SEEK_END);
-                long sz = ftell(f);
-                fseek(f, 0, SEEK_SET);
-                char* buffer = (char*)malloc(sz + 1);
-                fread(buffer, 1, sz, f);
-                buffer[sz] = 0;
-                fclose(f);
+            char* buffer = read_file_bytes(path);
+            if (!buffer) {
+                buffer = _strdup("");
+                MessageBoxW(hMainWnd, L"无法读取文件，请检查路径。", L"错误", MB_ICONERROR);
+            }
+            if (type == TASK_EXTRACT) {
+                p->textInput = buffer;  // [修改] 提取直接扫描文件原始字节，不再整体转成 UTF-16
+            } else if (buffer) {
                 int wlen = MultiByteToWideChar(CP_UTF8, 0, buffer, -1, NULL, 0);
                 if (wlen == 0) wlen = MultiByteToWideChar(CP_ACP, 0, buffer, -1, NULL, 0);
                 p->targetInput = (wchar_t*)malloc((wlen + 1) * sizeof(wchar_t));
                 MultiByteToWideChar(CP_UTF8, 0, buffer, -1, p->targetInput, wlen);
                 p->targetInput[wlen] = 0;
                 free(buffer);
-            } else {
-                p->targetInput = _wcsdup(L"");
-                MessageBoxW(hMainWnd, L"无法读取文件，请检查路径。", L"错误", MB_ICONERROR);
             }
             free(path);
+        } else if (type == TASK_EXTRACT) {
+            p->textInput = get_alloc_text_utf8(hEditText);
         } else {
             p->targetInput = get_alloc_text(hEditText);
         }
@@ -359,13 +702,31 @@ void start_task(TaskType type) {
     ListView_DeleteAllItems(hList);
     while(ListView_DeleteColumn(hList, 0));
 
+    // 指标按任务清零
+    metrics_reset();
+    metrics_snapshot(&g_lastSample);
+    g_taskRunning = 1;
+    SetTimer(hMainWnd, ID_TIMER_METRICS, METRICS_REFRESH_MS, NULL);
+
     if (type == TASK_PING) {
         int colIdx = 0;
         wchar_t* cols[] = {L"目标地址", L"状态", L"平均延迟(ms)", L"丢包率(%)", L"TTL"};
+        if (p->tcpingPort > 0) cols[4] = L"最小/最大(ms)";   // TCP 握手拿不到 TTL
+        if (p->monitorIntervalMs > 0) {
+            // 持续监控：统计量取最近 MONITOR_WINDOW 次探测
+            cols[2] = L"最新延迟(ms)";
+            cols[3] = L"平均延迟(ms)";
+            cols[4] = L"丢包率(%)";
+            p->showLocation = 0;
+        }
         for(int i=0; i<5; i++) {
             LVCOLUMNW lvc = {0}; lvc.mask = LVCF_TEXT | LVCF_WIDTH; lvc.pszText = cols[i]; lvc.cx = (i==0?180:100);
             ListView_InsertColumn(hList, colIdx++, &lvc);
         }
+        if (p->monitorIntervalMs > 0) {
+            LVCOLUMNW lvc = {0}; lvc.mask = LVCF_TEXT | LVCF_WIDTH; lvc.pszText = L"最小/最大/抖动(ms)"; lvc.cx = 160;
+            ListView_InsertColumn(hList, colIdx++, &lvc);
+        }
         if (p->showLocation) {
             LVCOLUMNW lvc = {0}; lvc.mask = LVCF_TEXT | LVCF_WIDTH; lvc.pszText = L"归属地"; lvc.cx = 200;
             ListView_InsertColumn(hList, colIdx++, &lvc);
@@ -373,12 +734,21 @@ void start_task(TaskType type) {
         _beginthreadex(NULL, 0, thread_ping, p, 0, NULL);
     } 
     else if (type == TASK_SCAN) {
+        // [新增] 同一任务上次被中止时询问是否从断点继续 (增量扫描不续扫)
+        if (!p->deltaScan && port_scan_can_resume(p) &&
+            MessageBoxW(hMainWnd, L"发现该任务未完成的扫描进度，是否从断点继续？\n选择“否”将重新开始扫描。", L"断点续扫", MB_YESNO | MB_ICONQUESTION) == IDYES) {
+            p->resume = 1;
+        }
         int colIdx = 0;
         wchar_t* cols[] = {L"目标地址", L"端口", L"状态"};
         for(int i=0; i<3; i++) {
             LVCOLUMNW lvc = {0}; lvc.mask = LVCF_TEXT | LVCF_WIDTH; lvc.pszText = cols[i]; lvc.cx = (i==0?200:100);
             ListView_InsertColumn(hList, colIdx++, &lvc);
         }
+        if (p->serviceDetect) {
+            LVCOLUMNW lvc = {0}; lvc.mask = LVCF_TEXT | LVCF_WIDTH; lvc.pszText = L"服务/备注"; lvc.cx = 260;
+            ListView_InsertColumn(hList, colIdx++, &lvc);
+        }
         if (p->showLocation) {
             LVCOLUMNW lvc = {0}; lvc.mask = LVCF_TEXT | LVCF_WIDTH; lvc.pszText = L"归属地"; lvc.cx = 200;
             ListView_InsertColumn(hList, colIdx++, &lvc);
@@ -407,6 +777,24 @@ void start_task(TaskType type) {
         }
         _beginthreadex(NULL, 0, thread_single_scan, p, 0, NULL);
     }
+    else if (type == TASK_TRACE) {
+        wchar_t* cols[] = {L"目标地址", L"跳数", L"节点地址", L"延迟(ms)", L"归属地"};
+        for(int i=0; i<5; i++) {
+            LVCOLUMNW lvc = {0}; lvc.mask = LVCF_TEXT|LVCF_WIDTH; lvc.pszText = cols[i]; lvc.cx = (i==0||i==4?180:(i==2?140:80));
+            ListView_InsertColumn(hList, i, &lvc);
+        }
+        _beginthreadex(NULL, 0, thread_trace, p, 0, NULL);
+    }
+    else if (type == TASK_PROXY_TEST) {
+        wchar_t* cols[] = {L"代理地址", L"端口", L"协议", L"握手(ms)", L"首字节(ms)", L"总延迟(ms)"};
+        for(int i=0; i<6; i++) {
+            LVCOLUMNW lvc = {0}; lvc.mask = LVCF_TEXT|LVCF_WIDTH; lvc.pszText = cols[i]; lvc.cx = (i==0?200:90);
+            ListView_InsertColumn(hList, i, &lvc);
+        }
+        _beginthreadex(NULL, 0, thread_proxy_test, p, 0, NULL);
+    }
+    // 结果经窗口消息在本线程处理，列建好后再开日志不会漏掉首行
+    open_result_log();
 }
 
 int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLine, int nCmdShow) {
@@ -466,11 +854,28 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
             CheckDlgButton(hWnd, ID_RADIO_FILE, BST_CHECKED);
 
             CreateWindowW(L"BUTTON", L"粘贴文本:", WS_CHILD|WS_VISIBLE|BS_AUTORADIOBUTTON, 30, grp1Y+55, 80, 20, hWnd, (HMENU)ID_RADIO_TEXT, hInst, NULL);
-            hEditText = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"", WS_CHILD|WS_VISIBLE|WS_VSCROLL|ES_MULTILINE|ES_WANTRETURN, 110, grp1Y+55, 370, 90, hWnd, (HMENU)ID_EDIT_TEXT, hInst, NULL);
+            hEditText = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"", WS_CHILD|WS_VISIBLE|WS_VSCROLL|ES_MULTILINE|ES_WANTRETURN, 110, grp1Y+55, 370, 60, hWnd, (HMENU)ID_EDIT_TEXT, hInst, NULL);
+
+            // [新增] TCP Ping：填写端口后批量 Ping 改为测量 TCP 握手延迟 (目标屏蔽 ICMP 时使用)
+            CreateWindowW(L"STATIC", L"TCP Ping端口:", WS_CHILD|WS_VISIBLE, 30, grp1Y+127, 80, 20, hWnd, NULL, hInst, NULL);
+            CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"", WS_CHILD|WS_VISIBLE|ES_NUMBER, 110, grp1Y+125, 60, 23, hWnd, (HMENU)ID_EDIT_TCPING_PORT, hInst, NULL);
+            CreateWindowW(L"STATIC", L"(留空则用 ICMP)", WS_CHILD|WS_VISIBLE, 180, grp1Y+127, 100, 20, hWnd, NULL, hInst, NULL);
+            // [新增] 持续监控：勾选后批量 Ping 按间隔循环探测，直到点击 "中止任务"
+            CreateWindowW(L"BUTTON", L"持续监控, 间隔(秒):", WS_CHILD|WS_VISIBLE|BS_AUTOCHECKBOX, 285, grp1Y+127, 140, 20, hWnd, (HMENU)ID_CHECK_MONITOR, hInst, NULL);
+            CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"1", WS_CHILD|WS_VISIBLE|ES_NUMBER, 430, grp1Y+125, 50, 23, hWnd, (HMENU)ID_EDIT_MONITOR_SEC, hInst, NULL);
 
-            CreateWindowW(L"STATIC", L"Ping超时(ms):", WS_CHILD|WS_VISIBLE, 500, grp1Y+55, 90, 20, hWnd, NULL, hInst, NULL);
+            CreateWindowW(L"STATIC", L"超时(ms):", WS_CHILD|WS_VISIBLE, 500, grp1Y+55, 90, 20, hWnd, NULL, hInst, NULL);
             hEditTimeout = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"1000", WS_CHILD|WS_VISIBLE|ES_NUMBER, 600, grp1Y+53, 60, 23, hWnd, (HMENU)ID_EDIT_TIMEOUT, hInst, NULL);
             
+            // [新增] 扫描速率 (令牌桶) 与同网段并发上限，填 0 表示不限
+            CreateWindowW(L"STATIC", L"速率(pps):", WS_CHILD|WS_VISIBLE, 500, grp1Y+25, 90, 20, hWnd, NULL, hInst, NULL);
+            CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"2000", WS_CHILD|WS_VISIBLE|ES_NUMBER, 600, grp1Y+23, 60, 23, hWnd, (HMENU)ID_EDIT_PPS, hInst, NULL);
+            // [新增] 端口扫描超时按实测 RTT 自适应，介于下限与上面的超时之间
+            CreateWindowW(L"STATIC", L"最小超时:", WS_CHILD|WS_VISIBLE, 710, grp1Y+25, 70, 20, hWnd, NULL, hInst, NULL);
+            CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"100", WS_CHILD|WS_VISIBLE|ES_NUMBER, 790, grp1Y+23, 60, 23, hWnd, (HMENU)ID_EDIT_MIN_TIMEOUT, hInst, NULL);
+            CreateWindowW(L"STATIC", L"网段并发:", WS_CHILD|WS_VISIBLE, 710, grp1Y+55, 70, 20, hWnd, NULL, hInst, NULL);
+            CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"64", WS_CHILD|WS_VISIBLE|ES_NUMBER, 790, grp1Y+53, 60, 23, hWnd, (HMENU)ID_EDIT_SUBNET_CAP, hInst, NULL);
+
             CreateWindowW(L"STATIC", L"Ping次数:", WS_CHILD|WS_VISIBLE, 500, grp1Y+85, 90, 20, hWnd, NULL, hInst, NULL);
             hEditCount = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"5", WS_CHILD|WS_VISIBLE|ES_NUMBER, 600, grp1Y+83, 60, 23, hWnd, (HMENU)ID_EDIT_COUNT, hInst, NULL);
 
@@ -478,8 +883,21 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
             CreateWindowW(L"BUTTON", L"显示 IP 归属地 (需 qqwry.dat)", WS_CHILD|WS_VISIBLE|BS_AUTOCHECKBOX, 500, grp1Y+120, 200, 20, hWnd, (HMENU)ID_CHECK_LOCATION, hInst, NULL);
             CheckDlgButton(hWnd, ID_CHECK_LOCATION, BST_UNCHECKED); 
 
+            // [新增] UDP 扫描模式 - 对端口扫描生效，常见端口发送协议载荷
+            CreateWindowW(L"BUTTON", L"UDP 扫描模式", WS_CHILD|WS_VISIBLE|BS_AUTOCHECKBOX, 710, grp1Y+120, 150, 20, hWnd, (HMENU)ID_CHECK_UDP, hInst, NULL);
+            // [新增] 服务识别 - 对开放端口抓取 Banner，结果写入 "服务/备注" 列
+            CreateWindowW(L"BUTTON", L"识别服务 (Banner)", WS_CHILD|WS_VISIBLE|BS_AUTOCHECKBOX, 710, grp1Y+85, 150, 20, hWnd, (HMENU)ID_CHECK_SERVICE, hInst, NULL);
+
             CreateWindowW(L"STATIC", L"批量扫描端口:", WS_CHILD|WS_VISIBLE, 30, grp1Y+160, 90, 20, hWnd, NULL, hInst, NULL);
-            hEditPorts = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"80,443,8080,1433,3306,3389", WS_CHILD|WS_VISIBLE|ES_AUTOHSCROLL, 120, grp1Y+158, 750, 23, hWnd, (HMENU)ID_EDIT_PORTS, hInst, NULL);
+            hEditPorts = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"80,443,8080,1433,3306,3389", WS_CHILD|WS_VISIBLE|ES_AUTOHSCROLL, 120, grp1Y+158, 330, 23, hWnd, (HMENU)ID_EDIT_PORTS, hInst, NULL);
+            // [新增] 源地址：多个本机地址或网卡名 (逗号分隔)，留空由系统选择
+            CreateWindowW(L"STATIC", L"源地址:", WS_CHILD|WS_VISIBLE, 460, grp1Y+160, 50, 20, hWnd, NULL, hInst, NULL);
+            CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"", WS_CHILD|WS_VISIBLE|ES_AUTOHSCROLL, 515, grp1Y+158, 175, 23, hWnd, (HMENU)ID_EDIT_SOURCE, hInst, NULL);
+            // [新增] 存活探测 - 取消勾选即视所有主机为在线 (适用于屏蔽 Ping 的网络)
+            CreateWindowW(L"BUTTON", L"先探测存活主机", WS_CHILD|WS_VISIBLE|BS_AUTOCHECKBOX, 710, grp1Y+160, 150, 20, hWnd, (HMENU)ID_CHECK_DISCOVERY, hInst, NULL);
+            CheckDlgButton(hWnd, ID_CHECK_DISCOVERY, BST_CHECKED);
+            // [新增] 增量扫描 - 与该目标上次的结果对比，只列出新开放、已关闭与服务变化的端口
+            CreateWindowW(L"BUTTON", L"增量扫描 (只列变化)", WS_CHILD|WS_VISIBLE|BS_AUTOCHECKBOX, 710, grp1Y+140, 150, 20, hWnd, (HMENU)ID_CHECK_DELTA, hInst, NULL);
 
             int btnY = grp1Y + 195;
             CreateWindowW(L"BUTTON", L"开始批量 Ping", WS_CHILD|WS_VISIBLE|BS_PUSHBUTTON, 30, btnY, 120, 30, hWnd, (HMENU)ID_BTN_PING, hInst, NULL);
@@ -489,6 +907,13 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
             
             hBtnProxy = CreateWindowW(L"BUTTON", L"设置系统代理", WS_CHILD|WS_VISIBLE|BS_PUSHBUTTON, 530, btnY, 100, 30, hWnd, (HMENU)ID_BTN_PROXY, hInst, NULL);
 
+            // [新增] 多机分片：各节点填写相同的目标与端口，分别填 1/N ... N/N；
+            // 种子由目标与端口列表推导，可与用 --shard i/N 且不带 --seed 的命令行节点混用
+            CreateWindowW(L"STATIC", L"分片(i/N):", WS_CHILD|WS_VISIBLE, 650, btnY+7, 70, 20, hWnd, NULL, hInst, NULL);
+            CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"1/1", WS_CHILD|WS_VISIBLE, 725, btnY+4, 60, 23, hWnd, (HMENU)ID_EDIT_SHARD, hInst, NULL);
+            // [新增] 路由追踪：探测方式随 TCP Ping 端口 / UDP 选项，否则为 ICMP
+            CreateWindowW(L"BUTTON", L"路由追踪", WS_CHILD|WS_VISIBLE|BS_PUSHBUTTON, 795, btnY, 85, 30, hWnd, (HMENU)ID_BTN_TRACE, hInst, NULL);
+
             int grp2Y = 250;
             CreateWindowW(L"BUTTON", L"单个目标扫描", WS_CHILD|WS_VISIBLE|BS_GROUPBOX, 10, grp2Y, 880, 60, hWnd, NULL, hInst, NULL);
             
@@ -496,9 +921,14 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
             hEditSingleIp = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"127.0.0.1", WS_CHILD|WS_VISIBLE, 85, grp2Y+23, 120, 23, hWnd, (HMENU)ID_EDIT_SINGLE_IP, hInst, NULL);
             
             CreateWindowW(L"STATIC", L"端口范围:", WS_CHILD|WS_VISIBLE, 220, grp2Y+25, 60, 20, hWnd, NULL, hInst, NULL);
-            hEditSinglePort = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"1-1024, 3306, 8080", WS_CHILD|WS_VISIBLE, 285, grp2Y+23, 300, 23, hWnd, (HMENU)ID_EDIT_SINGLE_PORT, hInst, NULL);
+            hEditSinglePort = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"1-1024, 3306, 8080", WS_CHILD|WS_VISIBLE|ES_AUTOHSCROLL, 285, grp2Y+23, 150, 23, hWnd, (HMENU)ID_EDIT_SINGLE_PORT, hInst, NULL);
+            // [新增] 代理检测的测试目标，可改为内网或本机站点以便离线检测
+            CreateWindowW(L"STATIC", L"代理测试:", WS_CHILD|WS_VISIBLE, 445, grp2Y+25, 60, 20, hWnd, NULL, hInst, NULL);
+            CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"www.msftconnecttest.com:80", WS_CHILD|WS_VISIBLE|ES_AUTOHSCROLL, 505, grp2Y+23, 90, 23, hWnd, (HMENU)ID_EDIT_PROXY_TARGET, hInst, NULL);
             
             CreateWindowW(L"BUTTON", L"扫描指定目标", WS_CHILD|WS_VISIBLE|BS_PUSHBUTTON, 600, grp2Y+20, 120, 30, hWnd, (HMENU)ID_BTN_SINGLE_SCAN, hInst, NULL);
+            // [新增] 候选取自上次端口扫描的开放端口，否则取目标输入中的 "地址:端口"
+            CreateWindowW(L"BUTTON", L"批量检测代理", WS_CHILD|WS_VISIBLE|BS_PUSHBUTTON, 730, grp2Y+20, 120, 30, hWnd, (HMENU)ID_BTN_PROXY_TEST, hInst, NULL);
 
             CreateWindowW(L"STATIC", L"运行结果 (右键可复制/全选):", WS_CHILD|WS_VISIBLE, 10, 320, 200, 20, hWnd, NULL, hInst, NULL);
             
@@ -508,9 +938,11 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
                 10, 340, 880, 320, hWnd, (HMENU)ID_LIST_RESULT, hInst, NULL);
             ListView_SetExtendedListViewStyle(hList, LVS_EX_FULLROWSELECT | LVS_EX_GRIDLINES);
 
-            CreateWindowW(L"BUTTON", L"导出结果为 CSV", WS_CHILD|WS_VISIBLE|BS_PUSHBUTTON, 10, 670, 120, 25, hWnd, (HMENU)ID_BTN_EXPORT, hInst, NULL);
+            CreateWindowW(L"BUTTON", L"导出结果", WS_CHILD|WS_VISIBLE|BS_PUSHBUTTON, 10, 670, 120, 25, hWnd, (HMENU)ID_BTN_EXPORT, hInst, NULL);
+            CreateWindowW(L"BUTTON", L"合并分片结果", WS_CHILD|WS_VISIBLE|BS_PUSHBUTTON, 140, 670, 120, 25, hWnd, (HMENU)ID_BTN_MERGE, hInst, NULL);
             
             hStatus = CreateWindowExW(0, STATUSCLASSNAMEW, L"就绪 - 支持拖拽文件输入", WS_CHILD|WS_VISIBLE|SBARS_SIZEGRIP, 0, 0, 0, 0, hWnd, (HMENU)ID_STATUS_BAR, hInst, NULL);
+            layout_status_parts();
 
             EnumChildWindows(hWnd, EnumChildProcSetFont, (LPARAM)hSystemFont);
         }
@@ -542,6 +974,8 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
                     AppendMenuW(hMenu, MF_SEPARATOR, 0, NULL);
                     AppendMenuW(hMenu, MF_STRING, IDM_DEL_OFFLINE, L"删除不在线/超时结果");
                 }
+                AppendMenuW(hMenu, MF_SEPARATOR, 0, NULL);
+                AppendMenuW(hMenu, MF_STRING, IDM_DUMP_METRICS, L"导出运行指标");
                 TrackPopupMenu(hMenu, TPM_RIGHTBUTTON, pt.x, pt.y, 0, hWnd, NULL);
                 DestroyMenu(hMenu);
             }
@@ -569,6 +1003,7 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
         case IDM_DEL_OFFLINE: DeleteOfflineItems(); break;
         case IDM_DEL_SELECTED: DeleteSelectedItems(); break;
         case IDM_REMOVE_DUPLICATE: RemoveDuplicateItems(); break; // [新增] 处理去重
+        case IDM_DUMP_METRICS: dump_metrics(); break;
 
         case ID_BTN_STOP: 
             signal_stop_task(); 
@@ -601,7 +1036,10 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
         case ID_BTN_SCAN: start_task(TASK_SCAN); break;
         case ID_BTN_EXTRACT: start_task(TASK_EXTRACT); break;
         case ID_BTN_SINGLE_SCAN: start_task(TASK_SINGLE_SCAN); break;
-        case ID_BTN_EXPORT: export_csv(); break;
+        case ID_BTN_PROXY_TEST: start_task(TASK_PROXY_TEST); break;
+        case ID_BTN_TRACE: start_task(TASK_TRACE); break;
+        case ID_BTN_EXPORT: export_results(); break;
+        case ID_BTN_MERGE: merge_csv(); break;
         case ID_BTN_PROXY:
             if (isProxySet) {
                 if (proxy_unset_system()) {
@@ -611,6 +1049,8 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
                 }
             } else {
                 int idx = ListView_GetSelectionMark(hList);
+                // [新增] 代理检测结果已按延迟排序，未选中时直接应用最快的一个
+                if (idx == -1 && g_currentTask == TASK_PROXY_TEST && ListView_GetItemCount(hList) > 0) idx = 0;
                 if (idx == -1) {
                     MessageBoxW(hWnd, L"请先在列表中选中包含 IP 和 端口 的一行。", L"提示", MB_OK);
                     break;
@@ -620,8 +1060,30 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
                 ListView_GetItemText(hList, idx, 1, portStr, sizeof(portStr)/sizeof(wchar_t));
                 
                 int port = _wtoi(portStr);
+                wchar_t proto[32] = {0};
+                if (g_currentTask == TASK_PROXY_TEST) {
+                    ListView_GetItemText(hList, idx, 2, proto, 32);
+                    if (wcscmp(proto, L"不可用") == 0) {
+                        MessageBoxW(hWnd, L"所选代理未通过检测，无法使用。", L"提示", MB_OK);
+                        break;
+                    }
+                }
+                // [修改] 协议列先列最快的协议，再列其余通过握手的协议。系统代理的 socks= 条目只走 SOCKS4，
+                // 只通过 SOCKS5 握手的代理不能写入；否则取列在前面的 HTTP 或 SOCKS4
+                int socks = 0;
+                if (g_currentTask == TASK_PROXY_TEST) {
+                    const wchar_t* http = wcsstr(proto, L"HTTP");
+                    const wchar_t* socks4 = wcsstr(proto, L"SOCKS4");
+                    if (!http && !socks4) {
+                        MessageBoxW(hWnd, L"所选代理只通过了 SOCKS5 握手。\nWindows 系统代理的 SOCKS 设置只支持 SOCKS4，"
+                                          L"无法应用；请在支持 SOCKS5 的程序中单独配置该代理。", L"提示", MB_OK);
+                        break;
+                    }
+                    socks = socks4 && (!http || socks4 < http);
+                }
                 if (port > 0 && port < 65536) {
-                    if (proxy_set_system(ip, port)) {
+                    int ok = socks ? proxy_set_system_socks(ip, port) : proxy_set_system(ip, port);
+                    if (ok) {
                         isProxySet = 1;
                         SetWindowTextW(hBtnProxy, L"取消系统代理");
                         wchar_t msg[128];
@@ -642,26 +1104,51 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
         {
             wchar_t* text = (wchar_t*)lParam;
             SendMessageW(hStatus, SB_SETTEXTW, 0, (LPARAM)text);
-            free(text);
+            free_message(text);
+            metrics_add(METRIC_UI_DRAINED, 1);
         }
         break;
     case WM_USER_RESULT:
         {
             wchar_t* row = (wchar_t*)lParam;
             add_list_row(row);
-            free(row);
+            free_message(row);
+            metrics_add(METRIC_UI_DRAINED, 1);
+        }
+        break;
+    case WM_USER_UPDATE:
+        {
+            wchar_t* batch = (wchar_t*)lParam;
+            update_list_rows(batch);
+            free_message(batch);
+            metrics_add(METRIC_UI_DRAINED, 1);
         }
         break;
     case WM_USER_FINISH:
         {
             wchar_t* msg = (wchar_t*)lParam;
             SendMessageW(hStatus, SB_SETTEXTW, 0, (LPARAM)msg);
-            free(msg);
+            free_message(msg);
+            metrics_add(METRIC_UI_DRAINED, 1);
+            // 停止采样前刷新一次，保留最终数值
+            if (g_taskRunning) {
+                g_taskRunning = 0;
+                KillTimer(hWnd, ID_TIMER_METRICS);
+                update_metrics_pane();
+            }
+            reslog_flush(g_resultLog);
+        }
+        break;
+    case WM_TIMER:
+        if (wParam == ID_TIMER_METRICS && g_taskRunning) {
+            update_metrics_pane();
+            reslog_flush(g_resultLog);
         }
         break;
         
     case WM_SIZE:
         SendMessage(hStatus, WM_SIZE, 0, 0);
+        layout_status_parts();
         RECT rc;
         GetClientRect(hWnd, &rc);
         
@@ -678,6 +1165,8 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
             int x = rc.right - btnW - margin;
             int y = rc.bottom - statusHeight - btnH - 5; 
             SetWindowPos(hBtnExport, NULL, x, y, btnW, btnH, SWP_NOZORDER);
+            HWND hBtnMerge = GetDlgItem(hWnd, ID_BTN_MERGE);
+            if (hBtnMerge) SetWindowPos(hBtnMerge, NULL, x - btnW - margin, y, btnW, btnH, SWP_NOZORDER);
         }
 
         if (hList) {
@@ -699,6 +1188,8 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 
     case WM_DESTROY:
         if (isProxySet) proxy_unset_system();
+        reslog_close(g_resultLog);
+        g_resultLog = NULL;
         PostQuitMessage(0);
         break;
 
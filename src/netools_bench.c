@@ -0,0 +1,1099 @@
+#include "network_modules.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <pthread.h>
+#endif
+
+// --- 性能基准 ---
+// 微基准：文本提取、归属地查询、端口解析、主机拆分、结果排序去重，输入均为固定种子生成的合成数据；
+// 宏基准：在本机回环上搭一组监听端口，用探测引擎反复扫描，比较各 I/O 后端的每秒探测数。
+// 另有一项在一批挂起到超时的探测占住大半在途窗口的同时扫描同一组端口，衡量在途探测很多时的调度开销。
+// 同一组监听端口上还做一次 SYN 扫描校验 (需 CAP_NET_RAW)，开放与关闭数不符时以非零状态退出。
+// 代理检测在本机搭几个只应答握手的替身代理来校验 (不依赖外网)，各代理通过的协议不符时同样以非零状态退出。
+// UDP 扫描在回环上搭应答、静默与无人绑定三类端口，校验探测载荷与 开放 / open|filtered / 关闭 的判定。
+// 每项结果输出一行 JSON，便于跨提交对比；check 字段是结果校验值，同一输入下应保持不变。
+
+#define BENCH_HOSTS         8       // 127.0.0.1 ~ 127.0.0.8 (整个 127/8 都落在回环上)
+#define BENCH_PORT_BASE     41000
+#define BENCH_PORTS         2048
+#define BENCH_LISTEN_EVERY  64      // 每 64 个端口放一个监听者，其余端口回 RST
+#define BENCH_DEFAULT_ROUNDS   5
+#define BENCH_DEFAULT_INFLIGHT 1024
+#define BENCH_PENDING_PORT     40999    // 积压队列已满的监听端口：新来的 SYN 被丢弃，连接挂起到超时
+#define BENCH_PENDING_HOSTS    4096     // 127.1.0.0 起每个地址一个挂起的探测
+#define BENCH_PENDING_INFLIGHT 8192
+#define BENCH_PENDING_TIMEOUT  3000
+#define BENCH_PROXY_TARGET     "127.0.0.9"  // 替身代理只核对请求中的目标，不会真的连过去
+#define BENCH_PROXY_TARGET_PORT 8080
+#define BENCH_PROXY_STANDINS   3
+#define BENCH_UDP_BASE         43000    // 无专用载荷的应答端口、静默端口与无人绑定的端口从这里起
+#define BENCH_UDP_SILENT       8
+#define BENCH_UDP_CLOSED       32       // 本机 ICMP 全局限速的突发额度约 50 个，超过会有端口等到超时
+#define BENCH_UDP_TIMEOUT      300
+
+#define BENCH_LOG_LINES     20000   // 合成日志行数 (约 2M 字符)
+#define BENCH_GEO_IPS       4096
+#define BENCH_GEO_LOOKUPS   200000
+#define BENCH_GEO_RANGES    65536   // 合成库按 /16 划分
+#define BENCH_PORT_PARSES   200
+#define BENCH_HOST_TOKENS   100000
+#define BENCH_RESULT_ROWS   200000
+
+// 引擎通过此函数检查中止；基准测试从不中止
+int is_task_stopped() {
+    return 0;
+}
+
+typedef struct {
+    int cursor;
+    int total;
+    long long open;
+    long long closed;
+    long long filtered;
+} BenchScan;
+
+static int bench_scan_next(void* ctx, int* target, int* port) {
+    BenchScan* b = (BenchScan*)ctx;
+    if (b->cursor >= b->total) return 0;
+    *target = b->cursor % BENCH_HOSTS;
+    *port = BENCH_PORT_BASE + b->cursor / BENCH_HOSTS;
+    b->cursor++;
+    return 1;
+}
+
+static void on_bench_scan_result(void* ctx, int target, int port, int state, const char* data, int len) {
+    BenchScan* b = (BenchScan*)ctx;
+    (void)target; (void)port; (void)data; (void)len;
+    if (state == PROBE_OPEN) b->open++;
+    else if (state == PROBE_CLOSED) b->closed++;
+    else b->filtered++;
+}
+
+static const char* backend_name(int backend) {
+    switch (backend) {
+    case PROBE_BACKEND_SELECT: return "select";
+    case PROBE_BACKEND_EPOLL:  return "epoll";
+    case PROBE_BACKEND_URING:  return "uring";
+    }
+    return "auto";
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// --- 微基准框架 ---
+// fn 执行一轮并返回处理的条目数，*check 写入结果校验值
+typedef long long (*BenchFn)(void* ctx, long long* check);
+
+static const char* g_filter = NULL;     // 只运行名称包含该子串的项目
+static int g_rounds = BENCH_DEFAULT_ROUNDS;
+
+static int bench_selected(const char* name) {
+    return !g_filter || strstr(name, g_filter) != NULL;
+}
+
+static unsigned int g_seed = 2463534242u;
+
+static unsigned int bench_rand(void) {
+    g_seed ^= g_seed << 13;
+    g_seed ^= g_seed >> 17;
+    g_seed ^= g_seed << 5;
+    return g_seed;
+}
+
+static void bench_run(const char* name, BenchFn fn, void* ctx, const char* note) {
+    if (!bench_selected(name)) return;
+    double* us = (double*)malloc(sizeof(double) * g_rounds);
+    if (!us) return;
+    long long ops = 0, check = 0;
+    for (int r = 0; r < g_rounds; r++) {
+        unsigned long long start = platform_tick_us();
+        ops = fn(ctx, &check);
+        us[r] = (double)(platform_tick_us() - start);
+    }
+    qsort(us, g_rounds, sizeof(double), compare_double);
+    double median = us[g_rounds / 2];
+    printf("{\"bench\":\"%s\",\"ops\":%lld,\"check\":%lld,\"rounds\":%d,"
+           "\"median_us\":%.0f,\"best_us\":%.0f,\"ops_per_sec\":%.0f%s}\n",
+           name, ops, check, g_rounds, median, us[0],
+           median > 0 ? ops * 1000000.0 / median : 0, note ? note : "");
+    fflush(stdout);
+    free(us);
+}
+
+// --- 文本提取 ---
+// 模拟访问日志：时间戳、主机名、IPv4/IPv6 地址与 URL 混排，另夹杂形似地址的干扰串
+typedef struct {
+    char* text;
+    int (*extract)(const char* text, ExtractCallback cb, void* ctx);
+    long long matches;
+} ExtractBench;
+
+static char* build_log_text(int lines, size_t* outLen) {
+    size_t cap = (size_t)lines * 200 + 1, len = 0;
+    char* text = (char*)malloc(cap);
+    if (!text) return NULL;
+    static const char* tlds[] = { "com", "net", "org", "cn", "io", "example" };
+    for (int i = 0; i < lines && cap - len > 200; i++) {
+        unsigned int a = bench_rand(), b = bench_rand(), c = bench_rand();
+        int n = snprintf(text + len, cap - len,
+            "2024-05-%02u 12:%02u:%02u host-%u.node%u.%s %u.%u.%u.%u -> 2001:db8:%x::%x "
+            "GET /v%u/item?id=%u.%u ver=1.%u.%u status=%u\n",
+            1 + a % 28, a % 60, b % 60, b % 1000, c % 50, tlds[c % 6],
+            a & 255, (a >> 8) & 255, (b >> 16) & 255, c & 255,
+            (b >> 4) & 0xffff, c & 0xffff,
+            c % 9, a % 100000, b % 1000, a % 20, b % 20, 200 + c % 300);
+        if (n < 0) break;
+        len += (size_t)n;
+    }
+    text[len] = 0;
+    *outLen = len;
+    return text;
+}
+
+static void on_bench_extract(void* ctx, const char* value, int kind) {
+    (void)value; (void)kind;
+    ((ExtractBench*)ctx)->matches++;
+}
+
+static long long bench_extract(void* ctx, long long* check) {
+    ExtractBench* b = (ExtractBench*)ctx;
+    b->matches = 0;
+    b->extract(b->text, on_bench_extract, b);
+    *check = b->matches;
+    return (long long)strlen(b->text);
+}
+
+// --- 归属地查询 ---
+// 未找到 qqwry.dat 时按其格式在内存中生成一个合成库：每个 /16 一条记录，
+// 奇数记录用模式 2 重定向到共享的国家字符串，偶数记录为内联字符串
+typedef struct {
+    char ips[BENCH_GEO_IPS][16];
+} GeoBench;
+
+static void put_int3(unsigned char* p, unsigned int v) {
+    p[0] = (unsigned char)v; p[1] = (unsigned char)(v >> 8); p[2] = (unsigned char)(v >> 16);
+}
+
+static void put_int4(unsigned char* p, unsigned int v) {
+    put_int3(p, v); p[3] = (unsigned char)(v >> 24);
+}
+
+static int load_synthetic_qqwry(void) {
+    size_t size = 8 + 256 * 16 + (size_t)BENCH_GEO_RANGES * (4 + 16 + 1) + (size_t)BENCH_GEO_RANGES * 7;
+    unsigned char* data = (unsigned char*)calloc(1, size);
+    if (!data) return 0;
+    unsigned int pos = 8;
+    unsigned int pool[256];
+    for (int i = 0; i < 256; i++) {
+        pool[i] = pos;
+        pos += (unsigned int)sprintf((char*)data + pos, "Country-%03d", i) + 1;
+    }
+    unsigned int* records = (unsigned int*)malloc(sizeof(unsigned int) * BENCH_GEO_RANGES);
+    if (!records) { free(data); return 0; }
+    for (unsigned int i = 0; i < BENCH_GEO_RANGES; i++) {
+        records[i] = pos;
+        put_int4(data + pos, (i << 16) | 0xFFFF);
+        pos += 4;
+        if (i & 1) {
+            data[pos] = 2;
+            put_int3(data + pos + 1, pool[i & 255]);
+            pos += 4;
+            data[pos++] = 0;        // 地区为空
+        } else {
+            pos += (unsigned int)sprintf((char*)data + pos, "Region-%05u", i) + 1;
+            data[pos++] = 0;
+        }
+    }
+    put_int4(data, pos);
+    for (unsigned int i = 0; i < BENCH_GEO_RANGES; i++) {
+        put_int4(data + pos, i << 16);
+        put_int3(data + pos + 4, records[i]);
+        pos += 7;
+    }
+    put_int4(data + 4, pos - 7);
+    free(records);
+    ipv4_load_qqwry(data, pos);
+    return 1;
+}
+
+static long long bench_geo(void* ctx, long long* check) {
+    GeoBench* g = (GeoBench*)ctx;
+    wchar_t loc[256];
+    unsigned int hash = 2166136261u;    // 查询结果的 FNV-1a 摘要
+    for (int i = 0; i < BENCH_GEO_LOOKUPS; i++) {
+        ipv4_get_location(g->ips[i % BENCH_GEO_IPS], loc, 256);
+        for (const wchar_t* p = loc; *p; p++) hash = (hash ^ (unsigned int)*p) * 16777619u;
+    }
+    *check = hash;
+    return BENCH_GEO_LOOKUPS;
+}
+
+// --- 端口解析 ---
+static long long bench_parse_ports(void* ctx, long long* check) {
+    static const wchar_t* specs[] = {
+        L"top100", L"1-1024", L"top1000,!25,!110", L"1-65535",
+        L"21,22,23,25,53,80,110,143,443,445,993,995,1433,3306,3389,5432,6379,8080,8443",
+        L"1-1000,2000-3000,8000-9000,!8080",
+    };
+    (void)ctx;
+    long long ports = 0;
+    for (int i = 0; i < BENCH_PORT_PARSES; i++) {
+        int count = 0;
+        int* list = parse_ports(specs[i % 6], &count);
+        ports += count;
+        free(list);
+    }
+    *check = ports;
+    return BENCH_PORT_PARSES;
+}
+
+// --- 主机列表拆分 ---
+typedef struct {
+    wchar_t* text;
+} SplitBench;
+
+static wchar_t* build_host_text(int tokens) {
+    size_t cap = (size_t)tokens * 32 + 1, len = 0;
+    wchar_t* text = (wchar_t*)malloc(cap * sizeof(wchar_t));
+    if (!text) return NULL;
+    static const wchar_t* seps[] = { L"\n", L",", L" ", L"\r\n", L", " };
+    for (int i = 0; i < tokens; i++) {
+        unsigned int r = bench_rand();
+        int n;
+        if (r % 4 == 0) n = swprintf(text + len, cap - len, L"svc%u.example.com%ls", r % 100000, seps[r % 5]);
+        else if (r % 4 == 1) n = swprintf(text + len, cap - len, L"10.%u.%u.0/24%ls", (r >> 8) & 255, (r >> 16) & 255, seps[r % 5]);
+        else n = swprintf(text + len, cap - len, L"192.168.%u.%u%ls", (r >> 8) & 255, (r >> 16) & 255, seps[r % 5]);
+        if (n < 0) break;
+        len += (size_t)n;
+    }
+    text[len] = 0;
+    return text;
+}
+
+static long long bench_split_hosts(void* ctx, long long* check) {
+    SplitBench* b = (SplitBench*)ctx;
+    Arena arena = {0};
+    int count = 0;
+    split_hosts(&arena, b->text, &count);
+    arena_free(&arena);
+    *check = count;
+    return count;
+}
+
+// --- 结果排序去重 ---
+// 约四分之一的行与先前某行 "地址,端口" 相同，模拟多节点分片导出的重叠
+typedef struct {
+    wchar_t** source;
+    wchar_t** work;
+    int count;
+} DedupeBench;
+
+static long long bench_sort_dedupe(void* ctx, long long* check) {
+    DedupeBench* b = (DedupeBench*)ctx;
+    memcpy(b->work, b->source, sizeof(wchar_t*) * b->count);
+    *check = result_sort_dedupe(b->work, b->count);
+    return b->count;
+}
+
+static void run_micro_benchmarks(void) {
+    size_t logLen = 0;
+    char* log = build_log_text(BENCH_LOG_LINES, &logLen);
+    if (log) {
+        ExtractBench eb;
+        memset(&eb, 0, sizeof(eb));
+        eb.text = log;
+        eb.extract = extract_ipv4;
+        bench_run("extract_ipv4", bench_extract, &eb, NULL);
+        eb.extract = extract_ipv6;
+        bench_run("extract_ipv6", bench_extract, &eb, NULL);
+        eb.extract = extract_domains;
+        bench_run("extract_domains", bench_extract, &eb, NULL);
+        free(log);
+    }
+
+    if (bench_selected("geo_lookup")) {
+        GeoBench* g = (GeoBench*)malloc(sizeof(GeoBench));
+        if (g) {
+            ipv4_init_qqwry();
+            char note[64];
+            wchar_t probe[64];
+            ipv4_get_location("1.1.1.1", probe, 64);
+            const char* db = "qqwry.dat";
+            if (wcslen(probe) == 0) {
+                db = "synthetic";
+                load_synthetic_qqwry();
+            }
+            for (int i = 0; i < BENCH_GEO_IPS; i++) {
+                unsigned int ip = bench_rand();
+                snprintf(g->ips[i], sizeof(g->ips[i]), "%u.%u.%u.%u", ip >> 24, (ip >> 16) & 255, (ip >> 8) & 255, ip & 255);
+            }
+            snprintf(note, sizeof(note), ",\"db\":\"%s\"", db);
+            bench_run("geo_lookup", bench_geo, g, note);
+            ipv4_cleanup_qqwry();
+            free(g);
+        }
+    }
+
+    bench_run("parse_ports", bench_parse_ports, NULL, NULL);
+
+    SplitBench sb;
+    sb.text = bench_selected("split_hosts") ? build_host_text(BENCH_HOST_TOKENS) : NULL;
+    if (sb.text) {
+        bench_run("split_hosts", bench_split_hosts, &sb, NULL);
+        free(sb.text);
+    }
+
+    if (bench_selected("result_sort_dedupe")) {
+        DedupeBench db;
+        db.count = BENCH_RESULT_ROWS;
+        db.source = (wchar_t**)calloc(db.count, sizeof(wchar_t*));
+        db.work = (wchar_t**)malloc(sizeof(wchar_t*) * db.count);
+        int built = 0;
+        if (db.source && db.work) {
+            wchar_t line[128];
+            for (; built < db.count; built++) {
+                unsigned int r = bench_rand();
+                unsigned int host = (built > 0 && r % 4 == 0) ? bench_rand() % (unsigned int)built : (unsigned int)built;
+                swprintf(line, 128, L"10.%u.%u.%u,%u,开放,%u ms,HTTP,", (host >> 16) & 255, (host >> 8) & 255, host & 255,
+                         host % 7 == 0 ? 443 : 80, r % 500);
+                size_t len = wcslen(line) + 1;
+                db.source[built] = (wchar_t*)malloc(len * sizeof(wchar_t));
+                if (db.source[built]) memcpy(db.source[built], line, len * sizeof(wchar_t));
+                if (!db.source[built]) break;
+            }
+            if (built == db.count) bench_run("result_sort_dedupe", bench_sort_dedupe, &db, NULL);
+        }
+        if (db.source) for (int i = 0; i < built; i++) free(db.source[i]);
+        free(db.source);
+        free(db.work);
+    }
+}
+
+// 监听者绑定在 0.0.0.0，对所有回环地址生效；积压队列足够容纳全部轮次的连接，无需 accept
+static int open_listeners(SOCKET* socks) {
+    int n = 0;
+    for (int i = 0; i < BENCH_PORTS; i += BENCH_LISTEN_EVERY) {
+        SOCKET s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (s == INVALID_SOCKET) continue;
+        int on = 1;
+        setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const char*)&on, sizeof(on));
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons((unsigned short)(BENCH_PORT_BASE + i));
+        if (bind(s, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(s, 4096) != 0) {
+            closesocket(s);
+            continue;
+        }
+        socks[n++] = s;
+    }
+    return n;
+}
+
+// --- 大量挂起探测下的扫描 ---
+// 监听队列只容纳两个连接并由本进程占满，之后对该端口的 SYN 一律被内核丢弃
+static SOCKET open_blackhole(SOCKET* holders) {
+    SOCKET s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (s == INVALID_SOCKET) return s;
+    int on = 1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const char*)&on, sizeof(on));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(BENCH_PENDING_PORT);
+    if (bind(s, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(s, 1) != 0) {
+        closesocket(s);
+        return INVALID_SOCKET;
+    }
+    addr.sin_addr.s_addr = htonl(0x7F000001u);
+    for (int i = 0; i < 2; i++) {
+        holders[i] = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (holders[i] != INVALID_SOCKET) connect(holders[i], (struct sockaddr*)&addr, sizeof(addr));
+    }
+    return s;
+}
+
+typedef struct {
+    BenchScan scan;
+    int pendingCursor;
+    unsigned long long start;
+    unsigned long long lastDone;    // 最后一个非挂起探测完成的时间
+} BenchPending;
+
+// 先发出全部挂起探测，再扫描 loopback_scan 的端口组
+static int bench_pending_next(void* ctx, int* target, int* port) {
+    BenchPending* b = (BenchPending*)ctx;
+    if (b->pendingCursor < BENCH_PENDING_HOSTS) {
+        *target = BENCH_HOSTS + b->pendingCursor++;
+        *port = BENCH_PENDING_PORT;
+        return 1;
+    }
+    return bench_scan_next(&b->scan, target, port);
+}
+
+static void on_bench_pending_result(void* ctx, int target, int port, int state, const char* data, int len) {
+    BenchPending* b = (BenchPending*)ctx;
+    on_bench_scan_result(&b->scan, target, port, state, data, len);
+    if (target < BENCH_HOSTS) b->lastDone = platform_tick_us();
+}
+
+static void bench_loopback_pending(int backend, int rounds, int listeners) {
+    int count = BENCH_HOSTS + BENCH_PENDING_HOSTS;
+    ProbeTarget* targets = (ProbeTarget*)calloc(count, sizeof(ProbeTarget));
+    double* pps = (double*)malloc(sizeof(double) * rounds);
+    if (!targets || !pps) { free(targets); free(pps); return; }
+    for (int i = 0; i < count; i++) {
+        targets[i].family = 4;
+        targets[i].addr.v4.sin_family = AF_INET;
+        targets[i].addr.v4.sin_addr.s_addr = htonl(i < BENCH_HOSTS ? 0x7F000001u + i : 0x7F010000u + (i - BENCH_HOSTS));
+    }
+
+    BenchPending last;
+    memset(&last, 0, sizeof(last));
+    for (int r = 0; r < rounds; r++) {
+        BenchPending b;
+        memset(&b, 0, sizeof(b));
+        b.scan.total = BENCH_HOSTS * BENCH_PORTS;
+
+        ProbeEngineConfig cfg;
+        memset(&cfg, 0, sizeof(cfg));
+        cfg.targets = targets;
+        cfg.targetCount = count;
+        cfg.proto = PROBE_TCP;
+        cfg.maxInFlight = BENCH_PENDING_INFLIGHT;
+        cfg.timeoutMs = BENCH_PENDING_TIMEOUT;
+        cfg.minTimeoutMs = BENCH_PENDING_TIMEOUT;
+        cfg.backend = backend;
+        cfg.next = bench_pending_next;
+        cfg.onResult = on_bench_pending_result;
+        cfg.ctx = &b;
+
+        b.start = platform_tick_us();
+        engine_run(&cfg);
+        pps[r] = b.lastDone > b.start ? b.scan.total * 1000000.0 / (b.lastDone - b.start) : 0;
+        last = b;
+    }
+    qsort(pps, rounds, sizeof(double), compare_double);
+
+    // pps 只计 loopback_scan 那一组端口：挂起探测要等满超时，计入的话只反映超时设置
+    printf("{\"bench\":\"loopback_pending\",\"backend\":\"%s\",\"inflight\":%d,\"pending\":%d,\"probes\":%d,"
+           "\"open\":%lld,\"closed\":%lld,\"filtered\":%lld,\"expected_open\":%d,"
+           "\"rounds\":%d,\"pps_median\":%.0f,\"pps_best\":%.0f}\n",
+           backend_name(backend), BENCH_PENDING_INFLIGHT, BENCH_PENDING_HOSTS, BENCH_HOSTS * BENCH_PORTS,
+           last.scan.open, last.scan.closed, last.scan.filtered, listeners * BENCH_HOSTS,
+           rounds, pps[rounds / 2], pps[rounds - 1]);
+    fflush(stdout);
+    free(pps);
+    free(targets);
+}
+
+// --- 代理检测校验 ---
+// 替身代理在独立线程上逐个处理连接：按首字节区分 SOCKS5 (0x05)、SOCKS4 (0x04) 与 HTTP CONNECT，
+// 不支持的协议直接断开；握手中请求的目标须与配置的测试目标一致，随后代替目标站点应答测试请求
+typedef struct {
+    SOCKET listeners[BENCH_PROXY_STANDINS];
+    int accepts[BENCH_PROXY_STANDINS];      // 各替身支持的协议，PROXY_BIT 的按位或
+    struct sockaddr_in target;
+    volatile int stop;
+    int mismatches;                         // 请求的目标与测试目标不符的次数
+    int progress;                           // 最后一次进度回调的完成数，应等于总尝试数
+    int progressTotal;
+} ProxyStandin;
+
+// 读到至少 need 字节 (need 为 0 时读到 HTTP 头结束)，最多等 1 秒；成功返回 1
+static int standin_fill(SOCKET s, char* buf, int cap, int* len, int need) {
+    for (;;) {
+        buf[*len] = 0;
+        if (need > 0 ? *len >= need : strstr(buf, "\r\n\r\n") != NULL) return 1;
+        fd_set fds;
+        FD_ZERO(&fds);
+        FD_SET(s, &fds);
+        struct timeval tv = { 1, 0 };
+        if (select((int)s + 1, &fds, NULL, NULL, &tv) <= 0) return 0;
+        int n = recv(s, buf + *len, cap - 1 - *len, 0);
+        if (n <= 0) return 0;
+        *len += n;
+    }
+}
+
+static void standin_serve(ProxyStandin* st, SOCKET s, int accepts) {
+    char buf[512];
+    int len = 0;
+    const unsigned char* b = (const unsigned char*)buf;
+    unsigned short port = ntohs(st->target.sin_port);
+    if (!standin_fill(s, buf, sizeof(buf), &len, 1)) return;
+
+    if (b[0] == 0x05) {
+        if (!(accepts & PROXY_BIT(PROXY_SOCKS5)) || !standin_fill(s, buf, sizeof(buf), &len, 3)) return;
+        send(s, "\x05\x00", 2, PLATFORM_SEND_FLAGS);
+        len = 0;
+        if (!standin_fill(s, buf, sizeof(buf), &len, 10)) return;
+        if (b[3] != 0x01 || memcmp(b + 4, &st->target.sin_addr.s_addr, 4) != 0 || (b[8] << 8 | b[9]) != port) { st->mismatches++; return; }
+        send(s, "\x05\x00\x00\x01\x00\x00\x00\x00\x00\x00", 10, PLATFORM_SEND_FLAGS);
+    } else if (b[0] == 0x04) {
+        if (!(accepts & PROXY_BIT(PROXY_SOCKS4)) || !standin_fill(s, buf, sizeof(buf), &len, 9)) return;
+        if (memcmp(b + 4, &st->target.sin_addr.s_addr, 4) != 0 || (b[2] << 8 | b[3]) != port) { st->mismatches++; return; }
+        send(s, "\x00\x5A\x00\x00\x00\x00\x00\x00", 8, PLATFORM_SEND_FLAGS);
+    } else {
+        char expect[64];
+        snprintf(expect, sizeof(expect), "CONNECT %s:%d ", BENCH_PROXY_TARGET, port);
+        if (!(accepts & PROXY_BIT(PROXY_HTTP)) || !standin_fill(s, buf, sizeof(buf), &len, 0)) return;
+        if (strncmp(buf, expect, strlen(expect)) != 0) { st->mismatches++; return; }
+        static const char established[] = "HTTP/1.1 200 Connection established\r\n\r\n";
+        send(s, established, sizeof(established) - 1, PLATFORM_SEND_FLAGS);
+    }
+
+    // 隧道已 "打通"：代替测试目标应答经隧道发来的请求
+    len = 0;
+    if (!standin_fill(s, buf, sizeof(buf), &len, 0)) return;
+    static const char response[] = "HTTP/1.1 204 No Content\r\nConnection: close\r\n\r\n";
+    send(s, response, sizeof(response) - 1, PLATFORM_SEND_FLAGS);
+}
+
+static void standin_loop(ProxyStandin* st) {
+    while (!st->stop) {
+        fd_set fds;
+        FD_ZERO(&fds);
+        SOCKET maxFd = 0;
+        for (int i = 0; i < BENCH_PROXY_STANDINS; i++) {
+            FD_SET(st->listeners[i], &fds);
+            if (st->listeners[i] > maxFd) maxFd = st->listeners[i];
+        }
+        struct timeval tv = { 0, 50000 };
+        if (select((int)maxFd + 1, &fds, NULL, NULL, &tv) <= 0) continue;
+        for (int i = 0; i < BENCH_PROXY_STANDINS; i++) {
+            if (!FD_ISSET(st->listeners[i], &fds)) continue;
+            SOCKET s = accept(st->listeners[i], NULL, NULL);
+            if (s == INVALID_SOCKET) continue;
+            standin_serve(st, s, st->accepts[i]);
+            closesocket(s);
+        }
+    }
+}
+
+#ifdef _WIN32
+static unsigned int __stdcall standin_thread(void* arg) {
+    standin_loop((ProxyStandin*)arg);
+    return 0;
+}
+#else
+static void* standin_thread(void* arg) {
+    standin_loop((ProxyStandin*)arg);
+    return NULL;
+}
+#endif
+
+static void on_bench_proxy_progress(void* ctx, int done, int total) {
+    ProxyStandin* st = (ProxyStandin*)ctx;
+    st->progress = done;
+    st->progressTotal = total;
+}
+
+// 绑定 127.0.0.1 的随机端口，port 写回实际端口
+static SOCKET open_loopback_listener(int* port) {
+    SOCKET s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (s == INVALID_SOCKET) return s;
+    struct sockaddr_in addr;
+    socklen_t addrLen = sizeof(addr);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(0x7F000001u);
+    if (bind(s, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(s, 64) != 0 ||
+        getsockname(s, (struct sockaddr*)&addr, &addrLen) != 0) {
+        closesocket(s);
+        return INVALID_SOCKET;
+    }
+    *port = ntohs(addr.sin_port);
+    return s;
+}
+
+// 候选依次为：只支持 HTTP CONNECT、只支持 SOCKS5、同时支持 SOCKS4 与 SOCKS5 的替身，以及一个无人监听的端口；
+// 各候选通过的协议集合须与替身一致，进度须走到全部尝试数。返回 0 表示不符
+static int bench_proxy_loopback(void) {
+    static const int accepts[BENCH_PROXY_STANDINS] = {
+        PROXY_BIT(PROXY_HTTP), PROXY_BIT(PROXY_SOCKS5), PROXY_BIT(PROXY_SOCKS4) | PROXY_BIT(PROXY_SOCKS5)
+    };
+    ProxyStandin st;
+    // 末尾另有一个未解析的候选 (family 为 0)，不创建 socket 即以失败计入进度
+    ProbeTarget proxies[BENCH_PROXY_STANDINS + 2];
+    ProxyCheckResult results[BENCH_PROXY_STANDINS + 2];
+    int ports[BENCH_PROXY_STANDINS + 1];
+    int opened = 0;
+    memset(&st, 0, sizeof(st));
+    memset(proxies, 0, sizeof(proxies));
+    for (; opened < BENCH_PROXY_STANDINS + 1; opened++) {
+        SOCKET s = open_loopback_listener(&ports[opened]);
+        if (s == INVALID_SOCKET) break;
+        // 最后一个端口拿到后立即关闭，用作拒绝连接的候选
+        if (opened == BENCH_PROXY_STANDINS) closesocket(s);
+        else {
+            st.listeners[opened] = s;
+            st.accepts[opened] = accepts[opened];
+        }
+        proxies[opened].family = 4;
+        proxies[opened].addr.v4.sin_family = AF_INET;
+        proxies[opened].addr.v4.sin_addr.s_addr = htonl(0x7F000001u);
+        proxies[opened].addr.v4.sin_port = htons((unsigned short)ports[opened]);
+    }
+    st.target.sin_family = AF_INET;
+    st.target.sin_addr.s_addr = inet_addr(BENCH_PROXY_TARGET);
+    st.target.sin_port = htons(BENCH_PROXY_TARGET_PORT);
+
+    int pass = 0, started = 0;
+    unsigned long long elapsed = 0;
+    if (opened == BENCH_PROXY_STANDINS + 1) {
+#ifdef _WIN32
+        HANDLE thread = (HANDLE)_beginthreadex(NULL, 0, standin_thread, &st, 0, NULL);
+        started = thread != NULL;
+#else
+        pthread_t thread;
+        started = pthread_create(&thread, NULL, standin_thread, &st) == 0;
+#endif
+        if (started) {
+            ProxyCheckConfig cfg;
+            memset(&cfg, 0, sizeof(cfg));
+            cfg.proxies = proxies;
+            cfg.proxyCount = BENCH_PROXY_STANDINS + 2;
+            cfg.testAddr = st.target;
+            cfg.testHost = BENCH_PROXY_TARGET;
+            cfg.timeoutMs = 2000;
+            cfg.maxInFlight = 2;    // 窗口小，未解析的候选在其余尝试都结束后才轮到，进度只能由它自己报到最后
+            cfg.onProgress = on_bench_proxy_progress;
+            cfg.ctx = &st;
+            unsigned long long start = platform_tick_us();
+            proxy_check_run(&cfg, results);
+            elapsed = platform_tick_us() - start;
+
+            st.stop = 1;
+#ifdef _WIN32
+            WaitForSingleObject(thread, INFINITE);
+            CloseHandle(thread);
+#else
+            pthread_join(thread, NULL);
+#endif
+            // 失败的尝试同样要汇报进度，否则进度停在 100% 之前
+            pass = st.mismatches == 0 && results[BENCH_PROXY_STANDINS].protocols == 0 &&
+                   results[BENCH_PROXY_STANDINS + 1].protocols == 0 &&
+                   st.progressTotal > 0 && st.progress == st.progressTotal;
+            for (int i = 0; i < BENCH_PROXY_STANDINS; i++) {
+                if (results[i].protocols != accepts[i]) pass = 0;
+            }
+        }
+    }
+    for (int i = 0; i < opened && i < BENCH_PROXY_STANDINS; i++) closesocket(st.listeners[i]);
+    if (!started) {
+        printf("{\"bench\":\"proxy_loopback\",\"skipped\":true}\n");
+        return 1;
+    }
+
+    printf("{\"bench\":\"proxy_loopback\",\"http\":%d,\"socks5\":%d,\"socks4_socks5\":%d,\"refused\":%d,"
+           "\"mismatches\":%d,\"progress\":\"%d/%d\",\"ms\":%.1f,\"pass\":%s}\n",
+           results[0].protocols, results[1].protocols, results[2].protocols, results[3].protocols,
+           st.mismatches, st.progress, st.progressTotal, elapsed / 1000.0, pass ? "true" : "false");
+    fflush(stdout);
+    return pass;
+}
+
+// --- UDP 探测校验 ---
+// 在 127.0.0.1 上为载荷表中的端口各绑一个应答者，核对收到的请求与 udp_probe_payload 一致后回包；
+// 另有一个无专用载荷的应答端口 (收空报文)、几个收下请求却从不应答的静默端口和一段无人绑定的端口。
+// 应答端口应判为开放且带回应答内容，静默端口为 open|filtered，无人绑定的端口靠 ICMP 端口不可达判为关闭。
+// 静默端口放在 127.0.0.2：同一主机回过 ICMP 又沉默时引擎按疑似限速多次重发，每轮会拖到十秒以上
+// 绑定不了的载荷端口 (1024 以下需要权限，或已被本机服务占用) 跳过并计入 skipped_ports
+static const int g_benchUdpPayloadPorts[] = { 53, 123, 137, 161, 1434, 1900, 5353, 11211 };
+#define BENCH_UDP_PAYLOAD_PORTS ((int)(sizeof(g_benchUdpPayloadPorts) / sizeof(g_benchUdpPayloadPorts[0])))
+#define BENCH_UDP_MAX_BOUND     (BENCH_UDP_PAYLOAD_PORTS + 1 + BENCH_UDP_SILENT)
+
+typedef struct {
+    SOCKET socks[BENCH_UDP_MAX_BOUND];
+    int ports[BENCH_UDP_MAX_BOUND];
+    int answers[BENCH_UDP_MAX_BOUND];   // 0 = 静默端口
+    int count;
+    volatile int stop;
+    int mismatches;                     // 请求内容与该端口的探测载荷不符的次数
+} UdpResponder;
+
+typedef struct {
+    const int* hosts;                   // 0 = 127.0.0.1，1 = 127.0.0.2
+    const int* ports;
+    const int* expect;                  // 各端口应得的状态
+    int count;
+    int cursor;
+    long long open;
+    long long closed;
+    long long filtered;
+    long long wrong;                    // 状态或应答内容与预期不符的次数
+} BenchUdp;
+
+// 应答内容带上端口号，扫描端据此确认回包来自对应端口
+static int udp_answer(int port, char* buf, int cap) {
+    return snprintf(buf, cap, "bench-udp %d", port);
+}
+
+static void udp_responder_loop(UdpResponder* r) {
+    while (!r->stop) {
+        fd_set fds;
+        FD_ZERO(&fds);
+        SOCKET maxFd = 0;
+        for (int i = 0; i < r->count; i++) {
+            FD_SET(r->socks[i], &fds);
+            if (r->socks[i] > maxFd) maxFd = r->socks[i];
+        }
+        struct timeval tv = { 0, 50000 };
+        if (select((int)maxFd + 1, &fds, NULL, NULL, &tv) <= 0) continue;
+        for (int i = 0; i < r->count; i++) {
+            if (!FD_ISSET(r->socks[i], &fds)) continue;
+            char buf[1500], reply[32];
+            struct sockaddr_in from;
+            socklen_t fromLen = sizeof(from);
+            int n = recvfrom(r->socks[i], buf, sizeof(buf), 0, (struct sockaddr*)&from, &fromLen);
+            if (n < 0) continue;
+            int len = 0;
+            const char* payload = udp_probe_payload(r->ports[i], &len);
+            if (n != len || memcmp(buf, payload, len) != 0) { r->mismatches++; continue; }
+            if (!r->answers[i]) continue;
+            int replyLen = udp_answer(r->ports[i], reply, sizeof(reply));
+            sendto(r->socks[i], reply, replyLen, 0, (struct sockaddr*)&from, fromLen);
+        }
+    }
+}
+
+#ifdef _WIN32
+static unsigned int __stdcall udp_responder_thread(void* arg) {
+    udp_responder_loop((UdpResponder*)arg);
+    return 0;
+}
+#else
+static void* udp_responder_thread(void* arg) {
+    udp_responder_loop((UdpResponder*)arg);
+    return NULL;
+}
+#endif
+
+static SOCKET open_udp_port(int host, int port) {
+    SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s == INVALID_SOCKET) return s;
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(0x7F000001u + host);
+    addr.sin_port = htons((unsigned short)port);
+    if (bind(s, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        closesocket(s);
+        return INVALID_SOCKET;
+    }
+    return s;
+}
+
+static int bench_udp_next(void* ctx, int* target, int* port) {
+    BenchUdp* b = (BenchUdp*)ctx;
+    if (b->cursor >= b->count) return 0;
+    *target = b->hosts[b->cursor];
+    *port = b->ports[b->cursor++];
+    return 1;
+}
+
+static void on_bench_udp_result(void* ctx, int target, int port, int state, const char* data, int len) {
+    BenchUdp* b = (BenchUdp*)ctx;
+    if (state == PROBE_OPEN) b->open++;
+    else if (state == PROBE_CLOSED) b->closed++;
+    else b->filtered++;
+    int i = 0;
+    while (i < b->count && (b->hosts[i] != target || b->ports[i] != port)) i++;
+    if (i == b->count || state != b->expect[i]) { b->wrong++; return; }
+    if (state == PROBE_OPEN) {
+        char reply[32];
+        int replyLen = udp_answer(port, reply, sizeof(reply));
+        if (len != replyLen || memcmp(data, reply, replyLen) != 0) b->wrong++;
+    }
+}
+
+// 返回 0 表示分类或载荷不符
+static int bench_udp_loopback(int backend, int inflight, int rounds) {
+    UdpResponder r;
+    int hosts[BENCH_UDP_MAX_BOUND + BENCH_UDP_CLOSED];
+    int ports[BENCH_UDP_MAX_BOUND + BENCH_UDP_CLOSED];
+    int expect[BENCH_UDP_MAX_BOUND + BENCH_UDP_CLOSED];
+    int count = 0, skipped = 0, answering = 0, silent = 0;
+    memset(&r, 0, sizeof(r));
+    for (int i = 0; i < BENCH_UDP_PAYLOAD_PORTS + 1 + BENCH_UDP_SILENT; i++) {
+        // 依次为：载荷表中的端口、无专用载荷的应答端口、静默端口
+        int port = i < BENCH_UDP_PAYLOAD_PORTS ? g_benchUdpPayloadPorts[i] : BENCH_UDP_BASE + i - BENCH_UDP_PAYLOAD_PORTS;
+        int answers = i <= BENCH_UDP_PAYLOAD_PORTS;
+        SOCKET s = open_udp_port(!answers, port);
+        if (s == INVALID_SOCKET) { skipped++; continue; }
+        r.socks[r.count] = s;
+        r.ports[r.count] = port;
+        r.answers[r.count++] = answers;
+        hosts[count] = !answers;
+        ports[count] = port;
+        expect[count++] = answers ? PROBE_OPEN : PROBE_FILTERED;
+        if (answers) answering++;
+        else silent++;
+    }
+    for (int i = 0; i < BENCH_UDP_CLOSED; i++) {
+        hosts[count] = 0;
+        ports[count] = BENCH_UDP_BASE + BENCH_UDP_MAX_BOUND + i;
+        expect[count++] = PROBE_CLOSED;
+    }
+
+    ProbeTarget targets[2];
+    memset(targets, 0, sizeof(targets));
+    for (int i = 0; i < 2; i++) {
+        targets[i].family = 4;
+        targets[i].addr.v4.sin_family = AF_INET;
+        targets[i].addr.v4.sin_addr.s_addr = htonl(0x7F000001u + i);
+    }
+
+    int started = 0;
+#ifdef _WIN32
+    HANDLE thread = (HANDLE)_beginthreadex(NULL, 0, udp_responder_thread, &r, 0, NULL);
+    started = thread != NULL;
+#else
+    pthread_t thread;
+    started = pthread_create(&thread, NULL, udp_responder_thread, &r) == 0;
+#endif
+    double* ms = (double*)malloc(sizeof(double) * rounds);
+    BenchUdp last;
+    long long wrong = 0;
+    memset(&last, 0, sizeof(last));
+    for (int round = 0; started && ms && round < rounds; round++) {
+        BenchUdp b;
+        memset(&b, 0, sizeof(b));
+        b.hosts = hosts;
+        b.ports = ports;
+        b.expect = expect;
+        b.count = count;
+
+        ProbeEngineConfig cfg;
+        memset(&cfg, 0, sizeof(cfg));
+        cfg.targets = targets;
+        cfg.targetCount = 2;
+        cfg.proto = PROBE_UDP;
+        cfg.maxInFlight = inflight;
+        cfg.timeoutMs = BENCH_UDP_TIMEOUT;
+        cfg.minTimeoutMs = BENCH_UDP_TIMEOUT;
+        cfg.udpRetries = 1;
+        cfg.backend = backend;
+        cfg.next = bench_udp_next;
+        cfg.onResult = on_bench_udp_result;
+        cfg.ctx = &b;
+
+        unsigned long long start = platform_tick_us();
+        engine_run(&cfg);
+        ms[round] = (platform_tick_us() - start) / 1000.0;
+        wrong += b.wrong;
+        last = b;
+    }
+    if (started) {
+        r.stop = 1;
+#ifdef _WIN32
+        WaitForSingleObject(thread, INFINITE);
+        CloseHandle(thread);
+#else
+        pthread_join(thread, NULL);
+#endif
+    }
+    for (int i = 0; i < r.count; i++) closesocket(r.socks[i]);
+    if (!started || !ms) {
+        printf("{\"bench\":\"udp_loopback\",\"backend\":\"%s\",\"skipped\":true}\n", backend_name(backend));
+        free(ms);
+        return 1;
+    }
+    qsort(ms, rounds, sizeof(double), compare_double);
+
+    // 静默端口要等满 (重发次数 + 1) 个超时，耗时主要由它决定
+    int pass = wrong == 0 && r.mismatches == 0;
+    printf("{\"bench\":\"udp_loopback\",\"backend\":\"%s\",\"probes\":%d,\"open\":%lld,\"closed\":%lld,\"filtered\":%lld,"
+           "\"expected_open\":%d,\"expected_closed\":%d,\"expected_filtered\":%d,\"skipped_ports\":%d,"
+           "\"wrong\":%lld,\"payload_mismatches\":%d,\"rounds\":%d,\"ms_median\":%.1f,\"pass\":%s}\n",
+           backend_name(backend), count, last.open, last.closed, last.filtered,
+           answering, BENCH_UDP_CLOSED, silent, skipped,
+           wrong, r.mismatches, rounds, ms[rounds / 2], pass ? "true" : "false");
+    fflush(stdout);
+    free(ms);
+    return pass;
+}
+
+// --- SYN 扫描校验 ---
+typedef struct {
+    long long open;
+    long long closed;
+} BenchSyn;
+
+static void on_bench_syn_result(void* ctx, int ipIndex, int port, int state) {
+    BenchSyn* b = (BenchSyn*)ctx;
+    (void)ipIndex; (void)port;
+    if (state == SYN_STATE_OPEN) b->open++;
+    else b->closed++;
+}
+
+// 对 127.0.0.1 的全部基准端口发 SYN：监听端口应回 SYN-ACK，其余回 RST，不应有遗漏；返回 0 表示不符
+static int bench_syn_loopback(int listeners) {
+    if (!syn_scan_available()) {
+        printf("{\"bench\":\"syn_loopback\",\"skipped\":true}\n");
+        return 1;
+    }
+    static int ports[BENCH_PORTS];
+    for (int i = 0; i < BENCH_PORTS; i++) ports[i] = BENCH_PORT_BASE + i;
+    unsigned long ip = htonl(0x7F000001u);
+
+    BenchSyn b;
+    memset(&b, 0, sizeof(b));
+    SynScanConfig cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.ips = &ip;
+    cfg.ipCount = 1;
+    cfg.ports = ports;
+    cfg.portCount = BENCH_PORTS;
+    cfg.waitMs = 500;
+    cfg.seed = 1;
+    cfg.onResult = on_bench_syn_result;
+    cfg.ctx = &b;
+
+    unsigned long long start = platform_tick_us();
+    int sent = syn_scan_run(&cfg);
+    unsigned long long elapsed = platform_tick_us() - start;
+    int pass = sent == BENCH_PORTS && b.open == listeners && b.closed == BENCH_PORTS - listeners;
+    printf("{\"bench\":\"syn_loopback\",\"sent\":%d,\"open\":%lld,\"closed\":%lld,"
+           "\"expected_open\":%d,\"expected_closed\":%d,\"ms\":%.1f,\"pass\":%s}\n",
+           sent, b.open, b.closed, listeners, BENCH_PORTS - listeners, elapsed / 1000.0, pass ? "true" : "false");
+    fflush(stdout);
+    return pass;
+}
+
+static void bench_loopback_scan(int backend, int inflight, int rounds, int listeners) {
+    ProbeTarget targets[BENCH_HOSTS];
+    memset(targets, 0, sizeof(targets));
+    for (int i = 0; i < BENCH_HOSTS; i++) {
+        targets[i].family = 4;
+        targets[i].addr.v4.sin_family = AF_INET;
+        targets[i].addr.v4.sin_addr.s_addr = htonl(0x7F000001u + i);
+    }
+
+    double* pps = (double*)malloc(sizeof(double) * rounds);
+    BenchScan last;
+    memset(&last, 0, sizeof(last));
+    if (!pps) return;
+    for (int r = 0; r < rounds; r++) {
+        BenchScan b;
+        memset(&b, 0, sizeof(b));
+        b.total = BENCH_HOSTS * BENCH_PORTS;
+
+        ProbeEngineConfig cfg;
+        memset(&cfg, 0, sizeof(cfg));
+        cfg.targets = targets;
+        cfg.targetCount = BENCH_HOSTS;
+        cfg.proto = PROBE_TCP;
+        cfg.maxInFlight = inflight;
+        cfg.timeoutMs = 1000;
+        cfg.minTimeoutMs = 1000;
+        cfg.backend = backend;
+        cfg.next = bench_scan_next;
+        cfg.onResult = on_bench_scan_result;
+        cfg.ctx = &b;
+
+        unsigned long long start = platform_tick_us();
+        engine_run(&cfg);
+        unsigned long long elapsed = platform_tick_us() - start;
+        pps[r] = elapsed ? b.total * 1000000.0 / elapsed : 0;
+        last = b;
+    }
+    qsort(pps, rounds, sizeof(double), compare_double);
+
+    // open 应等于 监听端口数 x 主机数，其余为 closed；filtered 非零说明本地资源不足或丢包
+    printf("{\"bench\":\"loopback_scan\",\"backend\":\"%s\",\"inflight\":%d,\"probes\":%d,"
+           "\"open\":%lld,\"closed\":%lld,\"filtered\":%lld,\"expected_open\":%d,"
+           "\"rounds\":%d,\"pps_median\":%.0f,\"pps_best\":%.0f}\n",
+           backend_name(backend), inflight, BENCH_HOSTS * BENCH_PORTS,
+           last.open, last.closed, last.filtered, listeners * BENCH_HOSTS,
+           rounds, pps[rounds / 2], pps[rounds - 1]);
+    fflush(stdout);
+    free(pps);
+}
+
+int main(int argc, char** argv) {
+    int inflight = BENCH_DEFAULT_INFLIGHT;
+    const char* only = NULL;        // 只运行指定后端
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--inflight")) inflight = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--rounds")) g_rounds = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--backend")) only = argv[i + 1];
+        else if (!strcmp(argv[i], "--filter")) g_filter = argv[i + 1];
+    }
+    if (inflight <= 0) inflight = BENCH_DEFAULT_INFLIGHT;
+    if (g_rounds <= 0) g_rounds = BENCH_DEFAULT_ROUNDS;
+
+#ifdef _WIN32
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) return 1;
+#endif
+
+    run_micro_benchmarks();
+
+    int rc = 0;
+    if (bench_selected("proxy_loopback") && !bench_proxy_loopback()) rc = 1;
+
+    if (bench_selected("udp_loopback")) {
+        static const int backends[] = { PROBE_BACKEND_SELECT, PROBE_BACKEND_EPOLL };
+        for (int i = 0; i < (int)(sizeof(backends) / sizeof(backends[0])); i++) {
+            if (only && strcmp(only, backend_name(backends[i])) != 0) continue;
+            if (!engine_backend_available(backends[i])) {
+                printf("{\"bench\":\"udp_loopback\",\"backend\":\"%s\",\"skipped\":true}\n", backend_name(backends[i]));
+                continue;
+            }
+            if (!bench_udp_loopback(backends[i], inflight, g_rounds)) rc = 1;
+        }
+    }
+
+    if (bench_selected("loopback_scan") || bench_selected("loopback_pending") || bench_selected("syn_loopback")) {
+        SOCKET listeners[BENCH_PORTS / BENCH_LISTEN_EVERY];
+        int listenerCount = open_listeners(listeners);
+
+        // 先于连接扫描运行，监听队列中还没有积压的连接
+        if (bench_selected("syn_loopback") && !bench_syn_loopback(listenerCount)) rc = 1;
+
+        if (bench_selected("loopback_scan")) {
+            static const int backends[] = { PROBE_BACKEND_SELECT, PROBE_BACKEND_EPOLL, PROBE_BACKEND_URING };
+            for (int i = 0; i < (int)(sizeof(backends) / sizeof(backends[0])); i++) {
+                if (only && strcmp(only, backend_name(backends[i])) != 0) continue;
+                if (!engine_backend_available(backends[i])) {
+                    printf("{\"bench\":\"loopback_scan\",\"backend\":\"%s\",\"skipped\":true}\n", backend_name(backends[i]));
+                    continue;
+                }
+                bench_loopback_scan(backends[i], inflight, g_rounds, listenerCount);
+            }
+        }
+
+        if (bench_selected("loopback_pending")) {
+            SOCKET holders[2] = { INVALID_SOCKET, INVALID_SOCKET };
+            SOCKET blackhole = open_blackhole(holders);
+            static const int backends[] = { PROBE_BACKEND_EPOLL, PROBE_BACKEND_URING };
+            for (int i = 0; blackhole != INVALID_SOCKET && i < (int)(sizeof(backends) / sizeof(backends[0])); i++) {
+                if (only && strcmp(only, backend_name(backends[i])) != 0) continue;
+                if (!engine_backend_available(backends[i])) {
+                    printf("{\"bench\":\"loopback_pending\",\"backend\":\"%s\",\"skipped\":true}\n", backend_name(backends[i]));
+                    continue;
+                }
+                bench_loopback_pending(backends[i], g_rounds, listenerCount);
+            }
+            for (int i = 0; i < 2; i++) if (holders[i] != INVALID_SOCKET) closesocket(holders[i]);
+            if (blackhole != INVALID_SOCKET) closesocket(blackhole);
+        }
+
+        for (int i = 0; i < listenerCount; i++) closesocket(listeners[i]);
+    }
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    return rc;
+}
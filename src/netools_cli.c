@@ -0,0 +1,880 @@
+#include "network_modules.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+
+#ifndef _WIN32
+#include <netdb.h>
+#endif
+
+// --- 命令行前端 (无界面) ---
+// 复用与 GUI 相同的探测引擎与文本提取模块，结果以 NDJSON 或 CSV 逐行写到标准输出，
+// 便于接入管道与脚本。用法见 print_usage()。
+
+#define CLI_OUT_BUF     65536
+#define CLI_MAX_INFLIGHT 256
+
+static volatile sig_atomic_t g_interrupted = 0;
+
+// 探测模块通过此函数检查中止 (GUI 中由 network_tools.c 提供)
+int is_task_stopped() {
+    return g_interrupted;
+}
+
+static void on_sigint(int sig) {
+    (void)sig;
+    g_interrupted = 1;
+}
+
+// --- 输出 ---
+// 缓冲写出与转义由 network_output.c 提供，按行追加字段，写满或结束时整块 fwrite
+static RowWriter g_out;
+static ProbeSources g_sources;          // --source 解析结果
+
+// --- 输入 ---
+// 读入整个流 (目标列表或待提取文本)，调用方 free
+static char* read_stream(FILE* f) {
+    size_t cap = 65536, len = 0;
+    char* buf = (char*)malloc(cap);
+    while (buf) {
+        size_t n = fread(buf + len, 1, cap - len - 1, f);
+        len += n;
+        if (n == 0) break;
+        if (len + 1 == cap) {
+            char* grown = (char*)realloc(buf, cap * 2);
+            if (!grown) { free(buf); return NULL; }
+            buf = grown;
+            cap *= 2;
+        }
+    }
+    if (buf) buf[len] = 0;
+    return buf;
+}
+
+// 按空白与逗号原地切分，返回指向 text 内部的指针数组
+static char** split_tokens(char* text, int* count) {
+    int n = 0, cap = 64;
+    char** list = (char**)malloc(sizeof(char*) * cap);
+    char* p = text;
+    while (list && *p) {
+        while (*p && strchr(" \t\r\n,", *p)) *p++ = 0;
+        if (!*p) break;
+        if (n == cap) {
+            char** grown = (char**)realloc(list, sizeof(char*) * cap * 2);
+            if (!grown) break;
+            list = grown;
+            cap *= 2;
+        }
+        list[n++] = p;
+        while (*p && !strchr(" \t\r\n,", *p)) p++;
+    }
+    *count = list ? n : 0;
+    return list;
+}
+
+// 与 GUI 的 resolve_host 相同的策略：优先 IPv4，没有时取第一个 IPv6
+static int cli_resolve(const char* host, ProbeTarget* t) {
+    struct addrinfo hints, *result = NULL, *v6 = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    unsigned long long start = platform_tick_us();
+    int rc = getaddrinfo(host, NULL, &hints, &result);
+    metrics_add(METRIC_DNS_LOOKUPS, 1);
+    metrics_observe(METRIC_HIST_DNS, platform_tick_us() - start);
+    if (rc != 0) return 0;
+    t->family = 0;
+    for (struct addrinfo* ai = result; ai; ai = ai->ai_next) {
+        if (ai->ai_family == AF_INET) {
+            memcpy(&t->addr.v4, ai->ai_addr, sizeof(struct sockaddr_in));
+            t->family = 4;
+            break;
+        }
+        if (ai->ai_family == AF_INET6 && !v6) v6 = ai;
+    }
+    if (!t->family && v6) {
+        memcpy(&t->addr.v6, v6->ai_addr, sizeof(struct sockaddr_in6));
+        t->family = 6;
+    }
+    freeaddrinfo(result);
+    return t->family;
+}
+
+static void target_ip(const ProbeTarget* t, char* out, int outLen) {
+    out[0] = 0;
+    if (t->family == 4) inet_ntop(AF_INET, &t->addr.v4.sin_addr, out, outLen);
+    else if (t->family == 6) inet_ntop(AF_INET6, &t->addr.v6.sin6_addr, out, outLen);
+}
+
+// --- 选项 ---
+typedef struct {
+    const char* targetList;     // -t
+    const char* targetFile;     // -f
+    const char* ports;          // -p
+    int format;
+    int geo;
+    int udp;
+    int service;
+    int all;                    // scan 同时输出关闭与过滤的端口
+    int syn;                    // scan 的 IPv4 目标用 SYN 半开扫描 (需 CAP_NET_RAW，否则回退 connect)
+    int pps;
+    int timeoutMs;
+    int minTimeoutMs;
+    int subnetCap;
+    unsigned long long seed;
+    int shardIndex;
+    int shardCount;
+    int count;                  // ping 的探测次数
+    int port;                   // ping: TCP 端口 / trace: UDP 起始端口或 TCP 目标端口
+    int traceMode;
+    int backend;                // 探测引擎的 I/O 后端
+    const char* metricsFile;    // 结束时追加一行运行指标
+    const char* sourceSpec;     // --source 本机地址或网卡名列表
+    int sourceMode;             // PROBE_SOURCE_*
+    ProbeSources* sources;      // 解析后的源地址，NULL = 由系统选择
+    const char* baseline;       // scan 与此前的结果对比，只输出变化
+    const char* saveBaseline;   // scan 完成后写出本次开放端口的快照
+} CliOptions;
+
+static void print_usage() {
+    fputs(
+        "用法: netools_cli <命令> [选项]\n"
+        "\n"
+        "命令:\n"
+        "  scan     端口扫描 (connect / UDP)，默认只输出开放端口\n"
+        "  ping     批量 Ping；指定 --port 时改用 TCP 握手测延迟\n"
+        "  trace    并行路由追踪 (需原始套接字权限)\n"
+        "  extract  从 -f 指定的文件 (未指定时为标准输入) 提取 IPv4 / IPv6 / 域名\n"
+        "  export   把 GUI 的结果日志 (-f netools_results.dat) 转为 NDJSON / CSV，\n"
+        "           程序异常退出后也可用来找回已收到的结果\n"
+        "\n"
+        "目标 (scan / ping / trace):\n"
+        "  -t <列表>          以空格或逗号分隔的主机\n"
+        "  -f <文件>          每行一个主机；两者都未指定时从标准输入读取\n"
+        "\n"
+        "通用选项:\n"
+        "  --format ndjson|csv  输出格式 (默认 ndjson)\n"
+        "  --geo                附带 qqwry.dat 中的 IPv4 归属地\n"
+        "  --timeout <ms>       超时上限 (默认 1000)\n"
+        "  --backend auto|select|epoll|uring  探测引擎的 I/O 后端 (auto = epoll，Windows 为 select)；\n"
+        "                       uring 仅用于不抓 Banner 的 TCP 扫描，本机回环基准上未测得比 epoll 更快\n"
+        "  --metrics <文件>     结束时把运行指标 (计数与延迟直方图) 追加为一行 JSON\n"
+        "  --source <列表>      探测分摊到多个本机地址或网卡 (如 127.0.0.2,127.0.0.3 或 eth0)\n"
+        "  --source-mode rr|hash  按探测轮询 (默认) 或按目标哈希选择源地址\n"
+        "\n"
+        "scan:\n"
+        "  -p <端口>            如 top100,1-1024,!25 (默认 top100)\n"
+        "  --udp  --service  --all\n"
+        "  --syn                IPv4 目标改用 SYN 半开扫描 (需 root 或 CAP_NET_RAW，否则回退 connect)\n"
+        "  --pps <n>  --min-timeout <ms>  --subnet-cap <n>\n"
+        "  --seed <n>           探测顺序的置换种子 (默认随机)\n"
+        "  --shard <i>/<N>      只扫描第 i 片，共 N 片 (1 <= i <= N，与 GUI 的分片框相同)；\n"
+        "                       未给 --seed 时种子由目标与端口列表推导，各节点自动一致\n"
+        "  --baseline <文件>     与上次的结果 (NDJSON / CSV) 对比，先复查上次开放的端口，\n"
+        "                       只输出 new / closed / changed\n"
+        "  --save-baseline <文件>  扫描完成后写出本次开放端口的快照，供下次 --baseline 使用\n"
+        "\n"
+        "ping:   -c <次数> (默认 4)  --port <端口>\n"
+        "trace:  --mode icmp|udp|tcp  --port <端口>\n",
+        stderr);
+}
+
+// 解析选项，返回 0 表示参数有误
+static int parse_options(int argc, char** argv, CliOptions* o) {
+    memset(o, 0, sizeof(*o));
+    o->format = OUTPUT_NDJSON;
+    o->timeoutMs = 1000;
+    o->minTimeoutMs = 100;
+    o->count = 4;
+    o->traceMode = TRACE_ICMP;
+    for (int i = 0; i < argc; i++) {
+        const char* a = argv[i];
+        const char* v = (i + 1 < argc) ? argv[i + 1] : NULL;
+        int takesValue = 1;
+        if (!strcmp(a, "--geo")) { o->geo = 1; takesValue = 0; }
+        else if (!strcmp(a, "--udp")) { o->udp = 1; takesValue = 0; }
+        else if (!strcmp(a, "--service")) { o->service = 1; takesValue = 0; }
+        else if (!strcmp(a, "--all")) { o->all = 1; takesValue = 0; }
+        else if (!strcmp(a, "--syn")) { o->syn = 1; takesValue = 0; }
+        else if (!v) { fprintf(stderr, "未知选项或缺少参数: %s\n", a); return 0; }
+        else if (!strcmp(a, "-t")) o->targetList = v;
+        else if (!strcmp(a, "-f")) o->targetFile = v;
+        else if (!strcmp(a, "-p")) o->ports = v;
+        else if (!strcmp(a, "-c")) o->count = atoi(v);
+        else if (!strcmp(a, "--port")) o->port = atoi(v);
+        else if (!strcmp(a, "--pps")) o->pps = atoi(v);
+        else if (!strcmp(a, "--timeout")) o->timeoutMs = atoi(v);
+        else if (!strcmp(a, "--min-timeout")) o->minTimeoutMs = atoi(v);
+        else if (!strcmp(a, "--subnet-cap")) o->subnetCap = atoi(v);
+        else if (!strcmp(a, "--seed")) o->seed = strtoull(v, NULL, 10);
+        else if (!strcmp(a, "--metrics")) o->metricsFile = v;
+        else if (!strcmp(a, "--source")) o->sourceSpec = v;
+        else if (!strcmp(a, "--baseline")) o->baseline = v;
+        else if (!strcmp(a, "--save-baseline")) o->saveBaseline = v;
+        else if (!strcmp(a, "--source-mode")) {
+            if (!strcmp(v, "rr")) o->sourceMode = PROBE_SOURCE_ROUND_ROBIN;
+            else if (!strcmp(v, "hash")) o->sourceMode = PROBE_SOURCE_HASH;
+            else { fprintf(stderr, "不支持的源地址选择方式: %s\n", v); return 0; }
+        }
+        else if (!strcmp(a, "--shard")) {
+            if (sscanf(v, "%d/%d", &o->shardIndex, &o->shardCount) != 2 ||
+                o->shardCount < 1 || o->shardIndex < 1 || o->shardIndex > o->shardCount) {
+                fprintf(stderr, "--shard 格式应为 i/N (1 <= i <= N)\n");
+                return 0;
+            }
+            o->shardIndex--;   // 内部按 0 起计
+        }
+        else if (!strcmp(a, "--format")) {
+            if (!strcmp(v, "ndjson")) o->format = OUTPUT_NDJSON;
+            else if (!strcmp(v, "csv")) o->format = OUTPUT_CSV;
+            else { fprintf(stderr, "不支持的输出格式: %s\n", v); return 0; }
+        }
+        else if (!strcmp(a, "--backend")) {
+            if (!strcmp(v, "auto")) o->backend = PROBE_BACKEND_AUTO;
+            else if (!strcmp(v, "select")) o->backend = PROBE_BACKEND_SELECT;
+            else if (!strcmp(v, "epoll")) o->backend = PROBE_BACKEND_EPOLL;
+            else if (!strcmp(v, "uring")) o->backend = PROBE_BACKEND_URING;
+            else { fprintf(stderr, "不支持的 I/O 后端: %s\n", v); return 0; }
+        }
+        else if (!strcmp(a, "--mode")) {
+            if (!strcmp(v, "icmp")) o->traceMode = TRACE_ICMP;
+            else if (!strcmp(v, "udp")) o->traceMode = TRACE_UDP;
+            else if (!strcmp(v, "tcp")) o->traceMode = TRACE_TCP;
+            else { fprintf(stderr, "不支持的追踪模式: %s\n", v); return 0; }
+        }
+        else { fprintf(stderr, "未知选项: %s\n", a); return 0; }
+        if (takesValue) i++;
+    }
+    if (o->timeoutMs <= 0) o->timeoutMs = 1000;
+    if (o->count <= 0) o->count = 4;
+    return 1;
+}
+
+// 源地址需试绑定确认，放在 socket 库初始化之后解析
+static int load_sources(CliOptions* o) {
+    char bad[128];
+    if (!o->sourceSpec) return 1;
+    if (source_parse(o->sourceSpec, &g_sources, bad, sizeof(bad)) < 0) {
+        fprintf(stderr, "源地址不是本机地址或网卡名: %s\n", bad);
+        return 0;
+    }
+    g_sources.mode = o->sourceMode;
+    if (g_sources.count > 0) o->sources = &g_sources;
+    return 1;
+}
+
+// 目标列表：解析后的地址与原始主机名一一对应
+typedef struct {
+    char* text;
+    char** hosts;
+    int count;
+    ProbeTarget* targets;
+} CliTargets;
+
+static int load_targets(const CliOptions* o, CliTargets* t) {
+    memset(t, 0, sizeof(*t));
+    if (o->targetList) {
+        t->text = (char*)malloc(strlen(o->targetList) + 1);
+        if (t->text) strcpy(t->text, o->targetList);
+    } else {
+        FILE* f = o->targetFile ? fopen(o->targetFile, "rb") : stdin;
+        if (!f) { fprintf(stderr, "无法打开目标文件: %s\n", o->targetFile); return 0; }
+        t->text = read_stream(f);
+        if (f != stdin) fclose(f);
+    }
+    if (!t->text) return 0;
+    t->hosts = split_tokens(t->text, &t->count);
+    t->targets = (ProbeTarget*)calloc(t->count ? t->count : 1, sizeof(ProbeTarget));
+    if (!t->hosts || !t->targets) return 0;
+    for (int i = 0; i < t->count && !g_interrupted; i++) {
+        if (!cli_resolve(t->hosts[i], &t->targets[i])) fprintf(stderr, "无法解析: %s\n", t->hosts[i]);
+    }
+    return t->count > 0;
+}
+
+static void free_targets(CliTargets* t) {
+    free(t->text);
+    free(t->hosts);
+    free(t->targets);
+}
+
+static void out_location(const ProbeTarget* t, int geo) {
+    const char* location = "";
+    char ip[64];
+    if (geo && t->family == 4) {
+        target_ip(t, ip, sizeof(ip));
+        location = ipv4_lookup_location(ip);
+    }
+    writer_str(&g_out, "location", location);
+}
+
+// --- scan ---
+typedef struct {
+    const CliOptions* opt;
+    CliTargets* list;
+    int* ports;
+    int portCount;
+    int proto;
+    ServiceMatcher* matcher;
+    Permutation order;
+    int shuffled;
+    unsigned long long cursor;
+    unsigned long long space;
+    long long open;
+    DeltaIndex* delta;          // --baseline / --save-baseline 时非 NULL
+    char* synDone;              // 已由 SYN 扫描处理的目标，connect 阶段跳过
+} CliScanJob;
+
+static int cli_scan_next(void* ctx, int* target, int* port) {
+    CliScanJob* job = (CliScanJob*)ctx;
+    unsigned long long idx;
+    // 增量扫描先复查上次开放的端口
+    if (job->delta && delta_next(job->delta, &idx)) {
+        *target = (int)(idx % job->list->count);
+        *port = job->ports[idx / job->list->count];
+        return 1;
+    }
+    while (job->cursor < job->space) {
+        unsigned long long pos = job->cursor++;
+        idx = pos;
+        if (job->shuffled && !permutation_next(&job->order, &idx)) { job->cursor = job->space; return 0; }
+        if (job->opt->shardCount > 1 && pos % job->opt->shardCount != (unsigned long long)job->opt->shardIndex) continue;
+        int h = (int)(idx % job->list->count);
+        if (!job->list->targets[h].family || (job->synDone && job->synDone[h])) continue;
+        if (job->delta && delta_known(job->delta, h, (int)(idx / job->list->count))) continue;
+        *target = h;
+        *port = job->ports[idx / job->list->count];
+        return 1;
+    }
+    return 0;
+}
+
+static void on_cli_scan_result(void* ctx, int target, int port, int state, const char* data, int len) {
+    CliScanJob* job = (CliScanJob*)ctx;
+    const char* name = state == PROBE_OPEN ? "open" : state == PROBE_CLOSED ? "closed" :
+                       state == PROBE_ERROR ? "error" : job->proto == PROBE_UDP ? "open|filtered" : "filtered";
+    int report = state == PROBE_OPEN || (job->proto == PROBE_UDP && state == PROBE_FILTERED);
+    if (state == PROBE_OPEN) job->open++;
+    wchar_t service[256] = {0};
+    if (job->matcher && report) service_identify(job->matcher, data, len, service, 256);
+
+    // 增量扫描只输出变化 (--all 不起作用)
+    int change = job->delta ? delta_observe(job->delta, target, port, state, service) : DELTA_NONE;
+    if (job->delta && delta_first_pass_done(job->delta)) {
+        DeltaStats ds;
+        delta_stats(job->delta, &ds);
+        fprintf(stderr, "已复查上次开放的端口：%d 个仍开放，%d 个已关闭，继续扫描其余端口\n", ds.stillOpen, ds.closed);
+    }
+    if (job->opt->baseline) {
+        if (change == DELTA_NONE) return;
+    } else if (!report && !job->opt->all) {
+        return;
+    }
+
+    char ip[64];
+    const ProbeTarget* t = &job->list->targets[target];
+    target_ip(t, ip, sizeof(ip));
+    writer_str(&g_out, "host", job->list->hosts[target]);
+    writer_str(&g_out, "ip", ip);
+    writer_int(&g_out, "port", port);
+    writer_str(&g_out, "proto", job->proto == PROBE_UDP ? "udp" : "tcp");
+    writer_str(&g_out, "state", name);
+    if (job->opt->baseline) writer_str(&g_out, "change", delta_change_name(change));
+    writer_wstr(&g_out, "service", service);
+    if (job->opt->baseline) writer_str(&g_out, "previous", delta_previous_service(job->delta, target, port));
+    out_location(t, job->opt->geo);
+    writer_end_row(&g_out);
+}
+
+// --- scan: SYN ---
+typedef struct {
+    CliScanJob* job;
+    const int* hostOf;          // SYN 目标下标 -> 目标列表下标
+    int* portIndex;             // 端口号 -> 端口序号
+    unsigned char* seen;        // 收到回包的 目标×端口，--all 时其余补为 filtered
+} CliSynJob;
+
+static void cli_syn_row(const CliScanJob* job, int target, int port, const char* state) {
+    char ip[64];
+    const ProbeTarget* t = &job->list->targets[target];
+    target_ip(t, ip, sizeof(ip));
+    writer_str(&g_out, "host", job->list->hosts[target]);
+    writer_str(&g_out, "ip", ip);
+    writer_int(&g_out, "port", port);
+    writer_str(&g_out, "proto", "tcp");
+    writer_str(&g_out, "state", state);
+    writer_str(&g_out, "service", "");
+    out_location(t, job->opt->geo);
+    writer_end_row(&g_out);
+}
+
+// 接收线程逐个回调；主线程此时在等待 syn_scan_run 返回，输出缓冲不会并发写入
+static void on_cli_syn_result(void* ctx, int ipIndex, int port, int state) {
+    CliSynJob* s = (CliSynJob*)ctx;
+    CliScanJob* job = s->job;
+    size_t bit = (size_t)ipIndex * job->portCount + s->portIndex[port];
+    s->seen[bit >> 3] |= (unsigned char)(1 << (bit & 7));
+    if (state == SYN_STATE_OPEN) {
+        job->open++;
+        cli_syn_row(job, s->hostOf[ipIndex], port, "open");
+    } else if (job->opt->all) {
+        cli_syn_row(job, s->hostOf[ipIndex], port, "closed");
+    }
+}
+
+// 对全部 IPv4 目标执行 SYN 扫描并标记为已处理；无权限或启动失败时不标记，全部交给 connect
+static void cli_syn_scan(CliScanJob* job, unsigned long long seed) {
+    const CliOptions* o = job->opt;
+    if (!syn_scan_available()) {
+        fprintf(stderr, "SYN 扫描需要 root 或 CAP_NET_RAW，已回退到 connect 扫描\n");
+        return;
+    }
+    int count = job->list->count;
+    unsigned long* ips = (unsigned long*)malloc(sizeof(unsigned long) * count);
+    unsigned long* sourceIps = o->sources && o->sources->v4Count > 0 ? (unsigned long*)calloc(count, sizeof(unsigned long)) : NULL;
+    int* hostOf = (int*)malloc(sizeof(int) * count);
+    job->synDone = (char*)calloc(count, 1);
+    int n = 0;
+    for (int i = 0; ips && hostOf && job->synDone && i < count; i++) {
+        if (job->list->targets[i].family != 4) continue;
+        ips[n] = job->list->targets[i].addr.v4.sin_addr.s_addr;
+        if (sourceIps) sourceIps[n] = source_pick(o->sources, 4, (unsigned int)i)->addr.v4.sin_addr.s_addr;
+        hostOf[n++] = i;
+    }
+    CliSynJob s = { job, hostOf, (int*)malloc(sizeof(int) * 65536),
+                    n > 0 ? (unsigned char*)calloc(((size_t)n * job->portCount + 7) / 8, 1) : NULL };
+    if (s.seen && s.portIndex) {
+        for (int j = 0; j < job->portCount; j++) s.portIndex[job->ports[j]] = j;
+        SynScanConfig cfg;
+        memset(&cfg, 0, sizeof(cfg));
+        cfg.ips = ips;
+        cfg.ipCount = n;
+        cfg.ports = job->ports;
+        cfg.portCount = job->portCount;
+        cfg.pps = o->pps;
+        cfg.waitMs = o->timeoutMs;
+        cfg.seed = seed;
+        cfg.shardIndex = o->shardIndex;
+        cfg.shardCount = o->shardCount;
+        cfg.sourceIps = sourceIps;
+        cfg.onResult = on_cli_syn_result;
+        cfg.ctx = &s;
+        if (syn_scan_run(&cfg) < 0) {
+            fprintf(stderr, "SYN 扫描启动失败，已回退到 connect 扫描\n");
+        } else {
+            for (int k = 0; k < n; k++) job->synDone[hostOf[k]] = 1;
+            // 没有回包的视为过滤 (分片时只补本片发出的探测无从区分，统一不补)
+            for (size_t bit = 0; o->all && o->shardCount <= 1 && bit < (size_t)n * job->portCount; bit++) {
+                if (!(s.seen[bit >> 3] & (1 << (bit & 7)))) {
+                    cli_syn_row(job, hostOf[bit / job->portCount], job->ports[bit % job->portCount], "filtered");
+                }
+            }
+        }
+    }
+    free(s.seen);
+    free(s.portIndex);
+    free(ips);
+    free(sourceIps);
+    free(hostOf);
+}
+
+static int cmd_scan(const CliOptions* o) {
+    CliTargets list;
+    CliScanJob job;
+    memset(&job, 0, sizeof(job));
+    int rc = 1;
+    if (!load_targets(o, &list)) goto cleanup;
+
+    wchar_t* portSpec = utf8_to_wide(o->ports ? o->ports : "top100");
+    PortSet* set = (PortSet*)malloc(sizeof(PortSet));
+    if (portSpec && set) {
+        if (portset_parse(set, portSpec) > 0) fprintf(stderr, "端口列表中有无法识别的片段已忽略\n");
+        job.ports = portset_to_array(set, &job.portCount);
+    }
+    free(portSpec);
+    free(set);
+    if (!job.ports || job.portCount == 0) { fprintf(stderr, "没有可扫描的端口\n"); goto cleanup; }
+
+    job.opt = o;
+    job.list = &list;
+    job.proto = o->udp ? PROBE_UDP : PROBE_TCP;
+    job.space = (unsigned long long)list.count * job.portCount;
+    // 与 GUI 相同：多目标时打乱探测顺序；分片时各节点须使用同一种子，未指定则由目标与端口推导
+    unsigned long long seed = o->seed;
+    if (!seed && o->shardCount > 1) seed = shard_default_seed((const char* const*)list.hosts, list.count, job.ports, job.portCount);
+    // SYN 扫描不建立连接，拿不到 Banner，也不经过增量对比
+    if (o->syn && (o->udp || o->service || o->baseline || o->saveBaseline)) {
+        fprintf(stderr, "--syn 不能与 --udp / --service / --baseline / --save-baseline 同时使用\n");
+        goto cleanup;
+    }
+    // 首轮复查的是整份基线，无法按遍历位置分片
+    if (o->baseline && o->shardCount > 1) {
+        fprintf(stderr, "--baseline 不能与 --shard 同时使用\n");
+        goto cleanup;
+    }
+    if (!seed) seed = platform_tick_us() ^ ((unsigned long long)time(NULL) << 20);
+    if (list.count > 1) job.shuffled = permutation_init(&job.order, job.space, seed);
+    if (o->service) job.matcher = service_matcher_create();
+
+    if (o->baseline || o->saveBaseline) {
+        job.delta = delta_create(list.targets, list.count, job.ports, job.portCount, job.proto);
+        if (!job.delta) { fprintf(stderr, "内存不足\n"); goto cleanup; }
+        for (int i = 0; i < list.count; i++) delta_set_name(job.delta, i, list.hosts[i]);
+    }
+    if (o->baseline) {
+        // 基线不存在 (第一次运行) 时按空基线对比，本次开放的都输出为 new
+        wchar_t* path = utf8_to_wide(o->baseline);
+        int n = path ? delta_load(job.delta, path) : -1;
+        free(path);
+        if (n < 0) fprintf(stderr, "基线文件不存在，按空基线对比: %s\n", o->baseline);
+        else fprintf(stderr, "基线中有 %d 个开放端口落在本次扫描范围内，先行复查\n", n);
+        writer_header(&g_out, "host,ip,port,proto,state,change,service,previous,location");
+    } else {
+        writer_header(&g_out, "host,ip,port,proto,state,service,location");
+    }
+
+    if (o->syn) cli_syn_scan(&job, seed);
+
+    ProbeEngineConfig cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.targets = list.targets;
+    cfg.targetCount = list.count;
+    cfg.proto = job.proto;
+    cfg.maxInFlight = CLI_MAX_INFLIGHT;
+    cfg.timeoutMs = o->timeoutMs;
+    cfg.minTimeoutMs = o->minTimeoutMs;
+    cfg.udpRetries = 2;
+    cfg.tcpRetries = 1;
+    cfg.grabBanner = (job.matcher != NULL);
+    cfg.bannerWaitMs = 1500;
+    cfg.pps = o->pps;
+    cfg.subnetCap = o->subnetCap;
+    cfg.backend = o->backend;
+    cfg.sources = o->sources;
+    cfg.next = cli_scan_next;
+    cfg.onResult = on_cli_scan_result;
+    cfg.ctx = &job;
+    engine_run(&cfg);
+    fprintf(stderr, "扫描完成：%lld 个开放端口\n", job.open);
+    if (o->baseline) {
+        DeltaStats ds;
+        delta_stats(job.delta, &ds);
+        fprintf(stderr, "与基线相比：新开放 %d，已关闭 %d，服务变化 %d，仍开放 %d\n", ds.added, ds.closed, ds.changed, ds.stillOpen);
+    }
+    rc = 0;
+    // 中断的扫描不完整，不覆盖快照
+    if (o->saveBaseline && !g_interrupted) {
+        wchar_t* path = utf8_to_wide(o->saveBaseline);
+        int n = path ? delta_save(job.delta, path) : -1;
+        free(path);
+        if (n < 0) { fprintf(stderr, "无法写入基线快照: %s\n", o->saveBaseline); rc = 1; }
+        else fprintf(stderr, "基线快照已写入 %d 条: %s\n", n, o->saveBaseline);
+    }
+
+cleanup:
+    delta_free(job.delta);
+    free(job.synDone);
+    free(job.ports);
+    service_matcher_free(job.matcher);
+    free_targets(&list);
+    return rc;
+}
+
+// --- ping ---
+typedef struct {
+    int replied;
+    int refused;
+    unsigned long long sumUs, minUs, maxUs;
+} CliPingStat;
+
+typedef struct {
+    const ProbeTarget* targets;
+    int hostCount;
+    int rounds;
+    int port;
+    int cursor;
+    CliPingStat* stats;
+} CliPingJob;
+
+static int cli_ping_next(void* ctx, int* target, int* port) {
+    CliPingJob* job = (CliPingJob*)ctx;
+    while (job->cursor < job->hostCount * job->rounds) {
+        int i = job->cursor++ % job->hostCount;
+        if (!job->targets[i].family) continue;
+        *target = i;
+        *port = job->port;
+        return 1;
+    }
+    return 0;
+}
+
+static void ping_stat_add(CliPingStat* s, unsigned long long rttUs) {
+    if (s->replied == 0 || rttUs < s->minUs) s->minUs = rttUs;
+    if (rttUs > s->maxUs) s->maxUs = rttUs;
+    s->sumUs += rttUs;
+    s->replied++;
+}
+
+static void on_cli_ping_rtt(void* ctx, int target, int port, unsigned long long rttUs) {
+    (void)port;
+    ping_stat_add(&((CliPingJob*)ctx)->stats[target], rttUs);
+}
+
+static void on_cli_ping_result(void* ctx, int target, int port, int state, const char* data, int len) {
+    (void)port; (void)data; (void)len;
+    if (state == PROBE_CLOSED) ((CliPingJob*)ctx)->stats[target].refused++;
+}
+
+// ICMP 回显依赖 Windows 的 IcmpSendEcho；其他平台请改用 --port 的 TCP 握手方式
+static int cli_icmp_ping(const ProbeTarget* t, ProbeSources* sources, unsigned int key, int rounds, int timeoutMs, CliPingStat* s) {
+#ifdef _WIN32
+    for (int r = 0; r < rounds && !g_interrupted; r++) {
+        long rtt = 0;
+        int ttl = 0, ok = 0;
+        const ProbeTarget* src = source_pick(sources, t->family, key);
+        if (t->family == 4) ok = ipv4_ping_host(t->addr.v4.sin_addr.s_addr, src ? src->addr.v4.sin_addr.s_addr : 0, 1, timeoutMs, &rtt, &ttl);
+        else if (t->family == 6) ok = ipv6_ping_host((struct sockaddr_in6*)&t->addr.v6, src ? &src->addr.v6 : NULL, 1, timeoutMs, &rtt, &ttl);
+        if (ok) ping_stat_add(s, (unsigned long long)rtt * 1000);
+    }
+    return 1;
+#else
+    (void)t; (void)sources; (void)key; (void)rounds; (void)timeoutMs; (void)s;
+    return 0;
+#endif
+}
+
+static int cmd_ping(const CliOptions* o) {
+    CliTargets list;
+    CliPingJob job;
+    memset(&job, 0, sizeof(job));
+    int rc = 1;
+    if (!load_targets(o, &list)) goto cleanup;
+    job.stats = (CliPingStat*)calloc(list.count, sizeof(CliPingStat));
+    if (!job.stats) goto cleanup;
+    job.targets = list.targets;
+    job.hostCount = list.count;
+    job.rounds = o->count;
+    job.port = o->port;
+
+    if (o->port > 0) {
+        ProbeEngineConfig cfg;
+        memset(&cfg, 0, sizeof(cfg));
+        cfg.targets = list.targets;
+        cfg.targetCount = list.count;
+        cfg.proto = PROBE_TCP;
+        cfg.maxInFlight = CLI_MAX_INFLIGHT;
+        cfg.timeoutMs = o->timeoutMs;
+        cfg.minTimeoutMs = o->timeoutMs;    // 超时即计为丢包
+        cfg.pps = o->pps;
+        cfg.subnetCap = o->subnetCap;
+        cfg.backend = o->backend;
+        cfg.sources = o->sources;
+        cfg.onRtt = on_cli_ping_rtt;
+        cfg.next = cli_ping_next;
+        cfg.onResult = on_cli_ping_result;
+        cfg.ctx = &job;
+        engine_run(&cfg);
+    } else {
+        for (int i = 0; i < list.count && !g_interrupted; i++) {
+            if (!list.targets[i].family) continue;
+            if (!cli_icmp_ping(&list.targets[i], o->sources, (unsigned int)i, o->count, o->timeoutMs, &job.stats[i])) {
+                fprintf(stderr, "此平台不支持 ICMP Ping，请用 --port 指定 TCP 端口\n");
+                goto cleanup;
+            }
+        }
+    }
+
+    writer_header(&g_out, "host,ip,sent,received,loss_pct,avg_ms,min_ms,max_ms,location");
+    for (int i = 0; i < list.count; i++) {
+        const CliPingStat* s = &job.stats[i];
+        char ip[64];
+        target_ip(&list.targets[i], ip, sizeof(ip));
+        int sent = list.targets[i].family ? o->count : 0;
+        writer_str(&g_out, "host", list.hosts[i]);
+        writer_str(&g_out, "ip", ip);
+        writer_int(&g_out, "sent", sent);
+        writer_int(&g_out, "received", s->replied);
+        writer_int(&g_out, "loss_pct", sent ? (sent - s->replied) * 100 / sent : 100);
+        writer_ms(&g_out, "avg_ms", s->replied ? s->sumUs / 1000.0 / s->replied : 0, s->replied > 0);
+        writer_ms(&g_out, "min_ms", s->minUs / 1000.0, s->replied > 0);
+        writer_ms(&g_out, "max_ms", s->maxUs / 1000.0, s->replied > 0);
+        out_location(&list.targets[i], o->geo);
+        writer_end_row(&g_out);
+    }
+    rc = 0;
+
+cleanup:
+    free(job.stats);
+    free_targets(&list);
+    return rc;
+}
+
+// --- trace ---
+typedef struct {
+    unsigned int addr;
+    unsigned int rttUs;
+    int reached;
+} CliHop;
+
+static void on_cli_trace_hop(void* ctx, int target, int ttl, unsigned int hop, unsigned long long rttUs, int reached) {
+    CliHop* h = &((CliHop*)ctx)[target * TRACE_MAX_HOPS + ttl - 1];
+    h->addr = hop;
+    h->rttUs = rttUs < 0xFFFFFFFFULL ? (unsigned int)rttUs : 0xFFFFFFFFu;
+    h->reached = reached;
+}
+
+static int cmd_trace(const CliOptions* o) {
+    CliTargets list;
+    int rc = 1;
+    CliHop* hops = NULL;
+    if (!load_targets(o, &list)) goto cleanup;
+    hops = (CliHop*)calloc((size_t)list.count * TRACE_MAX_HOPS, sizeof(CliHop));
+    if (!hops) goto cleanup;
+
+    TraceConfig cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.targets = list.targets;
+    cfg.targetCount = list.count;
+    cfg.mode = o->traceMode;
+    cfg.port = o->port;
+    cfg.maxHops = TRACE_MAX_HOPS;
+    cfg.timeoutMs = o->timeoutMs;
+    cfg.onHop = on_cli_trace_hop;
+    cfg.ctx = hops;
+    if (trace_run(&cfg) < 0) {
+#ifdef _WIN32
+        // 无原始套接字权限：逐跳调用系统 ICMP 接口
+        for (int i = 0; i < list.count && !g_interrupted; i++) {
+            if (list.targets[i].family != 4) continue;
+            for (int ttl = 1; ttl <= TRACE_MAX_HOPS && !g_interrupted; ttl++) {
+                unsigned long hop = 0;
+                long rtt = 0;
+                int ret = ipv4_trace_hop(list.targets[i].addr.v4.sin_addr.s_addr, ttl, o->timeoutMs, &hop, &rtt);
+                if (ret) on_cli_trace_hop(hops, i, ttl, (unsigned int)hop, (unsigned long long)rtt * 1000, ret == 2);
+                if (ret == 2) break;
+            }
+        }
+#else
+        fprintf(stderr, "路由追踪需要原始套接字权限 (root 或 CAP_NET_RAW)\n");
+        goto cleanup;
+#endif
+    }
+
+    writer_header(&g_out, "host,ttl,hop,rtt_ms,reached,location");
+    for (int i = 0; i < list.count; i++) {
+        if (list.targets[i].family != 4) continue;
+        // 输出到达目标为止；未到达则截到最后一个有应答的节点
+        int len = 0;
+        for (int ttl = 1; ttl <= TRACE_MAX_HOPS; ttl++) {
+            const CliHop* h = &hops[i * TRACE_MAX_HOPS + ttl - 1];
+            if (h->reached) { len = ttl; break; }
+            if (h->addr) len = ttl;
+        }
+        for (int ttl = 1; ttl <= len; ttl++) {
+            const CliHop* h = &hops[i * TRACE_MAX_HOPS + ttl - 1];
+            ProbeTarget node;
+            char ip[64] = "";
+            memset(&node, 0, sizeof(node));
+            if (h->addr) {
+                node.family = 4;
+                node.addr.v4.sin_addr.s_addr = h->addr;
+                target_ip(&node, ip, sizeof(ip));
+            }
+            writer_str(&g_out, "host", list.hosts[i]);
+            writer_int(&g_out, "ttl", ttl);
+            writer_str(&g_out, "hop", ip);
+            writer_ms(&g_out, "rtt_ms", h->rttUs / 1000.0, h->addr != 0);
+            writer_int(&g_out, "reached", h->reached);
+            out_location(&node, o->geo);
+            writer_end_row(&g_out);
+        }
+    }
+    rc = 0;
+
+cleanup:
+    free(hops);
+    free_targets(&list);
+    return rc;
+}
+
+// --- extract ---
+static void on_cli_extract(void* ctx, const char* value, int kind) {
+    const CliOptions* o = (const CliOptions*)ctx;
+    writer_str(&g_out, "value", value);
+    writer_str(&g_out, "kind", kind == EXTRACT_IPV4 ? "ipv4" : kind == EXTRACT_IPV6 ? "ipv6" : "domain");
+    writer_str(&g_out, "location", kind == EXTRACT_IPV4 && o->geo ? ipv4_lookup_location(value) : "");
+    writer_end_row(&g_out);
+}
+
+// [修改] 读取 -f 指定的文件，未指定时读标准输入；按原始字节扫描，不做编码转换
+static int cmd_extract(const CliOptions* o) {
+    if (o->targetList) { fprintf(stderr, "extract 不接受 -t，请用 -f 指定文件或从标准输入读取\n"); return 2; }
+    FILE* f = o->targetFile ? fopen(o->targetFile, "rb") : stdin;
+    if (!f) { fprintf(stderr, "无法打开文件: %s\n", o->targetFile); return 1; }
+    char* text = read_stream(f);
+    if (f != stdin) fclose(f);
+    if (!text) return 1;
+    writer_header(&g_out, "value,kind,location");
+    extract_ipv4(text, on_cli_extract, (void*)o);
+    extract_ipv6(text, on_cli_extract, (void*)o);
+    extract_domains(text, on_cli_extract, (void*)o);
+    free(text);
+    return 0;
+}
+
+// --- export ---
+static int cmd_export(const CliOptions* o) {
+    if (!o->targetFile) { fprintf(stderr, "export 需要用 -f 指定结果日志\n"); return 2; }
+    wchar_t* path = utf8_to_wide(o->targetFile);
+    ResultLogView* view = path ? reslog_load(path) : NULL;
+    free(path);
+    if (!view) { fprintf(stderr, "无法读取结果日志: %s\n", o->targetFile); return 1; }
+    reslog_write_header(view, &g_out);
+    unsigned int rows = reslog_view_rows(view);
+    for (unsigned int id = 0; id < rows; id++) reslog_write_row(view, &g_out, id);
+    reslog_view_free(view);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    CliOptions opt;
+    if (argc < 2 || !strcmp(argv[1], "-h") || !strcmp(argv[1], "--help")) {
+        print_usage();
+        return argc < 2 ? 2 : 0;
+    }
+    if (!parse_options(argc - 2, argv + 2, &opt)) return 2;
+    if (!writer_init(&g_out, stdout, opt.format, CLI_OUT_BUF)) return 1;
+    signal(SIGINT, on_sigint);
+
+#ifdef _WIN32
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) return 1;
+#endif
+    if (!load_sources(&opt)) return 2;
+    if (opt.geo) ipv4_init_qqwry();
+
+    int rc;
+    if (!strcmp(argv[1], "scan")) rc = cmd_scan(&opt);
+    else if (!strcmp(argv[1], "ping")) rc = cmd_ping(&opt);
+    else if (!strcmp(argv[1], "trace")) rc = cmd_trace(&opt);
+    else if (!strcmp(argv[1], "extract")) rc = cmd_extract(&opt);
+    else if (!strcmp(argv[1], "export")) rc = cmd_export(&opt);
+    else { print_usage(); rc = 2; }
+
+    writer_flush(&g_out);
+    writer_free(&g_out);
+    if (opt.metricsFile) {
+        MetricsSnapshot snap;
+        wchar_t* path = utf8_to_wide(opt.metricsFile);
+        metrics_snapshot(&snap);
+        if (!path || !metrics_dump(path, &snap)) fprintf(stderr, "无法写入运行指标: %s\n", opt.metricsFile);
+        free(path);
+    }
+    if (opt.geo) ipv4_cleanup_qqwry();
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    return rc;
+}
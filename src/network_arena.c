@@ -0,0 +1,135 @@
+#include "network_modules.h"
+#include <stdlib.h>
+#include <string.h>
+
+// --- 任务内存 ---
+// Arena：按块顺序分配、整体释放，任务的输入拆分与中间字符串都从这里取，任务结束一次归还；
+// Slab：固定大小记录的对象池，界面消息反复复用同一批记录，长时间运行也不产生碎片。
+
+#define ARENA_DEFAULT_CHUNK 65536
+#define ARENA_ALIGN         8
+
+struct ArenaChunk {
+    struct ArenaChunk* next;
+    size_t used;
+    size_t cap;
+    // 数据紧随其后
+};
+
+#define ARENA_HEADER ((sizeof(ArenaChunk) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+static ArenaChunk* arena_new_chunk(size_t cap) {
+    ArenaChunk* c = (ArenaChunk*)malloc(ARENA_HEADER + cap);
+    if (!c) return NULL;
+    c->next = NULL;
+    c->used = 0;
+    c->cap = cap;
+    return c;
+}
+
+void* arena_alloc(Arena* a, size_t size) {
+    size_t chunk = a->chunkSize ? a->chunkSize : ARENA_DEFAULT_CHUNK;
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    ArenaChunk* head = a->head;
+    if (head && head->cap - head->used >= size) {
+        void* p = (char*)head + ARENA_HEADER + head->used;
+        head->used += size;
+        return p;
+    }
+    // 大块单独成块挂在当前块之后，当前块剩余空间继续使用
+    if (head && size > chunk / 4) {
+        ArenaChunk* big = arena_new_chunk(size);
+        if (!big) return NULL;
+        big->used = size;
+        big->next = head->next;
+        head->next = big;
+        return (char*)big + ARENA_HEADER;
+    }
+    ArenaChunk* c = arena_new_chunk(size > chunk ? size : chunk);
+    if (!c) return NULL;
+    c->next = head;
+    a->head = c;
+    c->used = size;
+    return (char*)c + ARENA_HEADER;
+}
+
+wchar_t* arena_wcsdup(Arena* a, const wchar_t* s) {
+    size_t len = wcslen(s);
+    wchar_t* p = (wchar_t*)arena_alloc(a, (len + 1) * sizeof(wchar_t));
+    if (p) memcpy(p, s, (len + 1) * sizeof(wchar_t));
+    return p;
+}
+
+// 只保留最近的一块供下次复用
+void arena_reset(Arena* a) {
+    if (!a->head) return;
+    ArenaChunk* c = a->head->next;
+    while (c) {
+        ArenaChunk* next = c->next;
+        free(c);
+        c = next;
+    }
+    a->head->next = NULL;
+    a->head->used = 0;
+}
+
+void arena_free(Arena* a) {
+    arena_reset(a);
+    free(a->head);
+    a->head = NULL;
+}
+
+// --- 对象池 ---
+// 空闲记录串成单链表，取还各持锁几条指令；池只增不减，slab_destroy 时整体释放
+typedef struct SlabNode {
+    struct SlabNode* next;
+} SlabNode;
+
+void slab_init(Slab* s, size_t size, int perChunk) {
+    memset(s, 0, sizeof(*s));
+    s->size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    if (s->size < sizeof(SlabNode)) s->size = sizeof(SlabNode);
+    s->perChunk = perChunk > 0 ? perChunk : 64;
+}
+
+void* slab_alloc(Slab* s) {
+    platform_lock(&s->lock);
+    SlabNode* n = (SlabNode*)s->freeList;
+    if (!n) {
+        // 一次分配整块记录，块首留一个指针串起所有块
+        char* chunk = (char*)malloc(ARENA_ALIGN + s->size * s->perChunk);
+        if (!chunk) { platform_unlock(&s->lock); return NULL; }
+        *(void**)chunk = s->chunks;
+        s->chunks = chunk;
+        for (int i = s->perChunk - 1; i >= 0; i--) {
+            SlabNode* rec = (SlabNode*)(chunk + ARENA_ALIGN + s->size * i);
+            rec->next = n;
+            n = rec;
+        }
+        s->capacity += s->perChunk;
+    }
+    s->freeList = n->next;
+    s->inUse++;
+    platform_unlock(&s->lock);
+    return n;
+}
+
+void slab_free(Slab* s, void* p) {
+    if (!p) return;
+    platform_lock(&s->lock);
+    ((SlabNode*)p)->next = (SlabNode*)s->freeList;
+    s->freeList = p;
+    s->inUse--;
+    platform_unlock(&s->lock);
+}
+
+void slab_destroy(Slab* s) {
+    void* chunk = s->chunks;
+    while (chunk) {
+        void* next = *(void**)chunk;
+        free(chunk);
+        chunk = next;
+    }
+    s->chunks = s->freeList = NULL;
+    s->capacity = s->inUse = 0;
+}
@@ -0,0 +1,212 @@
+#include "network_modules.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// --- 扫描断点 ---
+// 状态文件很小 (任务哈希、置换位置、未完成索引)，每次整体重写到临时文件再替换，中途断电不会留下半个文件；
+// 结果单独追加写入结果文件，状态文件记录其中已确认的记录数，续扫时截掉之后的部分。
+
+#define CHECKPOINT_MAGIC   0x4B43544Eu   // "NTCK"
+#define CHECKPOINT_VERSION 2   // [修改] 2: current 改为 64 位
+
+unsigned int checkpoint_hash(const void* data, int len, unsigned int h) {
+    const unsigned char* p = (const unsigned char*)data;
+    for (int i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// --- 未完成索引集合 (线性探测哈希，删除时回移) ---
+int indexset_init(IndexSet* s, int capacity) {
+    int cap = 16;
+    while (cap < capacity * 2) cap <<= 1;
+    s->slots = (unsigned long long*)calloc(cap, sizeof(unsigned long long));
+    s->capacity = cap;
+    s->count = 0;
+    return s->slots != NULL;
+}
+
+void indexset_free(IndexSet* s) {
+    free(s->slots);
+    s->slots = NULL;
+    s->capacity = s->count = 0;
+}
+
+static int indexset_home(const IndexSet* s, unsigned long long key) {
+    return (int)((key * 0x9E3779B97F4A7C15ULL) >> 32) & (s->capacity - 1);
+}
+
+// [修改] 负载超过一半时翻倍重建，探测链始终有空槽终止；扩容失败且已接近满载时拒绝插入
+static int indexset_grow(IndexSet* s) {
+    int cap = s->capacity * 2;
+    unsigned long long* slots = (unsigned long long*)calloc(cap, sizeof(unsigned long long));
+    if (!slots) return 0;
+    unsigned long long* old = s->slots;
+    int oldCap = s->capacity;
+    s->slots = slots;
+    s->capacity = cap;
+    for (int i = 0; i < oldCap; i++) {
+        if (!old[i]) continue;
+        int j = indexset_home(s, old[i]);
+        while (s->slots[j]) j = (j + 1) & (cap - 1);
+        s->slots[j] = old[i];
+    }
+    free(old);
+    return 1;
+}
+
+int indexset_add(IndexSet* s, unsigned long long index) {
+    unsigned long long key = index + 1;   // 0 表示空槽
+    if ((s->count + 1) * 2 > s->capacity && !indexset_grow(s) && (s->count + 1) * 4 > s->capacity * 3) return 0;
+    int i = indexset_home(s, key);
+    while (s->slots[i] && s->slots[i] != key) i = (i + 1) & (s->capacity - 1);
+    if (!s->slots[i]) { s->slots[i] = key; s->count++; }
+    return 1;
+}
+
+void indexset_remove(IndexSet* s, unsigned long long index) {
+    unsigned long long key = index + 1;
+    int mask = s->capacity - 1;
+    int i = indexset_home(s, key);
+    while (s->slots[i] && s->slots[i] != key) i = (i + 1) & mask;
+    if (!s->slots[i]) return;
+
+    // 把后续同簇元素前移，保持探测链连续
+    int j = i;
+    for (;;) {
+        s->slots[i] = 0;
+        for (;;) {
+            j = (j + 1) & mask;
+            if (!s->slots[j]) { s->count--; return; }
+            int home = indexset_home(s, s->slots[j]);
+            if (i <= j ? (home <= i || home > j) : (home <= i && home > j)) break;
+        }
+        s->slots[i] = s->slots[j];
+        i = j;
+    }
+}
+
+int indexset_collect(const IndexSet* s, unsigned long long* out) {
+    int n = 0;
+    for (int i = 0; i < s->capacity; i++) {
+        if (s->slots[i]) out[n++] = s->slots[i] - 1;
+    }
+    return n;
+}
+
+// --- 状态文件 ---
+#define CK_WRITE(v) ok &= (fwrite(&(v), sizeof(v), 1, f) == 1)
+#define CK_READ(v)  ok &= (fread(&(v), sizeof(v), 1, f) == 1)
+
+int checkpoint_save(const wchar_t* path, const ScanCheckpoint* ck) {
+    wchar_t tmp[MAX_CHECKPOINT_PATH + 8];
+    swprintf(tmp, MAX_CHECKPOINT_PATH + 8, L"%ls.tmp", path);
+    FILE* f = platform_wfopen(tmp, L"wb");
+    if (!f) return 0;
+
+    unsigned int magic = CHECKPOINT_MAGIC, version = CHECKPOINT_VERSION;
+    int ok = 1;
+    CK_WRITE(magic);
+    CK_WRITE(version);
+    CK_WRITE(ck->specHash);
+    CK_WRITE(ck->seed);
+    CK_WRITE(ck->order);
+    CK_WRITE(ck->shuffled);
+    CK_WRITE(ck->cursor);
+    CK_WRITE(ck->current);
+    CK_WRITE(ck->openCount);
+    CK_WRITE(ck->closedCount);
+    CK_WRITE(ck->filteredCount);
+    CK_WRITE(ck->resultCount);
+    CK_WRITE(ck->pendingCount);
+    if (ck->pendingCount > 0) {
+        ok &= (fwrite(ck->pending, sizeof(unsigned long long), ck->pendingCount, f) == (size_t)ck->pendingCount);
+    }
+    ok &= (fclose(f) == 0);
+    if (!ok) return 0;
+    return platform_replace_file(tmp, path);
+}
+
+int checkpoint_load(const wchar_t* path, ScanCheckpoint* ck) {
+    memset(ck, 0, sizeof(*ck));
+    FILE* f = platform_wfopen(path, L"rb");
+    if (!f) return 0;
+
+    unsigned int magic = 0, version = 0;
+    int ok = 1;
+    CK_READ(magic);
+    CK_READ(version);
+    if (!ok || magic != CHECKPOINT_MAGIC || version != CHECKPOINT_VERSION) { fclose(f); return 0; }
+    CK_READ(ck->specHash);
+    CK_READ(ck->seed);
+    CK_READ(ck->order);
+    CK_READ(ck->shuffled);
+    CK_READ(ck->cursor);
+    CK_READ(ck->current);
+    CK_READ(ck->openCount);
+    CK_READ(ck->closedCount);
+    CK_READ(ck->filteredCount);
+    CK_READ(ck->resultCount);
+    CK_READ(ck->pendingCount);
+    if (ok && ck->pendingCount > 0) {
+        ck->pending = (unsigned long long*)malloc(sizeof(unsigned long long) * ck->pendingCount);
+        ok = ck->pending &&
+             fread(ck->pending, sizeof(unsigned long long), ck->pendingCount, f) == (size_t)ck->pendingCount;
+    }
+    fclose(f);
+    if (!ok) {
+        free(ck->pending);
+        memset(ck, 0, sizeof(*ck));
+    }
+    return ok;
+}
+
+// --- 结果文件 ---
+int checkpoint_append_result(FILE* f, int target, int port, int state, const char* data, int len) {
+    int ok = 1;
+    if (!data) len = 0;
+    if (len > CHECKPOINT_MAX_DATA) len = CHECKPOINT_MAX_DATA;
+    CK_WRITE(target);
+    CK_WRITE(port);
+    CK_WRITE(state);
+    CK_WRITE(len);
+    if (len > 0) ok &= (fwrite(data, 1, len, f) == (size_t)len);
+    return ok;
+}
+
+// 回放前 maxCount 条结果，并把结果文件截断到这些记录 (之后的记录未被状态文件确认)
+int checkpoint_replay_results(const wchar_t* path, int maxCount, ProbeResultCallback cb, void* ctx) {
+    wchar_t tmp[MAX_CHECKPOINT_PATH + 8];
+    swprintf(tmp, MAX_CHECKPOINT_PATH + 8, L"%ls.tmp", path);
+    FILE* in = platform_wfopen(path, L"rb");
+    FILE* out = platform_wfopen(tmp, L"wb");
+    if (!out) { if (in) fclose(in); return -1; }
+
+    char data[CHECKPOINT_MAX_DATA];
+    int n = 0;
+    while (in && n < maxCount) {
+        int target, port, state, len;
+        FILE* f = in;
+        int ok = 1;
+        CK_READ(target);
+        CK_READ(port);
+        CK_READ(state);
+        CK_READ(len);
+        if (!ok || len < 0 || len > CHECKPOINT_MAX_DATA) break;
+        if (len > 0 && fread(data, 1, len, in) != (size_t)len) break;
+        checkpoint_append_result(out, target, port, state, data, len);
+        if (cb) cb(ctx, target, port, state, data, len);
+        n++;
+    }
+    if (in) fclose(in);
+    fclose(out);
+    return platform_replace_file(tmp, path) ? n : -1;
+}
+
+void checkpoint_remove(const wchar_t* statePath, const wchar_t* resultPath) {
+    platform_remove_file(statePath);
+    platform_remove_file(resultPath);
+}
@@ -0,0 +1,507 @@
+#include "network_modules.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// --- 增量扫描 ---
+// 上次扫描的开放端口载入为 主机×端口 位图 (每台主机占一段连续的端口序号位)，另按扫描索引排序
+// 保存一份条目表。扫描先复查这些端口，很快得出 "是否仍在" 的结论，再覆盖其余部分；
+// 结果只报告变化：新开放、已关闭 (含过滤)、服务变化。扫描完成后写出的快照作为下一次的基线。
+// 基线为 scan 输出的 NDJSON 或带表头的 CSV，只取 host / ip / port / proto / state / service 几列。
+
+#define DELTA_FIELD_MAX 256
+
+enum { DELTA_COL_HOST, DELTA_COL_IP, DELTA_COL_PORT, DELTA_COL_PROTO, DELTA_COL_STATE, DELTA_COL_SERVICE, DELTA_COL_COUNT };
+
+typedef struct {
+    char field[DELTA_COL_COUNT][DELTA_FIELD_MAX];
+} DeltaRow;
+
+typedef struct {
+    unsigned long long index;   // 扫描索引 = 端口序号 * 主机数 + 主机序号
+    unsigned long long bit;     // 位图位置 = 主机序号 * 端口数 + 端口序号
+    int state;
+    const char* service;        // UTF-8，取自 arena，"" = 未识别
+} DeltaEntry;
+
+typedef struct {
+    DeltaEntry* items;
+    int count;
+    int cap;
+} DeltaList;
+
+struct DeltaIndex {
+    const ProbeTarget* targets;
+    int hostCount;
+    const int* ports;
+    int portCount;
+    int proto;
+    int* portIndex;             // 端口号 -> 端口序号，-1 = 不在本次列表
+    unsigned long long* bits;   // 上次开放的位图
+    const char** names;         // 主机序号 -> 主机名，写快照用
+    const char** keys;          // 主机名与地址 -> 主机序号 (开放寻址)
+    int* keyTarget;
+    unsigned int keyMask;
+    DeltaList base;             // 上次开放，按扫描索引排序
+    DeltaList now;              // 本次快照
+    int basePos;                // 首轮游标
+    int pending;                // 首轮已发出尚未得出结果
+    int issued;
+    int firstPassReported;
+    DeltaStats stats;
+    Arena arena;
+};
+
+static const char* delta_strdup(DeltaIndex* d, const char* s) {
+    size_t len = strlen(s);
+    if (len == 0) return "";
+    char* p = (char*)arena_alloc(&d->arena, len + 1);
+    if (!p) return "";
+    memcpy(p, s, len + 1);
+    return p;
+}
+
+static int delta_append(DeltaList* l, const DeltaEntry* e) {
+    if (l->count == l->cap) {
+        int cap = l->cap ? l->cap * 2 : 256;
+        DeltaEntry* grown = (DeltaEntry*)realloc(l->items, sizeof(DeltaEntry) * cap);
+        if (!grown) return 0;
+        l->items = grown;
+        l->cap = cap;
+    }
+    l->items[l->count++] = *e;
+    return 1;
+}
+
+static int delta_test(const DeltaIndex* d, unsigned long long bit) {
+    return (int)((d->bits[bit >> 6] >> (bit & 63)) & 1);
+}
+
+// --- 主机名 / 地址查找 ---
+static unsigned int delta_hash(const char* s) {
+    unsigned int h = 2166136261u;
+    while (*s) h = (h ^ (unsigned char)*s++) * 16777619u;
+    return h;
+}
+
+// 重复的键保留先加入的 (同一主机在列表中出现多次时取第一个)
+static void delta_key_add(DeltaIndex* d, const char* key, int target) {
+    if (!key[0]) return;
+    unsigned int i = delta_hash(key) & d->keyMask;
+    while (d->keys[i]) {
+        if (strcmp(d->keys[i], key) == 0) return;
+        i = (i + 1) & d->keyMask;
+    }
+    d->keys[i] = delta_strdup(d, key);
+    d->keyTarget[i] = target;
+}
+
+static int delta_key_find(const DeltaIndex* d, const char* key) {
+    if (!key[0]) return -1;
+    unsigned int i = delta_hash(key) & d->keyMask;
+    while (d->keys[i]) {
+        if (strcmp(d->keys[i], key) == 0) return d->keyTarget[i];
+        i = (i + 1) & d->keyMask;
+    }
+    return -1;
+}
+
+static void delta_target_ip(const ProbeTarget* t, char* out, int outLen) {
+    out[0] = 0;
+    if (t->family == 4) inet_ntop(AF_INET, (void*)&t->addr.v4.sin_addr, out, outLen);
+    else if (t->family == 6) inet_ntop(AF_INET6, (void*)&t->addr.v6.sin6_addr, out, outLen);
+}
+
+DeltaIndex* delta_create(const ProbeTarget* targets, int hostCount, const int* ports, int portCount, int proto) {
+    DeltaIndex* d = (DeltaIndex*)calloc(1, sizeof(DeltaIndex));
+    if (!d) return NULL;
+    d->targets = targets;
+    d->hostCount = hostCount;
+    d->ports = ports;
+    d->portCount = portCount;
+    d->proto = proto;
+
+    unsigned long long bitCount = (unsigned long long)hostCount * portCount;
+    unsigned int keyCap = 16;
+    while (keyCap < (unsigned int)hostCount * 4) keyCap *= 2;     // 主机名与地址各一个键，负载不超过一半
+    d->keyMask = keyCap - 1;
+    d->bits = (unsigned long long*)calloc((size_t)(bitCount / 64 + 1), sizeof(unsigned long long));
+    d->portIndex = (int*)malloc(sizeof(int) * 65536);
+    d->names = (const char**)calloc(hostCount ? hostCount : 1, sizeof(char*));
+    d->keys = (const char**)calloc(keyCap, sizeof(char*));
+    d->keyTarget = (int*)malloc(sizeof(int) * keyCap);
+    if (!d->bits || !d->portIndex || !d->names || !d->keys || !d->keyTarget) { delta_free(d); return NULL; }
+
+    memset(d->portIndex, 0xff, sizeof(int) * 65536);
+    for (int i = 0; i < portCount; i++) d->portIndex[ports[i]] = i;
+    for (int h = 0; h < hostCount; h++) {
+        char ip[64];
+        delta_target_ip(&targets[h], ip, sizeof(ip));
+        delta_key_add(d, ip, h);
+    }
+    return d;
+}
+
+void delta_free(DeltaIndex* d) {
+    if (!d) return;
+    free(d->bits);
+    free(d->portIndex);
+    free(d->names);
+    free(d->keys);
+    free(d->keyTarget);
+    free(d->base.items);
+    free(d->now.items);
+    arena_free(&d->arena);
+    free(d);
+}
+
+void delta_set_name(DeltaIndex* d, int target, const char* name) {
+    if (target < 0 || target >= d->hostCount) return;
+    d->names[target] = delta_strdup(d, name);
+    delta_key_add(d, name, target);
+}
+
+// --- 基线解析 ---
+static int delta_column(const char* key) {
+    static const char* names[DELTA_COL_COUNT] = { "host", "ip", "port", "proto", "state", "service" };
+    for (int i = 0; i < DELTA_COL_COUNT; i++) {
+        if (strcmp(key, names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+static void delta_put(char* out, int cap, int* n, unsigned int c) {
+    if (*n < cap - 1) out[(*n)++] = (char)c;
+}
+
+static void delta_put_utf8(char* out, int cap, int* n, unsigned int cp) {
+    if (cp < 0x80) { delta_put(out, cap, n, cp); return; }
+    if (cp < 0x800) {
+        delta_put(out, cap, n, 0xC0 | (cp >> 6));
+    } else if (cp < 0x10000) {
+        delta_put(out, cap, n, 0xE0 | (cp >> 12));
+        delta_put(out, cap, n, 0x80 | ((cp >> 6) & 0x3F));
+    } else {
+        delta_put(out, cap, n, 0xF0 | (cp >> 18));
+        delta_put(out, cap, n, 0x80 | ((cp >> 12) & 0x3F));
+        delta_put(out, cap, n, 0x80 | ((cp >> 6) & 0x3F));
+    }
+    delta_put(out, cap, n, 0x80 | (cp & 0x3F));
+}
+
+static unsigned int delta_hex4(const char* p) {
+    unsigned int v = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        v <<= 4;
+        if (c >= '0' && c <= '9') v |= (unsigned int)(c - '0');
+        else if (c >= 'a' && c <= 'f') v |= (unsigned int)(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') v |= (unsigned int)(c - 'A' + 10);
+        else return 0xFFFFFFFFu;
+    }
+    return v;
+}
+
+// p 指向开头的引号，返回结尾引号之后的位置；超长部分截断
+static const char* delta_json_string(const char* p, char* out, int cap) {
+    int n = 0;
+    p++;
+    while (*p && *p != '"') {
+        if (*p != '\\') { delta_put(out, cap, &n, (unsigned char)*p++); continue; }
+        p++;
+        char c = *p ? *p++ : 0;
+        if (c == 'n') delta_put(out, cap, &n, '\n');
+        else if (c == 'r') delta_put(out, cap, &n, '\r');
+        else if (c == 't') delta_put(out, cap, &n, '\t');
+        else if (c == 'b') delta_put(out, cap, &n, '\b');
+        else if (c == 'f') delta_put(out, cap, &n, '\f');
+        else if (c == 'u') {
+            unsigned int cp = delta_hex4(p);
+            if (cp == 0xFFFFFFFFu) continue;
+            p += 4;
+            // UTF-16 代理对合并为一个码点
+            if (cp >= 0xD800 && cp <= 0xDBFF && p[0] == '\\' && p[1] == 'u') {
+                unsigned int lo = delta_hex4(p + 2);
+                if (lo >= 0xDC00 && lo <= 0xDFFF) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                    p += 6;
+                }
+            }
+            delta_put_utf8(out, cap, &n, cp);
+        }
+        else if (c) delta_put(out, cap, &n, (unsigned char)c);
+    }
+    out[n] = 0;
+    return *p ? p + 1 : p;
+}
+
+// 一行 NDJSON：只认顶层的 "键":值，非字符串的值 (端口号) 原样取出
+static void delta_parse_json(const char* p, DeltaRow* r) {
+    char key[32], value[DELTA_FIELD_MAX];
+    while ((p = strchr(p, '"')) != NULL) {
+        p = delta_json_string(p, key, sizeof(key));
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p != ':') continue;
+        p++;
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p == '"') {
+            p = delta_json_string(p, value, sizeof(value));
+        } else {
+            int n = 0;
+            while (*p && *p != ',' && *p != '}' && *p != ' ') delta_put(value, sizeof(value), &n, (unsigned char)*p++);
+            value[n] = 0;
+        }
+        int col = delta_column(key);
+        if (col >= 0) memcpy(r->field[col], value, sizeof(value));
+    }
+}
+
+// 一个 CSV 字段：引号内的 "" 为一个引号；返回 0 表示本行已无字段
+static int delta_csv_field(const char** pp, char* out, int cap) {
+    const char* p = *pp;
+    int n = 0;
+    if (!p) return 0;
+    if (*p == '"') {
+        p++;
+        while (*p) {
+            if (*p == '"') {
+                if (p[1] != '"') { p++; break; }
+                p++;
+            }
+            delta_put(out, cap, &n, (unsigned char)*p++);
+        }
+    }
+    while (*p && *p != ',') delta_put(out, cap, &n, (unsigned char)*p++);
+    out[n] = 0;
+    *pp = *p == ',' ? p + 1 : NULL;
+    return 1;
+}
+
+// 只取开放的条目；缺少的列按宽松处理 (没有 state 视为开放，没有 proto 视为与本次相同)
+static int delta_add_row(DeltaIndex* d, const DeltaRow* r) {
+    int port = atoi(r->field[DELTA_COL_PORT]);
+    if (port <= 0 || port > 65535 || d->portIndex[port] < 0) return 0;
+    const char* proto = r->field[DELTA_COL_PROTO];
+    if (proto[0] && strcmp(proto, d->proto == PROBE_UDP ? "udp" : "tcp") != 0) return 0;
+    const char* stateName = r->field[DELTA_COL_STATE];
+    int state = PROBE_OPEN;
+    if (strcmp(stateName, "open|filtered") == 0 && d->proto == PROBE_UDP) state = PROBE_FILTERED;
+    else if (stateName[0] && strcmp(stateName, "open") != 0) return 0;
+
+    int h = delta_key_find(d, r->field[DELTA_COL_HOST]);
+    if (h < 0) h = delta_key_find(d, r->field[DELTA_COL_IP]);
+    if (h < 0) return 0;
+
+    DeltaEntry e;
+    e.bit = (unsigned long long)h * d->portCount + d->portIndex[port];
+    if (delta_test(d, e.bit)) return 0;
+    e.index = (unsigned long long)d->portIndex[port] * d->hostCount + h;
+    e.state = state;
+    e.service = delta_strdup(d, r->field[DELTA_COL_SERVICE]);
+    if (!delta_append(&d->base, &e)) return 0;
+    d->bits[e.bit >> 6] |= 1ULL << (e.bit & 63);
+    return 1;
+}
+
+static int delta_cmp_index(const void* a, const void* b) {
+    unsigned long long x = ((const DeltaEntry*)a)->index, y = ((const DeltaEntry*)b)->index;
+    return x < y ? -1 : x > y;
+}
+
+static int delta_cmp_bit(const void* a, const void* b) {
+    unsigned long long x = ((const DeltaEntry*)a)->bit, y = ((const DeltaEntry*)b)->bit;
+    return x < y ? -1 : x > y;
+}
+
+int delta_load(DeltaIndex* d, const wchar_t* path) {
+    FILE* f = platform_wfopen(path, L"rb");
+    if (!f) return -1;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char* text = (char*)malloc(size > 0 ? (size_t)size + 1 : 1);
+    size_t got = text && size > 0 ? fread(text, 1, (size_t)size, f) : 0;
+    fclose(f);
+    if (!text) return -1;
+    text[got] = 0;
+
+    DeltaRow* row = (DeltaRow*)malloc(sizeof(DeltaRow));
+    int cols[DELTA_COL_COUNT + 32];     // CSV：第 i 列 -> DELTA_COL_*，-1 = 不用
+    int colCount = 0, csv = -1;
+    char* line = text;
+    if ((unsigned char)line[0] == 0xEF && (unsigned char)line[1] == 0xBB && (unsigned char)line[2] == 0xBF) line += 3;
+    while (row && line && *line) {
+        char* next = strchr(line, '\n');
+        if (next) *next++ = 0;
+        size_t len = strlen(line);
+        while (len > 0 && (line[len - 1] == '\r' || line[len - 1] == ' ')) line[--len] = 0;
+        while (*line == ' ' || *line == '\t') line++;
+        if (*line) {
+            memset(row, 0, sizeof(DeltaRow));
+            if (csv < 0) csv = (*line != '{');
+            if (!csv) {
+                delta_parse_json(line, row);
+                delta_add_row(d, row);
+            } else if (colCount == 0) {
+                // 首行为表头
+                char name[DELTA_FIELD_MAX];
+                const char* p = line;
+                while (colCount < (int)(sizeof(cols) / sizeof(cols[0])) && delta_csv_field(&p, name, sizeof(name))) {
+                    cols[colCount++] = delta_column(name);
+                }
+            } else {
+                char value[DELTA_FIELD_MAX];
+                const char* p = line;
+                for (int c = 0; c < colCount && delta_csv_field(&p, value, sizeof(value)); c++) {
+                    if (cols[c] >= 0) memcpy(row->field[cols[c]], value, sizeof(value));
+                }
+                delta_add_row(d, row);
+            }
+        }
+        line = next;
+    }
+    free(row);
+    free(text);
+
+    qsort(d->base.items, d->base.count, sizeof(DeltaEntry), delta_cmp_index);
+    d->stats.baseline = d->base.count;
+    return d->base.count;
+}
+
+// --- 扫描过程 ---
+static const DeltaEntry* delta_find(const DeltaIndex* d, unsigned long long index) {
+    DeltaEntry key;
+    key.index = index;
+    return (const DeltaEntry*)bsearch(&key, d->base.items, d->base.count, sizeof(DeltaEntry), delta_cmp_index);
+}
+
+// 没能得出结论的 (主机未解析、本地错误) 沿用上次的记录，下次不会误报为新开放
+static void delta_carry(DeltaIndex* d, const DeltaEntry* e) {
+    delta_append(&d->now, e);
+}
+
+static int delta_usable(const DeltaIndex* d, const DeltaEntry* e) {
+    return d->targets[e->index % d->hostCount].family != 0;
+}
+
+// 取出一个后立即越过其后不可用的条目，最后一个发出后首轮即可判定为发完
+static void delta_skip_unusable(DeltaIndex* d) {
+    while (d->basePos < d->base.count && !delta_usable(d, &d->base.items[d->basePos])) {
+        delta_carry(d, &d->base.items[d->basePos++]);
+    }
+}
+
+int delta_next(DeltaIndex* d, unsigned long long* index) {
+    delta_skip_unusable(d);
+    if (d->basePos >= d->base.count) return 0;
+    *index = d->base.items[d->basePos++].index;
+    d->pending++;
+    d->issued++;
+    delta_skip_unusable(d);
+    return 1;
+}
+
+int delta_known(const DeltaIndex* d, int target, int portIdx) {
+    return delta_test(d, (unsigned long long)target * d->portCount + portIdx);
+}
+
+int delta_observe(DeltaIndex* d, int target, int port, int state, const wchar_t* service) {
+    if (target < 0 || target >= d->hostCount || port < 0 || port > 65535 || d->portIndex[port] < 0) return DELTA_NONE;
+    int portIdx = d->portIndex[port];
+    unsigned long long index = (unsigned long long)portIdx * d->hostCount + target;
+    int known = delta_known(d, target, portIdx);
+    const DeltaEntry* prev = known ? delta_find(d, index) : NULL;
+    if (known) d->pending--;
+    if (state == PROBE_ERROR) {
+        if (prev) delta_carry(d, prev);
+        return DELTA_NONE;
+    }
+
+    int open = state == PROBE_OPEN || (d->proto == PROBE_UDP && state == PROBE_FILTERED);
+    if (open) {
+        char text[DELTA_FIELD_MAX];
+        int n = wide_to_utf8(service ? service : L"", text, DELTA_FIELD_MAX - 1);
+        text[n] = 0;
+        DeltaEntry e;
+        e.index = index;
+        e.bit = (unsigned long long)target * d->portCount + portIdx;
+        e.state = state;
+        e.service = delta_strdup(d, text);
+        delta_append(&d->now, &e);
+        if (!known) { d->stats.added++; return DELTA_NEW; }
+        d->stats.stillOpen++;
+        // 两次都识别出服务且不同才算变化；本次未开启识别时不比较
+        if (prev && prev->service[0] && text[0] && strcmp(prev->service, text) != 0) {
+            d->stats.changed++;
+            return DELTA_CHANGED;
+        }
+        return DELTA_NONE;
+    }
+    if (!known) return DELTA_NONE;
+    d->stats.closed++;
+    return DELTA_CLOSED;
+}
+
+int delta_first_pass_done(DeltaIndex* d) {
+    if (d->firstPassReported || d->issued == 0 || d->basePos < d->base.count || d->pending > 0) return 0;
+    d->firstPassReported = 1;
+    return 1;
+}
+
+const char* delta_previous_service(const DeltaIndex* d, int target, int port) {
+    if (target < 0 || target >= d->hostCount || port < 0 || port > 65535 || d->portIndex[port] < 0) return "";
+    const DeltaEntry* e = delta_find(d, (unsigned long long)d->portIndex[port] * d->hostCount + target);
+    return e ? e->service : "";
+}
+
+const char* delta_change_name(int change) {
+    if (change == DELTA_NEW) return "new";
+    if (change == DELTA_CLOSED) return "closed";
+    if (change == DELTA_CHANGED) return "changed";
+    return "";
+}
+
+void delta_stats(const DeltaIndex* d, DeltaStats* out) {
+    *out = d->stats;
+    out->current = d->now.count;
+}
+
+// --- 快照 ---
+// 与 scan 的 NDJSON 输出同样的字段，按主机、端口排序；先写临时文件再替换，中途失败不破坏旧基线
+int delta_save(const DeltaIndex* d, const wchar_t* path) {
+    size_t len = wcslen(path);
+    wchar_t* tmp = (wchar_t*)malloc((len + 8) * sizeof(wchar_t));
+    if (!tmp) return -1;
+    memcpy(tmp, path, len * sizeof(wchar_t));
+    memcpy(tmp + len, L".tmp", 5 * sizeof(wchar_t));
+    FILE* f = platform_wfopen(tmp, L"wb");
+    RowWriter w;
+    if (!f || !writer_init(&w, f, OUTPUT_NDJSON, 0)) {
+        if (f) fclose(f);
+        free(tmp);
+        return -1;
+    }
+
+    qsort(d->now.items, d->now.count, sizeof(DeltaEntry), delta_cmp_bit);
+    for (int i = 0; i < d->now.count; i++) {
+        const DeltaEntry* e = &d->now.items[i];
+        int h = (int)(e->index % d->hostCount);
+        char ip[64];
+        delta_target_ip(&d->targets[h], ip, sizeof(ip));
+        writer_str(&w, "host", d->names[h] ? d->names[h] : ip);
+        writer_str(&w, "ip", ip);
+        writer_int(&w, "port", d->ports[e->index / d->hostCount]);
+        writer_str(&w, "proto", d->proto == PROBE_UDP ? "udp" : "tcp");
+        writer_str(&w, "state", e->state == PROBE_OPEN ? "open" : "open|filtered");
+        writer_str(&w, "service", e->service);
+        writer_end_row(&w);
+    }
+    writer_flush(&w);
+    int ok = !w.failed;
+    writer_free(&w);
+    ok &= (fclose(f) == 0);
+    ok = ok && platform_replace_file(tmp, path);
+    if (!ok) platform_remove_file(tmp);
+    free(tmp);
+    return ok ? d->now.count : -1;
+}
@@ -0,0 +1,1095 @@
+#include "network_modules.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <linux/io_uring.h>
+#endif
+
+// --- 并发探测引擎 ---
+// 维护一个固定大小的在途探测窗口，等待就绪：
+// TCP 以可写 + SO_ERROR 判定连接结果，UDP 以可读 (回包或 ICMP 错误) 判定。
+// I/O 后端：Windows 用 select；Linux 默认用 epoll。纯 TCP 连接探测可显式选用 io_uring，
+// 把 socket 创建、connect、链接超时与 close 批量提交，每批只需一次系统调用；
+// [修改] 回环基准 (含大量挂起探测的场景) 上未测得比 epoll 更快，因此不作为默认选择。
+// 需要延后执行的探测 (UDP 限速、重发) 进入按到期时间排序的小顶堆；
+// 在途探测的截止时间另有一个按槽位编号索引的小顶堆，下次唤醒与超时检查都只看堆顶。
+// 发包速率由令牌桶限制，并按超时比例做 AIMD 调整；同一网段的在途探测数另有上限。
+// 在途上限不超过进程句柄数与本机临时端口数；本地资源报错 (句柄、临时端口耗尽) 的探测
+// 退避后重发并临时收缩在途上限，不当作关闭或过滤上报。已建立的连接以 RST 关闭，不留 TIME_WAIT。
+// 指定多个源地址时每个探测绑定其中之一，临时端口预算按地址数倍增。
+
+#define ENGINE_DEFAULT_INFLIGHT  256
+#define ENGINE_MAX_INFLIGHT      16384   // epoll / io_uring 不受 FD_SETSIZE 限制
+#define ENGINE_TICK_MS           50      // select 最长等待，保证及时响应中止信号
+#define ENGINE_DEFAULT_TIMEOUT   2000
+#define ENGINE_MIN_TIMEOUT       50
+#define ENGINE_PENDING_CAP       4096    // 延后队列上限，超出时暂停从生成器取新探测
+#define ENGINE_SOCKET_RETRY_MS   100     // socket() 失败 (资源不足) 后的重试间隔
+#define ENGINE_SOCKET_GIVEUP     50      // 无在途探测时 socket() 连续失败的放弃阈值
+#define ENGINE_MIN_INFLIGHT      8       // 本地资源报错后在途上限收缩的下限
+#define ENGINE_FD_RESERVE        64      // 留给进程其他文件与 socket 的句柄
+#define ENGINE_PORT_RESERVE      1024    // 留给本机其他连接的临时端口
+
+#define BANNER_BUF_SIZE          512     // 每个连接的 Banner 缓冲区 (池化复用)
+#define BANNER_DEFAULT_WAIT_MS   1500
+
+#define PHASE_CONNECT            0
+#define PHASE_BANNER             1       // 已连接，被动等待服务端 Banner
+#define PHASE_PROBE              2       // 已发送服务探测请求，等待应答
+#define PHASE_SOCKET             3       // io_uring: 等待异步创建 socket
+
+// io_uring 完成事件的 user_data：槽位编号 << 2 | 类型
+#define URING_TAG_IGNORE         0ULL    // 链接超时与 close 的完成事件
+#define URING_TAG_SOCKET         1ULL
+#define URING_TAG_CONNECT        2ULL
+#define URING_USER(id, tag)      (((unsigned long long)(id) << 2) | (tag))
+
+#define RATE_BURST_MS            20      // 令牌桶容量：最多积攒 20ms 的令牌，避免突发
+#define RATE_MIN_PPS             10      // AIMD 降速下限
+#define AIMD_WINDOW_MS           1000
+#define AIMD_MIN_SAMPLES         20      // 窗口内完成数太少时不做判断
+#define STATS_INTERVAL_MS        500
+
+#define UDP_PACE_MIN_MS          50      // 检测到 ICMP 限速后的最小发包间隔
+#define UDP_PACE_MAX_MS          1000    // 常见系统默认每秒 1 个端口不可达
+#define UDP_RATELIMIT_EXTRA      3       // 疑似 ICMP 限速时额外允许的重发次数
+
+typedef struct {
+    SOCKET sock;
+    int id;                        // 稳定编号：在途窗口会压缩移动，epoll / io_uring 事件按编号找回槽位
+    int target;
+    int port;
+    int attempt;
+    int phase;
+    char* buf;
+    int bufLen;
+    unsigned long long sentUs;     // 本次发包时间 (微秒单调时钟)，用于 RTT 采样
+} EngineSlot;
+
+typedef struct {
+    unsigned long long due;
+    int target;
+    int port;
+    int attempt;
+} EnginePending;
+
+typedef struct {
+    unsigned long long nextSlot;   // UDP: 下一次允许向该主机发包的时间
+    int intervalMs;                // UDP: 发包间隔，疑似 ICMP 限速时加大
+    int icmpSeen;                  // 已收到的端口不可达数量
+    double srtt;                   // 平滑 RTT (ms)
+    double rttvar;                 // RTT 偏差 (ms)
+    int rttSamples;
+} EngineHost;
+
+typedef struct {
+    int target;
+    int port;
+    int attempt;
+    int next;
+} EngineParked;
+
+typedef struct {
+    double rate;                   // 当前速率 (令牌/秒)
+    double tokens;
+    double burst;
+    unsigned long long last;       // 上次补充令牌的时间 (微秒)
+} TokenBucket;
+
+typedef struct {
+    const ProbeEngineConfig* cfg;
+    int backend;                   // 实际使用的 I/O 后端
+    int maxInFlight;
+    int minTimeoutMs;
+    int maxTimeoutMs;
+    EngineSlot* slots;
+    int inFlight;
+    int* slotOf;                   // 编号 -> 在途窗口下标，-1 = 空闲
+    int* freeIds;
+    int freeIdCount;
+#ifdef __linux__
+    int epfd;
+    struct epoll_event* events;
+    UringRing* ring;
+    int uringSocket;               // 内核支持 IORING_OP_SOCKET，socket 创建也走环
+#endif
+    EnginePending* heap;
+    int heapSize;
+    int* timerHeap;                // 在途截止时间：按到期排序的槽位编号
+    int* timerPos;                 // 编号 -> 在 timerHeap 中的位置，-1 = 未设截止时间
+    unsigned long long* timerDue;  // 编号 -> 截止时间
+    int timerCount;
+    EngineHost* hosts;
+    char* bufPool;                 // maxInFlight 个固定大小缓冲区
+    char** freeBufs;
+    int freeCount;
+    int bannerWaitMs;
+    int genDone;
+    int socketFailures;
+    int completed;
+
+    // 本地资源：报错时在途上限减半，一个 AIMD 窗口内不再报错则线性回升
+    int inFlightLimit;
+    unsigned long long localBackoffAt;
+    long long localErrors;
+
+    // 速率与网段并发控制
+    TokenBucket bucket;
+    int* groupOf;                  // 目标 -> 网段组
+    int* groupInFlight;
+    int* groupHead;                // 被网段上限挡住的探测 (按组排队)
+    int* groupTail;
+    EngineParked* parked;
+    int parkedFree;
+    int parkedCount;
+
+    // AIMD 窗口与运行统计
+    unsigned long long windowStart;
+    int windowDone;
+    int windowTimeouts;
+    double timeoutBaseline;        // 超时比例的平滑基线，-1 表示尚未建立
+    int timeoutPct;
+    long long sent;
+    long long sentAtStats;
+    unsigned long long statsAt;
+} Engine;
+
+// --- 延后队列 (按 due 排序的小顶堆) ---
+static void heap_push(Engine* e, unsigned long long due, int target, int port, int attempt) {
+    int i = e->heapSize++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (e->heap[parent].due <= due) break;
+        e->heap[i] = e->heap[parent];
+        i = parent;
+    }
+    e->heap[i].due = due;
+    e->heap[i].target = target;
+    e->heap[i].port = port;
+    e->heap[i].attempt = attempt;
+}
+
+static EnginePending heap_pop(Engine* e) {
+    EnginePending top = e->heap[0];
+    EnginePending last = e->heap[--e->heapSize];
+    int i = 0;
+    for (;;) {
+        int child = i * 2 + 1;
+        if (child >= e->heapSize) break;
+        if (child + 1 < e->heapSize && e->heap[child + 1].due < e->heap[child].due) child++;
+        if (last.due <= e->heap[child].due) break;
+        e->heap[i] = e->heap[child];
+        i = child;
+    }
+    if (e->heapSize > 0) e->heap[i] = last;
+    return top;
+}
+
+// --- 在途截止时间 (按槽位编号索引的小顶堆) ---
+// 设置、取消为 O(log n)，取最早截止时间为 O(1)；超时检查只弹出已到期的槽位，不再遍历整个在途窗口
+static void timer_place(Engine* e, int pos, int id) {
+    e->timerHeap[pos] = id;
+    e->timerPos[id] = pos;
+}
+
+static void timer_sift_up(Engine* e, int pos) {
+    int id = e->timerHeap[pos];
+    while (pos > 0) {
+        int parent = (pos - 1) / 2;
+        if (e->timerDue[e->timerHeap[parent]] <= e->timerDue[id]) break;
+        timer_place(e, pos, e->timerHeap[parent]);
+        pos = parent;
+    }
+    timer_place(e, pos, id);
+}
+
+static void timer_sift_down(Engine* e, int pos) {
+    int id = e->timerHeap[pos];
+    for (;;) {
+        int child = pos * 2 + 1;
+        if (child >= e->timerCount) break;
+        if (child + 1 < e->timerCount && e->timerDue[e->timerHeap[child + 1]] < e->timerDue[e->timerHeap[child]]) child++;
+        if (e->timerDue[id] <= e->timerDue[e->timerHeap[child]]) break;
+        timer_place(e, pos, e->timerHeap[child]);
+        pos = child;
+    }
+    timer_place(e, pos, id);
+}
+
+static void timer_set(Engine* e, int id, unsigned long long due) {
+    int pos = e->timerPos[id];
+    if (pos < 0) {
+        e->timerDue[id] = due;
+        timer_place(e, e->timerCount, id);
+        timer_sift_up(e, e->timerCount++);
+        return;
+    }
+    unsigned long long old = e->timerDue[id];
+    e->timerDue[id] = due;
+    if (due < old) timer_sift_up(e, pos);
+    else timer_sift_down(e, pos);
+}
+
+static void timer_clear(Engine* e, int id) {
+    int pos = e->timerPos[id];
+    if (pos < 0) return;
+    e->timerPos[id] = -1;
+    int last = e->timerHeap[--e->timerCount];
+    if (pos == e->timerCount) return;
+    // 末尾元素补到空位，可能需要上移也可能需要下移
+    timer_place(e, pos, last);
+    timer_sift_up(e, pos);
+    timer_sift_down(e, e->timerPos[last]);
+}
+
+// --- UDP 按主机限速 ---
+static unsigned long long udp_host_slot(EngineHost* h, unsigned long long now) {
+    unsigned long long at = h->nextSlot > now ? h->nextSlot : now;
+    h->nextSlot = at + h->intervalMs;
+    return at;
+}
+
+static void udp_host_backoff(EngineHost* h) {
+    h->intervalMs = h->intervalMs ? h->intervalMs * 2 : UDP_PACE_MIN_MS;
+    if (h->intervalMs > UDP_PACE_MAX_MS) h->intervalMs = UDP_PACE_MAX_MS;
+}
+
+static void udp_host_relax(EngineHost* h) {
+    if (h->intervalMs == 0) return;
+    h->intervalMs -= h->intervalMs / 8;
+    if (h->intervalMs < UDP_PACE_MIN_MS) h->intervalMs = UDP_PACE_MIN_MS;
+}
+
+// --- 超时估计 ---
+// 与 TCP 重传超时 (RFC 6298) 相同：SRTT + 4 * RTTVAR，按重试次数指数退避，并限制在上下限内
+static void host_rtt_sample(EngineHost* h, double rtt) {
+    if (h->rttSamples == 0) {
+        h->srtt = rtt;
+        h->rttvar = rtt / 2;
+    } else {
+        double delta = h->srtt > rtt ? h->srtt - rtt : rtt - h->srtt;
+        h->rttvar = h->rttvar * 0.75 + delta * 0.25;
+        h->srtt = h->srtt * 0.875 + rtt * 0.125;
+    }
+    h->rttSamples++;
+}
+
+static int host_timeout(const Engine* e, const EngineHost* h, int attempt) {
+    if (h->rttSamples == 0) return e->maxTimeoutMs;
+    double rto = h->srtt + 4 * h->rttvar;
+    for (int i = 0; i < attempt && rto < e->maxTimeoutMs; i++) rto *= 2;
+    if (rto < e->minTimeoutMs) return e->minTimeoutMs;
+    if (rto > e->maxTimeoutMs) return e->maxTimeoutMs;
+    return (int)rto;
+}
+
+static void engine_rtt_sample(Engine* e, const EngineSlot* s, unsigned long long nowUs) {
+    unsigned long long rttUs = nowUs > s->sentUs ? nowUs - s->sentUs : 0;
+    host_rtt_sample(&e->hosts[s->target], rttUs / 1000.0);
+    metrics_observe(METRIC_HIST_RTT, rttUs);
+    if (e->cfg->onRtt) e->cfg->onRtt(e->cfg->ctx, s->target, s->port, rttUs);
+}
+
+// --- 令牌桶 ---
+static void bucket_set_rate(TokenBucket* b, double rate) {
+    b->rate = rate;
+    b->burst = rate * RATE_BURST_MS / 1000.0;
+    if (b->burst < 1.0) b->burst = 1.0;
+    if (b->tokens > b->burst) b->tokens = b->burst;
+}
+
+static void bucket_refill(TokenBucket* b, unsigned long long nowUs) {
+    if (nowUs > b->last) {
+        b->tokens += (double)(nowUs - b->last) * b->rate / 1000000.0;
+        if (b->tokens > b->burst) b->tokens = b->burst;
+    }
+    b->last = nowUs;
+}
+
+// 距离下一个令牌可用的毫秒数 (至少 1ms)
+static int bucket_wait_ms(const TokenBucket* b) {
+    double ms = (1.0 - b->tokens) * 1000.0 / b->rate;
+    return ms < 1.0 ? 1 : (int)ms + 1;
+}
+
+// --- 网段分组 ---
+typedef struct {
+    int family;
+    unsigned long long key;
+    int index;
+} PrefixKey;
+
+static int compare_prefix(const void* a, const void* b) {
+    const PrefixKey* x = (const PrefixKey*)a;
+    const PrefixKey* y = (const PrefixKey*)b;
+    if (x->family != y->family) return x->family - y->family;
+    return (x->key > y->key) - (x->key < y->key);
+}
+
+// IPv4 按 /24、IPv6 按 /64 归组，组内共享在途上限
+static int engine_build_groups(Engine* e) {
+    int n = e->cfg->targetCount;
+    PrefixKey* keys = (PrefixKey*)malloc(sizeof(PrefixKey) * n);
+    e->groupOf = (int*)malloc(sizeof(int) * n);
+    e->groupInFlight = (int*)calloc(n, sizeof(int));
+    e->groupHead = (int*)malloc(sizeof(int) * n);
+    e->groupTail = (int*)malloc(sizeof(int) * n);
+    if (!keys || !e->groupOf || !e->groupInFlight || !e->groupHead || !e->groupTail) { free(keys); return 0; }
+
+    for (int i = 0; i < n; i++) {
+        const ProbeTarget* t = &e->cfg->targets[i];
+        keys[i].family = t->family;
+        keys[i].index = i;
+        keys[i].key = 0;
+        if (t->family == 4) {
+            keys[i].key = ntohl(t->addr.v4.sin_addr.s_addr) >> 8;
+        } else if (t->family == 6) {
+            for (int k = 0; k < 8; k++) keys[i].key = (keys[i].key << 8) | t->addr.v6.sin6_addr.s6_addr[k];
+        }
+    }
+    qsort(keys, n, sizeof(PrefixKey), compare_prefix);
+
+    int group = -1;
+    for (int i = 0; i < n; i++) {
+        if (i == 0 || compare_prefix(&keys[i - 1], &keys[i]) != 0) group++;
+        e->groupOf[keys[i].index] = group;
+        e->groupHead[i] = -1;
+        e->groupTail[i] = -1;
+    }
+    free(keys);
+    return 1;
+}
+
+static void engine_park(Engine* e, int target, int port, int attempt) {
+    int node = e->parkedFree;
+    int g = e->groupOf[target];
+    e->parkedFree = e->parked[node].next;
+    e->parked[node].target = target;
+    e->parked[node].port = port;
+    e->parked[node].attempt = attempt;
+    e->parked[node].next = -1;
+    if (e->groupTail[g] >= 0) e->parked[e->groupTail[g]].next = node;
+    else e->groupHead[g] = node;
+    e->groupTail[g] = node;
+    e->parkedCount++;
+}
+
+// 网段内一个探测结束，放行该组排队中的下一个
+static void engine_unpark(Engine* e, int g) {
+    int node = e->groupHead[g];
+    if (node < 0) return;
+    e->groupHead[g] = e->parked[node].next;
+    if (e->groupHead[g] < 0) e->groupTail[g] = -1;
+    heap_push(e, 0, e->parked[node].target, e->parked[node].port, e->parked[node].attempt);
+    e->parked[node].next = e->parkedFree;
+    e->parkedFree = node;
+    e->parkedCount--;
+}
+
+// --- AIMD 调速与统计 ---
+static void engine_adjust_rate(Engine* e, unsigned long long now) {
+    if (now - e->windowStart < AIMD_WINDOW_MS) return;
+
+    if (e->windowDone >= AIMD_MIN_SAMPLES) {
+        double ratio = (double)e->windowTimeouts / e->windowDone;
+        e->timeoutPct = (int)(ratio * 100);
+        if (e->cfg->pps > 0) {
+            // 超时比例明显高于基线：疑似拥塞或被限速，速率减半；否则线性回升到设定值
+            if (e->timeoutBaseline >= 0 && ratio > e->timeoutBaseline * 1.5 + 0.1) {
+                double rate = e->bucket.rate / 2;
+                bucket_set_rate(&e->bucket, rate < RATE_MIN_PPS ? RATE_MIN_PPS : rate);
+            } else if (e->bucket.rate < e->cfg->pps) {
+                double step = e->cfg->pps / 20.0;
+                double rate = e->bucket.rate + (step < 1 ? 1 : step);
+                bucket_set_rate(&e->bucket, rate > e->cfg->pps ? e->cfg->pps : rate);
+            }
+        }
+        e->timeoutBaseline = e->timeoutBaseline < 0 ? ratio : e->timeoutBaseline * 0.8 + ratio * 0.2;
+        e->windowDone = 0;
+        e->windowTimeouts = 0;
+    }
+    if (e->inFlightLimit < e->maxInFlight && now - e->localBackoffAt >= AIMD_WINDOW_MS) {
+        int step = e->maxInFlight / 16;
+        e->inFlightLimit += step < 1 ? 1 : step;
+        if (e->inFlightLimit > e->maxInFlight) e->inFlightLimit = e->maxInFlight;
+    }
+    e->windowStart = now;
+}
+
+static void engine_report_stats(Engine* e, unsigned long long now) {
+    if (!e->cfg->onStats || now - e->statsAt < STATS_INTERVAL_MS) return;
+    ProbeEngineStats st;
+    st.sent = e->sent;
+    st.completed = e->completed;
+    st.inFlight = e->inFlight;
+    st.rateLimit = e->cfg->pps > 0 ? (int)e->bucket.rate : 0;
+    st.effectivePps = (int)((e->sent - e->sentAtStats) * 1000 / (long long)(now - e->statsAt));
+    st.timeoutPct = e->timeoutPct;
+    st.backend = e->backend;
+    st.inFlightLimit = e->inFlightLimit;
+    st.localErrors = e->localErrors;
+    e->cfg->onStats(e->cfg->ctx, &st);
+    e->sentAtStats = e->sent;
+    e->statsAt = now;
+}
+
+// 计算下一次需要醒来的时间：在途超时、延后队列、令牌补充三者取最早
+static unsigned long long engine_next_wake(Engine* e, unsigned long long now) {
+    unsigned long long wake = now + ENGINE_TICK_MS;
+    if (e->timerCount > 0 && e->timerDue[e->timerHeap[0]] < wake) wake = e->timerDue[e->timerHeap[0]];
+    if (e->heapSize > 0 && e->heap[0].due < wake) wake = e->heap[0].due;
+    if (e->cfg->pps > 0 && e->bucket.tokens < 1.0 && e->inFlight < e->inFlightLimit &&
+        (e->heapSize > 0 || !e->genDone)) {
+        unsigned long long t = now + bucket_wait_ms(&e->bucket);
+        if (t < wake) wake = t;
+    }
+    return wake;
+}
+
+// --- 探测生命周期 ---
+static void engine_report(Engine* e, int target, int port, int state, const char* data, int len) {
+    if (state == PROBE_CLOSED && e->cfg->proto == PROBE_UDP) {
+        e->hosts[target].icmpSeen++;
+        udp_host_relax(&e->hosts[target]);
+    }
+    e->completed++;
+    e->windowDone++;
+    metrics_add(METRIC_RESULTS, 1);
+    if (state == PROBE_FILTERED) e->windowTimeouts++;
+    if (e->cfg->onResult) e->cfg->onResult(e->cfg->ctx, target, port, state, data, len);
+}
+
+static void engine_close(Engine* e, SOCKET sock) {
+    if (sock == INVALID_SOCKET) return;
+#ifdef __linux__
+    // io_uring 下 close 随下一批提交执行
+    if (e->ring && uring_prep_close(e->ring, sock, URING_TAG_IGNORE)) return;
+#else
+    (void)e;
+#endif
+    closesocket(sock);
+}
+
+static EngineSlot* engine_alloc_slot(Engine* e, int target, int port, int attempt) {
+    EngineSlot* s = &e->slots[e->inFlight];
+    s->id = e->freeIds[--e->freeIdCount];
+    e->slotOf[s->id] = e->inFlight++;
+    s->sock = INVALID_SOCKET;
+    s->target = target;
+    s->port = port;
+    s->attempt = attempt;
+    s->phase = PHASE_CONNECT;
+    s->buf = NULL;
+    s->bufLen = 0;
+    e->groupInFlight[e->groupOf[target]]++;
+    metrics_add(METRIC_INFLIGHT, 1);
+    return s;
+}
+
+// 关闭 socket、归还缓冲区与网段配额，并从在途窗口中移除
+static void engine_release(Engine* e, int idx) {
+    EngineSlot* s = &e->slots[idx];
+    int g = e->groupOf[s->target];
+    engine_close(e, s->sock);
+    if (s->buf) e->freeBufs[e->freeCount++] = s->buf;
+    e->groupInFlight[g]--;
+    engine_unpark(e, g);
+    timer_clear(e, s->id);
+    e->slotOf[s->id] = -1;
+    e->freeIds[e->freeIdCount++] = s->id;
+    e->slots[idx] = e->slots[--e->inFlight];
+    if (idx < e->inFlight) e->slotOf[e->slots[idx].id] = idx;
+    metrics_add(METRIC_INFLIGHT, -1);
+}
+
+static void engine_finish(Engine* e, int idx, int state, const char* data, int len) {
+    EngineSlot* s = &e->slots[idx];
+    unsigned long long nowUs = platform_tick_us();
+    // 只有已建立的连接会在关闭后进入 TIME_WAIT，握手未完成的直接关闭即可
+    if (state == PROBE_OPEN && e->cfg->proto == PROBE_TCP && s->sock != INVALID_SOCKET) platform_set_abortive_close(s->sock);
+    metrics_observe(METRIC_HIST_PROBE, nowUs > s->sentUs ? nowUs - s->sentUs : 0);
+    engine_report(e, s->target, s->port, state, data, len);
+    engine_release(e, idx);
+}
+
+// epoll 下登记关注的事件 (modify = 1 时为已登记 socket 改换事件)；其他后端无需登记
+static int engine_watch(Engine* e, const EngineSlot* s, int readable, int modify) {
+#ifdef __linux__
+    if (e->backend == PROBE_BACKEND_EPOLL) {
+        struct epoll_event ev;
+        ev.events = readable ? EPOLLIN : EPOLLOUT;
+        ev.data.u64 = (unsigned long long)s->id;
+        return epoll_ctl(e->epfd, modify ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, s->sock, &ev) == 0;
+    }
+#else
+    (void)e; (void)s; (void)readable; (void)modify;
+#endif
+    return 1;
+}
+
+// --- Banner 抓取 ---
+static void engine_send_probe(Engine* e, EngineSlot* s, const char* probe, int len, unsigned long long now) {
+    send(s->sock, probe, len, PLATFORM_SEND_FLAGS);
+    s->phase = PHASE_PROBE;
+    timer_set(e, s->id, now + e->bannerWaitMs);
+}
+
+static void engine_begin_banner(Engine* e, int idx, unsigned long long now) {
+    EngineSlot* s = &e->slots[idx];
+    s->buf = e->freeBufs[--e->freeCount];
+    s->bufLen = 0;
+    engine_watch(e, s, 1, 1);
+
+    int len = 0;
+    const char* probe = service_probe_for_port(s->port, &len);
+    if (probe) {
+        engine_send_probe(e, s, probe, len, now);
+    } else {
+        s->phase = PHASE_BANNER;
+        timer_set(e, s->id, now + e->bannerWaitMs);
+    }
+}
+
+static void engine_read_banner(Engine* e, int idx) {
+    EngineSlot* s = &e->slots[idx];
+    int n = recv(s->sock, s->buf + s->bufLen, BANNER_BUF_SIZE - s->bufLen, 0);
+    if (n > 0) {
+        // 首个数据块已足以识别服务，不再等待后续内容
+        s->bufLen += n;
+    } else if (n < 0 && platform_last_error() == WSAEWOULDBLOCK) {
+        return;
+    }
+    // 连接已建立，即便对端随即关闭或复位也视为开放
+    engine_finish(e, idx, PROBE_OPEN, s->buf, s->bufLen);
+}
+
+// 目标地址填入端口，返回地址长度
+static int engine_target_addr(const ProbeTarget* t, int port, ProbeTarget* dst) {
+    *dst = *t;
+    if (t->family == 6) {
+        dst->addr.v6.sin6_port = htons((unsigned short)port);
+        return sizeof(dst->addr.v6);
+    }
+    dst->addr.v4.sin_port = htons((unsigned short)port);
+    return sizeof(dst->addr.v4);
+}
+
+static SOCKET engine_socket(int family, int isUdp) {
+#ifdef SOCK_NONBLOCK
+    // 创建时即设为非阻塞，省去两次 fcntl
+    return socket(family, (isUdp ? SOCK_DGRAM : SOCK_STREAM) | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                  isUdp ? IPPROTO_UDP : IPPROTO_TCP);
+#else
+    SOCKET sock = socket(family, isUdp ? SOCK_DGRAM : SOCK_STREAM, isUdp ? IPPROTO_UDP : IPPROTO_TCP);
+    if (sock != INVALID_SOCKET) platform_set_nonblock(sock);
+    return sock;
+#endif
+}
+
+#ifdef __linux__
+// --- io_uring 后端 (仅 TCP 连接探测) ---
+// 超时由链接在 connect 之后的 LINK_TIMEOUT 负责，槽位自身不进截止时间堆
+static int engine_uring_connect(Engine* e, EngineSlot* s) {
+    const ProbeTarget* t = &e->cfg->targets[s->target];
+    if (!source_bind(s->sock, source_pick(e->cfg->sources, t->family, (unsigned int)s->target))) return 0;
+    ProbeTarget dst;
+    int addrLen = engine_target_addr(t, s->port, &dst);
+    s->phase = PHASE_CONNECT;
+    s->sentUs = platform_tick_us();
+    return uring_prep_connect(e->ring, s->sock, (struct sockaddr*)&dst.addr, addrLen,
+                              host_timeout(e, &e->hosts[s->target], s->attempt),
+                              URING_USER(s->id, URING_TAG_CONNECT), URING_TAG_IGNORE);
+}
+
+static int engine_launch_uring(Engine* e, int target, int port, int attempt) {
+    int family = e->cfg->targets[target].family == 6 ? AF_INET6 : AF_INET;
+    EngineSlot* s = engine_alloc_slot(e, target, port, attempt);
+    if (e->uringSocket) {
+        s->phase = PHASE_SOCKET;
+        if (uring_prep_socket(e->ring, family, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP, URING_USER(s->id, URING_TAG_SOCKET))) return 1;
+    } else {
+        // 阻塞模式即可：connect 由 io_uring 异步完成
+        s->sock = socket(family, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+        if (s->sock != INVALID_SOCKET && engine_uring_connect(e, s)) return 1;
+    }
+    engine_release(e, e->inFlight - 1);
+    return 0;
+}
+#endif
+
+// 本地资源耗尽 (句柄、临时端口、内核缓冲) 的错误与目标无关，不能当作扫描结果
+static int engine_local_error(int err) {
+#ifdef __linux__
+    if (err == ENFILE || err == ENOMEM) return 1;
+#endif
+    return err == WSAEADDRNOTAVAIL || err == WSAEADDRINUSE || err == WSAEMFILE || err == WSAENOBUFS;
+}
+
+// 返回 1 表示探测已启动或已得出结果，0 表示本地资源不足 (socket 创建或 connect 报本地错误)
+static int engine_launch(Engine* e, int target, int port, int attempt, unsigned long long now) {
+#ifdef __linux__
+    if (e->backend == PROBE_BACKEND_URING) return engine_launch_uring(e, target, port, attempt);
+#endif
+    const ProbeTarget* t = &e->cfg->targets[target];
+    int isUdp = (e->cfg->proto == PROBE_UDP);
+    SOCKET sock = engine_socket(t->family == 6 ? AF_INET6 : AF_INET, isUdp);
+    if (sock == INVALID_SOCKET) return 0;
+    if (!source_bind(sock, source_pick(e->cfg->sources, t->family, (unsigned int)target))) { closesocket(sock); return 0; }
+
+    ProbeTarget dst;
+    int addrLen = engine_target_addr(t, port, &dst);
+
+    int state = 0;
+    unsigned long long sentUs = platform_tick_us();
+    if (connect(sock, (struct sockaddr*)&dst.addr, addrLen) == SOCKET_ERROR) {
+        int err = platform_last_error();
+        if (engine_local_error(err)) { closesocket(sock); return 0; }
+        if (err != WSAEWOULDBLOCK && err != WSAEINPROGRESS) {
+            state = (err == WSAECONNREFUSED) ? PROBE_CLOSED : PROBE_FILTERED;
+        }
+    }
+
+    if (!state && isUdp) {
+        // UDP 已 connect，端口不可达会以 recv 错误的形式返回
+        int len = 0;
+        const char* payload = udp_probe_payload(port, &len);
+        if (send(sock, payload, len, 0) == SOCKET_ERROR) {
+            if (engine_local_error(platform_last_error())) { closesocket(sock); return 0; }
+            state = PROBE_FILTERED;
+        }
+    }
+
+    if (state) {
+        closesocket(sock);
+        engine_report(e, target, port, state, NULL, 0);
+        return 1;
+    }
+
+    EngineSlot* s = engine_alloc_slot(e, target, port, attempt);
+    s->sock = sock;
+    s->sentUs = sentUs;
+    timer_set(e, s->id, now + host_timeout(e, &e->hosts[target], attempt));
+    if (!engine_watch(e, s, isUdp, 0)) {
+        engine_release(e, e->inFlight - 1);
+        return 0;
+    }
+    return 1;
+}
+
+// 本地资源不足：在途上限减半 (同一阵连串报错只收缩一次)，探测不计重发次数，稍后原样重发；
+// 没有在途探测可等待时连续失败则放弃该探测，以 PROBE_ERROR 上报，避免死循环
+static void engine_launch_failed(Engine* e, int target, int port, int attempt, unsigned long long now) {
+    e->localErrors++;
+    metrics_add(METRIC_LOCAL_ERRORS, 1);
+    if (now - e->localBackoffAt >= ENGINE_SOCKET_RETRY_MS) {
+        int base = e->inFlight < e->inFlightLimit ? e->inFlight : e->inFlightLimit;
+        e->inFlightLimit = base / 2 < ENGINE_MIN_INFLIGHT ? ENGINE_MIN_INFLIGHT : base / 2;
+        e->localBackoffAt = now;
+    }
+    if (e->inFlight == 0 && ++e->socketFailures >= ENGINE_SOCKET_GIVEUP) {
+        e->socketFailures = 0;
+        engine_report(e, target, port, PROBE_ERROR, NULL, 0);
+    } else {
+        heap_push(e, now + ENGINE_SOCKET_RETRY_MS, target, port, attempt);
+    }
+}
+
+// 已在途的探测收到本地错误 (SO_ERROR 或 io_uring 完成结果)：释放槽位后按上面的方式重发
+static void engine_retry_local(Engine* e, int idx, unsigned long long now) {
+    EngineSlot* s = &e->slots[idx];
+    int target = s->target, port = s->port, attempt = s->attempt;
+    engine_release(e, idx);
+    engine_launch_failed(e, target, port, attempt, now);
+}
+
+static void engine_fill(Engine* e, unsigned long long now) {
+    const ProbeEngineConfig* cfg = e->cfg;
+    int isUdp = (cfg->proto == PROBE_UDP);
+
+    if (cfg->pps > 0) bucket_refill(&e->bucket, platform_tick_us());
+
+    while (e->inFlight < e->inFlightLimit) {
+        int target, port, attempt = 0;
+        if (cfg->pps > 0 && e->bucket.tokens < 1.0) break;
+
+        if (e->heapSize > 0 && e->heap[0].due <= now) {
+            EnginePending p = heap_pop(e);
+            target = p.target; port = p.port; attempt = p.attempt;
+        } else {
+            if (e->genDone || e->heapSize + e->parkedCount >= ENGINE_PENDING_CAP) break;
+            if (!cfg->next(cfg->ctx, &target, &port)) { e->genDone = 1; break; }
+            if (target < 0 || target >= cfg->targetCount || cfg->targets[target].family == 0) continue;
+            metrics_add(METRIC_TARGETS, 1);
+            if (isUdp) {
+                unsigned long long due = udp_host_slot(&e->hosts[target], now);
+                if (due > now) { heap_push(e, due, target, port, 0); continue; }
+            }
+        }
+
+        // 网段在途已满：排到该组队尾，等组内有探测结束再放行
+        if (cfg->subnetCap > 0 && e->groupInFlight[e->groupOf[target]] >= cfg->subnetCap) {
+            engine_park(e, target, port, attempt);
+            continue;
+        }
+
+        if (!engine_launch(e, target, port, attempt, now)) {
+            engine_launch_failed(e, target, port, attempt, now);
+            break;
+        }
+        e->socketFailures = 0;
+        e->sent++;
+        metrics_add(METRIC_PROBES_SENT, 1);
+        if (cfg->pps > 0) e->bucket.tokens -= 1.0;
+    }
+}
+
+static void engine_timeout(Engine* e, int idx, unsigned long long now) {
+    EngineSlot* s = &e->slots[idx];
+    metrics_add(METRIC_TIMEOUTS, 1);
+    if (e->cfg->proto == PROBE_UDP) {
+        EngineHost* h = &e->hosts[s->target];
+        int maxAttempts = e->cfg->udpRetries + 1;
+        // 该主机会回 ICMP 却在此处沉默，多半是被目标侧限速：放慢节奏并多给几次机会
+        if (h->icmpSeen > 0) {
+            maxAttempts += UDP_RATELIMIT_EXTRA;
+            udp_host_backoff(h);
+        }
+        if (s->attempt + 1 < maxAttempts) {
+            heap_push(e, udp_host_slot(h, now), s->target, s->port, s->attempt + 1);
+            engine_release(e, idx);
+            return;
+        }
+    } else if (s->phase == PHASE_CONNECT) {
+        // 连接无应答才是疑似过滤的情形，只对它重发；开放/关闭在首次即可确定
+        if (s->attempt < e->cfg->tcpRetries) {
+            heap_push(e, now, s->target, s->port, s->attempt + 1);
+            engine_release(e, idx);
+            return;
+        }
+    } else if (s->phase == PHASE_BANNER) {
+        // 服务端未主动发送 Banner，改为发送通用探测
+        int len = 0;
+        const char* probe = service_fallback_probe(&len);
+        engine_send_probe(e, s, probe, len, now);
+        return;
+    } else if (s->phase == PHASE_PROBE) {
+        engine_finish(e, idx, PROBE_OPEN, s->buf, s->bufLen);
+        return;
+    }
+    engine_finish(e, idx, PROBE_FILTERED, NULL, 0);
+}
+
+// 处理一个就绪的 socket，返回 1 表示已处理 (探测结束或进入下一阶段)，本轮无需再检查超时
+static int engine_on_ready(Engine* e, int idx, int writable, int readable, unsigned long long now, unsigned long long nowUs) {
+    EngineSlot* s = &e->slots[idx];
+    int isUdp = (e->cfg->proto == PROBE_UDP);
+    if (s->phase == PHASE_CONNECT && !isUdp) {
+        if (!writable) return 0;
+        int err = 0;
+        socklen_t len = sizeof(err);
+        getsockopt(s->sock, SOL_SOCKET, SO_ERROR, (char*)&err, &len);
+        if (engine_local_error(err)) { engine_retry_local(e, idx, now); return 1; }
+        // 握手完成或收到 RST 都是一次完整往返
+        if (err == 0 || err == WSAECONNREFUSED) engine_rtt_sample(e, s, nowUs);
+        if (err != 0) {
+            engine_finish(e, idx, err == WSAECONNREFUSED ? PROBE_CLOSED : PROBE_FILTERED, NULL, 0);
+        } else if (e->cfg->grabBanner) {
+            engine_begin_banner(e, idx, now);
+        } else {
+            engine_finish(e, idx, PROBE_OPEN, NULL, 0);
+        }
+        return 1;
+    }
+    if (!readable) return 0;
+    if (isUdp) {
+        char buf[1500];
+        int n = recv(s->sock, buf, sizeof(buf), 0);
+        if (n >= 0) { engine_rtt_sample(e, s, nowUs); engine_finish(e, idx, PROBE_OPEN, buf, n); return 1; }
+        int err = platform_last_error();
+        if (err == WSAECONNRESET || err == WSAECONNREFUSED) { engine_rtt_sample(e, s, nowUs); engine_finish(e, idx, PROBE_CLOSED, NULL, 0); return 1; }
+        if (err != WSAEWOULDBLOCK) { engine_finish(e, idx, PROBE_FILTERED, NULL, 0); return 1; }
+        return 0;
+    }
+    int before = e->inFlight;
+    engine_read_banner(e, idx);
+    return e->inFlight != before;
+}
+
+// 依次处理已到期的截止时间；engine_timeout 总会释放槽位或把截止时间推后，循环必然结束
+static void engine_expire(Engine* e, unsigned long long now) {
+    while (e->timerCount > 0 && e->timerDue[e->timerHeap[0]] <= now) {
+        engine_timeout(e, e->slotOf[e->timerHeap[0]], now);
+    }
+}
+
+static void engine_poll_select(Engine* e, unsigned long long now) {
+    int isUdp = (e->cfg->proto == PROBE_UDP);
+    fd_set readFds, writeFds, exceptFds;
+    FD_ZERO(&readFds);
+    FD_ZERO(&writeFds);
+    FD_ZERO(&exceptFds);
+    SOCKET maxFd = 0;
+    int reading = 0, writing = 0;
+    unsigned long long wake = engine_next_wake(e, now);
+
+    for (int i = 0; i < e->inFlight; i++) {
+        EngineSlot* s = &e->slots[i];
+        // UDP 与 Banner 阶段等可读，TCP 连接阶段等可写；
+        // Windows 下连接被拒只出现在异常集合中，不监听的话 RST 会被拖到超时
+        if (isUdp || s->phase != PHASE_CONNECT) { FD_SET(s->sock, &readFds); reading = 1; }
+        else { FD_SET(s->sock, &writeFds); FD_SET(s->sock, &exceptFds); writing = 1; }
+        if (s->sock > maxFd) maxFd = s->sock;
+    }
+
+    int waitMs = wake > now ? (int)(wake - now) : 0;
+    struct timeval tv;
+    tv.tv_sec = waitMs / 1000;
+    tv.tv_usec = (waitMs % 1000) * 1000;
+
+    int ret = select((int)maxFd + 1, reading ? &readFds : NULL, writing ? &writeFds : NULL, writing ? &exceptFds : NULL, &tv);
+    now = platform_tick_ms();
+    unsigned long long nowUs = platform_tick_us();
+
+    // 倒序遍历：engine_finish 会把末尾元素换到当前位置
+    for (int i = e->inFlight - 1; ret > 0 && i >= 0; i--) {
+        EngineSlot* s = &e->slots[i];
+        engine_on_ready(e, i, FD_ISSET(s->sock, &writeFds) || FD_ISSET(s->sock, &exceptFds), FD_ISSET(s->sock, &readFds), now, nowUs);
+    }
+    engine_expire(e, now);
+}
+
+#ifdef __linux__
+// 只返回就绪的 socket，无需每轮重建并扫描整个集合
+static void engine_poll_epoll(Engine* e, unsigned long long now) {
+    unsigned long long wake = engine_next_wake(e, now);
+    int n = epoll_wait(e->epfd, e->events, e->maxInFlight, wake > now ? (int)(wake - now) : 0);
+    now = platform_tick_ms();
+    unsigned long long nowUs = platform_tick_us();
+
+    for (int k = 0; k < n; k++) {
+        int idx = e->slotOf[e->events[k].data.u64];
+        if (idx < 0) continue;
+        unsigned int ev = e->events[k].events;
+        engine_on_ready(e, idx, (ev & (EPOLLOUT | EPOLLERR | EPOLLHUP)) != 0,
+                        (ev & (EPOLLIN | EPOLLERR | EPOLLHUP)) != 0, now, nowUs);
+    }
+    engine_expire(e, now);
+}
+
+// 一次 io_uring_enter 提交本轮所有操作并等待完成事件
+static void engine_poll_uring(Engine* e, unsigned long long now) {
+    unsigned long long wake = engine_next_wake(e, now);
+    uring_submit(e->ring, wake > now ? (int)(wake - now) : 0);
+    now = platform_tick_ms();
+    unsigned long long nowUs = platform_tick_us();
+
+    unsigned long long data;
+    int res;
+    while (uring_next_cqe(e->ring, &data, &res)) {
+        unsigned long long tag = data & 3;
+        if (tag == URING_TAG_IGNORE) continue;
+        int idx = e->slotOf[data >> 2];
+        if (idx < 0) continue;
+        EngineSlot* s = &e->slots[idx];
+
+        if (tag == URING_TAG_SOCKET) {
+            if (res >= 0) {
+                s->sock = res;
+                e->socketFailures = 0;
+                if (engine_uring_connect(e, s)) continue;
+            }
+            engine_retry_local(e, idx, now);
+            continue;
+        }
+
+        // 链接超时先到时 connect 以 -ECANCELED 结束，按超时处理 (可能重发)
+        if (res == -ECANCELED) { engine_timeout(e, idx, now); continue; }
+        if (engine_local_error(-res)) { engine_retry_local(e, idx, now); continue; }
+        if (res == 0 || res == -ECONNREFUSED) engine_rtt_sample(e, s, nowUs);
+        engine_finish(e, idx, res == 0 ? PROBE_OPEN : res == -ECONNREFUSED ? PROBE_CLOSED : PROBE_FILTERED, NULL, 0);
+    }
+}
+
+// io_uring 只承担 TCP 连接探测 (UDP 与 Banner 需逐包收发)，且要求内核支持所用的操作
+static int uring_usable(UringRing* r) {
+    return r && uring_op_supported(r, IORING_OP_CONNECT) && uring_op_supported(r, IORING_OP_LINK_TIMEOUT) &&
+           uring_op_supported(r, IORING_OP_CLOSE);
+}
+#endif
+
+static void engine_poll(Engine* e, unsigned long long now) {
+#ifdef __linux__
+    if (e->backend == PROBE_BACKEND_URING) { engine_poll_uring(e, now); return; }
+    if (e->backend == PROBE_BACKEND_EPOLL) { engine_poll_epoll(e, now); return; }
+#endif
+    engine_poll_select(e, now);
+}
+
+// 按配置选择 I/O 后端，不可用时依次回退到 epoll、select
+static int engine_open_backend(Engine* e) {
+#ifdef __linux__
+    int want = e->cfg->backend;
+    if (want == PROBE_BACKEND_URING && e->cfg->proto == PROBE_TCP && !e->cfg->grabBanner) {
+        unsigned entries = (unsigned)e->maxInFlight * 2;
+        e->ring = uring_create(entries < 64 ? 64 : entries > 4096 ? 4096 : entries);
+        if (uring_usable(e->ring)) {
+            e->uringSocket = uring_op_supported(e->ring, IORING_OP_SOCKET);
+            return PROBE_BACKEND_URING;
+        }
+        uring_free(e->ring);
+        e->ring = NULL;
+    }
+    if (want != PROBE_BACKEND_SELECT) {
+        e->epfd = epoll_create1(EPOLL_CLOEXEC);
+        e->events = (struct epoll_event*)malloc(sizeof(struct epoll_event) * e->maxInFlight);
+        if (e->epfd >= 0 && e->events) return PROBE_BACKEND_EPOLL;
+        if (e->epfd >= 0) close(e->epfd);
+        e->epfd = -1;
+        free(e->events);
+        e->events = NULL;
+    }
+#endif
+    if (e->maxInFlight > FD_SETSIZE - 16) e->maxInFlight = FD_SETSIZE - 16;
+    return PROBE_BACKEND_SELECT;
+}
+
+int engine_backend_available(int backend) {
+    if (backend == PROBE_BACKEND_SELECT) return 1;
+#ifdef __linux__
+    if (backend == PROBE_BACKEND_EPOLL) return 1;
+    if (backend == PROBE_BACKEND_URING) {
+        UringRing* r = uring_create(8);
+        int ok = uring_usable(r);
+        uring_free(r);
+        return ok;
+    }
+#endif
+    return 0;
+}
+
+int engine_run(const ProbeEngineConfig* cfg) {
+    if (!cfg || !cfg->next || cfg->targetCount <= 0) return 0;
+
+    Engine e;
+    memset(&e, 0, sizeof(e));
+    e.cfg = cfg;
+    e.maxInFlight = cfg->maxInFlight > 0 ? cfg->maxInFlight : ENGINE_DEFAULT_INFLIGHT;
+    if (e.maxInFlight > ENGINE_MAX_INFLIGHT) e.maxInFlight = ENGINE_MAX_INFLIGHT;
+    // 句柄与临时端口预算：每个在途探测占一个句柄和一个本地端口，各留出余量；多个源地址各有一份端口
+    int fdLimit = platform_raise_fd_limit();
+    int ports = platform_ephemeral_ports();
+    if (cfg->sources) {
+        int addrs = cfg->sources->v4Count > cfg->sources->v6Count ? cfg->sources->v4Count : cfg->sources->v6Count;
+        if (addrs > 1) ports = (ports - ENGINE_PORT_RESERVE) * addrs + ENGINE_PORT_RESERVE;
+    }
+    if (fdLimit > 0 && e.maxInFlight > fdLimit - ENGINE_FD_RESERVE) e.maxInFlight = fdLimit - ENGINE_FD_RESERVE;
+    if (ports > 0 && e.maxInFlight > ports - ENGINE_PORT_RESERVE) e.maxInFlight = ports - ENGINE_PORT_RESERVE;
+    if (e.maxInFlight < ENGINE_MIN_INFLIGHT) e.maxInFlight = ENGINE_MIN_INFLIGHT;
+#ifdef __linux__
+    e.epfd = -1;
+#endif
+    e.backend = engine_open_backend(&e);
+    e.inFlightLimit = e.maxInFlight;
+
+    e.slots = (EngineSlot*)malloc(sizeof(EngineSlot) * e.maxInFlight);
+    e.slotOf = (int*)malloc(sizeof(int) * e.maxInFlight);
+    e.freeIds = (int*)malloc(sizeof(int) * e.maxInFlight);
+    e.heap = (EnginePending*)malloc(sizeof(EnginePending) * (ENGINE_PENDING_CAP + e.maxInFlight));
+    e.timerHeap = (int*)malloc(sizeof(int) * e.maxInFlight);
+    e.timerPos = (int*)malloc(sizeof(int) * e.maxInFlight);
+    e.timerDue = (unsigned long long*)malloc(sizeof(unsigned long long) * e.maxInFlight);
+    e.hosts = (EngineHost*)calloc(cfg->targetCount, sizeof(EngineHost));
+    e.parked = (EngineParked*)malloc(sizeof(EngineParked) * (ENGINE_PENDING_CAP + e.maxInFlight));
+    if (!e.slots || !e.slotOf || !e.freeIds || !e.heap || !e.timerHeap || !e.timerPos || !e.timerDue || !e.hosts || !e.parked || !engine_build_groups(&e)) goto cleanup;
+
+    // 倒序压栈，编号从 0 开始分配
+    for (int i = 0; i < e.maxInFlight; i++) {
+        e.slotOf[i] = -1;
+        e.timerPos[i] = -1;
+        e.freeIds[e.freeIdCount++] = e.maxInFlight - 1 - i;
+    }
+
+    for (int i = 0; i < ENGINE_PENDING_CAP + e.maxInFlight; i++) e.parked[i].next = i + 1;
+    e.parked[ENGINE_PENDING_CAP + e.maxInFlight - 1].next = -1;
+
+    e.maxTimeoutMs = cfg->timeoutMs > 0 ? cfg->timeoutMs : ENGINE_DEFAULT_TIMEOUT;
+    e.minTimeoutMs = cfg->minTimeoutMs > 0 ? cfg->minTimeoutMs : ENGINE_MIN_TIMEOUT;
+    if (e.minTimeoutMs > e.maxTimeoutMs) e.minTimeoutMs = e.maxTimeoutMs;
+    for (int i = 0; cfg->rttHintMs && i < cfg->targetCount; i++) {
+        if (cfg->rttHintMs[i] > 0) host_rtt_sample(&e.hosts[i], cfg->rttHintMs[i]);
+    }
+
+    e.timeoutBaseline = -1;
+    e.windowStart = e.statsAt = platform_tick_ms();
+    if (cfg->pps > 0) {
+        bucket_set_rate(&e.bucket, cfg->pps);
+        e.bucket.tokens = 1.0;
+        e.bucket.last = platform_tick_us();
+    }
+
+    if (cfg->grabBanner && cfg->proto == PROBE_TCP) {
+        e.bannerWaitMs = cfg->bannerWaitMs > 0 ? cfg->bannerWaitMs : BANNER_DEFAULT_WAIT_MS;
+        e.bufPool = (char*)malloc((size_t)BANNER_BUF_SIZE * e.maxInFlight);
+        e.freeBufs = (char**)malloc(sizeof(char*) * e.maxInFlight);
+        if (!e.bufPool || !e.freeBufs) goto cleanup;
+        for (int i = 0; i < e.maxInFlight; i++) e.freeBufs[e.freeCount++] = e.bufPool + (size_t)i * BANNER_BUF_SIZE;
+    }
+
+    while (!is_task_stopped()) {
+        unsigned long long now = platform_tick_ms();
+        engine_adjust_rate(&e, now);
+        engine_report_stats(&e, now);
+        engine_fill(&e, now);
+
+        if (e.inFlight == 0) {
+            if (e.heapSize == 0 && e.genDone) break;
+            unsigned long long wake = engine_next_wake(&e, now);
+            platform_sleep_ms(wake > now ? (int)(wake - now) : 1);
+            continue;
+        }
+        engine_poll(&e, now);
+    }
+
+cleanup:
+    if (e.slots) {
+        for (int i = 0; i < e.inFlight; i++) {
+            if (e.slots[i].sock == INVALID_SOCKET) continue;
+            if (e.slots[i].phase == PHASE_BANNER || e.slots[i].phase == PHASE_PROBE) platform_set_abortive_close(e.slots[i].sock);
+            closesocket(e.slots[i].sock);
+        }
+    }
+#ifdef __linux__
+    // 先提交排队中的 close，再销毁环 (仍在途的 connect 随之取消)
+    if (e.ring) {
+        unsigned long long data;
+        int res;
+        uring_submit(e.ring, 0);
+        // 中止时已由内核创建、尚未取走的 socket
+        while (uring_next_cqe(e.ring, &data, &res)) {
+            if ((data & 3) == URING_TAG_SOCKET && res >= 0) close(res);
+        }
+        uring_free(e.ring);
+    }
+    if (e.epfd >= 0) close(e.epfd);
+    free(e.events);
+#endif
+    free(e.slots);
+    free(e.slotOf);
+    free(e.freeIds);
+    free(e.heap);
+    free(e.timerHeap);
+    free(e.timerPos);
+    free(e.timerDue);
+    free(e.hosts);
+    free(e.bufPool);
+    free(e.freeBufs);
+    free(e.parked);
+    free(e.groupOf);
+    free(e.groupInFlight);
+    free(e.groupHead);
+    free(e.groupTail);
+    return e.completed;
+}
@@ -0,0 +1,154 @@
+#include "network_modules.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// --- 文本提取 (IPv4 / IPv6 / 域名) ---
+// [修改] 直接扫描 UTF-8 字节，输入文件无需先整体转成 UTF-16；地址与域名只由 ASCII 字符组成，
+// 多字节字符的各字节都大于 0x7F，一律当作分隔符，GBK 等其他编码的文本同样适用。
+// 命中的片段经回调交给调用方 (GUI 写入列表，命令行写到标准输出)
+
+#define EXTRACT_STOP_CHECK 0xFFFF   // 每扫描 64 KB 检查一次中止
+
+static int is_digit(unsigned char c) {
+    return c >= '0' && c <= '9';
+}
+
+static int is_alpha(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+static int is_hex(unsigned char c) {
+    return is_digit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+int extract_ipv4(const char* text, ExtractCallback cb, void* ctx) {
+    char currentIp[16] = {0};
+    int idx = 0;
+    int dots = 0;
+    int lastCharWasDigit = 0;
+    int found = 0;
+
+    for (size_t i = 0; ; i++) {
+        if ((i & EXTRACT_STOP_CHECK) == 0 && is_task_stopped()) break;
+        unsigned char c = (unsigned char)text[i];
+        if (is_digit(c)) {
+            if (idx < 15) currentIp[idx++] = (char)c;
+            lastCharWasDigit = 1;
+        } else if (c == '.') {
+            if (lastCharWasDigit && dots < 3) {
+                if (idx < 15) currentIp[idx++] = (char)c;
+                dots++;
+                lastCharWasDigit = 0;
+            } else {
+                idx = 0; dots = 0;
+            }
+        } else {
+            if (dots == 3 && lastCharWasDigit && idx >= 7) {
+                currentIp[idx] = 0;
+                int parts[4];
+                if (sscanf(currentIp, "%d.%d.%d.%d", &parts[0], &parts[1], &parts[2], &parts[3]) == 4) {
+                    if (parts[0]<=255 && parts[1]<=255 && parts[2]<=255 && parts[3]<=255) {
+                        cb(ctx, currentIp, EXTRACT_IPV4);
+                        found++;
+                    }
+                }
+            }
+            idx = 0; dots = 0; lastCharWasDigit = 0;
+            if (!c) break;
+        }
+    }
+    return found;
+}
+
+// 简单扫描符合 Hex:Hex:Hex... 格式的字符串，并用 inet_pton 验证
+int extract_ipv6(const char* text, ExtractCallback cb, void* ctx) {
+    char buf[64];
+    int bufIdx = 0;
+    int colons = 0;
+    int found = 0;
+
+    // IPv6 可能包含 0-9, a-f, A-F, :
+    for (size_t i = 0; ; i++) {
+        if ((i & EXTRACT_STOP_CHECK) == 0 && is_task_stopped()) break;
+        unsigned char c = (unsigned char)text[i];
+        if (is_hex(c) || c == ':') {
+            if (bufIdx < 63) {
+                buf[bufIdx++] = (char)c;
+                if (c == ':') colons++;
+            }
+        } else {
+            // 至少有一些长度，且包含至少两个冒号
+            if (bufIdx > 2 && colons >= 2) {
+                unsigned char addr[16];
+                buf[bufIdx] = 0;
+                if (inet_pton(AF_INET6, buf, addr) == 1) {
+                    cb(ctx, buf, EXTRACT_IPV6);
+                    found++;
+                }
+            }
+            bufIdx = 0;
+            colons = 0;
+            if (!c) break;
+        }
+    }
+    return found;
+}
+
+// 简单的域名字符检查 (字母, 数字, -, .)
+static int is_domain_char(unsigned char c) {
+    return is_alpha(c) || is_digit(c) || c == '-' || c == '.';
+}
+
+int extract_domains(const char* text, ExtractCallback cb, void* ctx) {
+    char buf[256];
+    int bufIdx = 0;
+    int dotCount = 0;
+    int hasAlpha = 0; // 确保包含字母，避免提取纯数字序列或IP
+    int found = 0;
+
+    for (size_t i = 0; ; i++) {
+        if ((i & EXTRACT_STOP_CHECK) == 0 && is_task_stopped()) break;
+
+        unsigned char c = (unsigned char)text[i];
+        
+        if (is_domain_char(c)) {
+            if (bufIdx < 255) {
+                // 如果是点，且前一个字符也是点，则是无效的（连续点）
+                if (c == '.' && bufIdx > 0 && buf[bufIdx-1] == '.') {
+                    bufIdx = 0; dotCount = 0; hasAlpha = 0;
+                    continue;
+                }
+                
+                buf[bufIdx++] = (char)c;
+                if (c == '.') dotCount++;
+                if (is_alpha(c)) hasAlpha = 1;
+            }
+        } else {
+            // 遇到非域名字符，检查缓冲区内容是否为有效域名
+            if (bufIdx > 0) {
+                buf[bufIdx] = 0;
+                
+                // 验证逻辑：
+                // 1. 至少有一个点
+                // 2. 不能以点或连字符开头/结尾
+                // 3. 必须包含字母 (排除 192.168.1.1 这样的纯IP，虽然它们是有效Host，但这里是"域名"提取)
+                // 4. 长度限制 (通常域名至少3-4个字符，如 a.com)
+                
+                if (dotCount > 0 && hasAlpha && bufIdx >= 4) {
+                    if (buf[0] != '.' && buf[0] != '-' && 
+                        buf[bufIdx-1] != '.' && buf[bufIdx-1] != '-') {
+                        cb(ctx, buf, EXTRACT_DOMAIN);
+                        found++;
+                    }
+                }
+            }
+            // 重置状态
+            bufIdx = 0;
+            dotCount = 0;
+            hasAlpha = 0;
+            if (!c) break;
+        }
+    }
+    return found;
+}
@@ -0,0 +1,174 @@
+#include "network_modules.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// [修改] 纯真库查询不依赖 Win32 API，独立成模块供 GUI 与命令行共用
+
+// --- QQWry 纯真IP库逻辑 (仅 IPv4) ---
+static unsigned char* g_qqwryData = NULL;
+static size_t g_qqwrySize = 0;
+
+// [新增] 归属地字符串按库内偏移共享，同一偏移只转码一次，UTF-8 结果存入 Arena 直到清理；
+// 开放寻址哈希表以偏移为键 (有效偏移不为 0)，超过半满时翻倍
+#define GEO_CACHE_INITIAL 4096
+
+typedef struct {
+    unsigned int offset;
+    const char* text;
+} GeoCacheEntry;
+
+static GeoCacheEntry* g_geoCache = NULL;
+static unsigned int g_geoCacheCap = 0;
+static unsigned int g_geoCacheCount = 0;
+static Arena g_geoText;
+static volatile long g_geoLock = 0;
+
+static unsigned int read_int3(unsigned char* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16);
+}
+static unsigned int read_int4(unsigned char* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (p[3] << 24);
+}
+
+static void read_qqwry_string(unsigned char* data, size_t size, unsigned int offset, char* buf, int bufSize) {
+    if (offset >= size) { buf[0] = 0; return; }
+    unsigned char* p = data + offset;
+    int i = 0;
+    while (offset + i < size && p[i] != 0 && i < bufSize - 1) {
+        buf[i] = p[i];
+        i++;
+    }
+    buf[i] = 0;
+}
+
+void ipv4_init_qqwry() {
+    if (g_qqwryData) return;
+    FILE* f = platform_wfopen(L"qqwry.dat", L"rb");
+    if (!f) return;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    unsigned char* data = size > 0 ? (unsigned char*)malloc((size_t)size) : NULL;
+    if (data && fread(data, 1, (size_t)size, f) == (size_t)size) {
+        ipv4_load_qqwry(data, (size_t)size);
+    } else {
+        free(data);
+    }
+    fclose(f);
+}
+
+void ipv4_load_qqwry(unsigned char* data, size_t size) {
+    ipv4_cleanup_qqwry();
+    // 至少要有文件头中的首末索引偏移
+    if (!data || size < 8) { free(data); return; }
+    g_qqwryData = data;
+    g_qqwrySize = size;
+}
+
+void ipv4_cleanup_qqwry() {
+    if (g_qqwryData) { free(g_qqwryData); g_qqwryData = NULL; }
+    g_qqwrySize = 0;
+    free(g_geoCache);
+    g_geoCache = NULL;
+    g_geoCacheCap = g_geoCacheCount = 0;
+    arena_free(&g_geoText);
+}
+
+static unsigned int geo_slot(unsigned int offset, unsigned int cap) {
+    return (offset * 2654435761u) & (cap - 1);
+}
+
+static int geo_cache_grow() {
+    unsigned int cap = g_geoCacheCap ? g_geoCacheCap * 2 : GEO_CACHE_INITIAL;
+    GeoCacheEntry* table = (GeoCacheEntry*)calloc(cap, sizeof(GeoCacheEntry));
+    if (!table) return 0;
+    for (unsigned int i = 0; i < g_geoCacheCap; i++) {
+        if (!g_geoCache[i].offset) continue;
+        unsigned int k = geo_slot(g_geoCache[i].offset, cap);
+        while (table[k].offset) k = (k + 1) & (cap - 1);
+        table[k] = g_geoCache[i];
+    }
+    free(g_geoCache);
+    g_geoCache = table;
+    g_geoCacheCap = cap;
+    return 1;
+}
+
+// 未命中时读出 GBK 字符串转为 UTF-8；纯真库的占位文字与空串统一显示为 "未知"
+static const char* geo_cached_string(unsigned int offset) {
+    const char* text = NULL;
+    platform_lock(&g_geoLock);
+    if ((g_geoCacheCount + 1) * 2 > g_geoCacheCap && !geo_cache_grow()) {
+        platform_unlock(&g_geoLock);
+        return "未知";
+    }
+    unsigned int k = geo_slot(offset, g_geoCacheCap);
+    while (g_geoCache[k].offset && g_geoCache[k].offset != offset) k = (k + 1) & (g_geoCacheCap - 1);
+    if (g_geoCache[k].offset) {
+        text = g_geoCache[k].text;
+    } else {
+        char gbk[256], utf8[768];
+        read_qqwry_string(g_qqwryData, g_qqwrySize, offset, gbk, sizeof(gbk));
+        platform_gbk_to_utf8(gbk, utf8, sizeof(utf8));
+        if (utf8[0] == 0 || strstr(utf8, "CZ88.NET")) text = "未知";
+        else {
+            size_t len = strlen(utf8) + 1;
+            char* copy = (char*)arena_alloc(&g_geoText, len);
+            if (copy) { memcpy(copy, utf8, len); text = copy; }
+            else text = "未知";
+        }
+        g_geoCache[k].offset = offset;
+        g_geoCache[k].text = text;
+        g_geoCacheCount++;
+    }
+    platform_unlock(&g_geoLock);
+    return text;
+}
+
+const char* ipv4_lookup_location(const char* ip) {
+    if (!g_qqwryData || !ip) return "";
+    unsigned long addr = inet_addr(ip);
+    if (addr == INADDR_NONE) return "";
+    // 索引中的起止地址按小端存放，read_int4 读出即为主机序数值，直接与 ntohl 的结果比较
+    addr = ntohl(addr);
+
+    unsigned int firstIndex = read_int4(g_qqwryData);
+    unsigned int lastIndex = read_int4(g_qqwryData + 4);
+    unsigned int l = 0, r = (lastIndex - firstIndex) / 7;
+    unsigned int indexOffset = 0;
+
+    while (l <= r) {
+        unsigned int m = (l + r) / 2;
+        unsigned int offset = firstIndex + m * 7;
+        if (offset + 7 > g_qqwrySize) break;
+        unsigned int startIp = read_int4(g_qqwryData + offset);
+        if (addr < startIp) r = m - 1;
+        else {
+            unsigned int recordOffset = read_int3(g_qqwryData + offset + 4);
+            if (recordOffset + 4 > g_qqwrySize) break;
+            unsigned int endIp = read_int4(g_qqwryData + recordOffset);
+            if (addr > endIp) l = m + 1;
+            else { indexOffset = recordOffset; break; }
+        }
+    }
+
+    if (indexOffset == 0 || indexOffset + 8 > g_qqwrySize) return "未知";
+
+    // 模式 1 整条重定向，模式 2 只重定向国家字符串；最终只需字符串所在偏移
+    unsigned int pos = indexOffset + 4;
+    unsigned char mode = g_qqwryData[pos];
+    if (mode == 1) {
+        pos = read_int3(g_qqwryData + pos + 1);
+        if (pos + 4 > g_qqwrySize) return "未知";
+        mode = g_qqwryData[pos];
+    }
+    if (mode == 2) pos = read_int3(g_qqwryData + pos + 1);
+    if (pos == 0 || pos >= g_qqwrySize) return "未知";
+    return geo_cached_string(pos);
+}
+
+// 界面显示用的宽字符版本
+void ipv4_get_location(const char* ip, wchar_t* outBuf, int outLen) {
+    utf8_to_wide_buf(ipv4_lookup_location(ip), outBuf, outLen);
+}
@@ -1,5 +1,4 @@
 #include "network_modules.h"
-#include "network_tools.h"
 #include <iphlpapi.h>
 #include <icmpapi.h>
 #include <stdio.h>
@@ -9,7 +8,7 @@
 #pragma comment(lib, "ws2_32.lib")
 
 // --- IPv6 Ping ---
-int ipv6_ping_host(struct sockaddr_in6* dest, int retry, int timeout, long* outRtt, int* outTtl) {
+int ipv6_ping_host(struct sockaddr_in6* dest, const struct sockaddr_in6* source, int retry, int timeout, long* outRtt, int* outTtl) {
     HANDLE hIcmp = Icmp6CreateFile();
     if (hIcmp == INVALID_HANDLE_VALUE) return 0;
 
@@ -19,8 +18,9 @@ int ipv6_ping_host(struct sockaddr_in6* dest, int retry, int timeout, long* outR
     DWORD replySize = sizeof(ICMPV6_ECHO_REPLY) + sizeof(sendData) + 128; 
     void* replyBuffer = malloc(replySize);
 
-    struct sockaddr_in6 source = {0};
-    source.sin6_family = AF_INET6; // 让系统自动选择源地址
+    struct sockaddr_in6 local = {0};
+    local.sin6_family = AF_INET6; // 未指定源地址时让系统自动选择
+    if (source) local.sin6_addr = source->sin6_addr;
 
     int successCount = 0;
     long totalRtt = 0;
@@ -31,7 +31,7 @@ int ipv6_ping_host(struct sockaddr_in6* dest, int retry, int timeout, long* outR
 
         // Icmp6SendEcho2 同步调用 (Event=NULL, ApcRoutine=NULL)
         DWORD ret = Icmp6SendEcho2(hIcmp, NULL, NULL, NULL, 
-                                   &source, dest, 
+                                   &local, dest, 
                                    sendData, sizeof(sendData), NULL, 
                                    replyBuffer, replySize, timeout);
         
@@ -62,10 +62,16 @@ int ipv6_ping_host(struct sockaddr_in6* dest, int retry, int timeout, long* outR
 }
 
 // --- IPv6 TCP Scan ---
-int ipv6_tcp_scan(struct sockaddr_in6* dest, int port, int timeout) {
+int ipv6_tcp_scan(struct sockaddr_in6* dest, const struct sockaddr_in6* source, int port, int timeout) {
     SOCKET sock = socket(AF_INET6, SOCK_STREAM, IPPROTO_TCP);
     if (sock == INVALID_SOCKET) return 0;
 
+    if (source) {
+        struct sockaddr_in6 local = *source;
+        local.sin6_port = 0;
+        if (bind(sock, (struct sockaddr*)&local, sizeof(local)) == SOCKET_ERROR) { closesocket(sock); return 0; }
+    }
+
     unsigned long mode = 1;
     ioctlsocket(sock, FIONBIO, &mode);
 
@@ -73,48 +79,33 @@ int ipv6_tcp_scan(struct sockaddr_in6* dest, int port, int timeout) {
     struct sockaddr_in6 addr = *dest;
     addr.sin6_port = htons(port);
 
-    connect(sock, (struct sockaddr*)&addr, sizeof(addr));
+    // 临时端口或缓冲区耗尽属于本地错误，不能当作关闭或过滤
+    if (connect(sock, (struct sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR) {
+        int err = WSAGetLastError();
+        if (err == WSAEADDRNOTAVAIL || err == WSAEADDRINUSE || err == WSAENOBUFS) { closesocket(sock); return 0; }
+    }
 
-    fd_set writeFds;
+    fd_set writeFds, exceptFds;
     FD_ZERO(&writeFds);
+    FD_ZERO(&exceptFds);
     FD_SET(sock, &writeFds);
+    FD_SET(sock, &exceptFds); // Windows 下连接被拒 (RST) 通过异常集合通知，而非可写
 
     struct timeval tv;
     tv.tv_sec = timeout / 1000;
     tv.tv_usec = (timeout % 1000) * 1000;
 
-    int ret = select(0, NULL, &writeFds, NULL, &tv);
-    closesocket(sock);
-    return (ret > 0);
-}
-
-// --- IPv6 提取逻辑 ---
-// 简单扫描符合 Hex:Hex:Hex... 格式的字符串，并尝试验证
-void ipv6_extract_search(const wchar_t* text, HWND hwnd) {
-    size_t len = wcslen(text);
-    wchar_t buf[64];
-    int bufIdx = 0;
-    
-    // IPv6 可能包含 0-9, a-f, A-F, :
-    for (size_t i = 0; i <= len; i++) {
-        if (is_task_stopped()) break;
-        wchar_t c = text[i];
-        if (iswxdigit(c) || c == L':') {
-            if (bufIdx < 63) buf[bufIdx++] = c;
-        } else {
-            if (bufIdx > 2) { // 至少有一些长度
-                buf[bufIdx] = 0;
-                // 验证是否包含至少两个冒号，且是有效地址
-                if (wcschr(buf, L':') && wcschr(wcschr(buf, L':')+1, L':')) {
-                    struct sockaddr_in6 sa;
-                    int saLen = sizeof(sa);
-                    // 使用 WSAStringToAddressW 验证格式
-                    if (WSAStringToAddressW(buf, AF_INET6, NULL, (struct sockaddr*)&sa, &saLen) == 0) {
-                         post_result(hwnd, buf, L"N/A", L"", L"", L"", L"");
-                    }
-                }
-            }
-            bufIdx = 0;
-        }
+    int state = PROBE_FILTERED;
+    if (select(0, NULL, &writeFds, &exceptFds, &tv) > 0) {
+        int err = 0;
+        int len = sizeof(err);
+        getsockopt(sock, SOL_SOCKET, SO_ERROR, (char*)&err, &len);
+        if (err == 0 && FD_ISSET(sock, &writeFds)) state = PROBE_OPEN;
+        else if (err == WSAECONNREFUSED) state = PROBE_CLOSED;
+        else if (err == WSAEADDRNOTAVAIL || err == WSAENOBUFS) state = 0;
     }
+    // 已建立的连接以 RST 关闭，不留 TIME_WAIT 占用临时端口
+    if (state == PROBE_OPEN) platform_set_abortive_close(sock);
+    closesocket(sock);
+    return state;
 }
@@ -0,0 +1,125 @@
+#include "network_modules.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// --- 运行指标 ---
+// 每个线程首次写入时领取一个分片，此后只改自己的分片，热路径上不存在跨线程争用；
+// 线程数超过分片数时按序号取模共用，原子加保证仍然正确。
+// 界面按固定频率取快照显示，也可追加到文件供离线分析。
+
+#define METRIC_SHARDS 64
+
+typedef struct {
+    volatile long long counters[METRIC_COUNTER_COUNT];
+    volatile long long hist[METRIC_HIST_COUNT][METRIC_HIST_BUCKETS];
+    volatile long long histSumUs[METRIC_HIST_COUNT];
+    char pad[64];                   // 与相邻分片错开缓存行
+} MetricShard;
+
+static MetricShard g_shards[METRIC_SHARDS];
+static volatile long long g_nextShard = 0;
+static PLATFORM_THREAD_LOCAL MetricShard* t_shard = NULL;
+
+static const char* g_counterNames[METRIC_COUNTER_COUNT] = {
+    "targets", "probes_sent", "inflight", "timeouts", "results",
+    "dns_lookups", "ui_posted", "ui_drained", "work_total", "work_done", "local_errors",
+};
+
+static const char* g_histNames[METRIC_HIST_COUNT] = { "dns", "probe", "rtt" };
+
+static MetricShard* metrics_shard() {
+    if (!t_shard) t_shard = &g_shards[platform_atomic_add(&g_nextShard, 1) % METRIC_SHARDS];
+    return t_shard;
+}
+
+// 减去当前值而不是直接写 0，清零期间其他线程的增量不会丢失
+static void metrics_clear_cell(volatile long long* p) {
+    long long v = platform_atomic_load(p);
+    if (v) platform_atomic_add(p, -v);
+}
+
+void metrics_reset() {
+    for (int i = 0; i < METRIC_SHARDS; i++) {
+        MetricShard* s = &g_shards[i];
+        for (int c = 0; c < METRIC_COUNTER_COUNT; c++) metrics_clear_cell(&s->counters[c]);
+        for (int h = 0; h < METRIC_HIST_COUNT; h++) {
+            for (int b = 0; b < METRIC_HIST_BUCKETS; b++) metrics_clear_cell(&s->hist[h][b]);
+            metrics_clear_cell(&s->histSumUs[h]);
+        }
+    }
+}
+
+void metrics_add(int counter, long long delta) {
+    if (counter < 0 || counter >= METRIC_COUNTER_COUNT) return;
+    platform_atomic_add(&metrics_shard()->counters[counter], delta);
+}
+
+static int metrics_bucket(unsigned long long us) {
+    int b = 0;
+    while (us > 1 && b < METRIC_HIST_BUCKETS - 1) { us >>= 1; b++; }
+    return b;
+}
+
+void metrics_observe(int hist, unsigned long long us) {
+    if (hist < 0 || hist >= METRIC_HIST_COUNT) return;
+    MetricShard* s = metrics_shard();
+    platform_atomic_add(&s->hist[hist][metrics_bucket(us)], 1);
+    platform_atomic_add(&s->histSumUs[hist], (long long)us);
+}
+
+void metrics_snapshot(MetricsSnapshot* out) {
+    memset(out, 0, sizeof(*out));
+    out->tickMs = platform_tick_ms();
+    for (int i = 0; i < METRIC_SHARDS; i++) {
+        MetricShard* s = &g_shards[i];
+        for (int c = 0; c < METRIC_COUNTER_COUNT; c++) out->counters[c] += platform_atomic_load(&s->counters[c]);
+        for (int h = 0; h < METRIC_HIST_COUNT; h++) {
+            for (int b = 0; b < METRIC_HIST_BUCKETS; b++) out->hist[h][b] += platform_atomic_load(&s->hist[h][b]);
+            out->histSumUs[h] += platform_atomic_load(&s->histSumUs[h]);
+        }
+    }
+}
+
+long long metrics_hist_count(const MetricsSnapshot* s, int hist) {
+    long long n = 0;
+    for (int b = 0; b < METRIC_HIST_BUCKETS; b++) n += s->hist[hist][b];
+    return n;
+}
+
+unsigned long long metrics_percentile(const MetricsSnapshot* s, int hist, int pct) {
+    long long total = metrics_hist_count(s, hist);
+    if (total == 0) return 0;
+    long long rank = (total * pct + 99) / 100, seen = 0;
+    if (rank < 1) rank = 1;
+    for (int b = 0; b < METRIC_HIST_BUCKETS; b++) {
+        seen += s->hist[hist][b];
+        if (seen >= rank) return 2ULL << b;
+    }
+    return 2ULL << (METRIC_HIST_BUCKETS - 1);
+}
+
+int metrics_dump(const wchar_t* path, const MetricsSnapshot* s) {
+    FILE* f = platform_wfopen(path, L"a");
+    if (!f) return 0;
+    fprintf(f, "{\"time\":%lld,\"tick_ms\":%llu,\"counters\":{", (long long)time(NULL), s->tickMs);
+    for (int c = 0; c < METRIC_COUNTER_COUNT; c++) {
+        fprintf(f, "%s\"%s\":%lld", c ? "," : "", g_counterNames[c], s->counters[c]);
+    }
+    fprintf(f, "},\"hist\":{");
+    for (int h = 0; h < METRIC_HIST_COUNT; h++) {
+        fprintf(f, "%s\"%s\":{\"count\":%lld,\"sum_us\":%lld,\"p50_us\":%llu,\"p90_us\":%llu,\"p99_us\":%llu,\"buckets\":[",
+                h ? "," : "", g_histNames[h], metrics_hist_count(s, h), s->histSumUs[h],
+                metrics_percentile(s, h, 50), metrics_percentile(s, h, 90), metrics_percentile(s, h, 99));
+        // 桶只写到最后一个非空桶为止
+        int last = METRIC_HIST_BUCKETS - 1;
+        while (last > 0 && s->hist[h][last] == 0) last--;
+        for (int b = 0; b <= last; b++) fprintf(f, "%s%lld", b ? "," : "", s->hist[h][b]);
+        fprintf(f, "]}");
+    }
+    fprintf(f, "}}\n");
+    int ok = !ferror(f);
+    fclose(f);
+    return ok;
+}
@@ -1,30 +1,494 @@
 #ifndef NETWORK_MODULES_H
 #define NETWORK_MODULES_H
 
-#include <winsock2.h>
-#include <ws2tcpip.h>
-#include <windows.h>
+#include "network_platform.h"
 
 // --- 共享辅助函数声明 ---
-char* wide_to_ansi(const wchar_t* wstr);
-void gbk_to_wide(const char* gbk, wchar_t* buf, int bufLen);
 int is_task_stopped(); 
 
-// --- IPv4 模块 ---
+// --- IP 归属地 (纯真库，平台无关) ---
 void ipv4_init_qqwry();
+void ipv4_load_qqwry(unsigned char* data, size_t size);    // [新增] 接管已载入内存的库 (malloc 分配)
 void ipv4_cleanup_qqwry();
+const char* ipv4_lookup_location(const char* ipStr);   // [新增] UTF-8，指向缓存，ipv4_cleanup_qqwry 前有效
 void ipv4_get_location(const char* ipStr, wchar_t* outBuf, int outLen);
-int ipv4_ping_host(unsigned long ip, int retry, int timeout, long* outRtt, int* outTtl);
-int ipv4_tcp_scan(unsigned long ip, int port, int timeout);
-void ipv4_extract_search(const wchar_t* text, HWND hwnd, int showLocation);
+
+// --- IPv4 模块 ---
+int ipv4_ping_host(unsigned long ip, unsigned long sourceIp, int retry, int timeout, long* outRtt, int* outTtl); // [修改] sourceIp 为 0 时由系统选择源地址
+int ipv4_trace_hop(unsigned long ip, int ttl, int timeout, unsigned long* outHop, long* outRtt); // [新增] 1 = 中间节点，2 = 到达目标，0 = 无应答
+int ipv4_tcp_scan(unsigned long ip, unsigned long sourceIp, int port, int timeout);   // 返回 PROBE_OPEN / PROBE_CLOSED / PROBE_FILTERED，0 = 本地错误
 
 // --- IPv6 模块 ---
-int ipv6_ping_host(struct sockaddr_in6* dest, int retry, int timeout, long* outRtt, int* outTtl);
-int ipv6_tcp_scan(struct sockaddr_in6* dest, int port, int timeout);
-void ipv6_extract_search(const wchar_t* text, HWND hwnd);
+int ipv6_ping_host(struct sockaddr_in6* dest, const struct sockaddr_in6* source, int retry, int timeout, long* outRtt, int* outTtl); // source 为 NULL 时由系统选择
+int ipv6_tcp_scan(struct sockaddr_in6* dest, const struct sockaddr_in6* source, int port, int timeout); // 同 ipv4_tcp_scan
+
+// --- [新增] 文本提取 (平台无关) ---
+#define EXTRACT_IPV4   1
+#define EXTRACT_IPV6   2
+#define EXTRACT_DOMAIN 3
+
+typedef void (*ExtractCallback)(void* ctx, const char* value, int kind);   // value 为 ASCII
+
+// 以下函数扫描 UTF-8 (或任何 ASCII 兼容编码) 文本，均返回命中数；is_task_stopped() 为真时提前结束
+int extract_ipv4(const char* text, ExtractCallback cb, void* ctx);
+int extract_ipv6(const char* text, ExtractCallback cb, void* ctx);
+int extract_domains(const char* text, ExtractCallback cb, void* ctx);  // 例如: example.com, www.google.com
+
+// --- [新增] 任务内存 (Arena 整体释放，Slab 固定大小记录复用) ---
+typedef struct ArenaChunk ArenaChunk;
+
+typedef struct {
+    ArenaChunk* head;       // 全零即为空 Arena，首次分配时才申请内存
+    size_t chunkSize;       // 0 = 默认 64 KB
+} Arena;
+
+void* arena_alloc(Arena* a, size_t size);   // 8 字节对齐，失败返回 NULL
+wchar_t* arena_wcsdup(Arena* a, const wchar_t* s);
+void arena_reset(Arena* a);                 // 保留一块供复用
+void arena_free(Arena* a);
+
+typedef struct {
+    size_t size;            // 每条记录的字节数
+    int perChunk;           // 空闲链表耗尽时一次补充的记录数
+    void* freeList;
+    void* chunks;
+    volatile long lock;
+    long capacity;
+    long inUse;
+} Slab;
+
+// 静态定义的对象池可直接用此初始化，无需调用 slab_init
+#define SLAB_INITIALIZER(recordSize, perChunk) { ((recordSize) + 7) & ~(size_t)7, (perChunk) }
+
+void slab_init(Slab* s, size_t size, int perChunk);
+void* slab_alloc(Slab* s);                  // 线程安全
+void slab_free(Slab* s, void* p);
+void slab_destroy(Slab* s);
+
+// --- [新增] 列表与结果行处理 (平台无关) ---
+wchar_t** split_hosts(Arena* arena, const wchar_t* input, int* count);  // 按空白与逗号拆分，指针数组与文本均取自 arena
+void free_string_list(wchar_t** list, int count);
+int* parse_ports(const wchar_t* portStr, int* count);       // 语法同 portset_parse，调用方 free
+int result_sort_dedupe(wchar_t** lines, int count);         // 按 "地址,端口" 排序去重，唯一行移到前部并返回其数量
+int wide_to_utf8(const wchar_t* s, char* out, int cap);     // 至多写 cap 字节，不含结尾 0，返回字节数
+wchar_t* utf8_to_wide(const char* s);                       // 非法字节替换为 U+FFFD，调用方 free
+int utf8_to_wide_buf(const char* s, wchar_t* out, int outLen); // 写入定长缓冲并截断，返回字符数
+
+// --- [新增] SYN 半开扫描模块 (Linux Raw Socket) ---
+// 发送线程构造 SYN，接收线程按序列号中的密钥哈希无状态匹配 SYN-ACK / RST
+#define SYN_STATE_OPEN   1
+#define SYN_STATE_CLOSED 2
+
+typedef void (*SynResultCallback)(void* ctx, int ipIndex, int port, int state);
+
+typedef struct {
+    const unsigned long* ips;   // 目标 IPv4 (网络字节序)
+    int ipCount;
+    const int* ports;
+    int portCount;
+    int pps;                    // 每秒发包上限，0 = 不限速
+    int waitMs;                 // 发送完毕后等待迟到回包的时间
+    unsigned long long seed;    // 探测顺序的置换种子
+    int shardIndex;             // 分片：只发送置换序列中位置模 shardCount 等于 shardIndex 的探测
+    int shardCount;             // 0 或 1 = 不分片
+    const unsigned long* sourceIps; // [新增] 可选：每个目标使用的源地址 (网络字节序)，0 或 NULL = 按路由选择
+    SynResultCallback onResult;
+    void* ctx;
+} SynScanConfig;
+
+int syn_scan_available();                    // 具备 CAP_NET_RAW 时返回 1
+int syn_scan_run(const SynScanConfig* cfg);  // 返回发出的探测数，失败返回 -1
+
+// --- [新增] 并发探测引擎 (非阻塞 socket + select 就绪循环) ---
+#define PROBE_TCP 1
+#define PROBE_UDP 2
+
+// I/O 后端：不可用时依次回退 (io_uring -> epoll -> select)
+#define PROBE_BACKEND_AUTO   0  // Linux 用 epoll，Windows 为 select；io_uring 需显式指定
+#define PROBE_BACKEND_SELECT 1
+#define PROBE_BACKEND_EPOLL  2
+#define PROBE_BACKEND_URING  3
+
+#define PROBE_OPEN      1
+#define PROBE_CLOSED    2   // TCP: RST / UDP: ICMP 端口不可达
+#define PROBE_FILTERED  3   // 超时无响应 (UDP 即 open|filtered)
+#define PROBE_ERROR     4   // [新增] 本地资源 (句柄、临时端口) 持续不足而放弃，不是扫描结论
+
+typedef struct {
+    int family;             // 4 或 6，0 表示解析失败 (跳过)
+    union {
+        struct sockaddr_in v4;
+        struct sockaddr_in6 v6;
+    } addr;
+} ProbeTarget;
+
+// --- [新增] 探测源地址 ---
+// 多个本机地址分摊探测，每个地址各有一份临时端口空间；未指定时由系统按路由选择
+#define PROBE_MAX_SOURCES        64
+#define PROBE_SOURCE_ROUND_ROBIN 0  // 逐个探测轮换地址
+#define PROBE_SOURCE_HASH        1  // 按目标哈希，同一目标始终使用同一地址
+
+typedef struct {
+    ProbeTarget addrs[PROBE_MAX_SOURCES];
+    int count;
+    unsigned char v4[PROBE_MAX_SOURCES];    // 各地址族在 addrs 中的下标
+    unsigned char v6[PROBE_MAX_SOURCES];
+    int v4Count;
+    int v6Count;
+    int mode;                               // PROBE_SOURCE_*，source_parse 之后由调用方设置
+    volatile long long next;                // 轮询游标 (多线程共用)
+} ProbeSources;
+
+// 以空格、逗号或分号分隔的地址或网卡名 (网卡展开为其单播地址，跳过链路本地)，每个地址试绑定确认属于本机；
+// 返回地址数，某项无法识别或绑定时返回 -1 并把该项写入 bad
+int source_parse(const char* spec, ProbeSources* out, char* bad, int badLen);
+const ProbeTarget* source_pick(ProbeSources* s, int family, unsigned int key);  // s 为 NULL 或无该族地址时返回 NULL
+int source_bind(SOCKET sock, const ProbeTarget* src);   // 绑定源地址 (端口由 connect 分配)，src 为 NULL 时不绑定；失败返回 0
+
+// 生成下一个探测，返回 0 表示已无更多探测
+typedef int (*ProbeNextCallback)(void* ctx, int* target, int* port);
+// 探测结束回调；data/len 为 UDP 回包或 TCP Banner 内容 (可能为 NULL)
+typedef void (*ProbeResultCallback)(void* ctx, int target, int port, int state, const char* data, int len);
+
+// 运行统计 (约每 500ms 回调一次)
+typedef struct {
+    long long sent;         // 已发出的探测 (含重发)
+    long long completed;
+    int inFlight;
+    int rateLimit;          // 当前令牌桶速率 (pps)，0 = 不限速
+    int effectivePps;       // 最近一个统计周期的实际发包速率
+    int timeoutPct;         // 最近一个 AIMD 窗口的超时比例
+    int backend;            // 实际使用的 I/O 后端
+    int inFlightLimit;      // [新增] 当前在途上限 (本地资源报错时收缩，随后逐步恢复)
+    long long localErrors;  // [新增] 累计的本地资源错误 (已退避重试，不计入结果)
+} ProbeEngineStats;
+typedef void (*ProbeStatsCallback)(void* ctx, const ProbeEngineStats* stats);
+// 一次完整往返 (TCP 握手完成或收到 RST、UDP 收到回包或端口不可达) 的耗时，微秒
+typedef void (*ProbeRttCallback)(void* ctx, int target, int port, unsigned long long rttUs);
+
+typedef struct {
+    const ProbeTarget* targets;
+    int targetCount;
+    int proto;              // PROBE_TCP / PROBE_UDP
+    int maxInFlight;        // 同时在途的探测数上限 (另受进程句柄数与本机临时端口数约束)
+    int timeoutMs;          // 超时上限，尚无 RTT 样本的主机按此等待
+    int minTimeoutMs;       // 超时下限 (由 RTT 估算的超时不低于此值)
+    int udpRetries;         // UDP 无响应时的重发次数
+    int tcpRetries;         // TCP 连接超时 (疑似过滤) 时的重发次数
+    const int* rttHintMs;   // 可选：各目标的初始 RTT (如 Ping 结果)，0 = 未知
+    int grabBanner;         // TCP 开放后继续读取 Banner / 发送服务探测，回包经 onResult 的 data 返回
+    int bannerWaitMs;       // 每个阶段 (被动等待 / 主动探测) 的等待时间
+    int pps;                // 全局发包速率上限 (令牌桶)，0 = 不限速
+    int subnetCap;          // 每个目标网段 (IPv4 /24、IPv6 /64) 的在途上限，0 = 不限
+    int backend;            // PROBE_BACKEND_*，0 = 自动选择
+    ProbeSources* sources;  // [新增] 可选：源地址，NULL = 由系统选择
+    ProbeStatsCallback onStats;
+    ProbeRttCallback onRtt;     // 可选：逐次往返耗时 (先于对应的 onResult 回调)
+    ProbeNextCallback next;
+    ProbeResultCallback onResult;
+    void* ctx;
+} ProbeEngineConfig;
+
+int engine_run(const ProbeEngineConfig* cfg);  // 返回完成的探测数
+int engine_backend_available(int backend);     // 当前系统 (含内核特性) 支持该后端时返回 1
+
+// --- [新增] io_uring 最小封装 (Linux，探测引擎的批量提交后端) ---
+typedef struct UringRing UringRing;
+#ifdef __linux__
+UringRing* uring_create(unsigned entries);       // 内核不支持或被禁用时返回 NULL
+void uring_free(UringRing* r);
+int uring_op_supported(const UringRing* r, int op);
+// 以下 prep 函数只写入提交队列，队列满时先自动提交；返回 0 表示无法排队
+int uring_prep_socket(UringRing* r, int family, int type, int protocol, unsigned long long userData);
+int uring_prep_connect(UringRing* r, int fd, const struct sockaddr* addr, int addrLen, int timeoutMs,
+                       unsigned long long userData, unsigned long long timeoutUserData);
+int uring_prep_close(UringRing* r, int fd, unsigned long long userData);
+int uring_submit(UringRing* r, int waitMs);      // 提交已排队的操作；waitMs > 0 时最多等待这么久直到有完成事件
+int uring_next_cqe(UringRing* r, unsigned long long* userData, int* res);  // 取出一个完成事件，没有则返回 0
+#endif
+
+// --- [新增] 端口集合 (位图) ---
+#define PORTSET_MIN   1
+#define PORTSET_MAX   65535
+#define PORTSET_WORDS 2048
+typedef struct {
+    unsigned int bits[PORTSET_WORDS];
+} PortSet;
+
+void portset_clear(PortSet* s);
+void portset_add(PortSet* s, int port);
+void portset_add_range(PortSet* s, int first, int last);
+int portset_has(const PortSet* s, int port);
+void portset_union(PortSet* dst, const PortSet* src);
+void portset_diff(PortSet* dst, const PortSet* src);   // dst -= src
+int portset_count(const PortSet* s);
+int portset_next(const PortSet* s, int from);           // 返回 >= from 的下一个端口，没有则 -1
+void portset_add_top(PortSet* s, int n);                // 加入最常见的 n 个端口
+int portset_parse(PortSet* s, const wchar_t* text);     // "top100,1-1024,!25"，返回无法识别的片段数
+int* portset_to_array(const PortSet* s, int* count);    // 常见端口在前，调用方 free
+
+// --- [新增] 伪随机探测顺序 (循环群置换) ---
+typedef struct {
+    unsigned long long range;   // 索引空间大小 n，输出 0..n-1 各一次
+    unsigned long long prime;   // 大于 n 的素数 p
+    unsigned long long root;    // 模 p 的原根 g
+    unsigned long long first;
+    unsigned long long current;
+    int started;
+} Permutation;
+
+int permutation_init(Permutation* pm, unsigned long long range, unsigned long long seed); // 空间超过 2^32 时返回 0
+int permutation_next(Permutation* pm, unsigned long long* index);                          // 遍历结束返回 0
+// [新增] 分片扫描未指定种子时的默认值：由展开后的主机 (UTF-8) 与端口列表推导，GUI 与命令行共用
+unsigned long long shard_default_seed(const char* const* hosts, int hostCount, const int* ports, int portCount);
+
+// --- [新增] 扫描断点续传 ---
+#define MAX_CHECKPOINT_PATH  260
+#define CHECKPOINT_MAX_DATA  512    // 每条结果保存的回包上限 (与 Banner 缓冲区一致)
+
+typedef struct {
+    unsigned int specHash;          // 目标、端口与扫描选项的哈希，续扫前校验是否同一任务
+    unsigned long long seed;
+    Permutation order;              // 探测顺序生成器的当前位置
+    int shuffled;
+    unsigned long long cursor;      // 已发出的索引数
+    unsigned long long current;     // 已计入进度的探测数
+    int openCount;
+    int closedCount;
+    int filteredCount;
+    int resultCount;                // 结果文件中已确认的记录数
+    int pendingCount;
+    unsigned long long* pending;    // 已发出但尚未得出结果的索引，续扫时重新探测
+} ScanCheckpoint;
+
+typedef struct {
+    unsigned long long* slots;
+    int capacity;
+    int count;
+} IndexSet;
+
+unsigned int checkpoint_hash(const void* data, int len, unsigned int h);   // FNV-1a，初值 2166136261
+int indexset_init(IndexSet* s, int capacity);
+void indexset_free(IndexSet* s);
+int indexset_add(IndexSet* s, unsigned long long index);   // 按需扩容，内存不足时返回 0
+void indexset_remove(IndexSet* s, unsigned long long index);
+int indexset_collect(const IndexSet* s, unsigned long long* out);
+
+int checkpoint_save(const wchar_t* path, const ScanCheckpoint* ck);
+int checkpoint_load(const wchar_t* path, ScanCheckpoint* ck);           // 成功后 pending 由调用方 free
+int checkpoint_append_result(FILE* f, int target, int port, int state, const char* data, int len);
+int checkpoint_replay_results(const wchar_t* path, int maxCount, ProbeResultCallback cb, void* ctx);
+void checkpoint_remove(const wchar_t* statePath, const wchar_t* resultPath);
+
+// --- [新增] 增量扫描 (与上次结果对比，只报告变化) ---
+#define DELTA_NONE    0
+#define DELTA_NEW     1     // 上次未开放，本次开放
+#define DELTA_CLOSED  2     // 上次开放，本次关闭或过滤
+#define DELTA_CHANGED 3     // 两次都开放，识别出的服务不同
+
+typedef struct DeltaIndex DeltaIndex;
+
+typedef struct {
+    int baseline;           // 基线中落在本次 目标×端口 范围内的开放端口
+    int stillOpen;
+    int closed;
+    int added;
+    int changed;
+    int current;            // 快照条目数 (本次开放与沿用上次的)
+} DeltaStats;
+
+DeltaIndex* delta_create(const ProbeTarget* targets, int hostCount, const int* ports, int portCount, int proto);
+void delta_free(DeltaIndex* d);
+void delta_set_name(DeltaIndex* d, int target, const char* name);   // 主机名 (UTF-8)，基线按主机名或地址匹配
+int delta_load(DeltaIndex* d, const wchar_t* path);     // scan 输出的 NDJSON 或 CSV，返回匹配的开放端口数，文件不存在返回 -1
+int delta_next(DeltaIndex* d, unsigned long long* index);          // 首轮：按扫描索引取下一个上次开放的端口
+int delta_known(const DeltaIndex* d, int target, int portIdx);      // 上次开放 (已在首轮复查)
+int delta_observe(DeltaIndex* d, int target, int port, int state, const wchar_t* service); // 返回 DELTA_*
+int delta_first_pass_done(DeltaIndex* d);               // 首轮全部得出结果时返回 1 (只返回一次)
+const char* delta_previous_service(const DeltaIndex* d, int target, int port);  // 上次识别的服务，没有返回 ""
+const char* delta_change_name(int change);              // "new" / "closed" / "changed"
+void delta_stats(const DeltaIndex* d, DeltaStats* out);
+int delta_save(const DeltaIndex* d, const wchar_t* path);   // 写出快照 (NDJSON)，返回条目数，失败返回 -1
+
+// --- [新增] 代理检测 ---
+#define PROXY_HTTP   1      // HTTP CONNECT
+#define PROXY_SOCKS5 2
+#define PROXY_SOCKS4 3
+
+#define PROXY_BIT(protocol) (1 << (protocol))
+
+typedef struct {
+    int protocol;           // 可用的协议 (多种可用时取最快者)，0 = 不可用
+    int protocols;          // [新增] 握手通过的全部协议，PROXY_BIT 的按位或
+    int connectMs;          // TCP 连接耗时
+    int handshakeMs;        // 连接建立到隧道打通
+    int firstByteMs;        // 经隧道发出测试请求到收到首字节
+} ProxyCheckResult;
+
+typedef void (*ProxyProgressCallback)(void* ctx, int done, int total);
+
+typedef struct {
+    const ProbeTarget* proxies;     // 候选代理 (端口已写入地址结构)
+    int proxyCount;
+    struct sockaddr_in testAddr;    // 经代理访问的测试目标 (SOCKS4 只支持 IPv4)
+    const char* testHost;           // 测试目标主机名，用于 CONNECT 与 Host 头
+    int maxInFlight;
+    int timeoutMs;                  // 单次尝试 (连接 + 握手 + 首字节) 的总超时
+    ProxyProgressCallback onProgress;
+    void* ctx;
+} ProxyCheckConfig;
+
+int proxy_check_run(const ProxyCheckConfig* cfg, ProxyCheckResult* results);   // 返回可用代理数
+
+// --- [新增] 并行路由追踪 ---
+#define TRACE_ICMP 1
+#define TRACE_UDP  2
+#define TRACE_TCP  3
+#define TRACE_MAX_HOPS 30
+
+// 某一跳有应答：hop 为应答节点地址 (网络字节序)，reached 表示应答来自目标本身
+typedef void (*TraceHopCallback)(void* ctx, int target, int ttl, unsigned int hop, unsigned long long rttUs, int reached);
+
+typedef struct {
+    const ProbeTarget* targets;     // 仅处理 IPv4 目标
+    int targetCount;
+    int mode;                       // TRACE_ICMP / TRACE_UDP / TRACE_TCP
+    int port;                       // UDP 起始端口 (每跳 +1) 或 TCP 目标端口
+    int maxHops;
+    int maxInFlight;
+    int timeoutMs;                  // 每个探测的等待时间
+    TraceHopCallback onHop;
+    void* ctx;
+} TraceConfig;
+
+int trace_available();                      // 可创建原始 ICMP socket 时返回 1
+int trace_run(const TraceConfig* cfg);      // 返回结束的探测数，无权限返回 -1
+
+// --- [新增] 持续监控时间序列 ---
+#define MONITOR_WINDOW 60               // 每个目标保留的最近样本数 (1 Hz 时为最近一分钟)
+#define MONITOR_LOST   0xFFFFFFFFu      // 丢包样本
+
+typedef struct {
+    unsigned int samples[MONITOR_WINDOW];   // 往返耗时 (微秒)
+    int head;                   // 下一个写入位置
+    int count;                  // 窗口内样本数
+    int lost;                   // 窗口内丢包数
+    unsigned long long sumUs;   // 窗口内有效样本之和
+    long long totalSent;        // 开始监控以来的累计值
+    long long totalLost;
+} MonitorSeries;
+
+typedef struct {
+    int samples;
+    int lossPct;
+    int lastLost;               // 最近一次探测是否丢包
+    double lastMs, avgMs, minMs, maxMs, jitterMs;
+} MonitorSummary;
+
+void monitor_series_reset(MonitorSeries* s);
+void monitor_series_add(MonitorSeries* s, unsigned int rttUs);    // O(1)
+void monitor_series_summary(const MonitorSeries* s, MonitorSummary* out);
+
+// --- [新增] 运行指标 (按线程分片的无锁计数器与延迟直方图) ---
+// 写入只做一次原子加，落在当前线程独占的分片上；读取时汇总全部分片
+#define METRIC_TARGETS          0   // 生成器产出的探测 (目标 x 端口)
+#define METRIC_PROBES_SENT      1   // 实际发出的探测 (含重发)
+#define METRIC_INFLIGHT         2   // 在途探测 (随发出与结束增减)
+#define METRIC_TIMEOUTS         3   // 超时事件 (含随后重发的)
+#define METRIC_RESULTS          4   // 得出结论的探测
+#define METRIC_DNS_LOOKUPS      5
+#define METRIC_UI_POSTED        6   // 投递给界面的消息
+#define METRIC_UI_DRAINED       7   // 界面已处理的消息，与上项之差为队列深度
+#define METRIC_WORK_TOTAL       8   // 当前任务的工作量与完成量，用于进度显示
+#define METRIC_WORK_DONE        9
+#define METRIC_LOCAL_ERRORS     10  // [新增] 本地资源错误 (句柄、临时端口、缓冲区耗尽)，探测已退避重试
+#define METRIC_COUNTER_COUNT    11
+
+#define METRIC_HIST_DNS         0   // 域名解析耗时
+#define METRIC_HIST_PROBE       1   // 单次探测从发出到结束 (含超时)
+#define METRIC_HIST_RTT         2   // 完整往返 (握手完成或 RST、UDP 回包)
+#define METRIC_HIST_COUNT       3
+#define METRIC_HIST_BUCKETS     32  // 第 i 桶: [2^i, 2^(i+1)) 微秒，0 归入第 0 桶
+
+typedef struct {
+    unsigned long long tickMs;
+    long long counters[METRIC_COUNTER_COUNT];
+    long long hist[METRIC_HIST_COUNT][METRIC_HIST_BUCKETS];
+    long long histSumUs[METRIC_HIST_COUNT];
+} MetricsSnapshot;
+
+void metrics_reset();                                   // 新任务开始时清零
+void metrics_add(int counter, long long delta);
+void metrics_observe(int hist, unsigned long long us);
+void metrics_snapshot(MetricsSnapshot* out);
+long long metrics_hist_count(const MetricsSnapshot* s, int hist);
+unsigned long long metrics_percentile(const MetricsSnapshot* s, int hist, int pct); // 所在桶的上界 (微秒)，无样本返回 0
+int metrics_dump(const wchar_t* path, const MetricsSnapshot* s);  // 追加一行 JSON，失败返回 0
+
+// --- [新增] 行输出 (CSV / NDJSON / TSV，UTF-8 缓冲写出) ---
+#define OUTPUT_NDJSON 1
+#define OUTPUT_CSV    2
+#define OUTPUT_TSV    3     // 制表符分隔，CRLF 换行，用于剪贴板
+
+typedef struct {
+    FILE* file;             // NULL = 写入内存，缓冲区按需扩容
+    char* buf;
+    size_t len;
+    size_t cap;
+    int format;
+    int fields;             // 当前行已写出的字段数
+    int failed;             // 写文件或扩容失败
+} RowWriter;
+
+int writer_init(RowWriter* w, FILE* file, int format, size_t cap);
+void writer_free(RowWriter* w);
+void writer_flush(RowWriter* w);
+void writer_raw(RowWriter* w, const char* s);
+void writer_text(RowWriter* w, const char* key, const char* value, int len);   // UTF-8 字段，CSV / TSV 忽略 key
+void writer_str(RowWriter* w, const char* key, const char* value);
+void writer_wstr(RowWriter* w, const char* key, const wchar_t* value);
+void writer_int(RowWriter* w, const char* key, long long value);
+void writer_ms(RowWriter* w, const char* key, double ms, int valid);
+void writer_end_row(RowWriter* w);
+void writer_header(RowWriter* w, const char* columns);
+
+// --- [新增] 结果日志 (追加写入的二进制记录，崩溃后仍可导出) ---
+#define RESLOG_HEADER     1     // 列名
+#define RESLOG_ROW        2     // 新增一行
+#define RESLOG_UPDATE     3     // 原地刷新，覆盖第 2 列起的内容
+#define RESLOG_MAX_FIELDS 16
+
+typedef struct ResultLog ResultLog;
+typedef struct ResultLogView ResultLogView;
+
+typedef struct {
+    int count;
+    const char* text[RESLOG_MAX_FIELDS];   // UTF-8，不以 0 结尾，指向日志数据
+    int len[RESLOG_MAX_FIELDS];
+} ResultLogRow;
+
+ResultLog* reslog_create(const wchar_t* path);  // 截断已有文件
+void reslog_append(ResultLog* log, int type, unsigned int rowId, const wchar_t* const* fields, int count);
+void reslog_flush(ResultLog* log);
+void reslog_close(ResultLog* log);
+
+ResultLogView* reslog_load(const wchar_t* path); // 读到第一条损坏或不完整的记录为止
+void reslog_view_free(ResultLogView* v);
+unsigned int reslog_view_rows(const ResultLogView* v);    // 最大行号 + 1
+int reslog_view_header(const ResultLogView* v, ResultLogRow* out);
+int reslog_view_row(const ResultLogView* v, unsigned int rowId, ResultLogRow* out);   // 合并刷新后的列，行不存在返回 0
+void reslog_write_header(const ResultLogView* v, RowWriter* w);             // 仅 CSV 写表头行
+int reslog_write_row(const ResultLogView* v, RowWriter* w, unsigned int rowId);
+
+// --- [新增] UDP 服务探测载荷 ---
+const char* udp_probe_payload(int port, int* len);
 
-// --- [新增] 域名模块接口 ---
-// 从文本中提取域名 (例如: example.com, www.google.com)
-void domain_extract_search(const wchar_t* text, HWND hwnd);
+// --- [新增] Banner 服务识别 ---
+typedef struct ServiceMatcher ServiceMatcher;
+ServiceMatcher* service_matcher_create();    // 将特征库编译为 Aho-Corasick 自动机
+void service_matcher_free(ServiceMatcher* m);
+void service_identify(const ServiceMatcher* m, const char* data, int len, wchar_t* out, int outLen);
+const char* service_probe_for_port(int port, int* len);  // 客户端先发言的协议返回请求，否则 NULL
+const char* service_fallback_probe(int* len);
 
 #endif // NETWORK_MODULES_H
@@ -0,0 +1,61 @@
+#include "network_modules.h"
+#include <string.h>
+
+// --- 持续监控时间序列 ---
+// 每个目标一个定长环形缓冲区，写满后覆盖最旧的样本，内存占用与运行时长无关。
+// 窗口内的样本和与丢包数随写入增量维护；最小/最大/抖动只在刷新显示时遍历一次窗口。
+
+void monitor_series_reset(MonitorSeries* s) {
+    memset(s, 0, sizeof(MonitorSeries));
+}
+
+void monitor_series_add(MonitorSeries* s, unsigned int rttUs) {
+    if (s->count == MONITOR_WINDOW) {
+        // 淘汰最旧样本，同步扣除其对聚合值的贡献
+        unsigned int old = s->samples[s->head];
+        if (old == MONITOR_LOST) s->lost--;
+        else s->sumUs -= old;
+    } else {
+        s->count++;
+    }
+    s->samples[s->head] = rttUs;
+    s->head = (s->head + 1) % MONITOR_WINDOW;
+    if (rttUs == MONITOR_LOST) { s->lost++; s->totalLost++; }
+    else s->sumUs += rttUs;
+    s->totalSent++;
+}
+
+void monitor_series_summary(const MonitorSeries* s, MonitorSummary* out) {
+    memset(out, 0, sizeof(MonitorSummary));
+    out->samples = s->count;
+    if (s->count == 0) return;
+
+    int newest = (s->head + MONITOR_WINDOW - 1) % MONITOR_WINDOW;
+    out->lastLost = (s->samples[newest] == MONITOR_LOST);
+    out->lastMs = out->lastLost ? 0 : s->samples[newest] / 1000.0;
+    out->lossPct = s->lost * 100 / s->count;
+
+    int replies = s->count - s->lost;
+    if (replies == 0) return;
+    out->avgMs = (double)s->sumUs / replies / 1000.0;
+
+    // 按时间顺序遍历窗口：抖动取相邻两次有效样本差值的平均 (RFC 3550 的简化形式)
+    unsigned int minUs = MONITOR_LOST, maxUs = 0, prev = MONITOR_LOST;
+    unsigned long long diffSum = 0;
+    int diffs = 0;
+    int start = (s->head + MONITOR_WINDOW - s->count) % MONITOR_WINDOW;
+    for (int k = 0; k < s->count; k++) {
+        unsigned int v = s->samples[(start + k) % MONITOR_WINDOW];
+        if (v == MONITOR_LOST) continue;
+        if (v < minUs) minUs = v;
+        if (v > maxUs) maxUs = v;
+        if (prev != MONITOR_LOST) {
+            diffSum += v > prev ? v - prev : prev - v;
+            diffs++;
+        }
+        prev = v;
+    }
+    out->minMs = minUs / 1000.0;
+    out->maxMs = maxUs / 1000.0;
+    out->jitterMs = diffs ? (double)diffSum / diffs / 1000.0 : 0;
+}
@@ -0,0 +1,177 @@
+#include "network_modules.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// --- 行输出 ---
+// [修改] 由命令行前端的输出缓冲抽出，GUI 导出与复制共用。
+// 字段按格式转义后追加到缓冲区：写文件时缓冲区满即整块 fwrite，写内存时按倍数扩容。
+// 全程按 UTF-8 输出，宽字符字段逐码点编码 (Windows 下合并 UTF-16 代理对)。
+
+int writer_init(RowWriter* w, FILE* file, int format, size_t cap) {
+    memset(w, 0, sizeof(*w));
+    w->file = file;
+    w->format = format;
+    w->cap = cap > 0 ? cap : 65536;
+    w->buf = (char*)malloc(w->cap);
+    return w->buf != NULL;
+}
+
+void writer_free(RowWriter* w) {
+    free(w->buf);
+    w->buf = NULL;
+    w->len = w->cap = 0;
+}
+
+void writer_flush(RowWriter* w) {
+    if (!w->file) return;
+    if (w->len > 0 && fwrite(w->buf, 1, w->len, w->file) != w->len) w->failed = 1;
+    w->len = 0;
+    if (fflush(w->file) != 0) w->failed = 1;
+}
+
+// 写文件时刷出，写内存时扩容；失败后丢弃后续输出并记下错误
+static int writer_room(RowWriter* w) {
+    if (w->file) {
+        if (fwrite(w->buf, 1, w->len, w->file) != w->len) w->failed = 1;
+        w->len = 0;
+        return 1;
+    }
+    char* grown = w->failed ? NULL : (char*)realloc(w->buf, w->cap * 2);
+    if (!grown) { w->failed = 1; return 0; }
+    w->buf = grown;
+    w->cap *= 2;
+    return 1;
+}
+
+static void writer_byte(RowWriter* w, char c) {
+    if (w->len == w->cap && !writer_room(w)) return;
+    w->buf[w->len++] = c;
+}
+
+void writer_raw(RowWriter* w, const char* s) {
+    while (*s) writer_byte(w, *s++);
+}
+
+// 单个字节按格式转义：JSON 转义引号、反斜杠与控制字符；CSV / TSV 字段加引号时把引号写两遍
+static void writer_escaped(RowWriter* w, unsigned char c) {
+    if (w->format != OUTPUT_NDJSON) {
+        if (c == '"') writer_byte(w, '"');
+        writer_byte(w, (char)c);
+        return;
+    }
+    if (c == '"' || c == '\\') { writer_byte(w, '\\'); writer_byte(w, (char)c); }
+    else if (c == '\n') writer_raw(w, "\\n");
+    else if (c == '\r') writer_raw(w, "\\r");
+    else if (c == '\t') writer_raw(w, "\\t");
+    else if (c < 0x20) {
+        static const char hex[] = "0123456789abcdef";
+        writer_raw(w, "\\u00");
+        writer_byte(w, hex[c >> 4]);
+        writer_byte(w, hex[c & 15]);
+    } else {
+        writer_byte(w, (char)c);
+    }
+}
+
+static void writer_codepoint(RowWriter* w, unsigned int cp) {
+    if (cp < 0x80) { writer_escaped(w, (unsigned char)cp); return; }
+    if (cp < 0x800) {
+        writer_byte(w, (char)(0xC0 | (cp >> 6)));
+    } else if (cp < 0x10000) {
+        writer_byte(w, (char)(0xE0 | (cp >> 12)));
+        writer_byte(w, (char)(0x80 | ((cp >> 6) & 0x3F)));
+    } else {
+        writer_byte(w, (char)(0xF0 | (cp >> 18)));
+        writer_byte(w, (char)(0x80 | ((cp >> 12) & 0x3F)));
+        writer_byte(w, (char)(0x80 | ((cp >> 6) & 0x3F)));
+    }
+    writer_byte(w, (char)(0x80 | (cp & 0x3F)));
+}
+
+static void writer_begin_field(RowWriter* w, const char* key) {
+    if (w->format == OUTPUT_CSV) {
+        if (w->fields++) writer_byte(w, ',');
+        return;
+    }
+    if (w->format == OUTPUT_TSV) {
+        if (w->fields++) writer_byte(w, '\t');
+        return;
+    }
+    writer_raw(w, w->fields++ ? ",\"" : "{\"");
+    for (const unsigned char* p = (const unsigned char*)key; *p; p++) writer_escaped(w, *p);
+    writer_raw(w, "\":");
+}
+
+// CSV 字符串字段一律加引号；TSV 只在含分隔符、换行或引号时加
+static int writer_quote_needed(const RowWriter* w, const char* s, int len) {
+    if (w->format != OUTPUT_TSV) return 1;
+    for (int i = 0; i < len; i++) {
+        if (s[i] == '\t' || s[i] == '\n' || s[i] == '\r' || s[i] == '"') return 1;
+    }
+    return 0;
+}
+
+void writer_text(RowWriter* w, const char* key, const char* value, int len) {
+    int quote = writer_quote_needed(w, value, len);
+    writer_begin_field(w, key);
+    if (quote) writer_byte(w, '"');
+    for (int i = 0; i < len; i++) writer_escaped(w, (unsigned char)value[i]);
+    if (quote) writer_byte(w, '"');
+}
+
+void writer_str(RowWriter* w, const char* key, const char* value) {
+    writer_text(w, key, value, (int)strlen(value));
+}
+
+void writer_wstr(RowWriter* w, const char* key, const wchar_t* value) {
+    int quote = 1;
+    if (w->format == OUTPUT_TSV) {
+        quote = 0;
+        for (const wchar_t* p = value; *p && !quote; p++) quote = (*p == L'\t' || *p == L'\n' || *p == L'\r' || *p == L'"');
+    }
+    writer_begin_field(w, key);
+    if (quote) writer_byte(w, '"');
+    for (const wchar_t* p = value; *p; p++) {
+        unsigned int cp = (unsigned int)*p;
+        if (cp >= 0xD800 && cp <= 0xDBFF && p[1] >= 0xDC00 && p[1] <= 0xDFFF) {
+            cp = 0x10000 + ((cp - 0xD800) << 10) + ((unsigned int)p[1] - 0xDC00);
+            p++;
+        }
+        writer_codepoint(w, cp);
+    }
+    if (quote) writer_byte(w, '"');
+}
+
+void writer_int(RowWriter* w, const char* key, long long value) {
+    char num[32];
+    snprintf(num, sizeof(num), "%lld", value);
+    writer_begin_field(w, key);
+    writer_raw(w, num);
+}
+
+// 毫秒值保留到微秒；无样本时 JSON 写 null，CSV 留空
+void writer_ms(RowWriter* w, const char* key, double ms, int valid) {
+    char num[32];
+    writer_begin_field(w, key);
+    if (!valid) {
+        if (w->format == OUTPUT_NDJSON) writer_raw(w, "null");
+        return;
+    }
+    snprintf(num, sizeof(num), "%.3f", ms);
+    writer_raw(w, num);
+}
+
+void writer_end_row(RowWriter* w) {
+    if (w->format == OUTPUT_NDJSON) writer_byte(w, '}');
+    if (w->format == OUTPUT_TSV) writer_byte(w, '\r');   // 剪贴板文本按 Windows 换行
+    writer_byte(w, '\n');
+    w->fields = 0;
+}
+
+// 固定的 CSV 表头，与各行写出字段的顺序一致
+void writer_header(RowWriter* w, const char* columns) {
+    if (w->format != OUTPUT_CSV) return;
+    writer_raw(w, columns);
+    writer_byte(w, '\n');
+}
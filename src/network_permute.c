@@ -0,0 +1,113 @@
+#include "network_modules.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// --- 循环群置换 ---
+// 取大于索引空间 n 的素数 p，在乘法群 Z_p* 上从起点 x0 反复乘以原根 g：
+// x0, x0*g, x0*g^2 ... 会不重不漏地遍历 1..p-1 后回到 x0，丢弃大于 n 的值即得到 0..n-1 的伪随机排列。
+// 只需保存几个整数，不需要打乱后的数组；相同种子得到相同顺序。
+// p 限制在 2^32 以内，乘积可直接用 64 位整数计算。
+
+#define PERMUTE_PRIME_LIMIT 4294967291ULL   // 小于 2^32 的最大素数
+
+static unsigned long long mix64(unsigned long long x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+static int is_prime(unsigned long long n) {
+    if (n < 2) return 0;
+    if (n % 2 == 0) return n == 2;
+    for (unsigned long long d = 3; d * d <= n; d += 2) {
+        if (n % d == 0) return 0;
+    }
+    return 1;
+}
+
+static unsigned long long pow_mod(unsigned long long b, unsigned long long e, unsigned long long m) {
+    unsigned long long r = 1;
+    b %= m;
+    while (e) {
+        if (e & 1) r = r * b % m;
+        b = b * b % m;
+        e >>= 1;
+    }
+    return r;
+}
+
+// g 是模 p 的原根，当且仅当对 p-1 的每个素因子 q 都有 g^((p-1)/q) != 1
+static int is_generator(unsigned long long g, unsigned long long p, const unsigned long long* factors, int factorCount) {
+    for (int i = 0; i < factorCount; i++) {
+        if (pow_mod(g, (p - 1) / factors[i], p) == 1) return 0;
+    }
+    return 1;
+}
+
+int permutation_init(Permutation* pm, unsigned long long range, unsigned long long seed) {
+    pm->range = range;
+    pm->current = 0;
+    pm->started = 0;
+    if (range == 0) return 1;
+    if (range >= PERMUTE_PRIME_LIMIT) return 0;
+
+    unsigned long long p = range + 1;
+    while (!is_prime(p)) p++;
+    pm->prime = p;
+
+    if (p == 2) {
+        // Z_2* 只有 1 个元素
+        pm->root = 1;
+        pm->first = 1;
+        return 1;
+    }
+
+    unsigned long long factors[16];
+    int factorCount = 0;
+    unsigned long long m = p - 1;
+    for (unsigned long long d = 2; d * d <= m; d++) {
+        if (m % d == 0) {
+            factors[factorCount++] = d;
+            while (m % d == 0) m /= d;
+        }
+    }
+    if (m > 1) factors[factorCount++] = m;
+
+    // 从种子派生的位置起寻找原根与起点，不同种子得到不同排列
+    unsigned long long h = mix64(seed);
+    unsigned long long g = 2 + h % (p - 2);
+    while (!is_generator(g, p, factors, factorCount)) g = (g + 1 < p) ? g + 1 : 2;
+    pm->root = g;
+    pm->first = 1 + mix64(h) % (p - 1);
+    return 1;
+}
+
+int permutation_next(Permutation* pm, unsigned long long* index) {
+    if (pm->range == 0) return 0;
+    for (;;) {
+        if (!pm->started) {
+            pm->current = pm->first;
+            pm->started = 1;
+        } else {
+            pm->current = pm->current * pm->root % pm->prime;
+            if (pm->current == pm->first) { pm->range = 0; return 0; }
+        }
+        if (pm->current <= pm->range) {
+            *index = pm->current - 1;
+            return 1;
+        }
+    }
+}
+
+// 分片时各节点必须得到相同的遍历顺序：主机按 UTF-8 哈希、端口按 2 字节小端哈希，与平台的 wchar_t 宽度和字节序无关
+unsigned long long shard_default_seed(const char* const* hosts, int hostCount, const int* ports, int portCount) {
+    unsigned int h = 2166136261u;
+    for (int i = 0; i < hostCount; i++) h = checkpoint_hash(hosts[i], (int)strlen(hosts[i]) + 1, h);
+    for (int i = 0; i < portCount; i++) {
+        unsigned char b[2] = { (unsigned char)ports[i], (unsigned char)(ports[i] >> 8) };
+        h = checkpoint_hash(b, 2, h);
+    }
+    return 0x6E6574746F6F6C73ULL ^ h;
+}
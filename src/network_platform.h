@@ -0,0 +1,262 @@
+#ifndef NETWORK_PLATFORM_H
+#define NETWORK_PLATFORM_H
+
+#include <stdio.h>
+
+// --- 平台抽象层 ---
+// Windows 下沿用 Winsock；Linux 下映射到 BSD socket，
+// 使仅依赖 socket 的模块 (如 SYN 扫描、并发探测引擎) 可以在两端编译。
+
+#ifdef _WIN32
+// Winsock 的 fd_set 是数组而非位图，默认只能容纳 64 个 socket，并发探测引擎需要更多
+#ifndef FD_SETSIZE
+#define FD_SETSIZE 1024
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+
+static __inline unsigned long long platform_tick_ms(void) {
+    return GetTickCount64();
+}
+
+// 微秒级单调时钟，用于令牌桶等高精度计时
+static __inline unsigned long long platform_tick_us(void) {
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+    if (freq.QuadPart == 0) QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (unsigned long long)(now.QuadPart / freq.QuadPart) * 1000000ULL +
+           (unsigned long long)(now.QuadPart % freq.QuadPart) * 1000000ULL / freq.QuadPart;
+}
+
+static __inline int platform_last_error(void) {
+    return WSAGetLastError();
+}
+
+static __inline void platform_sleep_ms(int ms) {
+    Sleep(ms);
+}
+
+static __inline int platform_set_nonblock(SOCKET s) {
+    unsigned long mode = 1;
+    return ioctlsocket(s, FIONBIO, &mode);
+}
+
+// 文件操作：路径统一用宽字符，Windows 直接调用宽字符 API
+static __inline FILE* platform_wfopen(const wchar_t* path, const wchar_t* mode) {
+    FILE* f = NULL;
+    if (_wfopen_s(&f, path, mode) != 0) return NULL;
+    return f;
+}
+
+static __inline int platform_replace_file(const wchar_t* from, const wchar_t* to) {
+    return MoveFileExW(from, to, MOVEFILE_REPLACE_EXISTING) != 0;
+}
+
+static __inline void platform_remove_file(const wchar_t* path) {
+    DeleteFileW(path);
+}
+
+// GBK (系统 ANSI 代码页) 文本转 UTF-8，经宽字符中转，用于 qqwry.dat 中的归属地字符串
+static __inline void platform_gbk_to_utf8(const char* gbk, char* buf, int bufLen) {
+    wchar_t wide[512];
+    if (bufLen <= 0) return;
+    if (MultiByteToWideChar(CP_ACP, 0, gbk, -1, wide, 512) == 0 ||
+        WideCharToMultiByte(CP_UTF8, 0, wide, -1, buf, bufLen, NULL, NULL) == 0) buf[0] = 0;
+}
+
+// 原子加与读取 (运行指标计数器用，无需内存序保证)
+static __inline long long platform_atomic_add(volatile long long* p, long long v) {
+    return InterlockedExchangeAdd64(p, v);
+}
+
+static __inline long long platform_atomic_load(volatile long long* p) {
+    return InterlockedCompareExchange64(p, 0, 0);
+}
+
+// [新增] 自旋锁 (对象池的空闲链表用，临界区只有几条指令)
+static __inline int platform_try_lock(volatile long* lock) {
+    return InterlockedCompareExchange(lock, 1, 0) == 0;
+}
+
+static __inline void platform_unlock(volatile long* lock) {
+    InterlockedExchange(lock, 0);
+}
+
+// [新增] 进程可打开的 socket 数：Windows 没有进程级句柄上限 (select 后端另受 FD_SETSIZE 约束)
+static __inline int platform_raise_fd_limit(void) {
+    return 0;
+}
+
+// [新增] 本机临时端口数：connect 自动分配的端口不跨目标复用，取系统默认动态端口范围 49152-65535
+static __inline int platform_ephemeral_ports(void) {
+    return 16384;
+}
+
+#ifdef _MSC_VER
+#define PLATFORM_THREAD_LOCAL __declspec(thread)
+#else
+#define PLATFORM_THREAD_LOCAL __thread
+#endif
+
+#define PLATFORM_SEND_FLAGS 0
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <wchar.h>
+#include <stdlib.h>
+#include <string.h>
+#include <iconv.h>
+#include <sys/resource.h>
+
+typedef int SOCKET;
+typedef void* HWND;
+
+#define INVALID_SOCKET  (-1)
+#define SOCKET_ERROR    (-1)
+#define closesocket     close
+
+// 统一使用 Winsock 错误码名称，便于共享判断逻辑
+#define WSAEWOULDBLOCK  EWOULDBLOCK
+#define WSAEINPROGRESS  EINPROGRESS
+#define WSAECONNRESET   ECONNRESET
+#define WSAECONNREFUSED ECONNREFUSED
+#define WSAEADDRINUSE    EADDRINUSE
+#define WSAEADDRNOTAVAIL EADDRNOTAVAIL
+#define WSAEMFILE        EMFILE
+#define WSAENOBUFS       ENOBUFS
+
+// 对端已关闭时避免 SIGPIPE 终止进程
+#define PLATFORM_SEND_FLAGS MSG_NOSIGNAL
+
+static inline unsigned long long platform_tick_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static inline unsigned long long platform_tick_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static inline int platform_last_error(void) {
+    return errno;
+}
+
+static inline void platform_sleep_ms(int ms) {
+    usleep((useconds_t)ms * 1000);
+}
+
+static inline int platform_set_nonblock(SOCKET s) {
+    int flags = fcntl(s, F_GETFL, 0);
+    return fcntl(s, F_SETFL, flags | O_NONBLOCK);
+}
+
+static inline long long platform_atomic_add(volatile long long* p, long long v) {
+    return __atomic_fetch_add(p, v, __ATOMIC_RELAXED);
+}
+
+static inline long long platform_atomic_load(volatile long long* p) {
+    return __atomic_load_n(p, __ATOMIC_RELAXED);
+}
+
+static inline int platform_try_lock(volatile long* lock) {
+    return __atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE) == 0;
+}
+
+static inline void platform_unlock(volatile long* lock) {
+    __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+}
+
+#define PLATFORM_THREAD_LOCAL __thread
+
+// 先把打开文件数的软上限提到硬上限，返回提升后的软上限 (0 = 不限)
+static inline int platform_raise_fd_limit(void) {
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) != 0) return 0;
+    if (rl.rlim_cur < rl.rlim_max) {
+        rlim_t want = rl.rlim_max == RLIM_INFINITY ? 1048576 : rl.rlim_max;
+        struct rlimit up = rl;
+        up.rlim_cur = want;
+        if (setrlimit(RLIMIT_NOFILE, &up) == 0) rl.rlim_cur = want;
+    }
+    if (rl.rlim_cur == RLIM_INFINITY || rl.rlim_cur > 0x7fffffff) return 0;
+    return (int)rl.rlim_cur;
+}
+
+// 本机临时端口范围的大小，读不到时按内核默认 32768-60999
+static inline int platform_ephemeral_ports(void) {
+    int lo = 32768, hi = 60999;
+    FILE* f = fopen("/proc/sys/net/ipv4/ip_local_port_range", "r");
+    if (f) {
+        if (fscanf(f, "%d %d", &lo, &hi) != 2) { lo = 32768; hi = 60999; }
+        fclose(f);
+    }
+    return hi >= lo ? hi - lo + 1 : 0;
+}
+
+// 宽字符路径按当前区域设置转为多字节
+static inline int platform_path(const wchar_t* path, char* out, size_t outLen) {
+    size_t n = wcstombs(out, path, outLen);
+    return n != (size_t)-1 && n < outLen;
+}
+
+static inline FILE* platform_wfopen(const wchar_t* path, const wchar_t* mode) {
+    char p[1024], m[8];
+    if (!platform_path(path, p, sizeof(p)) || !platform_path(mode, m, sizeof(m))) return NULL;
+    return fopen(p, m);
+}
+
+static inline int platform_replace_file(const wchar_t* from, const wchar_t* to) {
+    char a[1024], b[1024];
+    if (!platform_path(from, a, sizeof(a)) || !platform_path(to, b, sizeof(b))) return 0;
+    return rename(a, b) == 0;
+}
+
+static inline void platform_remove_file(const wchar_t* path) {
+    char p[1024];
+    if (platform_path(path, p, sizeof(p))) remove(p);
+}
+
+static inline void platform_gbk_to_utf8(const char* gbk, char* buf, int bufLen) {
+    if (bufLen <= 0) return;
+    buf[0] = 0;
+    iconv_t cd = iconv_open("UTF-8", "GBK");
+    if (cd == (iconv_t)-1) return;
+    char* in = (char*)gbk;
+    char* out = buf;
+    size_t inLeft = strlen(gbk);
+    size_t outLeft = (size_t)bufLen - 1;
+    iconv(cd, &in, &inLeft, &out, &outLeft);
+    *out = 0;
+    iconv_close(cd);
+}
+#endif
+
+// 取不到锁时先自旋，再让出时间片
+static __inline void platform_lock(volatile long* lock) {
+    int spins = 0;
+    while (!platform_try_lock(lock)) {
+        if (++spins > 64) { platform_sleep_ms(0); spins = 0; }
+    }
+}
+
+// [新增] 关闭时直接发送 RST 而不是 FIN：连接不进入 TIME_WAIT，高速扫描不会把临时端口耗尽
+static __inline void platform_set_abortive_close(SOCKET s) {
+    struct linger lg;
+    lg.l_onoff = 1;
+    lg.l_linger = 0;
+    setsockopt(s, SOL_SOCKET, SO_LINGER, (const char*)&lg, sizeof(lg));
+}
+
+#endif // NETWORK_PLATFORM_H
@@ -0,0 +1,162 @@
+#include "network_modules.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+
+// --- 端口集合 ---
+// 65536 位的位图 (8KB)，天然去重、可做并/差运算；
+// 导出为数组时常见端口排在前面，大范围扫描时开放端口会更早出现。
+
+// 端口按实际开放频率排序：前 100 个取自 Nmap 的 TCP 统计，其后为常见服务端口
+static const unsigned short g_topPorts[] = {
+    80, 23, 443, 21, 22, 25, 3389, 110, 445, 139, 143, 53, 135, 3306, 8080, 1723,
+    111, 995, 993, 5900, 1025, 587, 8888, 199, 1720, 465, 548, 113, 81, 6001, 10000, 514,
+    5060, 179, 1026, 2000, 8443, 8000, 32768, 554, 26, 1433, 49152, 2001, 515, 8008, 49154, 1027,
+    5666, 646, 5000, 5631, 631, 49153, 8081, 2049, 88, 79, 5800, 106, 2121, 1110, 49155, 6000,
+    513, 990, 5357, 427, 49156, 543, 544, 5101, 144, 7, 389, 8009, 3128, 444, 9999, 5009,
+    7070, 5190, 3000, 5432, 1900, 3986, 13, 1029, 9, 5051, 6646, 49157, 1028, 873, 1755, 2717,
+    4899, 9100, 119, 37, 1080, 1521, 6379, 27017, 9200, 5601, 11211, 5672, 15672, 2375, 2376, 2379,
+    6443, 10250, 9092, 2181, 8086, 9090, 9091, 9000, 9001, 8082, 8083, 8088, 8089, 8090, 8181, 8880,
+    8899, 9443, 10001, 10443, 1194, 1434, 1883, 2082, 2083, 2086, 2087, 2095, 2096, 3268, 3269, 3690,
+    4000, 4040, 4369, 4443, 4444, 4567, 4848, 5001, 5002, 5222, 5269, 5433, 5500, 5555, 5683, 5801,
+    5901, 5902, 5984, 5985, 5986, 6002, 6660, 6665, 6666, 6667, 6668, 6669, 6697, 7000, 7001, 7002,
+    7071, 7443, 7547, 7777, 8001, 8002, 8010, 8020, 8042, 8069, 8087, 8091, 8123, 8161, 8200, 8222,
+    8291, 8333, 8400, 8500, 8530, 8531, 8545, 8686, 8728, 8800, 8834, 8983, 9002, 9042, 9043, 9080,
+    9093, 9160, 9418, 9500, 9600, 9800, 9876, 9998, 10050, 10051, 16010, 17000, 18080, 20000, 25565, 27018,
+    28017, 31337, 37777, 44818, 47808, 50000, 50070, 50075, 1030, 1031, 1032, 1033, 1041, 1048, 1049, 1050,
+    1053, 1054, 1056, 1064, 1065, 2002, 2003, 2004, 2005, 2006, 2007, 3001, 3005, 3030, 3031, 3260,
+    3300, 3301, 3351, 3371, 3372, 3493, 3517, 3527, 3546, 3551, 3580, 3659, 3689, 3703, 3737, 3766,
+    3784, 3800, 3801, 3809, 3814, 3826, 3827, 3828, 3851, 3869, 3871, 3878, 3880, 3889, 3905, 3914,
+    3918, 3920, 3945, 3971, 3995, 3998,
+};
+
+#define TOP_PORT_COUNT ((int)(sizeof(g_topPorts) / sizeof(g_topPorts[0])))
+
+void portset_clear(PortSet* s) {
+    memset(s->bits, 0, sizeof(s->bits));
+}
+
+void portset_add(PortSet* s, int port) {
+    if (port >= PORTSET_MIN && port <= PORTSET_MAX) s->bits[port >> 5] |= 1u << (port & 31);
+}
+
+void portset_add_range(PortSet* s, int first, int last) {
+    if (first < PORTSET_MIN) first = PORTSET_MIN;
+    if (last > PORTSET_MAX) last = PORTSET_MAX;
+    for (int p = first; p <= last; p++) s->bits[p >> 5] |= 1u << (p & 31);
+}
+
+int portset_has(const PortSet* s, int port) {
+    if (port < PORTSET_MIN || port > PORTSET_MAX) return 0;
+    return (s->bits[port >> 5] >> (port & 31)) & 1;
+}
+
+void portset_union(PortSet* dst, const PortSet* src) {
+    for (int i = 0; i < PORTSET_WORDS; i++) dst->bits[i] |= src->bits[i];
+}
+
+void portset_diff(PortSet* dst, const PortSet* src) {
+    for (int i = 0; i < PORTSET_WORDS; i++) dst->bits[i] &= ~src->bits[i];
+}
+
+int portset_count(const PortSet* s) {
+    int n = 0;
+    for (int i = 0; i < PORTSET_WORDS; i++) {
+        unsigned int w = s->bits[i];
+        while (w) { w &= w - 1; n++; }
+    }
+    return n;
+}
+
+int portset_next(const PortSet* s, int from) {
+    if (from < PORTSET_MIN) from = PORTSET_MIN;
+    for (int i = from >> 5; i < PORTSET_WORDS; i++) {
+        unsigned int w = s->bits[i];
+        if (i == (from >> 5)) w &= ~0u << (from & 31);
+        if (!w) continue;
+        int bit = 0;
+        while (!(w & (1u << bit))) bit++;
+        return (i << 5) + bit;
+    }
+    return -1;
+}
+
+// 加入最常见的 n 个端口；超出内置频率表的部分按端口号升序补足
+void portset_add_top(PortSet* s, int n) {
+    PortSet ranked;
+    portset_clear(&ranked);
+    for (int i = 0; i < TOP_PORT_COUNT && i < n; i++) portset_add(&ranked, g_topPorts[i]);
+    int added = n < TOP_PORT_COUNT ? n : TOP_PORT_COUNT;
+    if (added < n) {
+        PortSet table;
+        portset_clear(&table);
+        for (int i = 0; i < TOP_PORT_COUNT; i++) portset_add(&table, g_topPorts[i]);
+        for (int p = PORTSET_MIN; p <= PORTSET_MAX && added < n; p++) {
+            if (!portset_has(&table, p)) { portset_add(&ranked, p); added++; }
+        }
+    }
+    portset_union(s, &ranked);
+}
+
+// 语法：逗号分隔的 端口 / 起-止 / topN，前缀 '!' 表示从结果中排除
+// 例如 "top1000,8000-8100,!25"。返回无法识别的片段数
+int portset_parse(PortSet* s, const wchar_t* text) {
+    PortSet exclude;
+    portset_clear(s);
+    portset_clear(&exclude);
+    if (!text) return 0;
+
+    int bad = 0;
+    const wchar_t* p = text;
+    while (*p) {
+        while (*p == L',' || *p == L' ' || *p == L'\t' || *p == L'\r' || *p == L'\n') p++;
+        if (!*p) break;
+
+        PortSet* target = s;
+        if (*p == L'!') { target = &exclude; p++; }
+
+        int first = 0, last = 0, n = 0;
+        if (swscanf(p, L"top%d%n", &first, &n) == 1 || swscanf(p, L"TOP%d%n", &first, &n) == 1) {
+            if (first > 0) portset_add_top(target, first);
+            else bad++;
+        } else if (swscanf(p, L"%d - %d%n", &first, &last, &n) == 2) {
+            if (first <= last) portset_add_range(target, first, last);
+            else bad++;
+        } else if (swscanf(p, L"%d%n", &first, &n) == 1 && first >= PORTSET_MIN && first <= PORTSET_MAX) {
+            portset_add(target, first);
+        } else {
+            bad++;
+            n = 0;
+        }
+        p += n;
+        while (*p == L' ' || *p == L'\t') p++;
+        // 跳过本片段剩余的无法识别内容
+        if (*p && *p != L',') {
+            if (n > 0) bad++;
+            while (*p && *p != L',') p++;
+        }
+    }
+    portset_diff(s, &exclude);
+    return bad;
+}
+
+// 导出为数组：频率表中的端口按排名在前，其余按端口号升序
+int* portset_to_array(const PortSet* s, int* count) {
+    int total = portset_count(s);
+    *count = 0;
+    int* out = (int*)malloc(sizeof(int) * (total ? total : 1));
+    if (!out) return NULL;
+
+    PortSet rest = *s;
+    int n = 0;
+    for (int i = 0; i < TOP_PORT_COUNT; i++) {
+        if (portset_has(&rest, g_topPorts[i])) {
+            out[n++] = g_topPorts[i];
+            rest.bits[g_topPorts[i] >> 5] &= ~(1u << (g_topPorts[i] & 31));
+        }
+    }
+    for (int p = portset_next(&rest, PORTSET_MIN); p >= 0; p = portset_next(&rest, p + 1)) out[n++] = p;
+    *count = n;
+    return out;
+}
@@ -0,0 +1,282 @@
+#include "network_modules.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// --- 代理检测 ---
+// 对每个候选代理并发尝试 HTTP CONNECT / SOCKS5 / SOCKS4 握手，隧道打通后经代理请求测试目标，
+// 分别记录握手耗时与首字节耗时。所有 socket 非阻塞，由单线程 select 循环驱动。
+
+#define PROXY_DEFAULT_INFLIGHT 128
+#define PROXY_DEFAULT_TIMEOUT  5000
+#define PROXY_BUF_SIZE         512
+#define PROXY_TICK_MS          50
+
+enum {
+    STEP_CONNECT = 0,   // 等待 TCP 连接
+    STEP_GREETING,      // SOCKS5 方法协商
+    STEP_TUNNEL,        // 等待 CONNECT 应答
+    STEP_FIRST_BYTE     // 隧道已通，等待测试请求的首字节
+};
+
+static const int g_protocols[] = { PROXY_HTTP, PROXY_SOCKS5, PROXY_SOCKS4 };
+#define PROTOCOL_COUNT ((int)(sizeof(g_protocols) / sizeof(g_protocols[0])))
+
+typedef struct {
+    SOCKET sock;
+    int proxy;
+    int protocol;
+    int step;
+    unsigned long long started;     // 微秒
+    unsigned long long connected;
+    unsigned long long tunneled;
+    unsigned long long deadline;    // 毫秒
+    int len;
+    char buf[PROXY_BUF_SIZE];
+} ProxyJob;
+
+typedef struct {
+    const ProxyCheckConfig* cfg;
+    ProxyCheckResult* results;
+    ProxyJob* jobs;
+    int inFlight;
+    int maxInFlight;
+    int cursor;                     // 下一个 (代理, 协议) 组合
+    int done;
+    char request[256];              // 隧道打通后发送的测试请求
+    int requestLen;
+} ProxyChecker;
+
+static void proxy_send(ProxyJob* j, const char* data, int len) {
+    send(j->sock, data, len, PLATFORM_SEND_FLAGS);
+    j->len = 0;
+}
+
+// 发送各协议的第一步请求
+static void proxy_begin(ProxyChecker* c, ProxyJob* j) {
+    const ProxyCheckConfig* cfg = c->cfg;
+    const unsigned char* ip = (const unsigned char*)&cfg->testAddr.sin_addr.s_addr;
+    unsigned short port = ntohs(cfg->testAddr.sin_port);
+    char req[300];
+    int n;
+
+    switch (j->protocol) {
+    case PROXY_HTTP:
+        n = snprintf(req, sizeof(req), "CONNECT %s:%d HTTP/1.1\r\nHost: %s:%d\r\n\r\n",
+                     cfg->testHost, port, cfg->testHost, port);
+        proxy_send(j, req, n);
+        j->step = STEP_TUNNEL;
+        break;
+    case PROXY_SOCKS5:
+        proxy_send(j, "\x05\x01\x00", 3);       // 1 种方法：无认证
+        j->step = STEP_GREETING;
+        break;
+    case PROXY_SOCKS4:
+        req[0] = 0x04; req[1] = 0x01;
+        req[2] = (char)(port >> 8); req[3] = (char)(port & 0xFF);
+        memcpy(req + 4, ip, 4);
+        req[8] = 0;                             // 空用户名
+        proxy_send(j, req, 9);
+        j->step = STEP_TUNNEL;
+        break;
+    }
+}
+
+static void proxy_send_connect_socks5(ProxyChecker* c, ProxyJob* j) {
+    char req[10];
+    unsigned short port = ntohs(c->cfg->testAddr.sin_port);
+    req[0] = 0x05; req[1] = 0x01; req[2] = 0x00; req[3] = 0x01;   // CONNECT, IPv4
+    memcpy(req + 4, &c->cfg->testAddr.sin_addr.s_addr, 4);
+    req[8] = (char)(port >> 8); req[9] = (char)(port & 0xFF);
+    proxy_send(j, req, 10);
+    j->step = STEP_TUNNEL;
+}
+
+// 检查隧道应答：返回 1 成功、0 数据不完整、-1 失败
+static int proxy_tunnel_reply(const ProxyJob* j) {
+    const unsigned char* b = (const unsigned char*)j->buf;
+    switch (j->protocol) {
+    case PROXY_HTTP: {
+        // 等到完整的响应头，状态码 2xx 即成功
+        int end = 0;
+        for (int i = 3; i < j->len; i++) {
+            if (b[i - 3] == '\r' && b[i - 2] == '\n' && b[i - 1] == '\r' && b[i] == '\n') { end = 1; break; }
+        }
+        if (j->len >= 12 && memcmp(j->buf, "HTTP/1.", 7) != 0) return -1;
+        if (!end) return j->len >= PROXY_BUF_SIZE ? -1 : 0;
+        return j->buf[9] == '2' ? 1 : -1;
+    }
+    case PROXY_SOCKS5: {
+        if (j->len < 5) return 0;
+        if (b[0] != 0x05 || b[1] != 0x00) return -1;
+        int need = b[3] == 0x01 ? 10 : b[3] == 0x04 ? 22 : b[3] == 0x03 ? 7 + b[4] : -1;
+        if (need < 0) return -1;
+        return j->len >= need ? 1 : 0;
+    }
+    case PROXY_SOCKS4:
+        if (j->len < 8) return 0;
+        return b[1] == 0x5A ? 1 : -1;
+    }
+    return -1;
+}
+
+// [修改] 每次尝试结束 (含 socket 创建与 connect 立即失败) 都汇报进度，失败的代理同样能走到 100%
+static void proxy_count_done(ProxyChecker* c) {
+    c->done++;
+    if (c->cfg->onProgress) c->cfg->onProgress(c->cfg->ctx, c->done, c->cfg->proxyCount * PROTOCOL_COUNT);
+}
+
+static void proxy_finish(ProxyChecker* c, int idx, int ok, unsigned long long nowUs) {
+    ProxyJob* j = &c->jobs[idx];
+    if (ok) {
+        ProxyCheckResult* r = &c->results[j->proxy];
+        int connectMs = (int)((j->connected - j->started) / 1000);
+        int handshakeMs = (int)((j->tunneled - j->connected) / 1000);
+        int firstByteMs = (int)((nowUs - j->tunneled) / 1000);
+        r->protocols |= PROXY_BIT(j->protocol);
+        // 同一代理支持多种协议时保留总耗时最短的
+        if (!r->protocol || handshakeMs + firstByteMs < r->handshakeMs + r->firstByteMs) {
+            r->protocol = j->protocol;
+            r->connectMs = connectMs;
+            r->handshakeMs = handshakeMs;
+            r->firstByteMs = firstByteMs;
+        }
+    }
+    closesocket(j->sock);
+    proxy_count_done(c);
+    c->jobs[idx] = c->jobs[--c->inFlight];
+}
+
+static void proxy_fill(ProxyChecker* c, unsigned long long now) {
+    const ProxyCheckConfig* cfg = c->cfg;
+    while (c->inFlight < c->maxInFlight && c->cursor < cfg->proxyCount * PROTOCOL_COUNT) {
+        int proxy = c->cursor / PROTOCOL_COUNT;
+        int protocol = g_protocols[c->cursor % PROTOCOL_COUNT];
+        const ProbeTarget* t = &cfg->proxies[proxy];
+        c->cursor++;
+
+        SOCKET s = t->family ? socket(t->family == 6 ? AF_INET6 : AF_INET, SOCK_STREAM, IPPROTO_TCP) : INVALID_SOCKET;
+        if (s == INVALID_SOCKET) {
+            proxy_count_done(c);
+            continue;
+        }
+        platform_set_nonblock(s);
+        int addrLen = t->family == 6 ? (int)sizeof(t->addr.v6) : (int)sizeof(t->addr.v4);
+        if (connect(s, (const struct sockaddr*)&t->addr, addrLen) == SOCKET_ERROR) {
+            int err = platform_last_error();
+            if (err != WSAEWOULDBLOCK && err != WSAEINPROGRESS) {
+                closesocket(s);
+                proxy_count_done(c);
+                continue;
+            }
+        }
+
+        ProxyJob* j = &c->jobs[c->inFlight++];
+        j->sock = s;
+        j->proxy = proxy;
+        j->protocol = protocol;
+        j->step = STEP_CONNECT;
+        j->started = platform_tick_us();
+        j->connected = j->tunneled = 0;
+        j->deadline = now + cfg->timeoutMs;
+        j->len = 0;
+    }
+}
+
+// 读取到新数据后推进状态机
+static void proxy_advance(ProxyChecker* c, int idx, unsigned long long nowUs) {
+    ProxyJob* j = &c->jobs[idx];
+    int n = recv(j->sock, j->buf + j->len, PROXY_BUF_SIZE - j->len, 0);
+    if (n < 0 && platform_last_error() == WSAEWOULDBLOCK) return;
+    if (n <= 0) { proxy_finish(c, idx, 0, nowUs); return; }
+    j->len += n;
+
+    if (j->step == STEP_FIRST_BYTE) {
+        proxy_finish(c, idx, 1, nowUs);
+    } else if (j->step == STEP_GREETING) {
+        if (j->len < 2) return;
+        if (j->buf[0] != 0x05 || j->buf[1] != 0x00) { proxy_finish(c, idx, 0, nowUs); return; }
+        proxy_send_connect_socks5(c, j);
+    } else if (j->step == STEP_TUNNEL) {
+        int r = proxy_tunnel_reply(j);
+        if (r < 0) { proxy_finish(c, idx, 0, nowUs); return; }
+        if (r == 0) return;
+        j->tunneled = nowUs;
+        proxy_send(j, c->request, c->requestLen);
+        j->step = STEP_FIRST_BYTE;
+    }
+}
+
+int proxy_check_run(const ProxyCheckConfig* cfg, ProxyCheckResult* results) {
+    if (!cfg || !results || cfg->proxyCount <= 0 || !cfg->testHost) return 0;
+
+    ProxyCheckConfig local = *cfg;
+    if (local.timeoutMs <= 0) local.timeoutMs = PROXY_DEFAULT_TIMEOUT;
+
+    ProxyChecker c;
+    memset(&c, 0, sizeof(c));
+    c.cfg = &local;
+    c.results = results;
+    c.maxInFlight = cfg->maxInFlight > 0 ? cfg->maxInFlight : PROXY_DEFAULT_INFLIGHT;
+    if (c.maxInFlight > FD_SETSIZE - 16) c.maxInFlight = FD_SETSIZE - 16;
+    c.jobs = (ProxyJob*)malloc(sizeof(ProxyJob) * c.maxInFlight);
+    if (!c.jobs) return 0;
+    memset(results, 0, sizeof(ProxyCheckResult) * cfg->proxyCount);
+    c.requestLen = snprintf(c.request, sizeof(c.request),
+                            "HEAD / HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n\r\n", cfg->testHost);
+
+    while (!is_task_stopped()) {
+        unsigned long long now = platform_tick_ms();
+        proxy_fill(&c, now);
+        if (c.inFlight == 0) break;
+
+        fd_set readFds, writeFds, exceptFds;
+        FD_ZERO(&readFds);
+        FD_ZERO(&writeFds);
+        FD_ZERO(&exceptFds);
+        SOCKET maxFd = 0;
+        unsigned long long wake = now + PROXY_TICK_MS;
+        for (int i = 0; i < c.inFlight; i++) {
+            ProxyJob* j = &c.jobs[i];
+            if (j->step == STEP_CONNECT) { FD_SET(j->sock, &writeFds); FD_SET(j->sock, &exceptFds); }
+            else FD_SET(j->sock, &readFds);
+            if (j->sock > maxFd) maxFd = j->sock;
+            if (j->deadline < wake) wake = j->deadline;
+        }
+        int waitMs = wake > now ? (int)(wake - now) : 0;
+        struct timeval tv;
+        tv.tv_sec = waitMs / 1000;
+        tv.tv_usec = (waitMs % 1000) * 1000;
+        int ret = select((int)maxFd + 1, &readFds, &writeFds, &exceptFds, &tv);
+        now = platform_tick_ms();
+        unsigned long long nowUs = platform_tick_us();
+
+        // 倒序遍历：proxy_finish 会把末尾元素换到当前位置
+        for (int i = c.inFlight - 1; i >= 0; i--) {
+            ProxyJob* j = &c.jobs[i];
+            if (ret > 0 && j->step == STEP_CONNECT &&
+                (FD_ISSET(j->sock, &writeFds) || FD_ISSET(j->sock, &exceptFds))) {
+                int err = 0;
+                socklen_t len = sizeof(err);
+                getsockopt(j->sock, SOL_SOCKET, SO_ERROR, (char*)&err, &len);
+                if (err != 0) { proxy_finish(&c, i, 0, nowUs); continue; }
+                j->connected = nowUs;
+                proxy_begin(&c, j);
+                continue;
+            }
+            if (ret > 0 && j->step != STEP_CONNECT && FD_ISSET(j->sock, &readFds)) {
+                int before = c.inFlight;
+                proxy_advance(&c, i, nowUs);
+                if (c.inFlight != before) continue;
+            }
+            if (now >= j->deadline) proxy_finish(&c, i, 0, nowUs);
+        }
+    }
+
+    for (int i = 0; i < c.inFlight; i++) closesocket(c.jobs[i].sock);
+    free(c.jobs);
+
+    int usable = 0;
+    for (int i = 0; i < cfg->proxyCount; i++) if (results[i].protocol) usable++;
+    return usable;
+}
@@ -0,0 +1,364 @@
+#include "network_modules.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// --- 结果日志 ---
+// 结果到达界面时按记录追加到二进制文件，导出与复制从这里按行流式读取，不再逐格读列表控件。
+// 文件头 8 字节标识 + 4 字节版本；之后每条记录为
+//   长度(4) 校验(4) | 类型(1) 列数(1) 保留(2) 行号(4) {列长(2) UTF-8 内容}...
+// 整数均为小端。程序崩溃时最多丢失尾部未写完的一条，读取时校验失败即视为日志结束。
+// [修改] 监控每轮都会追加刷新记录，文件超过阈值后按行压实：只保留每行合并后的最新状态，
+// 阈值随压实后的大小翻倍，追加的总开销仍与写入量成正比。
+
+#define RESLOG_MAGIC       "NTRESLOG"
+#define RESLOG_VERSION     1
+#define RESLOG_FILE_HEADER 12
+#define RESLOG_REC_HEADER  8        // 长度 + 校验
+#define RESLOG_BODY_FIXED  8        // 类型、列数、保留、行号
+#define RESLOG_FIELD_MAX   65535
+#define RESLOG_REC_MAX     (RESLOG_BODY_FIXED + RESLOG_MAX_FIELDS * (2 + RESLOG_FIELD_MAX))
+#define RESLOG_COMPACT_MIN (16ULL * 1024 * 1024)   // 小于此大小不压实
+
+struct ResultLog {
+    FILE* file;
+    wchar_t* path;                  // 压实时写临时文件再替换
+    unsigned char* rec;             // 编码缓冲，按需扩容
+    size_t recCap;
+    unsigned long long size;        // 已写入字节数
+    unsigned long long compactAt;   // 达到此大小时压实
+};
+
+// [修改] 读取时逐条解析，只为每行保留最新的新行记录与刷新记录，内存随行数而非文件大小增长
+struct ResultLogView {
+    unsigned char* header;          // 表头记录 (含记录头)，NULL = 没有
+    unsigned char** rowRec;         // 行号 -> 新行记录
+    unsigned char** updateRec;      // 行号 -> 最近一次刷新记录
+    unsigned int rowCap;
+    unsigned int rows;              // 最大行号 + 1
+    int columns;                    // 表头列数
+    char keys[RESLOG_MAX_FIELDS][64];   // NDJSON 键名，取自表头
+};
+
+static void put_u16(unsigned char* p, unsigned int v) {
+    p[0] = (unsigned char)v; p[1] = (unsigned char)(v >> 8);
+}
+
+static void put_u32(unsigned char* p, unsigned int v) {
+    put_u16(p, v); put_u16(p + 2, v >> 16);
+}
+
+static unsigned int get_u16(const unsigned char* p) {
+    return p[0] | (p[1] << 8);
+}
+
+static unsigned int get_u32(const unsigned char* p) {
+    return get_u16(p) | ((unsigned int)get_u16(p + 2) << 16);
+}
+
+static unsigned int reslog_checksum(const unsigned char* p, size_t len) {
+    unsigned int h = 2166136261u;
+    for (size_t i = 0; i < len; i++) h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+// --- 写入 ---
+static int reslog_reserve(ResultLog* log, size_t need) {
+    if (need <= log->recCap) return 1;
+    unsigned char* grown = (unsigned char*)realloc(log->rec, need);
+    if (!grown) return 0;
+    log->rec = grown;
+    log->recCap = need;
+    return 1;
+}
+
+static void reslog_body_start(ResultLog* log, int type, unsigned int rowId, int count) {
+    unsigned char* body = log->rec + RESLOG_REC_HEADER;
+    body[0] = (unsigned char)type;
+    body[1] = (unsigned char)count;
+    put_u16(body + 2, 0);
+    put_u32(body + 4, rowId);
+}
+
+// 补上长度与校验后整条写出
+static int reslog_body_finish(ResultLog* log, FILE* f, size_t pos) {
+    put_u32(log->rec, (unsigned int)pos);
+    put_u32(log->rec + 4, reslog_checksum(log->rec + RESLOG_REC_HEADER, pos));
+    size_t n = RESLOG_REC_HEADER + pos;
+    return fwrite(log->rec, 1, n, f) == n;
+}
+
+static int reslog_write_head(FILE* f) {
+    unsigned char head[RESLOG_FILE_HEADER];
+    memcpy(head, RESLOG_MAGIC, 8);
+    put_u32(head + 8, RESLOG_VERSION);
+    return fwrite(head, 1, sizeof(head), f) == sizeof(head);
+}
+
+ResultLog* reslog_create(const wchar_t* path) {
+    ResultLog* log = (ResultLog*)calloc(1, sizeof(ResultLog));
+    if (!log) return NULL;
+    size_t pathLen = wcslen(path) + 1;
+    log->path = (wchar_t*)malloc(pathLen * sizeof(wchar_t));
+    if (log->path) memcpy(log->path, path, pathLen * sizeof(wchar_t));
+    log->file = platform_wfopen(path, L"wb");
+    log->recCap = 4096;
+    log->rec = (unsigned char*)malloc(log->recCap);
+    if (!log->path || !log->file || !log->rec) { reslog_close(log); return NULL; }
+    // 结果到达很频繁，由调用方定期 reslog_flush 落盘
+    setvbuf(log->file, NULL, _IOFBF, 65536);
+    reslog_write_head(log->file);
+    log->size = RESLOG_FILE_HEADER;
+    log->compactAt = RESLOG_COMPACT_MIN;
+    return log;
+}
+
+// 已是 UTF-8 的一行原样编码，压实时使用
+static int reslog_put_row(ResultLog* log, FILE* f, int type, unsigned int rowId, const ResultLogRow* row) {
+    size_t need = RESLOG_REC_HEADER + RESLOG_BODY_FIXED;
+    for (int i = 0; i < row->count; i++) need += 2 + (size_t)row->len[i];
+    if (!reslog_reserve(log, need)) return 0;
+    reslog_body_start(log, type, rowId, row->count);
+    unsigned char* body = log->rec + RESLOG_REC_HEADER;
+    size_t pos = RESLOG_BODY_FIXED;
+    for (int i = 0; i < row->count; i++) {
+        put_u16(body + pos, (unsigned int)row->len[i]);
+        if (row->len[i] > 0) memcpy(body + pos + 2, row->text[i], row->len[i]);
+        pos += 2 + (size_t)row->len[i];
+    }
+    return reslog_body_finish(log, f, pos);
+}
+
+// 把日志重写为表头 + 每行合并后的一条新行记录，写完整个临时文件后再替换
+static void reslog_compact(ResultLog* log) {
+    fflush(log->file);
+    ResultLogView* v = reslog_load(log->path);
+    if (!v) { log->compactAt = log->size * 2; return; }
+
+    size_t pathLen = wcslen(log->path);
+    wchar_t* tmp = (wchar_t*)malloc((pathLen + 5) * sizeof(wchar_t));
+    FILE* out = NULL;
+    if (tmp) {
+        memcpy(tmp, log->path, pathLen * sizeof(wchar_t));
+        memcpy(tmp + pathLen, L".tmp", 5 * sizeof(wchar_t));
+        out = platform_wfopen(tmp, L"wb");
+    }
+    unsigned long long size = RESLOG_FILE_HEADER;
+    int ok = out && reslog_write_head(out);
+    ResultLogRow row;
+    if (ok && reslog_view_header(v, &row)) {
+        ok = reslog_put_row(log, out, RESLOG_HEADER, 0, &row);
+        size += RESLOG_REC_HEADER + get_u32(log->rec);
+    }
+    for (unsigned int id = 0; ok && id < v->rows; id++) {
+        if (!reslog_view_row(v, id, &row)) continue;
+        ok = reslog_put_row(log, out, RESLOG_ROW, id, &row);
+        size += RESLOG_REC_HEADER + get_u32(log->rec);
+    }
+    reslog_view_free(v);
+    if (out && fclose(out) != 0) ok = 0;
+
+    // 替换前必须先关闭原文件；替换失败时原文件仍完整，继续在末尾追加
+    if (ok) {
+        fclose(log->file);
+        ok = platform_replace_file(tmp, log->path);
+        log->file = platform_wfopen(log->path, L"ab");
+        if (log->file) setvbuf(log->file, NULL, _IOFBF, 65536);
+        if (ok) log->size = size;
+    } else if (tmp) {
+        platform_remove_file(tmp);
+    }
+    free(tmp);
+    log->compactAt = log->size * 2 > RESLOG_COMPACT_MIN ? log->size * 2 : RESLOG_COMPACT_MIN;
+}
+
+void reslog_append(ResultLog* log, int type, unsigned int rowId, const wchar_t* const* fields, int count) {
+    if (!log || !log->file) return;
+    if (count > RESLOG_MAX_FIELDS) count = RESLOG_MAX_FIELDS;
+
+    // UTF-8 每个 UTF-16 单元最多 3 字节，按上限一次备足空间
+    size_t need = RESLOG_REC_HEADER + RESLOG_BODY_FIXED;
+    for (int i = 0; i < count; i++) need += 2 + wcslen(fields[i]) * 3;
+    if (!reslog_reserve(log, need)) return;
+
+    reslog_body_start(log, type, rowId, count);
+    unsigned char* body = log->rec + RESLOG_REC_HEADER;
+    size_t pos = RESLOG_BODY_FIXED;
+    for (int i = 0; i < count; i++) {
+        int n = wide_to_utf8(fields[i], (char*)body + pos + 2, (int)(log->recCap - RESLOG_REC_HEADER - pos - 2));
+        if (n > RESLOG_FIELD_MAX) n = RESLOG_FIELD_MAX;
+        put_u16(body + pos, (unsigned int)n);
+        pos += 2 + (size_t)n;
+    }
+    reslog_body_finish(log, log->file, pos);
+    log->size += RESLOG_REC_HEADER + pos;
+    // 只有刷新记录会让文件超出行数所需的大小，压实也只在此时触发
+    if (type == RESLOG_UPDATE && log->size >= log->compactAt) reslog_compact(log);
+}
+
+void reslog_flush(ResultLog* log) {
+    if (log && log->file) fflush(log->file);
+}
+
+void reslog_close(ResultLog* log) {
+    if (!log) return;
+    if (log->file) fclose(log->file);
+    free(log->path);
+    free(log->rec);
+    free(log);
+}
+
+// --- 读取 ---
+static int view_reserve(ResultLogView* v, unsigned int rowId) {
+    if (rowId < v->rowCap) return 1;
+    unsigned int cap = v->rowCap ? v->rowCap : 1024;
+    while (cap <= rowId) cap *= 2;
+    unsigned char** rows = (unsigned char**)realloc(v->rowRec, sizeof(unsigned char*) * cap);
+    if (!rows) return 0;
+    v->rowRec = rows;
+    unsigned char** updates = (unsigned char**)realloc(v->updateRec, sizeof(unsigned char*) * cap);
+    if (!updates) return 0;
+    v->updateRec = updates;
+    memset(v->rowRec + v->rowCap, 0, sizeof(unsigned char*) * (cap - v->rowCap));
+    memset(v->updateRec + v->rowCap, 0, sizeof(unsigned char*) * (cap - v->rowCap));
+    v->rowCap = cap;
+    return 1;
+}
+
+static void view_set(unsigned char** slot, unsigned char* rec) {
+    free(*slot);
+    *slot = rec;
+}
+
+// 解析一条记录的各列，列内容直接指向该记录
+static int view_decode(const unsigned char* rec, int first, ResultLogRow* out) {
+    const unsigned char* body = rec + RESLOG_REC_HEADER;
+    size_t len = get_u32(rec);
+    int count = body[1];
+    size_t pos = RESLOG_BODY_FIXED;
+    int col = first;
+    for (int i = 0; i < count && col < RESLOG_MAX_FIELDS; i++, col++) {
+        if (pos + 2 > len) break;
+        unsigned int n = get_u16(body + pos);
+        if (pos + 2 + n > len) break;
+        out->text[col] = (const char*)body + pos + 2;
+        out->len[col] = (int)n;
+        pos += 2 + n;
+    }
+    if (col > out->count) out->count = col;
+    return col;
+}
+
+// 读出下一条完整且校验通过的记录，失败返回 NULL
+static unsigned char* view_read_record(FILE* f) {
+    unsigned char head[RESLOG_REC_HEADER];
+    if (fread(head, 1, sizeof(head), f) != sizeof(head)) return NULL;
+    size_t len = get_u32(head);
+    if (len < RESLOG_BODY_FIXED || len > RESLOG_REC_MAX) return NULL;
+    unsigned char* rec = (unsigned char*)malloc(RESLOG_REC_HEADER + len);
+    if (!rec) return NULL;
+    memcpy(rec, head, sizeof(head));
+    if (fread(rec + RESLOG_REC_HEADER, 1, len, f) != len ||
+        get_u32(head + 4) != reslog_checksum(rec + RESLOG_REC_HEADER, len)) {
+        free(rec);
+        return NULL;
+    }
+    return rec;
+}
+
+ResultLogView* reslog_load(const wchar_t* path) {
+    FILE* f = platform_wfopen(path, L"rb");
+    if (!f) return NULL;
+    unsigned char head[RESLOG_FILE_HEADER];
+    ResultLogView* v = NULL;
+    if (fread(head, 1, sizeof(head), f) == sizeof(head) &&
+        memcmp(head, RESLOG_MAGIC, 8) == 0 && get_u32(head + 8) == RESLOG_VERSION) {
+        v = (ResultLogView*)calloc(1, sizeof(ResultLogView));
+    }
+    if (!v) { fclose(f); return NULL; }
+
+    setvbuf(f, NULL, _IOFBF, 65536);
+    unsigned char* rec;
+    while ((rec = view_read_record(f))) {
+        int type = rec[RESLOG_REC_HEADER];
+        unsigned int rowId = get_u32(rec + RESLOG_REC_HEADER + 4);
+        if (type == RESLOG_HEADER) {
+            view_set(&v->header, rec);
+        } else if ((type == RESLOG_ROW || type == RESLOG_UPDATE) && view_reserve(v, rowId)) {
+            if (type == RESLOG_ROW) {
+                view_set(&v->rowRec[rowId], rec);
+                view_set(&v->updateRec[rowId], NULL);
+            } else if (v->rowRec[rowId]) {
+                view_set(&v->updateRec[rowId], rec);
+            } else {
+                free(rec);
+            }
+            if (rowId >= v->rows) v->rows = rowId + 1;
+        } else {
+            free(rec);
+            if (type == RESLOG_ROW || type == RESLOG_UPDATE) break;   // 行表扩容失败
+        }
+    }
+    fclose(f);
+
+    ResultLogRow row;
+    v->columns = reslog_view_header(v, &row);
+    for (int c = 0; c < RESLOG_MAX_FIELDS; c++) {
+        int n = c < v->columns ? row.len[c] : 0;
+        if (n > (int)sizeof(v->keys[c]) - 1) n = (int)sizeof(v->keys[c]) - 1;
+        // 截断时退回到完整的 UTF-8 字符边界
+        while (n > 0 && n < row.len[c] && (row.text[c][n] & 0xC0) == 0x80) n--;
+        if (n > 0) { memcpy(v->keys[c], row.text[c], n); v->keys[c][n] = 0; }
+        else snprintf(v->keys[c], sizeof(v->keys[c]), "col%d", c + 1);
+    }
+    return v;
+}
+
+void reslog_view_free(ResultLogView* v) {
+    if (!v) return;
+    free(v->header);
+    for (unsigned int i = 0; i < v->rows; i++) {
+        free(v->rowRec[i]);
+        free(v->updateRec[i]);
+    }
+    free(v->rowRec);
+    free(v->updateRec);
+    free(v);
+}
+
+unsigned int reslog_view_rows(const ResultLogView* v) {
+    return v->rows;
+}
+
+int reslog_view_header(const ResultLogView* v, ResultLogRow* out) {
+    memset(out, 0, sizeof(*out));
+    if (!v->header) return 0;
+    return view_decode(v->header, 0, out);
+}
+
+// 刷新记录从第 2 列起覆盖，与界面原地刷新的效果一致
+int reslog_view_row(const ResultLogView* v, unsigned int rowId, ResultLogRow* out) {
+    memset(out, 0, sizeof(*out));
+    if (rowId >= v->rows || !v->rowRec[rowId]) return 0;
+    view_decode(v->rowRec[rowId], 0, out);
+    if (v->updateRec[rowId]) view_decode(v->updateRec[rowId], 1, out);
+    return out->count;
+}
+
+// --- 导出 ---
+// CSV 写出表头行；NDJSON 与 TSV 不写，列名作为 NDJSON 的键
+void reslog_write_header(const ResultLogView* v, RowWriter* w) {
+    if (w->format != OUTPUT_CSV || v->columns == 0) return;
+    for (int c = 0; c < v->columns; c++) writer_str(w, v->keys[c], v->keys[c]);
+    writer_end_row(w);
+}
+
+// 写出一行，列数不足表头时补空字段，保证 CSV 各行列数一致
+int reslog_write_row(const ResultLogView* v, RowWriter* w, unsigned int rowId) {
+    ResultLogRow row;
+    if (!reslog_view_row(v, rowId, &row)) return 0;
+    int count = row.count > v->columns ? row.count : v->columns;
+    for (int c = 0; c < count; c++) writer_text(w, v->keys[c], row.text[c] ? row.text[c] : "", row.len[c]);
+    writer_end_row(w);
+    return 1;
+}
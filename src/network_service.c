@@ -0,0 +1,234 @@
+#include "network_modules.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// --- 服务识别 ---
+// 开放端口的首包 (服务端主动 Banner 或对探测请求的应答) 与特征库做多模式匹配。
+// 特征库在扫描开始时一次性编译为 Aho-Corasick 自动机，匹配时只需线性扫描一遍回包。
+
+#define SIG_ANCHORED 1      // 必须出现在回包开头
+
+typedef struct {
+    const char* pattern;    // 小写 (匹配时忽略 ASCII 大小写)
+    int patternLen;
+    const char* service;
+    int flags;
+} ServiceSignature;
+
+#define SIG(p, svc, flags) { p, (int)sizeof(p) - 1, svc, flags }
+
+// 表中顺序即优先级：同一回包命中多条时取靠前者
+static const ServiceSignature g_signatures[] = {
+    SIG("ssh-",                   "SSH",           SIG_ANCHORED),
+    SIG("http/1.",                "HTTP",          SIG_ANCHORED),
+    SIG("http/2",                 "HTTP",          SIG_ANCHORED),
+    SIG("\x16\x03",               "TLS/SSL",       SIG_ANCHORED),
+    SIG("\x15\x03",               "TLS/SSL",       SIG_ANCHORED),
+    SIG("+pong",                  "Redis",         SIG_ANCHORED),
+    SIG("-noauth",                "Redis",         SIG_ANCHORED),
+    SIG("-denied redis",          "Redis",         SIG_ANCHORED),
+    SIG("rfb 00",                 "VNC",           SIG_ANCHORED),
+    SIG("amqp",                   "AMQP",          SIG_ANCHORED),
+    SIG("rtsp/1.",                "RTSP",          SIG_ANCHORED),
+    SIG("sip/2.0",                "SIP",           SIG_ANCHORED),
+    SIG("jdwp-handshake",         "JDWP",          SIG_ANCHORED),
+    SIG("version 1.",             "Memcached",     SIG_ANCHORED),
+    SIG("* ok",                   "IMAP",          SIG_ANCHORED),
+    SIG("+ok",                    "POP3",          SIG_ANCHORED),
+    SIG("\xff\xfb",               "Telnet",        SIG_ANCHORED),
+    SIG("\xff\xfd",               "Telnet",        SIG_ANCHORED),
+    SIG("mysql_native_password",  "MySQL",         0),
+    SIG("caching_sha2_password",  "MySQL",         0),
+    SIG("mariadb",                "MySQL/MariaDB", 0),
+    SIG("esmtp",                  "SMTP",          0),
+    SIG("smtp",                   "SMTP",          0),
+    SIG("ftp",                    "FTP",           0),
+    SIG("mongodb",                "MongoDB",       0),
+    SIG("stat pid",               "Memcached",     0),
+};
+
+#define SIG_COUNT ((int)(sizeof(g_signatures) / sizeof(g_signatures[0])))
+
+// --- Aho-Corasick 自动机 (完全展开的 DFA) ---
+struct ServiceMatcher {
+    int stateCount;
+    int (*next)[256];           // 状态转移表
+    unsigned long long* output; // 每个状态命中的特征位图 (已沿失败链合并)
+};
+
+static unsigned char fold_ascii(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? (unsigned char)(c + 32) : c;
+}
+
+ServiceMatcher* service_matcher_create() {
+    int maxStates = 1;
+    for (int i = 0; i < SIG_COUNT; i++) maxStates += g_signatures[i].patternLen;
+
+    ServiceMatcher* m = (ServiceMatcher*)calloc(1, sizeof(ServiceMatcher));
+    if (!m) return NULL;
+    m->next = (int (*)[256])malloc(sizeof(int[256]) * maxStates);
+    m->output = (unsigned long long*)calloc(maxStates, sizeof(unsigned long long));
+    int* fail = (int*)calloc(maxStates, sizeof(int));
+    int* queue = (int*)malloc(sizeof(int) * maxStates);
+    if (!m->next || !m->output || !fail || !queue) {
+        free(fail); free(queue);
+        service_matcher_free(m);
+        return NULL;
+    }
+    memset(m->next, -1, sizeof(int[256]) * maxStates);
+    m->stateCount = 1;
+
+    // 1. 构建 Trie
+    for (int i = 0; i < SIG_COUNT; i++) {
+        int s = 0;
+        for (int k = 0; k < g_signatures[i].patternLen; k++) {
+            unsigned char c = fold_ascii((unsigned char)g_signatures[i].pattern[k]);
+            if (m->next[s][c] < 0) m->next[s][c] = m->stateCount++;
+            s = m->next[s][c];
+        }
+        m->output[s] |= 1ULL << i;
+    }
+
+    // 2. BFS 计算失败链，并把缺失的转移补全为 DFA
+    int head = 0, tail = 0;
+    for (int c = 0; c < 256; c++) {
+        if (m->next[0][c] < 0) m->next[0][c] = 0;
+        else { fail[m->next[0][c]] = 0; queue[tail++] = m->next[0][c]; }
+    }
+    while (head < tail) {
+        int s = queue[head++];
+        m->output[s] |= m->output[fail[s]];
+        for (int c = 0; c < 256; c++) {
+            int t = m->next[s][c];
+            if (t < 0) {
+                m->next[s][c] = m->next[fail[s]][c];
+            } else {
+                fail[t] = m->next[fail[s]][c];
+                queue[tail++] = t;
+            }
+        }
+    }
+
+    free(fail);
+    free(queue);
+    return m;
+}
+
+void service_matcher_free(ServiceMatcher* m) {
+    if (!m) return;
+    free(m->next);
+    free(m->output);
+    free(m);
+}
+
+// 返回命中的最高优先级特征下标，未命中返回 -1
+static int matcher_scan(const ServiceMatcher* m, const char* data, int len) {
+    int best = SIG_COUNT;
+    int s = 0;
+    for (int i = 0; i < len; i++) {
+        s = m->next[s][fold_ascii((unsigned char)data[i])];
+        unsigned long long out = m->output[s];
+        while (out) {
+            int id = 0;
+            while (!(out & (1ULL << id))) id++;
+            out &= ~(1ULL << id);
+            if (id >= best) break;
+            if ((g_signatures[id].flags & SIG_ANCHORED) && i + 1 != g_signatures[id].patternLen) continue;
+            best = id;
+        }
+    }
+    return best < SIG_COUNT ? best : -1;
+}
+
+// 提取一行可打印文本 (HTTP 优先取 Server 头) 作为备注
+static int banner_excerpt(const char* data, int len, int isHttp, wchar_t* out, int outLen) {
+    int start = 0;
+    if (isHttp) {
+        for (int i = 0; i + 8 <= len; i++) {
+            if ((i == 0 || data[i - 1] == '\n') && memcmp(data + i, "Server: ", 8) == 0) { start = i + 8; break; }
+        }
+    }
+    int n = 0;
+    for (int i = start; i < len && n < outLen - 1; i++) {
+        unsigned char c = (unsigned char)data[i];
+        if (c == '\r' || c == '\n') { if (n > 0) break; continue; }
+        out[n++] = (c >= 0x20 && c < 0x7F) ? (wchar_t)c : L'.';
+        if (n >= 80) break;
+    }
+    out[n] = 0;
+    return n;
+}
+
+void service_identify(const ServiceMatcher* m, const char* data, int len, wchar_t* out, int outLen) {
+    if (outLen <= 0) return;
+    out[0] = 0;
+    if (!data || len <= 0) return;
+
+    int id = m ? matcher_scan(m, data, len) : -1;
+    const wchar_t* unknown = L"未知服务";
+    int isHttp = 0, isBinary = 0;
+    int n = 0;
+
+    if (id >= 0) {
+        unsigned char lead = (unsigned char)g_signatures[id].pattern[0];
+        isHttp = (strcmp(g_signatures[id].service, "HTTP") == 0);
+        isBinary = (lead < 0x20 || lead >= 0x80);
+        for (const char* p = g_signatures[id].service; *p && n < outLen - 1; p++) out[n++] = (wchar_t)(unsigned char)*p;
+    } else {
+        for (const wchar_t* p = unknown; *p && n < outLen - 1; p++) out[n++] = *p;
+    }
+    out[n] = 0;
+
+    // 二进制协议 (TLS / Telnet) 的回包没有可读 Banner
+    if (isBinary || n + 4 >= outLen) return;
+    wchar_t excerpt[96];
+    if (banner_excerpt(data, len, isHttp, excerpt, 96) > 0) {
+        out[n++] = L' '; out[n++] = L'-'; out[n++] = L' ';
+        for (int i = 0; excerpt[i] && n < outLen - 1; i++) out[n++] = excerpt[i];
+        out[n] = 0;
+    }
+}
+
+// --- 主动探测请求 ---
+// 客户端先发言的协议 (HTTP / TLS / Redis) 不会主动发送 Banner，直接发请求以节省等待
+
+static const char g_probeHttp[] = "HEAD / HTTP/1.0\r\n\r\n";
+static const char g_probeRedis[] = "PING\r\n";
+static const char g_probeMemcached[] = "version\r\n";
+
+// TLS 1.2 ClientHello：6 个常用套件、无扩展，足以换回 ServerHello 或 Alert
+static const char g_probeTls[] =
+    "\x16\x03\x01\x00\x37"                  // 记录层: Handshake, 长度 55
+    "\x01\x00\x00\x33"                      // ClientHello, 长度 51
+    "\x03\x03"                              // client_version TLS 1.2
+    "\x4e\x54\x50\x72\x6f\x62\x65\x21\x4e\x54\x50\x72\x6f\x62\x65\x21"
+    "\x4e\x54\x50\x72\x6f\x62\x65\x21\x4e\x54\x50\x72\x6f\x62\x65\x21" // random
+    "\x00"                                  // session_id 长度
+    "\x00\x0c\xc0\x2f\xc0\x30\xc0\x2b\xc0\x2c\x00\x9c\x00\x2f"
+    "\x01\x00";                             // compression: null
+
+const char* service_probe_for_port(int port, int* len) {
+    switch (port) {
+    case 443: case 465: case 636: case 853: case 993: case 995: case 8443: case 9443:
+        *len = (int)sizeof(g_probeTls) - 1;
+        return g_probeTls;
+    case 6379:
+        *len = (int)sizeof(g_probeRedis) - 1;
+        return g_probeRedis;
+    case 11211:
+        *len = (int)sizeof(g_probeMemcached) - 1;
+        return g_probeMemcached;
+    case 80: case 81: case 3000: case 5000: case 8000: case 8008: case 8080: case 8081: case 8888: case 9200:
+        *len = (int)sizeof(g_probeHttp) - 1;
+        return g_probeHttp;
+    }
+    *len = 0;
+    return NULL;
+}
+
+// 被动等待无 Banner 时的通用探测：多数文本协议会对 HTTP 请求回错误行，足以识别
+const char* service_fallback_probe(int* len) {
+    *len = (int)sizeof(g_probeHttp) - 1;
+    return g_probeHttp;
+}
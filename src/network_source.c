@@ -0,0 +1,162 @@
+#include "network_modules.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <iphlpapi.h>
+#pragma comment(lib, "iphlpapi.lib")
+#else
+#include <netdb.h>
+#include <ifaddrs.h>
+#endif
+
+// --- 探测源地址 ---
+// 默认由系统按路由选择源地址，所有探测共用一个地址的临时端口空间。
+// 指定多个本机地址 (或网卡，展开为其全部单播地址) 后，探测按轮询或目标哈希分摊到各地址，
+// 每个地址各有一份临时端口，可同时在途的连接数随地址数倍增。
+
+static int source_same(const ProbeTarget* a, const struct sockaddr* sa) {
+    if (a->family == 4) return sa->sa_family == AF_INET &&
+        a->addr.v4.sin_addr.s_addr == ((const struct sockaddr_in*)sa)->sin_addr.s_addr;
+    return sa->sa_family == AF_INET6 &&
+        memcmp(&a->addr.v6.sin6_addr, &((const struct sockaddr_in6*)sa)->sin6_addr, sizeof(struct in6_addr)) == 0;
+}
+
+// 加入一个地址 (重复的忽略)，同时登记到所属地址族的下标表
+static void source_add(ProbeSources* s, const struct sockaddr* sa) {
+    if (s->count >= PROBE_MAX_SOURCES) return;
+    if (sa->sa_family != AF_INET && sa->sa_family != AF_INET6) return;
+    for (int i = 0; i < s->count; i++) {
+        if (source_same(&s->addrs[i], sa)) return;
+    }
+    ProbeTarget* t = &s->addrs[s->count];
+    memset(t, 0, sizeof(*t));
+    if (sa->sa_family == AF_INET) {
+        t->family = 4;
+        memcpy(&t->addr.v4, sa, sizeof(t->addr.v4));
+        t->addr.v4.sin_port = 0;
+        s->v4[s->v4Count++] = (unsigned char)s->count;
+    } else {
+        t->family = 6;
+        memcpy(&t->addr.v6, sa, sizeof(t->addr.v6));
+        t->addr.v6.sin6_port = 0;
+        s->v6[s->v6Count++] = (unsigned char)s->count;
+    }
+    s->count++;
+}
+
+// 链路本地 IPv6 只能到达同一链路，不作为扫描的源地址
+static int source_link_local(const struct sockaddr* sa) {
+    if (sa->sa_family != AF_INET6) return 0;
+    const unsigned char* a = (const unsigned char*)&((const struct sockaddr_in6*)sa)->sin6_addr;
+    return a[0] == 0xfe && (a[1] & 0xc0) == 0x80;
+}
+
+// 按网卡名展开其单播地址，返回加入的数量
+static int source_add_interface(ProbeSources* s, const char* name) {
+    int before = s->count;
+#ifdef _WIN32
+    // 网卡既可用友好名称 ("以太网") 也可用适配器 GUID 指定
+    wchar_t wide[256];
+    utf8_to_wide_buf(name, wide, 256);
+    ULONG size = 16384;
+    IP_ADAPTER_ADDRESSES* list = NULL;
+    for (int tries = 0; tries < 3; tries++) {
+        list = (IP_ADAPTER_ADDRESSES*)malloc(size);
+        if (!list) return 0;
+        ULONG ret = GetAdaptersAddresses(AF_UNSPEC, GAA_FLAG_SKIP_ANYCAST | GAA_FLAG_SKIP_MULTICAST | GAA_FLAG_SKIP_DNS_SERVER,
+                                         NULL, list, &size);
+        if (ret == NO_ERROR) break;
+        free(list);
+        list = NULL;
+        if (ret != ERROR_BUFFER_OVERFLOW) return 0;
+    }
+    for (IP_ADAPTER_ADDRESSES* a = list; a; a = a->Next) {
+        if (_wcsicmp(a->FriendlyName, wide) != 0 && _stricmp(a->AdapterName, name) != 0) continue;
+        for (IP_ADAPTER_UNICAST_ADDRESS* u = a->FirstUnicastAddress; u; u = u->Next) {
+            if (!source_link_local(u->Address.lpSockaddr)) source_add(s, u->Address.lpSockaddr);
+        }
+    }
+    free(list);
+#else
+    struct ifaddrs* list = NULL;
+    if (getifaddrs(&list) != 0) return 0;
+    for (struct ifaddrs* a = list; a; a = a->ifa_next) {
+        if (!a->ifa_addr || strcmp(a->ifa_name, name) != 0) continue;
+        if (!source_link_local(a->ifa_addr)) source_add(s, a->ifa_addr);
+    }
+    freeifaddrs(list);
+#endif
+    return s->count - before;
+}
+
+// 试绑定一次，确认是本机地址
+static int source_bindable(const ProbeTarget* t) {
+    SOCKET sock = socket(t->family == 6 ? AF_INET6 : AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (sock == INVALID_SOCKET) return 0;
+    int ok = source_bind(sock, t);
+    closesocket(sock);
+    return ok;
+}
+
+int source_parse(const char* spec, ProbeSources* out, char* bad, int badLen) {
+    memset(out, 0, sizeof(*out));
+    if (bad && badLen > 0) bad[0] = 0;
+    const char* p = spec ? spec : "";
+    for (;;) {
+        while (*p == ' ' || *p == ',' || *p == ';' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+        if (!*p) break;
+        char token[128];
+        int n = 0;
+        while (*p && *p != ' ' && *p != ',' && *p != ';' && *p != '\t' && *p != '\r' && *p != '\n') {
+            if (n < (int)sizeof(token) - 1) token[n++] = *p;
+            p++;
+        }
+        token[n] = 0;
+
+        // 先按地址字面量解析 (IPv6 可带 %网卡)，不是地址再当作网卡名
+        struct addrinfo hints, *res = NULL;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_flags = AI_NUMERICHOST;
+        int ok = 0;
+        if (getaddrinfo(token, NULL, &hints, &res) == 0 && res) {
+            int before = out->count;
+            source_add(out, res->ai_addr);
+            ok = out->count == before || source_bindable(&out->addrs[out->count - 1]);
+            freeaddrinfo(res);
+        } else {
+            ok = source_add_interface(out, token) > 0;
+        }
+        if (!ok) {
+            if (bad && badLen > 0) snprintf(bad, (size_t)badLen, "%s", token);
+            return -1;
+        }
+    }
+    return out->count;
+}
+
+// 轮询：每个探测换下一个地址，分摊最均匀；哈希：同一目标固定用同一地址，对端看到的来源稳定
+const ProbeTarget* source_pick(ProbeSources* s, int family, unsigned int key) {
+    if (!s) return NULL;
+    int n = family == 6 ? s->v6Count : s->v4Count;
+    if (n == 0) return NULL;
+    unsigned int k = s->mode == PROBE_SOURCE_HASH ? (key * 2654435761u) >> 7
+                                                 : (unsigned int)platform_atomic_add(&s->next, 1);
+    return &s->addrs[family == 6 ? s->v6[k % n] : s->v4[k % n]];
+}
+
+int source_bind(SOCKET sock, const ProbeTarget* src) {
+    if (!src) return 1;
+#if defined(IP_BIND_ADDRESS_NO_PORT)
+    // 绑定时只定地址，端口推迟到 connect 时按四元组分配，不同目标可以复用同一端口
+    int one = 1;
+    setsockopt(sock, IPPROTO_IP, IP_BIND_ADDRESS_NO_PORT, &one, sizeof(one));
+#elif defined(SO_REUSE_UNICASTPORT)
+    DWORD one = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSE_UNICASTPORT, (const char*)&one, sizeof(one));
+#endif
+    if (src->family == 6) return bind(sock, (const struct sockaddr*)&src->addr.v6, sizeof(src->addr.v6)) == 0;
+    return bind(sock, (const struct sockaddr*)&src->addr.v4, sizeof(src->addr.v4)) == 0;
+}
@@ -0,0 +1,337 @@
+#include "network_modules.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <netinet/ip.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <time.h>
+#include <fcntl.h>
+
+// --- 无状态 Cookie ---
+// 序列号 = SipHash(密钥, 目标IP, 目标端口, 源端口) 的低 32 位。
+// 回包的 ack - 1 必须与重新计算的 Cookie 一致，因此无需为每个探测保存状态。
+#define ROTL64(x, b) (uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
+#define SIPROUND do { \
+    v0 += v1; v1 = ROTL64(v1, 13); v1 ^= v0; v0 = ROTL64(v0, 32); \
+    v2 += v3; v3 = ROTL64(v3, 16); v3 ^= v2; \
+    v0 += v3; v3 = ROTL64(v3, 21); v3 ^= v0; \
+    v2 += v1; v1 = ROTL64(v1, 17); v1 ^= v2; v2 = ROTL64(v2, 32); \
+} while (0)
+
+static uint32_t syn_cookie(const uint64_t key[2], uint32_t ip, uint16_t port, uint16_t sport) {
+    uint64_t v0 = 0x736f6d6570736575ULL ^ key[0];
+    uint64_t v1 = 0x646f72616e646f6dULL ^ key[1];
+    uint64_t v2 = 0x6c7967656e657261ULL ^ key[0];
+    uint64_t v3 = 0x7465646279746573ULL ^ key[1];
+    uint64_t m = ((uint64_t)ip << 32) | ((uint64_t)port << 16) | sport;
+
+    v3 ^= m; SIPROUND; SIPROUND; v0 ^= m;
+    uint64_t b = (uint64_t)8 << 56;
+    v3 ^= b; SIPROUND; SIPROUND; v0 ^= b;
+    v2 ^= 0xff; SIPROUND; SIPROUND; SIPROUND; SIPROUND;
+    return (uint32_t)(v0 ^ v1 ^ v2 ^ v3);
+}
+
+// --- 校验和 ---
+static uint32_t csum_add(uint32_t sum, const void* data, int len) {
+    const uint8_t* p = (const uint8_t*)data;
+    while (len > 1) { sum += (uint32_t)((p[0] << 8) | p[1]); p += 2; len -= 2; }
+    if (len) sum += (uint32_t)(p[0] << 8);
+    return sum;
+}
+
+static uint16_t csum_fold(uint32_t sum) {
+    while (sum >> 16) sum = (sum & 0xFFFF) + (sum >> 16);
+    return htons((uint16_t)~sum);
+}
+
+// --- 扫描上下文 ---
+struct SynTarget {
+    uint32_t ip;    // 主机字节序，便于排序
+    int index;
+};
+
+typedef struct {
+    const SynScanConfig* cfg;
+    uint64_t key[2];
+    uint16_t srcPort;
+    uint32_t* srcIps;           // 每个目标的本地源地址 (网络字节序)
+    struct SynTarget* sorted;   // 接收端用于反查目标下标
+    int* portIndex;             // 端口 -> 下标 (-1 表示不在扫描列表中)
+    unsigned char* seen;        // 每个探测 1 bit，用于丢弃重复回包
+    int rawSend;
+    int rawRecv;
+    volatile int txDone;
+    long sent;
+} SynContext;
+
+static uint64_t random_u64() {
+    uint64_t v = 0;
+    int fd = open("/dev/urandom", O_RDONLY);
+    if (fd >= 0) {
+        if (read(fd, &v, sizeof(v)) != sizeof(v)) v = 0;
+        close(fd);
+    }
+    if (v == 0) v = ((uint64_t)time(NULL) << 32) ^ (uint64_t)getpid() ^ (uint64_t)clock();
+    return v;
+}
+
+static uint64_t now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// 通过 UDP connect 让内核选路，取得发往目标时使用的本地地址
+static uint32_t route_source_ip(uint32_t dst) {
+    uint32_t src = 0;
+    int s = socket(AF_INET, SOCK_DGRAM, 0);
+    if (s < 0) return 0;
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(53);
+    addr.sin_addr.s_addr = dst;
+    if (connect(s, (struct sockaddr*)&addr, sizeof(addr)) == 0) {
+        struct sockaddr_in local;
+        socklen_t len = sizeof(local);
+        if (getsockname(s, (struct sockaddr*)&local, &len) == 0) src = local.sin_addr.s_addr;
+    }
+    close(s);
+    return src;
+}
+
+static int compare_target(const void* a, const void* b) {
+    uint32_t x = ((const struct SynTarget*)a)->ip;
+    uint32_t y = ((const struct SynTarget*)b)->ip;
+    return (x > y) - (x < y);
+}
+
+static int lookup_ip(const SynContext* c, uint32_t ip) {
+    int l = 0, r = c->cfg->ipCount - 1;
+    uint32_t key = ntohl(ip);
+    while (l <= r) {
+        int m = (l + r) / 2;
+        uint32_t v = c->sorted[m].ip;
+        if (v == key) return c->sorted[m].index;
+        if (v < key) l = m + 1; else r = m - 1;
+    }
+    return -1;
+}
+
+// --- 报文构造 ---
+static int build_syn(uint8_t* pkt, uint32_t src, uint32_t dst, uint16_t sport, uint16_t dport, uint32_t seq) {
+    struct iphdr* ip = (struct iphdr*)pkt;
+    struct tcphdr* tcp = (struct tcphdr*)(pkt + sizeof(struct iphdr));
+    // MSS 选项，避免部分协议栈丢弃无选项的 SYN
+    uint8_t* opt = (uint8_t*)(tcp + 1);
+    int tcpLen = sizeof(struct tcphdr) + 4;
+
+    memset(pkt, 0, sizeof(struct iphdr) + tcpLen);
+    ip->version = 4;
+    ip->ihl = 5;
+    ip->tot_len = htons((uint16_t)(sizeof(struct iphdr) + tcpLen));
+    ip->id = htons((uint16_t)(seq >> 16));
+    ip->ttl = 64;
+    ip->protocol = IPPROTO_TCP;
+    ip->saddr = src;
+    ip->daddr = dst;
+    ip->check = csum_fold(csum_add(0, ip, sizeof(struct iphdr)));
+
+    tcp->source = htons(sport);
+    tcp->dest = htons(dport);
+    tcp->seq = htonl(seq);
+    tcp->doff = (uint16_t)(tcpLen / 4);
+    tcp->syn = 1;
+    tcp->window = htons(1024);
+    opt[0] = 2; opt[1] = 4; opt[2] = 0x05; opt[3] = 0xB4; // MSS 1460
+
+    uint8_t pseudo[12];
+    memcpy(pseudo, &src, 4);
+    memcpy(pseudo + 4, &dst, 4);
+    pseudo[8] = 0;
+    pseudo[9] = IPPROTO_TCP;
+    pseudo[10] = (uint8_t)(tcpLen >> 8);
+    pseudo[11] = (uint8_t)tcpLen;
+    tcp->check = csum_fold(csum_add(csum_add(0, pseudo, 12), tcp, tcpLen));
+
+    return (int)sizeof(struct iphdr) + tcpLen;
+}
+
+// --- 发送线程 ---
+static void* syn_tx_thread(void* arg) {
+    SynContext* c = (SynContext*)arg;
+    const SynScanConfig* cfg = c->cfg;
+    uint8_t pkt[64];
+    uint64_t start = now_ms();
+    long n = 0;
+
+    // 按循环群置换遍历 主机×端口 空间，相邻探测随机落在不同主机上；
+    // 空间过大无法置换时退回端口在外层的顺序
+    uint64_t total = (uint64_t)cfg->ipCount * cfg->portCount;
+    Permutation pm;
+    int shuffled = permutation_init(&pm, total, cfg->seed);
+    for (uint64_t k = 0; k < total && !is_task_stopped(); k++) {
+        unsigned long long idx = k;
+        if (shuffled && !permutation_next(&pm, &idx)) break;
+        if (cfg->shardCount > 1 && k % cfg->shardCount != (uint64_t)cfg->shardIndex) continue;
+        int i = (int)(idx % cfg->ipCount);
+        int j = (int)(idx / cfg->ipCount);
+        uint32_t dst = (uint32_t)cfg->ips[i];
+        uint16_t dport = (uint16_t)cfg->ports[j];
+        uint32_t seq = syn_cookie(c->key, dst, dport, c->srcPort);
+        int len = build_syn(pkt, c->srcIps[i], dst, c->srcPort, dport, seq);
+
+        struct sockaddr_in to = {0};
+        to.sin_family = AF_INET;
+        to.sin_addr.s_addr = dst;
+        while (sendto(c->rawSend, pkt, len, 0, (struct sockaddr*)&to, sizeof(to)) < 0) {
+            if (errno != ENOBUFS && errno != EAGAIN) break;
+            usleep(100); // 网卡队列满，稍等后重发
+        }
+        n++;
+        metrics_add(METRIC_TARGETS, 1);
+        metrics_add(METRIC_PROBES_SENT, 1);
+
+        if (cfg->pps > 0) {
+            uint64_t due = start + (uint64_t)n * 1000 / cfg->pps;
+            uint64_t now = now_ms();
+            if (due > now) usleep((useconds_t)(due - now) * 1000);
+        }
+    }
+    c->sent = n;
+    c->txDone = 1;
+    return NULL;
+}
+
+// --- 接收线程 ---
+static void* syn_rx_thread(void* arg) {
+    SynContext* c = (SynContext*)arg;
+    const SynScanConfig* cfg = c->cfg;
+    uint8_t buf[2048];
+    uint64_t doneAt = 0;
+
+    for (;;) {
+        if (is_task_stopped()) break;
+        if (c->txDone) {
+            if (doneAt == 0) doneAt = now_ms();
+            else if (now_ms() - doneAt >= (uint64_t)cfg->waitMs) break;
+        }
+
+        ssize_t n = recv(c->rawRecv, buf, sizeof(buf), 0);
+        if (n < (ssize_t)sizeof(struct iphdr)) continue;
+
+        struct iphdr* ip = (struct iphdr*)buf;
+        int ihl = ip->ihl * 4;
+        if (ip->protocol != IPPROTO_TCP || n < ihl + (ssize_t)sizeof(struct tcphdr)) continue;
+        struct tcphdr* tcp = (struct tcphdr*)(buf + ihl);
+
+        if (ntohs(tcp->dest) != c->srcPort || !tcp->ack) continue;
+        if (!(tcp->syn || tcp->rst)) continue;
+
+        uint16_t port = ntohs(tcp->source);
+        uint32_t expect = syn_cookie(c->key, ip->saddr, port, c->srcPort) + 1;
+        if (ntohl(tcp->ack_seq) != expect) continue; // 非本次扫描的报文
+
+        int hostIdx = lookup_ip(c, ip->saddr);
+        int portIdx = c->portIndex[port];
+        if (hostIdx < 0 || portIdx < 0) continue;
+
+        size_t bit = (size_t)hostIdx * cfg->portCount + portIdx;
+        if (c->seen[bit >> 3] & (1 << (bit & 7))) continue;
+        c->seen[bit >> 3] |= (unsigned char)(1 << (bit & 7));
+        metrics_add(METRIC_RESULTS, 1);
+
+        if (cfg->onResult) {
+            cfg->onResult(cfg->ctx, hostIdx, port, tcp->syn ? SYN_STATE_OPEN : SYN_STATE_CLOSED);
+        }
+    }
+    return NULL;
+}
+
+int syn_scan_available() {
+    int s = socket(AF_INET, SOCK_RAW, IPPROTO_TCP);
+    if (s < 0) return 0;
+    close(s);
+    return 1;
+}
+
+int syn_scan_run(const SynScanConfig* cfg) {
+    if (!cfg || cfg->ipCount <= 0 || cfg->portCount <= 0) return 0;
+
+    SynContext c;
+    memset(&c, 0, sizeof(c));
+    c.cfg = cfg;
+    c.key[0] = random_u64();
+    c.key[1] = random_u64();
+    c.srcPort = (uint16_t)(40000 + (c.key[0] % 20000));
+    c.rawSend = socket(AF_INET, SOCK_RAW, IPPROTO_RAW);
+    c.rawRecv = socket(AF_INET, SOCK_RAW, IPPROTO_TCP);
+    if (c.rawSend < 0 || c.rawRecv < 0) {
+        if (c.rawSend >= 0) close(c.rawSend);
+        if (c.rawRecv >= 0) close(c.rawRecv);
+        return -1;
+    }
+
+    struct timeval tv = {0, 100 * 1000};
+    setsockopt(c.rawRecv, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    int rcvbuf = 4 * 1024 * 1024;
+    setsockopt(c.rawRecv, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    size_t probes = (size_t)cfg->ipCount * cfg->portCount;
+    c.srcIps = (uint32_t*)malloc(sizeof(uint32_t) * cfg->ipCount);
+    c.sorted = (struct SynTarget*)malloc(sizeof(struct SynTarget) * cfg->ipCount);
+    c.portIndex = (int*)malloc(sizeof(int) * 65536);
+    c.seen = (unsigned char*)calloc((probes + 7) / 8, 1);
+
+    int ret = -1;
+    if (!c.srcIps || !c.sorted || !c.portIndex || !c.seen) goto cleanup;
+
+    for (int i = 0; i < cfg->ipCount; i++) {
+        c.srcIps[i] = cfg->sourceIps && cfg->sourceIps[i] ? (uint32_t)cfg->sourceIps[i] : route_source_ip((uint32_t)cfg->ips[i]);
+        c.sorted[i].ip = ntohl((uint32_t)cfg->ips[i]);
+        c.sorted[i].index = i;
+    }
+    qsort(c.sorted, cfg->ipCount, sizeof(struct SynTarget), compare_target);
+
+    for (int p = 0; p < 65536; p++) c.portIndex[p] = -1;
+    for (int j = 0; j < cfg->portCount; j++) {
+        if (cfg->ports[j] > 0 && cfg->ports[j] < 65536) c.portIndex[cfg->ports[j]] = j;
+    }
+
+    pthread_t tx, rx;
+    if (pthread_create(&rx, NULL, syn_rx_thread, &c) != 0) goto cleanup;
+    if (pthread_create(&tx, NULL, syn_tx_thread, &c) != 0) {
+        c.txDone = 1;
+        pthread_join(rx, NULL);
+        goto cleanup;
+    }
+    pthread_join(tx, NULL);
+    pthread_join(rx, NULL);
+    ret = (int)c.sent;
+
+cleanup:
+    close(c.rawSend);
+    close(c.rawRecv);
+    free(c.srcIps);
+    free(c.sorted);
+    free(c.portIndex);
+    free(c.seen);
+    return ret;
+}
+
+#else
+
+// Windows 自 XP SP2 起禁止通过 Raw Socket 发送 TCP 报文，此处始终回退到 connect() 扫描
+int syn_scan_available() {
+    return 0;
+}
+
+int syn_scan_run(const SynScanConfig* cfg) {
+    (void)cfg;
+    return -1;
+}
+
+#endif
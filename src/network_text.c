@@ -0,0 +1,186 @@
+#include "network_modules.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// [修改] 主机列表拆分、端口解析与结果去重不依赖 Win32 API，独立成模块供 GUI、命令行与基准测试共用
+
+static int is_host_separator(wchar_t c) {
+    return c == L' ' || c == L'\t' || c == L'\n' || c == L'\r' || c == L',';
+}
+
+// --- 列表处理辅助 ---
+// [修改] 整段输入复制一次，分隔符原地改为结尾 0；第一遍只计数，指针数组一次分配到位
+wchar_t** split_hosts(Arena* arena, const wchar_t* input, int* count) {
+    *count = 0;
+    if (!input) return NULL;
+
+    int n = 0;
+    for (const wchar_t* p = input; *p; ) {
+        while (*p && is_host_separator(*p)) p++;
+        if (!*p) break;
+        n++;
+        while (*p && !is_host_separator(*p)) p++;
+    }
+
+    wchar_t** list = (wchar_t**)arena_alloc(arena, sizeof(wchar_t*) * (n ? n : 1));
+    wchar_t* text = arena_wcsdup(arena, input);
+    if (!list || !text) return NULL;
+
+    int k = 0;
+    for (wchar_t* p = text; *p && k < n; ) {
+        while (*p && is_host_separator(*p)) p++;
+        if (!*p) break;
+        list[k++] = p;
+        while (*p && !is_host_separator(*p)) p++;
+        if (*p) *p++ = 0;
+    }
+
+    *count = k;
+    return list;
+}
+
+void free_string_list(wchar_t** list, int count) {
+    if(!list) return;
+    for (int i = 0; i < count; i++) free(list[i]);
+    free(list);
+}
+
+// [修改] 经位图去重与越界检查，支持 topN 与 '!' 排除；常见端口排在前面
+int* parse_ports(const wchar_t* portStr, int* count) {
+    if (!portStr) { *count = 0; return NULL; }
+
+    PortSet* set = (PortSet*)malloc(sizeof(PortSet));
+    if (!set) { *count = 0; return NULL; }
+    portset_parse(set, portStr);
+    int* ports = portset_to_array(set, count);
+    free(set);
+    return ports;
+}
+
+// --- 结果行排序去重 ---
+// 按 "地址,端口" 两列排序；键相同的行保留先出现者
+typedef struct {
+    wchar_t* line;
+    int keyLen;     // "地址,端口" 前缀长度
+    int order;      // 原始顺序，重复时保留先出现者
+} ResultRow;
+
+static int result_key_length(const wchar_t* line) {
+    const wchar_t* c = wcschr(line, L',');
+    if (!c) return (int)wcslen(line);
+    const wchar_t* d = wcschr(c + 1, L',');
+    return d ? (int)(d - line) : (int)wcslen(line);
+}
+
+static int compare_result_row(const void* a, const void* b) {
+    const ResultRow* x = (const ResultRow*)a;
+    const ResultRow* y = (const ResultRow*)b;
+    int n = x->keyLen < y->keyLen ? x->keyLen : y->keyLen;
+    int c = wcsncmp(x->line, y->line, n);
+    if (c == 0) c = x->keyLen - y->keyLen;
+    if (c == 0) c = x->order - y->order;
+    return c;
+}
+
+int result_sort_dedupe(wchar_t** lines, int count) {
+    if (!lines || count <= 0) return 0;
+    ResultRow* rows = (ResultRow*)malloc(sizeof(ResultRow) * count);
+    if (!rows) return -1;
+    for (int i = 0; i < count; i++) {
+        rows[i].line = lines[i];
+        rows[i].keyLen = result_key_length(lines[i]);
+        rows[i].order = i;
+    }
+    qsort(rows, count, sizeof(ResultRow), compare_result_row);
+
+    // 唯一行按序写回前部，重复行移到尾部，仍由调用方统一释放
+    int unique = 0, tail = count;
+    for (int i = 0; i < count; i++) {
+        if (i > 0 && rows[i].keyLen == rows[i - 1].keyLen &&
+            wcsncmp(rows[i].line, rows[i - 1].line, rows[i].keyLen) == 0) {
+            lines[--tail] = rows[i].line;
+        } else {
+            lines[unique++] = rows[i].line;
+        }
+    }
+    free(rows);
+    return unique;
+}
+
+// --- UTF-8 与宽字符互转 ---
+// 宽字符编码为 UTF-8，写入至多 cap 字节且不追加结尾 0，返回写入的字节数；
+// Windows 下合并 UTF-16 代理对，孤立的代理项替换为 U+FFFD
+int wide_to_utf8(const wchar_t* s, char* out, int cap) {
+    int n = 0;
+    for (const wchar_t* p = s; *p; p++) {
+        unsigned int cp = (unsigned int)*p;
+        if (cp >= 0xD800 && cp <= 0xDBFF && p[1] >= 0xDC00 && p[1] <= 0xDFFF) {
+            cp = 0x10000 + ((cp - 0xD800) << 10) + ((unsigned int)p[1] - 0xDC00);
+            p++;
+        } else if (cp >= 0xD800 && cp <= 0xDFFF) {
+            cp = 0xFFFD;
+        }
+        int len = cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4;
+        if (n + len > cap) break;
+        if (len == 1) { out[n++] = (char)cp; continue; }
+        if (len == 2) out[n++] = (char)(0xC0 | (cp >> 6));
+        else if (len == 3) out[n++] = (char)(0xE0 | (cp >> 12));
+        else {
+            out[n++] = (char)(0xF0 | (cp >> 18));
+            out[n++] = (char)(0x80 | ((cp >> 12) & 0x3F));
+        }
+        if (len >= 3) out[n++] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        out[n++] = (char)(0x80 | (cp & 0x3F));
+    }
+    return n;
+}
+
+// UTF-8 解码为宽字符，非法字节替换为 U+FFFD；outLen 含结尾 0，超出部分截断。
+// [修改] 按 RFC 3629 严格校验：C0/C1 与 F5..FF 不能作首字节，第二字节的范围随首字节收紧，
+// 从而拒绝过长编码 (E0 80..9F、F0 80..8F)、代理项 (ED A0..BF) 与超过 U+10FFFF 的值 (F4 90..)；
+// 每段不完整的序列只替换为一个 U+FFFD，出错的字节留给下一轮重新判断
+int utf8_to_wide_buf(const char* s, wchar_t* out, int outLen) {
+    int n = 0;
+    if (outLen <= 0) return 0;
+    const unsigned char* p = (const unsigned char*)s;
+    while (*p && n < outLen - 1) {
+        unsigned int cp = *p, extra = 0, lo = 0x80, hi = 0xBF;
+        if (cp < 0x80) { out[n++] = (wchar_t)cp; p++; continue; }
+        if (cp >= 0xC2 && cp <= 0xDF) { cp &= 0x1F; extra = 1; }
+        else if (cp >= 0xE0 && cp <= 0xEF) {
+            if (cp == 0xE0) lo = 0xA0;
+            else if (cp == 0xED) hi = 0x9F;
+            cp &= 0x0F; extra = 2;
+        } else if (cp >= 0xF0 && cp <= 0xF4) {
+            if (cp == 0xF0) lo = 0x90;
+            else if (cp == 0xF4) hi = 0x8F;
+            cp &= 0x07; extra = 3;
+        } else {
+            out[n++] = 0xFFFD; p++; continue;
+        }
+        p++;
+        for (unsigned int k = 0; k < extra; k++, p++) {
+            if (*p < lo || *p > hi) { cp = 0xFFFD; break; }
+            cp = (cp << 6) | (*p & 0x3F);
+            lo = 0x80; hi = 0xBF;
+        }
+        if (sizeof(wchar_t) == 2 && cp >= 0x10000) {
+            if (n + 2 > outLen - 1) break;
+            out[n++] = (wchar_t)(0xD800 + ((cp - 0x10000) >> 10));
+            out[n++] = (wchar_t)(0xDC00 + ((cp - 0x10000) & 0x3FF));
+        } else {
+            out[n++] = (wchar_t)cp;
+        }
+    }
+    out[n] = 0;
+    return n;
+}
+
+// 同上，按最坏情况 (每字节一个宽字符) 分配；调用方 free
+wchar_t* utf8_to_wide(const char* s) {
+    int len = (int)strlen(s);
+    wchar_t* out = (wchar_t*)malloc(sizeof(wchar_t) * ((size_t)len + 1));
+    if (out) utf8_to_wide_buf(s, out, len + 1);
+    return out;
+}
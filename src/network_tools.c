@@ -5,7 +5,11 @@
 #include <stdlib.h>
 #include <process.h>
 #include <string.h> 
+#include <stddef.h>
+#include <time.h>
 #include <ws2tcpip.h> // for GetAddrInfoW
+#include <iphlpapi.h>
+#include <icmpapi.h>
 
 #pragma comment(lib, "iphlpapi.lib")
 #pragma comment(lib, "ws2_32.lib")
@@ -30,21 +34,6 @@ int is_task_stopped() {
     return g_stopSignal;
 }
 
-// --- 字符串转换辅助 ---
-char* wide_to_ansi(const wchar_t* wstr) {
-    if (!wstr) return NULL;
-    int len = WideCharToMultiByte(CP_ACP, 0, wstr, -1, NULL, 0, NULL, NULL);
-    char* str = (char*)malloc(len);
-    if(str) WideCharToMultiByte(CP_ACP, 0, wstr, -1, str, len, NULL, NULL);
-    return str;
-}
-
-// GBK 转 Unicode (主要用于模块内部调用)
-void gbk_to_wide(const char* gbk, wchar_t* buf, int bufLen) {
-    if (!gbk || !buf) return;
-    MultiByteToWideChar(CP_ACP, 0, gbk, -1, buf, bufLen);
-}
-
 // --- 地址解析辅助 (支持 IPv4/IPv6/域名) ---
 // 返回值: 0=失败, 4=IPv4, 6=IPv6
 // 结果存入 addrOut (需分配足够的空间，如 sizeof(struct sockaddr_in6))
@@ -55,7 +44,11 @@ int resolve_host(const wchar_t* host, void* addrOut) {
     hints.ai_protocol = IPPROTO_TCP;
     
     struct addrinfoW* result = NULL;
-    if (GetAddrInfoW(host, NULL, &hints, &result) != 0) return 0;
+    unsigned long long start = platform_tick_us();
+    int rc = GetAddrInfoW(host, NULL, &hints, &result);
+    metrics_add(METRIC_DNS_LOOKUPS, 1);
+    metrics_observe(METRIC_HIST_DNS, platform_tick_us() - start);
+    if (rc != 0) return 0;
 
     int type = 0;
     // 策略：如果有 IPv4，优先使用 IPv4 (保持旧版兼容性)，否则使用 IPv6
@@ -83,69 +76,57 @@ int resolve_host(const wchar_t* host, void* addrOut) {
     return type;
 }
 
-// --- 列表处理辅助 ---
-wchar_t** split_hosts(const wchar_t* input, int* count) {
-    if (!input) { *count = 0; return NULL; }
-    
-    wchar_t* copy = _wcsdup(input);
-    int capacity = 10;
-    wchar_t** list = (wchar_t**)malloc(sizeof(wchar_t*) * capacity);
-    int n = 0;
+// [新增] 向一个目标发送 ICMP 回显，指定了源地址时按轮询或目标哈希 (key) 选用其一
+static int ping_target(const ProbeTarget* t, ProbeSources* sources, unsigned int key, int retry, int timeout, long* rtt, int* ttl) {
+    const ProbeTarget* src = source_pick(sources, t->family, key);
+    if (t->family == 4) return ipv4_ping_host(t->addr.v4.sin_addr.s_addr, src ? src->addr.v4.sin_addr.s_addr : 0, retry, timeout, rtt, ttl);
+    if (t->family == 6) return ipv6_ping_host((struct sockaddr_in6*)&t->addr.v6, src ? &src->addr.v6 : NULL, retry, timeout, rtt, ttl);
+    return 0;
+}
 
-    wchar_t* context = NULL;
-    wchar_t* token = wcstok_s(copy, L" \t\n\r,", &context);
-    while (token) {
-        if (n >= capacity) {
-            capacity *= 2;
-            list = (wchar_t**)realloc(list, sizeof(wchar_t*) * capacity);
-        }
-        list[n++] = _wcsdup(token);
-        token = wcstok_s(NULL, L" \t\n\r,", &context);
+// --- UI 消息辅助 ---
+// [修改] 消息文本取自固定大小的对象池，界面处理后归还，逐条结果不再 malloc / free；
+// 超长的批量刷新单独分配，由记录头的标记区分
+#define UI_MSG_CHARS 1024
+#define UI_MSG_SLAB  256        // 对象池每次补充的记录数
+
+typedef struct {
+    int pooled;
+    wchar_t text[UI_MSG_CHARS];
+} UiMessage;
+
+static Slab g_msgSlab = SLAB_INITIALIZER(sizeof(UiMessage), UI_MSG_SLAB);
+
+static UiMessage* alloc_message(size_t chars) {
+    UiMessage* m;
+    if (chars <= UI_MSG_CHARS) {
+        m = (UiMessage*)slab_alloc(&g_msgSlab);
+        if (m) m->pooled = 1;
+    } else {
+        m = (UiMessage*)malloc(offsetof(UiMessage, text) + chars * sizeof(wchar_t));
+        if (m) m->pooled = 0;
     }
-    
-    free(copy);
-    *count = n;
-    return list;
+    return m;
 }
 
-void free_string_list(wchar_t** list, int count) {
-    if(!list) return;
-    for (int i = 0; i < count; i++) free(list[i]);
-    free(list);
+static void send_message(HWND hwnd, UINT msg, WPARAM wParam, UiMessage* m) {
+    if (PostMessageW(hwnd, msg, wParam, (LPARAM)m->text)) metrics_add(METRIC_UI_POSTED, 1);
+    else free_message(m->text);
 }
 
-int* parse_ports(const wchar_t* portStr, int* count) {
-    if (!portStr) { *count = 0; return NULL; }
-    
-    int* ports = (int*)malloc(sizeof(int) * 65535); 
-    int n = 0;
-    
-    wchar_t* copy = _wcsdup(portStr);
-    wchar_t* context = NULL;
-    wchar_t* token = wcstok_s(copy, L",", &context);
-    
-    while (token) {
-        if (wcschr(token, L'-')) {
-            int start, end;
-            if (swscanf_s(token, L"%d-%d", &start, &end) == 2) {
-                for (int i = start; i <= end; i++) ports[n++] = i;
-            }
-        } else {
-            int p = _wtoi(token);
-            if (p > 0) ports[n++] = p;
-        }
-        token = wcstok_s(NULL, L",", &context);
-    }
-    free(copy);
-    *count = n;
-    return ports;
+void free_message(wchar_t* text) {
+    if (!text) return;
+    UiMessage* m = (UiMessage*)((char*)text - offsetof(UiMessage, text));
+    if (m->pooled) slab_free(&g_msgSlab, m);
+    else free(m);
 }
 
-// --- UI 消息辅助 ---
+// 直接格式化到池中的记录，不经过中间缓冲
 void post_result(HWND hwnd, const wchar_t* col1, const wchar_t* col2, const wchar_t* col3, const wchar_t* col4, const wchar_t* col5, const wchar_t* col6) {
-    wchar_t buffer[1024];
+    UiMessage* m = alloc_message(UI_MSG_CHARS);
+    if (!m) return;
     // 格式化并通过管道符分隔，UI层会解析并插入列表
-    swprintf_s(buffer, 1024, L"%s|%s|%s|%s|%s|%s", 
+    swprintf_s(m->text, UI_MSG_CHARS, L"%s|%s|%s|%s|%s|%s", 
              col1 ? col1 : L"", 
              col2 ? col2 : L"", 
              col3 ? col3 : L"", 
@@ -153,37 +134,410 @@ void post_result(HWND hwnd, const wchar_t* col1, const wchar_t* col2, const wcha
              col5 ? col5 : L"",
              col6 ? col6 : L"-"); 
     
-    wchar_t* msg = _wcsdup(buffer);
-    PostMessageW(hwnd, WM_USER_RESULT, 0, (LPARAM)msg);
+    send_message(hwnd, WM_USER_RESULT, 0, m);
+}
+
+// [新增] 投递成功的消息计入界面队列，界面处理后计为已取出
+void post_message(HWND hwnd, UINT msg, WPARAM wParam, const wchar_t* text) {
+    size_t chars = wcslen(text) + 1;
+    UiMessage* m = alloc_message(chars);
+    if (!m) return;
+    memcpy(m->text, text, chars * sizeof(wchar_t));
+    send_message(hwnd, msg, wParam, m);
 }
 
+// 阶段提示；逐探测的进度不走这里，由界面按固定频率读取运行指标
 void post_log(HWND hwnd, int progress, const wchar_t* text) {
-    wchar_t* msg = _wcsdup(text);
-    PostMessageW(hwnd, WM_USER_LOG, (WPARAM)progress, (LPARAM)msg);
+    post_message(hwnd, WM_USER_LOG, (WPARAM)progress, text);
 }
 
 void post_finish(HWND hwnd, const wchar_t* msg) {
-    PostMessageW(hwnd, WM_USER_FINISH, 0, (LPARAM)_wcsdup(msg));
+    post_message(hwnd, WM_USER_FINISH, 0, msg);
 }
 
 // --- 任务线程逻辑 ---
 
+// --- [新增] TCP Ping (tcping) ---
+// 以 TCP 握手 (SYN → SYN/ACK 或 RST) 的往返时间代替 ICMP 回显，适用于屏蔽 ICMP 的目标；
+// 所有目标的各轮探测由并发探测引擎统一调度，计时使用微秒级单调时钟
+#define TCPING_MAX_INFLIGHT 512
+
+typedef struct {
+    int replied;                    // 收到回应 (握手完成或 RST) 的次数
+    int refused;                    // 其中 RST 的次数
+    unsigned long long sumUs;
+    unsigned long long minUs;
+    unsigned long long maxUs;
+} TcpingStat;
+
+typedef struct {
+    HWND hwnd;
+    int hostCount;
+    int rounds;                     // 每个目标的探测次数
+    int port;
+    int cursor;
+    int done;
+    const ProbeTarget* targets;
+    TcpingStat* stats;
+} TcpingJob;
+
+// 按轮次展开：先向所有目标各发一次，再开始下一轮
+static int tcping_next(void* ctx, int* target, int* port) {
+    TcpingJob* job = (TcpingJob*)ctx;
+    while (job->cursor < job->hostCount * job->rounds) {
+        int i = job->cursor++ % job->hostCount;
+        if (!job->targets[i].family) continue;
+        *target = i;
+        *port = job->port;
+        return 1;
+    }
+    return 0;
+}
+
+static void on_tcping_rtt(void* ctx, int target, int port, unsigned long long rttUs) {
+    TcpingStat* s = &((TcpingJob*)ctx)->stats[target];
+    (void)port;
+    if (s->replied == 0 || rttUs < s->minUs) s->minUs = rttUs;
+    if (rttUs > s->maxUs) s->maxUs = rttUs;
+    s->sumUs += rttUs;
+    s->replied++;
+}
+
+static void on_tcping_result(void* ctx, int target, int port, int state, const char* data, int len) {
+    TcpingJob* job = (TcpingJob*)ctx;
+    (void)port; (void)data; (void)len;
+    if (state == PROBE_CLOSED) job->stats[target].refused++;
+    job->done++;
+    metrics_add(METRIC_WORK_DONE, 1);
+}
+
+static void thread_tcping(ThreadParams* p, wchar_t** hosts, int count) {
+    HWND hwnd = p->hwndNotify;
+    ProbeTarget* targets = (ProbeTarget*)calloc(count ? count : 1, sizeof(ProbeTarget));
+    TcpingJob job = {0};
+    job.hwnd = hwnd;
+    job.hostCount = count;
+    job.rounds = p->retryCount > 0 ? p->retryCount : 4;
+    job.port = p->tcpingPort;
+    job.targets = targets;
+    job.stats = (TcpingStat*)calloc(count ? count : 1, sizeof(TcpingStat));
+    if (!targets || !job.stats) goto cleanup;
+
+    post_log(hwnd, 0, L"正在解析目标地址...");
+    for (int i = 0; i < count && !g_stopSignal; i++) {
+        targets[i].family = resolve_host(hosts[i], &targets[i].addr);
+    }
+
+    ProbeEngineConfig cfg = {0};
+    cfg.targets = targets;
+    cfg.targetCount = count;
+    cfg.proto = PROBE_TCP;
+    cfg.maxInFlight = TCPING_MAX_INFLIGHT;
+    cfg.timeoutMs = p->timeoutMs > 0 ? p->timeoutMs : 1000;
+    cfg.minTimeoutMs = cfg.timeoutMs;   // 超时即计为丢包，不按 RTT 收紧
+    cfg.pps = p->pps;
+    cfg.subnetCap = p->subnetCap;
+    cfg.sources = p->sources;
+    cfg.onRtt = on_tcping_rtt;
+    cfg.next = tcping_next;
+    cfg.onResult = on_tcping_result;
+    cfg.ctx = &job;
+    if (!g_stopSignal) {
+        int valid = 0;
+        for (int i = 0; i < count; i++) if (targets[i].family) valid++;
+        metrics_add(METRIC_WORK_TOTAL, (long long)valid * job.rounds);
+        wchar_t msg[96];
+        swprintf_s(msg, 96, L"TCP Ping 端口 %d：%d 个目标 x %d 次探测...", job.port, valid, job.rounds);
+        post_log(hwnd, 0, msg);
+        engine_run(&cfg);
+    }
+
+    for (int i = 0; i < count && !g_stopSignal; i++) {
+        const TcpingStat* s = &job.stats[i];
+        wchar_t location[256] = {0};
+        if (targets[i].family == 4 && p->showLocation) {
+            ipv4_get_location(inet_ntoa(targets[i].addr.v4.sin_addr), location, 256);
+        } else if (targets[i].family == 6) {
+            wcscpy_s(location, 256, L"IPv6地址");
+        }
+
+        if (!targets[i].family) {
+            post_result(hwnd, hosts[i], L"无效地址", L"N/A", L"100", L"N/A", L"未知");
+            continue;
+        }
+        if (s->replied == 0) {
+            post_result(hwnd, hosts[i], L"超时", L"N/A", L"100", L"N/A", location);
+            continue;
+        }
+
+        // 延迟保留到微秒；TCP 握手拿不到 TTL，该列显示 最小/最大 延迟
+        wchar_t rttStr[32], lossStr[32], rangeStr[64];
+        swprintf_s(rttStr, 32, L"%.3f", s->sumUs / 1000.0 / s->replied);
+        swprintf_s(lossStr, 32, L"%d", (job.rounds - s->replied) * 100 / job.rounds);
+        swprintf_s(rangeStr, 64, L"%.3f/%.3f", s->minUs / 1000.0, s->maxUs / 1000.0);
+        post_result(hwnd, hosts[i], s->refused == s->replied ? L"在线 (端口拒绝)" : L"在线", rttStr, lossStr, rangeStr, location);
+    }
+
+cleanup:
+    free(targets);
+    free(job.stats);
+}
+
+// --- [新增] 持续监控 ---
+// 按固定间隔反复探测全部目标 (ICMP 或 TCP 握手)，结果写入各目标的环形缓冲区；
+// 每轮只向界面投递一条批量更新消息，由界面原地刷新对应行
+#define MONITOR_LINE_LEN      160
+#define MONITOR_ICMP_INFLIGHT 4096      // 同时在途的异步回显请求上限
+#define MONITOR_REPLY_SIZE    256       // 回复结构 + 数据 + IO_STATUS_BLOCK，IPv4 / IPv6 均够用
+
+// 新版 SDK 定义了 PIO_APC_ROUTINE 时回调参数按该类型声明，否则为 FARPROC
+#ifdef PIO_APC_ROUTINE_DEFINED
+#define MONITOR_APC(fn) ((PIO_APC_ROUTINE)(fn))
+#else
+#define MONITOR_APC(fn) ((FARPROC)(fn))
+#endif
+
+struct MonitorJob;
+
+typedef struct {
+    struct MonitorJob* job;
+    int target;
+    unsigned char reply[MONITOR_REPLY_SIZE];
+} MonitorEcho;
+
+typedef struct MonitorJob {
+    int hostCount;
+    int port;                       // >0 时测 TCP 握手，否则 ICMP
+    int timeoutMs;
+    int cursor;
+    int outstanding;                // 已发出、APC 尚未回调的回显请求数
+    HANDLE icmp4, icmp6;            // 整个监控任务共用，只在启动时打开一次
+    MonitorEcho* echoes;            // 每个目标一个回复缓冲区，各轮复用
+    const ProbeTarget* targets;
+    ProbeSources* sources;
+    unsigned int* roundRtt;         // 本轮各目标的结果 (微秒)，MONITOR_LOST 表示丢包
+} MonitorJob;
+
+static int monitor_next(void* ctx, int* target, int* port) {
+    MonitorJob* job = (MonitorJob*)ctx;
+    while (job->cursor < job->hostCount) {
+        int i = job->cursor++;
+        if (!job->targets[i].family) continue;
+        *target = i;
+        *port = job->port;
+        return 1;
+    }
+    return 0;
+}
+
+static void on_monitor_rtt(void* ctx, int target, int port, unsigned long long rttUs) {
+    MonitorJob* job = (MonitorJob*)ctx;
+    (void)port;
+    job->roundRtt[target] = rttUs < MONITOR_LOST ? (unsigned int)rttUs : MONITOR_LOST - 1;
+}
+
+// 回显完成 (应答、超时或出错) 时由系统以 APC 方式在监控线程上回调，无需加锁
+static void NTAPI monitor_echo_done(void* ctx, void* ioStatus, ULONG reserved) {
+    MonitorEcho* e = (MonitorEcho*)ctx;
+    MonitorJob* job = e->job;
+    (void)ioStatus;
+    (void)reserved;
+    if (job->targets[e->target].family == 6) {
+        if (Icmp6ParseReplies(e->reply, MONITOR_REPLY_SIZE) > 0) {
+            PICMPV6_ECHO_REPLY r = (PICMPV6_ECHO_REPLY)e->reply;
+            if (r->Status == IP_SUCCESS) job->roundRtt[e->target] = (unsigned int)r->RoundTripTime * 1000;
+        }
+    } else if (IcmpParseReplies(e->reply, MONITOR_REPLY_SIZE) > 0) {
+        PICMP_ECHO_REPLY r = (PICMP_ECHO_REPLY)e->reply;
+        if (r->Status == IP_SUCCESS) job->roundRtt[e->target] = (unsigned int)r->RoundTripTime * 1000;   // 只有毫秒精度
+    }
+    job->outstanding--;
+}
+
+// 异步发出一个回显请求，成功挂起返回 1
+static int monitor_echo_send(MonitorJob* job, int i) {
+    static char data[] = "NetToolMonitor";
+    const ProbeTarget* t = &job->targets[i];
+    const ProbeTarget* src = source_pick(job->sources, t->family, (unsigned int)i);
+    MonitorEcho* e = &job->echoes[i];
+    DWORD ret;
+    e->job = job;
+    e->target = i;
+    if (t->family == 6) {
+        if (job->icmp6 == INVALID_HANDLE_VALUE) return 0;
+        struct sockaddr_in6 local = {0};
+        local.sin6_family = AF_INET6;
+        if (src) local.sin6_addr = src->addr.v6.sin6_addr;
+        ret = Icmp6SendEcho2(job->icmp6, NULL, MONITOR_APC(monitor_echo_done), e, &local, (struct sockaddr_in6*)&t->addr.v6,
+                             data, sizeof(data), NULL, e->reply, MONITOR_REPLY_SIZE, job->timeoutMs);
+    } else {
+        if (job->icmp4 == INVALID_HANDLE_VALUE) return 0;
+        ret = src ? IcmpSendEcho2Ex(job->icmp4, NULL, MONITOR_APC(monitor_echo_done), e, src->addr.v4.sin_addr.s_addr, t->addr.v4.sin_addr.s_addr,
+                                    data, sizeof(data), NULL, e->reply, MONITOR_REPLY_SIZE, job->timeoutMs)
+                  : IcmpSendEcho2(job->icmp4, NULL, MONITOR_APC(monitor_echo_done), e, t->addr.v4.sin_addr.s_addr,
+                                  data, sizeof(data), NULL, e->reply, MONITOR_REPLY_SIZE, job->timeoutMs);
+    }
+    return ret == 0 && GetLastError() == ERROR_IO_PENDING;
+}
+
+static void monitor_round(MonitorJob* job, const ThreadParams* p) {
+    for (int i = 0; i < job->hostCount; i++) job->roundRtt[i] = MONITOR_LOST;
+
+    if (job->port > 0) {
+        ProbeEngineConfig cfg = {0};
+        cfg.targets = job->targets;
+        cfg.targetCount = job->hostCount;
+        cfg.proto = PROBE_TCP;
+        cfg.maxInFlight = TCPING_MAX_INFLIGHT;
+        cfg.timeoutMs = job->timeoutMs;
+        cfg.minTimeoutMs = job->timeoutMs;
+        cfg.pps = p->pps;
+        cfg.subnetCap = p->subnetCap;
+        cfg.sources = p->sources;
+        cfg.onRtt = on_monitor_rtt;
+        cfg.next = monitor_next;
+        cfg.ctx = job;
+        job->cursor = 0;
+        engine_run(&cfg);
+        return;
+    }
+
+    // [修改] ICMP 模式不再每轮创建线程：由本线程异步发出全部回显请求，
+    // 在可提醒等待中收取 APC 回调，目标全部不可达时一轮也只需约一个超时
+    job->cursor = 0;
+    job->outstanding = 0;
+    while (job->cursor < job->hostCount || job->outstanding > 0) {
+        while (job->cursor < job->hostCount && job->outstanding < MONITOR_ICMP_INFLIGHT && !g_stopSignal) {
+            int i = job->cursor++;
+            if (job->targets[i].family && monitor_echo_send(job, i)) job->outstanding++;
+        }
+        // 中止时不再发新请求，但已发出的仍占用回复缓冲区，须等其在超时内回调完毕
+        if (g_stopSignal) job->cursor = job->hostCount;
+        if (job->outstanding > 0) SleepEx(50, TRUE);
+    }
+}
+
+static int monitor_format(wchar_t* out, int outLen, int row, const MonitorSummary* s) {
+    const wchar_t* status = !s->lastLost ? L"在线" : s->lossPct == 100 ? L"离线" : L"丢包";
+    wchar_t last[32] = L"-", avg[32] = L"-", range[64] = L"-";
+    if (!s->lastLost) swprintf_s(last, 32, L"%.3f", s->lastMs);
+    if (s->lossPct < 100) {
+        swprintf_s(avg, 32, L"%.3f", s->avgMs);
+        swprintf_s(range, 64, L"%.1f/%.1f/%.1f", s->minMs, s->maxMs, s->jitterMs);
+    }
+    return swprintf_s(out, outLen, L"%d|%s|%s|%s|%d|%s\n", row, status, last, avg, s->lossPct, range);
+}
+
+static void thread_monitor(ThreadParams* p, wchar_t** hosts, int count) {
+    HWND hwnd = p->hwndNotify;
+    int interval = p->monitorIntervalMs;
+    ProbeTarget* targets = (ProbeTarget*)calloc(count ? count : 1, sizeof(ProbeTarget));
+    MonitorSeries* series = (MonitorSeries*)calloc(count ? count : 1, sizeof(MonitorSeries));
+    wchar_t* batch = (wchar_t*)malloc(sizeof(wchar_t) * (count * MONITOR_LINE_LEN + 1));
+    MonitorJob job = {0};
+    job.hostCount = count;
+    job.port = p->tcpingPort;
+    job.timeoutMs = p->timeoutMs > 0 && p->timeoutMs < interval ? p->timeoutMs : interval;
+    job.targets = targets;
+    job.sources = p->sources;
+    job.roundRtt = (unsigned int*)malloc(sizeof(unsigned int) * (count ? count : 1));
+    job.icmp4 = job.icmp6 = INVALID_HANDLE_VALUE;
+    if (job.port <= 0) {
+        job.icmp4 = IcmpCreateFile();
+        job.icmp6 = Icmp6CreateFile();
+        job.echoes = (MonitorEcho*)calloc(count ? count : 1, sizeof(MonitorEcho));
+        if (!job.echoes) goto cleanup;
+    }
+    if (!targets || !series || !batch || !job.roundRtt) goto cleanup;
+
+    // 先按目标顺序插入各行，第 i 行对应第 i 个目标
+    post_log(hwnd, 0, L"正在解析目标地址...");
+    for (int i = 0; i < count && !g_stopSignal; i++) {
+        targets[i].family = resolve_host(hosts[i], &targets[i].addr);
+        if (targets[i].family) post_result(hwnd, hosts[i], L"等待", L"-", L"-", L"-", L"-");
+        else post_result(hwnd, hosts[i], L"无效地址", L"-", L"-", L"-", L"-");
+    }
+
+    // [修改] 各轮按固定时间点起跑：第 n 轮在 start + n * interval 开始，
+    // 某轮超时则跳过已错过的时间点，而不是紧接着连续补跑
+    long long rounds = 0;
+    unsigned long long deadline = platform_tick_ms();
+    while (!g_stopSignal) {
+        unsigned long long roundStart = platform_tick_ms();
+        monitor_round(&job, p);
+        if (g_stopSignal) break;
+
+        int len = 0, online = 0;
+        for (int i = 0; i < count; i++) {
+            if (!targets[i].family) continue;
+            MonitorSummary s;
+            monitor_series_add(&series[i], job.roundRtt[i]);
+            monitor_series_summary(&series[i], &s);
+            if (!s.lastLost) online++;
+            len += monitor_format(batch + len, MONITOR_LINE_LEN, i, &s);
+        }
+        rounds++;
+        if (len > 0) post_message(hwnd, WM_USER_UPDATE, 0, batch);
+
+        unsigned long long elapsed = platform_tick_ms() - roundStart;
+        wchar_t msg[160];
+        swprintf_s(msg, 160, L"持续监控中：第 %lld 轮，在线 %d / %d，本轮耗时 %llu ms%s", rounds, online, count, elapsed,
+                   elapsed > (unsigned long long)interval ? L" (超过监控间隔)" : L"");
+        post_log(hwnd, 100, msg);
+
+        deadline += (unsigned long long)interval;
+        unsigned long long now = platform_tick_ms();
+        if (now >= deadline) deadline += ((now - deadline) / interval + 1) * (unsigned long long)interval;
+
+        // 分段休眠以便及时响应中止
+        while (!g_stopSignal && platform_tick_ms() < deadline) {
+            platform_sleep_ms(50);
+        }
+    }
+
+cleanup:
+    if (job.icmp4 != INVALID_HANDLE_VALUE) IcmpCloseHandle(job.icmp4);
+    if (job.icmp6 != INVALID_HANDLE_VALUE) IcmpCloseHandle(job.icmp6);
+    free(job.echoes);
+    free(targets);
+    free(series);
+    free(batch);
+    free(job.roundRtt);
+}
+
 unsigned int __stdcall thread_ping(void* arg) {
     ThreadParams* p = (ThreadParams*)arg;
     int count;
-    wchar_t** hosts = split_hosts(p->targetInput, &count);
+    wchar_t** hosts = split_hosts(&p->arena, p->targetInput, &count);
     HWND hwnd = p->hwndNotify; 
 
+    // [新增] 持续监控直到用户中止
+    if (p->monitorIntervalMs > 0) {
+        thread_monitor(p, hosts, count);
+        free_thread_params(p);
+        post_finish(hwnd, L"持续监控已停止。");
+        return 0;
+    }
+
+    // [新增] 指定端口时改用 TCP 握手测延迟
+    if (p->tcpingPort > 0) {
+        if (p->showLocation) ipv4_init_qqwry();
+        thread_tcping(p, hosts, count);
+        if (p->showLocation) ipv4_cleanup_qqwry();
+        free_thread_params(p);
+        if (g_stopSignal) post_finish(hwnd, L"任务已由用户中止。");
+        else post_finish(hwnd, L"批量 TCP Ping 任务完成。");
+        return 0;
+    }
+
     // 初始化 IPv4 库 (如果需要显示归属地)
     if (p->showLocation) ipv4_init_qqwry();
-    
+    metrics_add(METRIC_WORK_TOTAL, count);
+    post_log(hwnd, 0, L"正在 Ping...");
+
     for (int i = 0; i < count; i++) {
         if (g_stopSignal) { post_log(hwnd, 0, L"任务已中止"); break; }
 
-        wchar_t statusMsg[256];
-        swprintf_s(statusMsg, 256, L"正在 Ping (%d/%d): %s...", i + 1, count, hosts[i]);
-        post_log(hwnd, (i * 100) / count, statusMsg);
-
         // 解析地址 (自动识别 IPv4 或 IPv6)
         union {
             struct sockaddr_in v4;
@@ -202,16 +556,19 @@ unsigned int __stdcall thread_ping(void* arg) {
             if (p->showLocation) {
                  ipv4_get_location(inet_ntoa(addr.v4.sin_addr), location, 256);
             }
-            success = ipv4_ping_host(addr.v4.sin_addr.s_addr, p->retryCount, p->timeoutMs, &avgRtt, &ttl);
+            const ProbeTarget* src = source_pick(p->sources, 4, (unsigned int)i);
+            success = ipv4_ping_host(addr.v4.sin_addr.s_addr, src ? src->addr.v4.sin_addr.s_addr : 0, p->retryCount, p->timeoutMs, &avgRtt, &ttl);
         } 
         else if (type == 6) {
             // IPv6: 暂无归属地库，显示类型
             wcscpy_s(location, 256, L"IPv6地址");
-            success = ipv6_ping_host(&addr.v6, p->retryCount, p->timeoutMs, &avgRtt, &ttl);
+            const ProbeTarget* src = source_pick(p->sources, 6, (unsigned int)i);
+            success = ipv6_ping_host(&addr.v6, src ? &src->addr.v6 : NULL, p->retryCount, p->timeoutMs, &avgRtt, &ttl);
         }
         else {
              // 解析失败
              post_result(hwnd, hosts[i], L"无效地址", L"N/A", L"100", L"N/A", L"未知");
+             metrics_add(METRIC_WORK_DONE, 1);
              continue;
         }
 
@@ -227,9 +584,9 @@ unsigned int __stdcall thread_ping(void* arg) {
         } else {
             post_result(hwnd, hosts[i], L"超时", L"N/A", L"100", L"N/A", location);
         }
+        metrics_add(METRIC_WORK_DONE, 1);
     }
 
-    free_string_list(hosts, count);
     if (p->showLocation) ipv4_cleanup_qqwry();
     free_thread_params(p);
     
@@ -238,71 +595,1030 @@ unsigned int __stdcall thread_ping(void* arg) {
     return 0;
 }
 
+// --- [新增] 并发端口扫描 ---
+// 批量扫描定期把进度写入当前目录，中止或崩溃后可从断点继续
+#define CHECKPOINT_STATE_FILE   L"netools_scan.ckpt"
+#define CHECKPOINT_RESULT_FILE  L"netools_scan.res"
+#define CHECKPOINT_INTERVAL_MS  3000
+#define CHECKPOINT_TRACK_CAP    8192    // 未完成集合的初始容量，超出时自动扩容
+
+typedef struct {
+    HWND hwnd;
+    wchar_t** hosts;
+    int hostCount;
+    int* ports;
+    int portCount;
+    ProbeTarget* targets;
+    int proto;
+    int showLocation;
+    int singleScan;
+    ServiceMatcher* matcher; // 非 NULL 时启用服务识别
+    Permutation order;      // 主机×端口 索引空间的伪随机遍历
+    int shuffled;           // 0 时按索引顺序 (端口按常见程度) 遍历
+    unsigned long long cursor;
+    unsigned long long space;
+    int shardIndex;         // 分片：只处理遍历位置模 shardCount 等于 shardIndex 的探测
+    int shardCount;
+    unsigned long long current; // [修改] 主机×端口 可超过 2^31，进度按 64 位计
+    unsigned long long total;
+    int openCount;          // 按三态统计结果，完成时汇总
+    int closedCount;
+    int filteredCount;
+    int errorCount;         // [新增] 本地资源持续不足而放弃的探测 (不是扫描结论)
+    long long localErrors;  // [新增] 上次统计回调时引擎累计的本地错误数
+    DeltaIndex* delta;      // [新增] 增量扫描的基线索引，NULL = 普通扫描
+
+    // 断点续传 (resultLog 非 NULL 时启用)
+    FILE* resultLog;
+    int resultCount;
+    unsigned int specHash;
+    unsigned long long seed;
+    unsigned long long lastSave;
+    IndexSet outstanding;   // 已发出但尚未得出结果的索引
+    IndexSet retry;         // [新增] 因本地错误放弃、续扫时补发的索引
+    int untracked;          // [新增] 集合扩容失败，之后不再更新断点
+    int* portIndex;         // 端口号 -> 端口序号
+    unsigned long long* replay; // 续扫时需要补发的索引
+    int replayCount;
+    int replayPos;
+} PortScanJob;
+
+// 目标与端口的哈希：分片扫描时各节点由此得到相同的置换种子
+static unsigned int port_scan_target_hash(const ThreadParams* p) {
+    unsigned int h = 2166136261u;
+    if (p->targetInput) h = checkpoint_hash(p->targetInput, (int)(wcslen(p->targetInput) * sizeof(wchar_t)), h);
+    h = checkpoint_hash(L"|", sizeof(wchar_t), h);
+    if (p->portsInput) h = checkpoint_hash(p->portsInput, (int)(wcslen(p->portsInput) * sizeof(wchar_t)), h);
+    return h;
+}
+
+// [修改] 分片默认种子：主机名转为 UTF-8 后交给 shard_default_seed，与 netools_cli 对同一列表得到同一种子
+static unsigned long long port_scan_shard_seed(const PortScanJob* job) {
+    char** names = (char**)calloc(job->hostCount, sizeof(char*));
+    int n = 0;
+    for (; names && n < job->hostCount; n++) {
+        int cap = (int)wcslen(job->hosts[n]) * 3 + 1;
+        names[n] = (char*)malloc(cap);
+        if (!names[n]) break;
+        names[n][wide_to_utf8(job->hosts[n], names[n], cap - 1)] = 0;
+    }
+    // 内存不足时退回仅由端口推导，各节点仍然一致
+    unsigned long long seed = shard_default_seed((const char* const*)names, n == job->hostCount ? n : 0, job->ports, job->portCount);
+    for (int i = 0; names && i < n; i++) free(names[i]);
+    free(names);
+    return seed;
+}
+
+// 任务身份：目标、端口、分片与影响结果的选项，续扫前用于确认是同一任务
+unsigned int port_scan_spec_hash(const ThreadParams* p) {
+    int opts[4] = { p->udpScan, p->serviceDetect, p->shardIndex, p->shardCount };
+    return checkpoint_hash(opts, sizeof(opts), port_scan_target_hash(p));
+}
+
+int port_scan_can_resume(const ThreadParams* p) {
+    ScanCheckpoint ck;
+    if (!checkpoint_load(CHECKPOINT_STATE_FILE, &ck)) return 0;
+    free(ck.pending);
+    return ck.specHash == port_scan_spec_hash(p);
+}
+
+// [新增] 增量扫描的基线按目标列表与协议区分，每批目标各保留一份上次的快照 (端口列表可以不同)
+static void port_scan_baseline_path(const ThreadParams* p, wchar_t* out, int len) {
+    unsigned int h = 2166136261u;
+    if (p->targetInput) h = checkpoint_hash(p->targetInput, (int)(wcslen(p->targetInput) * sizeof(wchar_t)), h);
+    h = checkpoint_hash(&p->udpScan, sizeof(p->udpScan), h);
+    swprintf_s(out, len, L"netools_baseline_%08x.ndjson", h);
+}
+
+static DeltaIndex* port_scan_load_baseline(PortScanJob* job, const wchar_t* path) {
+    DeltaIndex* d = delta_create(job->targets, job->hostCount, job->ports, job->portCount, job->proto);
+    if (!d) return NULL;
+    char name[512];
+    for (int i = 0; i < job->hostCount; i++) {
+        int n = wide_to_utf8(job->hosts[i], name, sizeof(name) - 1);
+        name[n] = 0;
+        delta_set_name(d, i, name);
+    }
+    int n = delta_load(d, path);
+    wchar_t msg[160];
+    if (n < 0) swprintf_s(msg, 160, L"增量扫描：该目标尚无基线，本次开放的端口均列为新开放，完成后保存为基线");
+    else swprintf_s(msg, 160, L"增量扫描：基线中有 %d 个开放端口在本次范围内，先行复查", n);
+    post_log(job->hwnd, 0, msg);
+    return d;
+}
+
+static int port_scan_next(void* ctx, int* target, int* port) {
+    PortScanJob* job = (PortScanJob*)ctx;
+    for (;;) {
+        unsigned long long idx;
+        if (job->replayPos < job->replayCount) {
+            // 续扫：先补发上次中断时尚未得出结果的探测 (已计入进度)
+            idx = job->replay[job->replayPos++];
+        } else if (job->delta && delta_next(job->delta, &idx)) {
+            // [新增] 增量扫描：先复查上次开放的端口，尽快得出 "是否仍在" 的结论
+            job->current++;
+            metrics_add(METRIC_WORK_DONE, 1);
+        } else if (job->cursor < job->space) {
+            unsigned long long pos = job->cursor++;
+            idx = pos;
+            if (job->shuffled && !permutation_next(&job->order, &idx)) { job->cursor = job->space; return 0; }
+            // 各节点以相同种子遍历同一序列，按位置取模分配，互不重叠也无遗漏
+            if (job->shardCount > 1 && pos % job->shardCount != (unsigned long long)job->shardIndex) continue;
+            // 增量扫描：上次开放的端口已在首轮复查
+            if (job->delta && delta_known(job->delta, (int)(idx % job->hostCount), (int)(idx / job->hostCount))) continue;
+            job->current++;
+            metrics_add(METRIC_WORK_DONE, 1);
+        } else {
+            return 0;
+        }
+        // 索引 = 端口序号 * 主机数 + 主机序号：顺序遍历时相邻探测也落在不同主机上
+        int h = (int)(idx % job->hostCount);
+        int portIdx = (int)(idx / job->hostCount);
+        if (job->targets[h].family == 0) continue;
+
+        *target = h;
+        *port = job->ports[portIdx];
+        if (job->resultLog && !indexset_add(&job->outstanding, idx)) job->untracked = 1;
+        return 1;
+    }
+}
+
+// 百分比在 64 位内计算，current * 100 不会溢出
+static int port_scan_percent(const PortScanJob* job) {
+    return job->total ? (int)(job->current * 100 / job->total) : 0;
+}
+
+static const wchar_t* port_scan_status(const PortScanJob* job, int state) {
+    if (state == PROBE_OPEN) return L"开放 (Open)";
+    if (state == PROBE_FILTERED && job->proto == PROBE_UDP) return L"开放|过滤 (Open|Filtered)";
+    return NULL;
+}
+
+static void port_scan_location(const PortScanJob* job, int target, wchar_t* location, int len) {
+    const ProbeTarget* t = &job->targets[target];
+    location[0] = 0;
+    if (t->family == 4 && job->showLocation) {
+        ipv4_get_location(inet_ntoa(t->addr.v4.sin_addr), location, len);
+    } else if (t->family == 6) {
+        wcscpy_s(location, len, L"IPv6地址");
+    }
+}
+
+static void port_scan_port_text(const PortScanJob* job, int port, wchar_t* out, int len) {
+    if (job->proto == PROBE_UDP) swprintf_s(out, len, L"%d/udp", port);
+    else swprintf_s(out, len, L"%d", port);
+}
+
+// 结果写入列表 (续扫回放历史结果时同样走这里)
+static void port_scan_display(void* ctx, int target, int port, int state, const char* data, int len) {
+    PortScanJob* job = (PortScanJob*)ctx;
+    const wchar_t* status = port_scan_status(job, state);
+    if (!status || target < 0 || target >= job->hostCount) return;
+
+    wchar_t location[256];
+    port_scan_location(job, target, location, 256);
+    wchar_t portStr[16];
+    port_scan_port_text(job, port, portStr, 16);
+
+    if (!job->matcher) {
+        post_result(job->hwnd, job->hosts[target], portStr, status, location, L"", L"");
+        return;
+    }
+
+    // 服务识别：单目标扫描填入 "服务/备注" 列，批量扫描在状态列后追加一列
+    wchar_t service[256] = {0};
+    service_identify(job->matcher, data, len, service, 256);
+    if (job->singleScan) {
+        post_result(job->hwnd, job->hosts[target], portStr, service[0] ? service : status, location, L"", L"");
+    } else {
+        post_result(job->hwnd, job->hosts[target], portStr, status, service[0] ? service : L"-", location, L"");
+    }
+}
+
+// [新增] 增量扫描：只列出与基线不同的端口，首轮复查完成时汇总一次
+static void port_scan_delta(PortScanJob* job, int target, int port, int state, const char* data, int len) {
+    wchar_t service[256] = {0};
+    if (job->matcher && port_scan_status(job, state)) service_identify(job->matcher, data, len, service, 256);
+    int change = delta_observe(job->delta, target, port, state, service);
+
+    if (change != DELTA_NONE) {
+        const wchar_t* status = change == DELTA_NEW ? L"新开放" : change == DELTA_CHANGED ? L"服务变化" :
+                                state == PROBE_FILTERED ? L"已关闭 (过滤)" : L"已关闭";
+        wchar_t location[256], portStr[16];
+        port_scan_location(job, target, location, 256);
+        port_scan_port_text(job, port, portStr, 16);
+        if (!job->matcher) {
+            post_result(job->hwnd, job->hosts[target], portStr, status, location, L"", L"");
+        } else {
+            // 服务变化显示 "上次 -> 本次"
+            wchar_t detail[512];
+            if (change == DELTA_CHANGED) {
+                wchar_t previous[256];
+                utf8_to_wide_buf(delta_previous_service(job->delta, target, port), previous, 256);
+                swprintf_s(detail, 512, L"%s -> %s", previous, service);
+            } else {
+                wcscpy_s(detail, 512, service[0] ? service : L"-");
+            }
+            post_result(job->hwnd, job->hosts[target], portStr, status, detail, location, L"");
+        }
+    }
+
+    if (delta_first_pass_done(job->delta)) {
+        DeltaStats ds;
+        wchar_t msg[160];
+        delta_stats(job->delta, &ds);
+        swprintf_s(msg, 160, L"上次开放的端口已复查：%d 个仍开放，%d 个已关闭，继续扫描其余端口", ds.stillOpen, ds.closed);
+        post_log(job->hwnd, port_scan_percent(job), msg);
+    }
+}
+
+static void on_port_scan_result(void* ctx, int target, int port, int state, const char* data, int len) {
+    PortScanJob* job = (PortScanJob*)ctx;
+
+    if (state == PROBE_OPEN) job->openCount++;
+    else if (state == PROBE_CLOSED) job->closedCount++;
+    else if (state == PROBE_FILTERED) job->filteredCount++;
+    else job->errorCount++;
+
+    // 增量扫描不记断点，本地错误也交给基线索引沿用上次的记录
+    if (job->delta) {
+        port_scan_delta(job, target, port, state, data, len);
+        return;
+    }
+    unsigned long long idx = job->resultLog ? (unsigned long long)job->portIndex[port] * job->hostCount + target : 0;
+    if (job->resultLog) indexset_remove(&job->outstanding, idx);
+    // 本地错误不是结论：移入补发集合，续扫时重新发出
+    if (state == PROBE_ERROR) {
+        if (job->resultLog && !indexset_add(&job->retry, idx)) job->untracked = 1;
+        return;
+    }
+
+    if (job->resultLog) {
+        if (port_scan_status(job, state)) {
+            checkpoint_append_result(job->resultLog, target, port, state, data, len);
+            job->resultCount++;
+        }
+    }
+    port_scan_display(ctx, target, port, state, data, len);
+}
+
+// 写断点：先刷出结果文件，再替换状态文件，保证状态中的结果数都已落盘
+static void port_scan_checkpoint(PortScanJob* job) {
+    // 有索引没记进集合时，保留上一次完整的断点 (续扫会截掉其后追加的结果)
+    if (job->untracked) return;
+    ScanCheckpoint ck;
+    memset(&ck, 0, sizeof(ck));
+    fflush(job->resultLog);
+    ck.specHash = job->specHash;
+    ck.seed = job->seed;
+    ck.order = job->order;
+    ck.shuffled = job->shuffled;
+    ck.cursor = job->cursor;
+    ck.current = job->current;
+    ck.openCount = job->openCount;
+    ck.closedCount = job->closedCount;
+    ck.filteredCount = job->filteredCount;
+    ck.resultCount = job->resultCount;
+    ck.pending = (unsigned long long*)malloc(sizeof(unsigned long long) * (job->outstanding.count + job->retry.count + 1));
+    if (ck.pending) {
+        ck.pendingCount = indexset_collect(&job->outstanding, ck.pending);
+        ck.pendingCount += indexset_collect(&job->retry, ck.pending + ck.pendingCount);
+        checkpoint_save(CHECKPOINT_STATE_FILE, &ck);
+        free(ck.pending);
+    }
+    job->lastSave = platform_tick_ms();
+}
+
+// 载入断点并回放已有结果，失败时返回 0 (按新任务扫描)
+static int port_scan_resume(PortScanJob* job) {
+    ScanCheckpoint ck;
+    if (!checkpoint_load(CHECKPOINT_STATE_FILE, &ck)) return 0;
+    if (ck.specHash != job->specHash || ck.cursor > job->space) { free(ck.pending); return 0; }
+
+    job->seed = ck.seed;
+    job->order = ck.order;
+    job->shuffled = ck.shuffled;
+    job->cursor = ck.cursor;
+    job->current = ck.current;
+    job->openCount = ck.openCount;
+    job->closedCount = ck.closedCount;
+    job->filteredCount = ck.filteredCount;
+    job->replay = ck.pending;
+    job->replayCount = ck.pendingCount;
+    // 待补发的索引在发出前同样算作未完成，期间再次写断点也不会丢失
+    for (int i = 0; i < ck.pendingCount; i++) {
+        if (!indexset_add(&job->outstanding, ck.pending[i])) job->untracked = 1;
+    }
+
+    int n = checkpoint_replay_results(CHECKPOINT_RESULT_FILE, ck.resultCount, port_scan_display, job);
+    job->resultCount = n > 0 ? n : 0;
+
+    wchar_t msg[160];
+    swprintf_s(msg, 160, L"已从断点继续：进度 %llu/%llu，恢复 %d 条结果，补发 %d 个未完成探测",
+               job->current, job->total, job->resultCount, job->replayCount);
+    post_log(job->hwnd, port_scan_percent(job), msg);
+    return 1;
+}
+
+static void on_port_scan_stats(void* ctx, const ProbeEngineStats* st) {
+    PortScanJob* job = (PortScanJob*)ctx;
+    // 超时比例异常导致降速时提示用户
+    if (st->rateLimit > 0 && st->timeoutPct >= 50) {
+        wchar_t msg[128];
+        swprintf_s(msg, 128, L"超时比例 %d%%，疑似被限速，已降至 %d pps", st->timeoutPct, st->rateLimit);
+        post_log(job->hwnd, port_scan_percent(job), msg);
+    }
+    // 句柄或临时端口耗尽：引擎已收缩在途上限并稍后重发，提示用户而不是误报为关闭/过滤
+    if (st->localErrors > job->localErrors) {
+        wchar_t msg[128];
+        swprintf_s(msg, 128, L"本地资源不足 (句柄/临时端口) %lld 次，在途上限降至 %d，稍后重发",
+                   st->localErrors - job->localErrors, st->inFlightLimit);
+        post_log(job->hwnd, port_scan_percent(job), msg);
+        job->localErrors = st->localErrors;
+    }
+    if (job->resultLog && platform_tick_ms() - job->lastSave >= CHECKPOINT_INTERVAL_MS) port_scan_checkpoint(job);
+}
+
+// --- [新增] 存活主机探测 ---
+// 端口扫描前并发执行 ICMP Echo 与常见端口 TCP 探测，任一有应答 (含 RST) 即视为在线
+#define DISCOVERY_TIMEOUT_MS   1000
+#define DISCOVERY_PING_THREADS 32
+
+static const int g_discoveryPorts[] = { 80, 443, 22 };
+#define DISCOVERY_PORT_COUNT ((int)(sizeof(g_discoveryPorts) / sizeof(g_discoveryPorts[0])))
+
+typedef struct {
+    const ProbeTarget* targets;
+    int hostCount;
+    volatile char* alive;
+    ProbeSources* sources;
+    volatile LONG nextPing;     // Ping 线程共享的主机游标
+    int timeoutMs;
+    int hostCursor;             // TCP 探测生成器游标
+    int portCursor;
+} DiscoveryJob;
+
+static unsigned int __stdcall discovery_ping_worker(void* arg) {
+    DiscoveryJob* d = (DiscoveryJob*)arg;
+    for (;;) {
+        int i = (int)InterlockedIncrement(&d->nextPing) - 1;
+        if (i >= d->hostCount || g_stopSignal) break;
+        long rtt = 0;
+        int ttl = 0;
+        if (d->alive[i]) continue;
+        if (ping_target(&d->targets[i], d->sources, (unsigned int)i, 1, d->timeoutMs, &rtt, &ttl)) d->alive[i] = 1;
+    }
+    return 0;
+}
+
+static int discovery_next(void* ctx, int* target, int* port) {
+    DiscoveryJob* d = (DiscoveryJob*)ctx;
+    while (d->hostCursor < d->hostCount) {
+        int h = d->hostCursor;
+        // 已被 Ping 确认在线的主机不再发 TCP 探测
+        if (d->portCursor >= DISCOVERY_PORT_COUNT || d->targets[h].family == 0 || d->alive[h]) {
+            d->hostCursor++;
+            d->portCursor = 0;
+            continue;
+        }
+        *target = h;
+        *port = g_discoveryPorts[d->portCursor++];
+        return 1;
+    }
+    return 0;
+}
+
+static void on_discovery_result(void* ctx, int target, int port, int state, const char* data, int len) {
+    DiscoveryJob* d = (DiscoveryJob*)ctx;
+    (void)port; (void)data; (void)len;
+    if (state == PROBE_OPEN || state == PROBE_CLOSED) d->alive[target] = 1;
+}
+
+// 返回在线主机数；不在线的主机地址族清零，后续扫描视同无法解析而跳过
+static int discover_hosts(ThreadParams* p, ProbeTarget* targets, int hostCount) {
+    DiscoveryJob d;
+    memset(&d, 0, sizeof(d));
+    d.targets = targets;
+    d.hostCount = hostCount;
+    d.alive = (volatile char*)calloc(hostCount, 1);
+    d.sources = p->sources;
+    d.timeoutMs = (p->timeoutMs > 0 && p->timeoutMs < DISCOVERY_TIMEOUT_MS) ? p->timeoutMs : DISCOVERY_TIMEOUT_MS;
+    if (!d.alive) return hostCount;
+
+    wchar_t msg[128];
+    swprintf_s(msg, 128, L"存活探测中: %d 台主机 (ICMP + TCP 80/443/22)...", hostCount);
+    post_log(p->hwndNotify, 0, msg);
+
+    HANDLE workers[DISCOVERY_PING_THREADS];
+    int workerCount = hostCount < DISCOVERY_PING_THREADS ? hostCount : DISCOVERY_PING_THREADS;
+    int started = 0;
+    for (int i = 0; i < workerCount; i++) {
+        HANDLE h = (HANDLE)_beginthreadex(NULL, 0, discovery_ping_worker, &d, 0, NULL);
+        if (h) workers[started++] = h;
+    }
+
+    // Ping 线程与 TCP 探测同时进行
+    ProbeEngineConfig cfg = {0};
+    cfg.targets = targets;
+    cfg.targetCount = hostCount;
+    cfg.proto = PROBE_TCP;
+    cfg.maxInFlight = 256;
+    cfg.timeoutMs = d.timeoutMs;
+    cfg.minTimeoutMs = p->minTimeoutMs;
+    cfg.pps = p->pps;
+    cfg.subnetCap = p->subnetCap;
+    cfg.sources = p->sources;
+    cfg.next = discovery_next;
+    cfg.onResult = on_discovery_result;
+    cfg.ctx = &d;
+    engine_run(&cfg);
+
+    if (started > 0) WaitForMultipleObjects(started, workers, TRUE, INFINITE);
+    for (int i = 0; i < started; i++) CloseHandle(workers[i]);
+
+    int alive = 0;
+    for (int i = 0; i < hostCount; i++) {
+        if (d.alive[i]) alive++;
+        else targets[i].family = 0;
+    }
+    free((void*)d.alive);
+
+    swprintf_s(msg, 128, L"存活探测完成: %d/%d 台主机在线", alive, hostCount);
+    post_log(p->hwndNotify, 0, msg);
+    return alive;
+}
+
 unsigned int __stdcall thread_port_scan(void* arg) {
     ThreadParams* p = (ThreadParams*)arg;
     int hostCount, portCount;
-    wchar_t** hosts = split_hosts(p->targetInput, &hostCount);
+    wchar_t** hosts = split_hosts(&p->arena, p->targetInput, &hostCount);
     int* ports = parse_ports(p->portsInput, &portCount);
     HWND hwnd = p->hwndNotify;
 
     if (p->showLocation) ipv4_init_qqwry();
 
-    int total = hostCount * portCount;
-    int current = 0;
+    // 针对每个主机只解析一次
+    ProbeTarget* targets = (ProbeTarget*)calloc(hostCount ? hostCount : 1, sizeof(ProbeTarget));
+    for (int i = 0; i < hostCount && !g_stopSignal; i++) {
+        targets[i].family = resolve_host(hosts[i], &targets[i].addr);
+    }
 
-    for (int i = 0; i < hostCount; i++) {
-        if (g_stopSignal) break; 
-        
-        union {
-            struct sockaddr_in v4;
-            struct sockaddr_in6 v6;
-        } addr;
-        
-        // 针对每个主机只解析一次
-        int type = resolve_host(hosts[i], &addr);
-        wchar_t location[256] = {0};
+    // 可选的存活探测：跳过不在线主机 (防火墙屏蔽探测的网络可关闭此项，视所有主机为在线)
+    if (p->hostDiscovery && !p->singleScan && hostCount > 0 && !g_stopSignal) {
+        discover_hosts(p, targets, hostCount);
+    }
 
-        if (type == 4 && p->showLocation) {
-            ipv4_get_location(inet_ntoa(addr.v4.sin_addr), location, 256);
-        } else if (type == 6) {
-             wcscpy_s(location, 256, L"IPv6地址");
-        }
+    // 单目标扫描端口多，先 Ping 一次为超时估计提供初始 RTT；批量扫描靠连接结果自行收敛
+    int* rttHints = NULL;
+    if (p->singleScan && hostCount > 0 && !g_stopSignal) {
+        long rtt = 0;
+        int ttl = 0, ok = 0;
+        rttHints = (int*)calloc(hostCount, sizeof(int));
+        ok = ping_target(&targets[0], p->sources, 0, 1, p->timeoutMs, &rtt, &ttl);
+        if (ok && rttHints) rttHints[0] = rtt > 0 ? (int)rtt : 1;
+    }
 
-        for (int j = 0; j < portCount; j++) {
-            if (g_stopSignal) break; 
-
-            current++;
-            int port = ports[j];
-            wchar_t msg[256];
-            swprintf_s(msg, 256, L"扫描 (%d/%d): %s:%d", current, total, hosts[i], port);
-            post_log(hwnd, (current * 100) / (total ? total : 1), msg);
-
-            int open = 0;
-            // 根据类型调用不同的扫描模块
-            if (type == 4) {
-                open = ipv4_tcp_scan(addr.v4.sin_addr.s_addr, port, 2000); // 默认 2s 超时
-            } else if (type == 6) {
-                open = ipv6_tcp_scan(&addr.v6, port, 2000);
-            }
+    PortScanJob job = {0};
+    job.hwnd = hwnd;
+    job.hosts = hosts;
+    job.hostCount = hostCount;
+    job.ports = ports;
+    job.portCount = portCount;
+    job.targets = targets;
+    job.proto = p->udpScan ? PROBE_UDP : PROBE_TCP;
+    job.showLocation = p->showLocation;
+    job.singleScan = p->singleScan;
+    job.space = (unsigned long long)hostCount * portCount;
+    job.total = job.space;
+    // 增量扫描首轮复查整份基线，无法按遍历位置分片
+    if (p->deltaScan && p->shardCount > 1) {
+        post_log(hwnd, 0, L"增量扫描不支持分片，本机扫描全部目标");
+    } else if (p->shardCount > 1 && p->shardIndex < p->shardCount) {
+        job.shardIndex = p->shardIndex;
+        job.shardCount = p->shardCount;
+        job.total = (job.space + p->shardCount - 1 - p->shardIndex) / p->shardCount;
+    }
+    // 多目标时打乱 主机×端口 顺序以分散负载；单目标保持端口按常见程度排序。
+    // 分片时种子必须在各节点一致，未指定则按与命令行相同的规则由展开后的目标与端口推导
+    unsigned long long seed = p->scanSeed;
+    if (!seed && job.shardCount > 1) seed = port_scan_shard_seed(&job);
+    if (!seed) seed = platform_tick_us() ^ ((unsigned long long)time(NULL) << 20);
+    if (hostCount > 1) job.shuffled = permutation_init(&job.order, job.space, seed);
+    job.seed = seed;
 
-            if (open) {
-                wchar_t portStr[16];
-                swprintf_s(portStr, 16, L"%d", port);
-                post_result(hwnd, hosts[i], portStr, L"开放 (Open)", location, L"", L"");
-            } 
+    wchar_t baselinePath[64];
+    if (p->deltaScan && !p->singleScan && hostCount > 0 && portCount > 0) {
+        port_scan_baseline_path(p, baselinePath, 64);
+        job.delta = port_scan_load_baseline(&job, baselinePath);
+    }
+
+    // 批量 connect / UDP 扫描支持断点续传 (增量扫描中止后重新对比，不记录)
+    if (!p->singleScan && !job.delta && hostCount > 0 && portCount > 0) {
+        job.specHash = port_scan_spec_hash(p);
+        job.portIndex = (int*)malloc(sizeof(int) * 65536);
+        if (job.portIndex && indexset_init(&job.outstanding, CHECKPOINT_TRACK_CAP) && indexset_init(&job.retry, 64)) {
+            for (int i = 0; i < portCount; i++) job.portIndex[ports[i]] = i;
+            int resumed = p->resume && port_scan_resume(&job);
+            if (!resumed) checkpoint_remove(CHECKPOINT_STATE_FILE, CHECKPOINT_RESULT_FILE);
+            job.resultLog = platform_wfopen(CHECKPOINT_RESULT_FILE, resumed ? L"ab" : L"wb");
+            job.lastSave = platform_tick_ms();
         }
     }
+    // 续扫时已完成的部分直接计入进度
+    metrics_add(METRIC_WORK_TOTAL, (long long)job.total);
+    metrics_add(METRIC_WORK_DONE, (long long)job.current);
+    if (job.shuffled && !job.replay) {
+        wchar_t msg[96];
+        swprintf_s(msg, 96, L"探测顺序已随机化 (种子 %llu)", seed);
+        post_log(hwnd, 0, msg);
+    }
+    // UDP 回包本身即为协议应答，同样可用特征库识别
+    if (p->serviceDetect) job.matcher = service_matcher_create();
+
+    ProbeEngineConfig cfg = {0};
+    cfg.targets = targets;
+    cfg.targetCount = hostCount;
+    cfg.proto = job.proto;
+    cfg.maxInFlight = 256;
+    cfg.timeoutMs = p->timeoutMs;
+    cfg.minTimeoutMs = p->minTimeoutMs;
+    cfg.udpRetries = 2;
+    cfg.tcpRetries = 1;
+    cfg.rttHintMs = rttHints;
+    cfg.grabBanner = (job.matcher != NULL);
+    cfg.bannerWaitMs = 1500;
+    cfg.pps = p->pps;
+    cfg.subnetCap = p->subnetCap;
+    cfg.sources = p->sources;
+    cfg.onStats = on_port_scan_stats;
+    cfg.next = port_scan_next;
+    cfg.onResult = on_port_scan_result;
+    cfg.ctx = &job;
+    if (!g_stopSignal) engine_run(&cfg);
+
+    if (job.resultLog) {
+        // 中止时保留断点供下次继续；正常完成则清理
+        if (g_stopSignal) port_scan_checkpoint(&job);
+        fclose(job.resultLog);
+        if (!g_stopSignal) checkpoint_remove(CHECKPOINT_STATE_FILE, CHECKPOINT_RESULT_FILE);
+    }
+    DeltaStats ds = {0};
+    int deltaRun = job.delta != NULL;
+    if (deltaRun) {
+        // 只有完整扫描的结果才作为下次的基线
+        delta_stats(job.delta, &ds);
+        if (!g_stopSignal && delta_save(job.delta, baselinePath) < 0) post_log(hwnd, 100, L"增量扫描：基线快照写入失败");
+        delta_free(job.delta);
+    }
+    indexset_free(&job.outstanding);
+    indexset_free(&job.retry);
+    free(job.portIndex);
+    free(job.replay);
 
-    free_string_list(hosts, hostCount);
     free(ports);
+    free(targets);
+    free(rttHints);
+    service_matcher_free(job.matcher);
     if (p->showLocation) ipv4_cleanup_qqwry();
     free_thread_params(p);
     
+    wchar_t summary[160];
+    int n;
+    if (deltaRun) {
+        n = swprintf_s(summary, 160, L"增量扫描完成：新开放 %d，已关闭 %d，服务变化 %d，仍开放 %d。",
+                       ds.added, ds.closed, ds.changed, ds.stillOpen);
+    } else {
+        n = swprintf_s(summary, 160, L"批量端口扫描完成：开放 %d，关闭 %d，过滤 %d。", job.openCount, job.closedCount, job.filteredCount);
+    }
+    if (job.errorCount > 0) swprintf_s(summary + n, 160 - n, L"另有 %d 个探测因本地资源不足未完成。", job.errorCount);
+    if (g_stopSignal) post_finish(hwnd, L"任务已由用户中止。");
+    else post_finish(hwnd, summary);
+    return 0;
+}
+
+// --- [新增] 分片结果合并 ---
+// 各节点导出的 CSV 表头一致，按 "地址,端口" 两列去重后合并为一个文件
+int merge_result_files(const wchar_t** inputs, int count, const wchar_t* output) {
+    wchar_t** rows = NULL;
+    int n = 0, cap = 0;
+    wchar_t* header = NULL;
+    wchar_t buf[2048];
+    int failed = 0;             // [新增] 内存不足时整体失败，不写出残缺的结果
+
+    for (int i = 0; i < count && !failed; i++) {
+        FILE* f;
+        if (_wfopen_s(&f, inputs[i], L"r, ccs=UTF-8") != 0) continue;
+        int first = 1;
+        while (fgetws(buf, 2048, f)) {
+            size_t len = wcslen(buf);
+            while (len > 0 && (buf[len - 1] == L'\n' || buf[len - 1] == L'\r')) buf[--len] = 0;
+            if (len == 0) continue;
+            // 每个文件首行为表头，只保留第一个
+            if (first) { first = 0; if (!header) header = _wcsdup(buf); continue; }
+            if (n == cap) {
+                int newCap = cap ? cap * 2 : 1024;
+                wchar_t** grown = (wchar_t**)realloc(rows, sizeof(wchar_t*) * newCap);
+                if (!grown) { failed = 1; break; }
+                rows = grown;
+                cap = newCap;
+            }
+            rows[n] = _wcsdup(buf);
+            if (!rows[n]) { failed = 1; break; }
+            n++;
+        }
+        fclose(f);
+    }
+
+    // 先排序去重，失败时不创建也不截断输出文件
+    int unique = failed ? -1 : result_sort_dedupe(rows, n);
+    int written = -1;
+    FILE* out;
+    if (header && unique >= 0 && _wfopen_s(&out, output, L"w, ccs=UTF-8") == 0) {
+        fwprintf(out, L"%s\n", header);
+        written = 0;
+        for (int i = 0; i < unique; i++) {
+            fwprintf(out, L"%s\n", rows[i]);
+            written++;
+        }
+        fclose(out);
+    }
+
+    free_string_list(rows, n);
+    free(header);
+    return written;
+}
+
+// --- [新增] 并行路由追踪 ---
+// 所有目标的各跳探测同时在途；中间节点的归属地在全部结果返回后按去重地址统一查询一次
+#define TRACE_FALLBACK_THREADS 64     // 不超过 WaitForMultipleObjects 的上限 64
+
+typedef struct {
+    unsigned int addr;              // 应答节点 (网络字节序)，0 = 无应答
+    unsigned int rttUs;
+    int reached;                    // 应答来自目标本身
+} TraceHop;
+
+typedef struct {
+    const ProbeTarget* targets;
+    int hostCount;
+    int timeoutMs;
+    TraceHop* hops;                 // hostCount * TRACE_MAX_HOPS
+    volatile LONG* reachedAt;       // 已知到达目标的最小 TTL，回退路径据此跳过更远的探测
+    volatile LONG nextProbe;
+    HWND hwnd;
+} TraceJob;
+
+typedef struct {
+    unsigned int addr;
+    wchar_t location[128];
+} TraceLocation;
+
+static void on_trace_hop(void* ctx, int target, int ttl, unsigned int hop, unsigned long long rttUs, int reached) {
+    TraceJob* job = (TraceJob*)ctx;
+    TraceHop* h = &job->hops[target * TRACE_MAX_HOPS + ttl - 1];
+    h->addr = hop;
+    h->rttUs = rttUs < 0xFFFFFFFFULL ? (unsigned int)rttUs : 0xFFFFFFFFu;
+    h->reached = reached;
+}
+
+// 无原始 socket 权限时：多线程并发 IcmpSendEcho，每个请求带各自的 TTL
+static unsigned int __stdcall trace_fallback_worker(void* arg) {
+    TraceJob* job = (TraceJob*)arg;
+    for (;;) {
+        int probe = (int)InterlockedIncrement(&job->nextProbe) - 1;
+        if (probe >= job->hostCount * TRACE_MAX_HOPS || g_stopSignal) break;
+        int target = probe / TRACE_MAX_HOPS, ttl = probe % TRACE_MAX_HOPS + 1;
+        const ProbeTarget* t = &job->targets[target];
+        LONG known = job->reachedAt[target];
+        if (t->family == 4 && (known == 0 || ttl <= known)) {
+            unsigned long hop = 0;
+            long rtt = 0;
+            int ret = ipv4_trace_hop(t->addr.v4.sin_addr.s_addr, ttl, job->timeoutMs, &hop, &rtt);
+            if (ret) on_trace_hop(job, target, ttl, (unsigned int)hop, (unsigned long long)rtt * 1000, ret == 2);
+            // 记录到达目标的最小 TTL
+            while (ret == 2 && ((known = job->reachedAt[target]) == 0 || ttl < known)) {
+                if (InterlockedCompareExchange(&job->reachedAt[target], ttl, known) == known) break;
+            }
+        }
+        metrics_add(METRIC_WORK_DONE, 1);
+    }
+    return 0;
+}
+
+static int compare_trace_location(const void* a, const void* b) {
+    unsigned int x = ((const TraceLocation*)a)->addr, y = ((const TraceLocation*)b)->addr;
+    return (x > y) - (x < y);
+}
+
+unsigned int __stdcall thread_trace(void* arg) {
+    ThreadParams* p = (ThreadParams*)arg;
+    HWND hwnd = p->hwndNotify;
+    int count;
+    wchar_t** hosts = split_hosts(&p->arena, p->targetInput, &count);
+    ProbeTarget* targets = (ProbeTarget*)calloc(count ? count : 1, sizeof(ProbeTarget));
+    TraceHop* hops = (TraceHop*)calloc((size_t)(count ? count : 1) * TRACE_MAX_HOPS, sizeof(TraceHop));
+    LONG* reachedAt = (LONG*)calloc(count ? count : 1, sizeof(LONG));
+    int* pathLen = (int*)calloc(count ? count : 1, sizeof(int));
+    TraceLocation* locations = NULL;
+    int locationCount = 0;
+    wchar_t finishMsg[128] = L"路由追踪失败：内存不足。";
+    if (!targets || !hops || !reachedAt || !pathLen) goto cleanup;
+
+    post_log(hwnd, 0, L"正在解析目标地址...");
+    for (int i = 0; i < count && !g_stopSignal; i++) {
+        targets[i].family = resolve_host(hosts[i], &targets[i].addr);
+    }
+
+    TraceJob job = {0};
+    job.targets = targets;
+    job.hostCount = count;
+    job.timeoutMs = p->timeoutMs > 0 ? p->timeoutMs : 1000;
+    job.hops = hops;
+    job.reachedAt = reachedAt;
+    job.hwnd = hwnd;
+
+    // 模式沿用界面选项：填写了 TCP Ping 端口用 TCP SYN，勾选 UDP 用 UDP，否则 ICMP
+    TraceConfig cfg = {0};
+    cfg.targets = targets;
+    cfg.targetCount = count;
+    cfg.mode = p->tcpingPort > 0 ? TRACE_TCP : p->udpScan ? TRACE_UDP : TRACE_ICMP;
+    cfg.port = p->tcpingPort;
+    cfg.maxHops = TRACE_MAX_HOPS;
+    cfg.timeoutMs = job.timeoutMs;
+    cfg.onHop = on_trace_hop;
+    cfg.ctx = &job;
+    post_log(hwnd, 0, cfg.mode == TRACE_TCP ? L"正在并行追踪路由 (TCP SYN)..." :
+                      cfg.mode == TRACE_UDP ? L"正在并行追踪路由 (UDP)..." : L"正在并行追踪路由 (ICMP)...");
+    if (!g_stopSignal && trace_run(&cfg) < 0) {
+        post_log(hwnd, 0, L"原始套接字不可用 (需管理员权限)，改用系统 ICMP 接口并发追踪...");
+        metrics_add(METRIC_WORK_TOTAL, (long long)count * TRACE_MAX_HOPS);
+        HANDLE workers[TRACE_FALLBACK_THREADS];
+        int started = 0;
+        for (int i = 0; i < TRACE_FALLBACK_THREADS && i < count * TRACE_MAX_HOPS; i++) {
+            HANDLE h = (HANDLE)_beginthreadex(NULL, 0, trace_fallback_worker, &job, 0, NULL);
+            if (h) workers[started++] = h;
+        }
+        if (started > 0) WaitForMultipleObjects(started, workers, TRUE, INFINITE);
+        for (int i = 0; i < started; i++) CloseHandle(workers[i]);
+    }
+    if (g_stopSignal) goto cleanup;
+
+    // 各目标的路径长度：到达目标的最小 TTL，未到达则截到最后一个有应答的节点
+    for (int i = 0; i < count; i++) {
+        int len = 0;
+        for (int ttl = 1; ttl <= TRACE_MAX_HOPS; ttl++) {
+            const TraceHop* h = &hops[i * TRACE_MAX_HOPS + ttl - 1];
+            if (h->reached) { len = ttl; break; }
+            if (h->addr) len = ttl;
+        }
+        pathLen[i] = len;
+    }
+
+    // 去重后统一查询归属地，多个目标共享的前几跳只查一次
+    if (p->showLocation) {
+        ipv4_init_qqwry();
+        locations = (TraceLocation*)malloc(sizeof(TraceLocation) * (size_t)(count ? count : 1) * TRACE_MAX_HOPS);
+        for (int i = 0; locations && i < count; i++) {
+            for (int ttl = 1; ttl <= pathLen[i]; ttl++) {
+                unsigned int addr = hops[i * TRACE_MAX_HOPS + ttl - 1].addr;
+                if (addr) locations[locationCount++].addr = addr;
+            }
+        }
+        if (locations) qsort(locations, locationCount, sizeof(TraceLocation), compare_trace_location);
+        int unique = 0;
+        for (int i = 0; i < locationCount; i++) {
+            if (unique > 0 && locations[unique - 1].addr == locations[i].addr) continue;
+            struct in_addr a;
+            a.s_addr = locations[i].addr;
+            locations[unique].addr = locations[i].addr;
+            locations[unique].location[0] = 0;
+            ipv4_get_location(inet_ntoa(a), locations[unique].location, 128);
+            unique++;
+        }
+        locationCount = unique;
+        ipv4_cleanup_qqwry();
+    }
+
+    int reachedCount = 0;
+    for (int i = 0; i < count; i++) {
+        if (targets[i].family != 4) {
+            post_result(hwnd, hosts[i], L"-", targets[i].family ? L"暂不支持 IPv6" : L"无效地址", L"-", L"-", L"-");
+            continue;
+        }
+        for (int ttl = 1; ttl <= pathLen[i]; ttl++) {
+            const TraceHop* h = &hops[i * TRACE_MAX_HOPS + ttl - 1];
+            wchar_t ttlStr[8], node[64] = L"*", rtt[32] = L"超时";
+            const wchar_t* location = L"-";
+            swprintf_s(ttlStr, 8, L"%d", ttl);
+            if (h->addr) {
+                struct in_addr a;
+                a.s_addr = h->addr;
+                utf8_to_wide_buf(inet_ntoa(a), node, 64);
+                swprintf_s(rtt, 32, L"%.3f", h->rttUs / 1000.0);
+                TraceLocation key;
+                key.addr = h->addr;
+                TraceLocation* found = locationCount ? (TraceLocation*)bsearch(&key, locations, locationCount, sizeof(TraceLocation), compare_trace_location) : NULL;
+                if (found && found->location[0]) location = found->location;
+            }
+            post_result(hwnd, hosts[i], ttlStr, node, rtt, location, L"-");
+        }
+        if (pathLen[i] > 0 && hops[i * TRACE_MAX_HOPS + pathLen[i] - 1].reached) reachedCount++;
+        else post_result(hwnd, hosts[i], L"-", L"未到达目标", L"-", L"-", L"-");
+    }
+
+    swprintf_s(finishMsg, 128, L"路由追踪完成：%d / %d 个目标到达。", reachedCount, count);
+
+cleanup:
+    post_finish(hwnd, g_stopSignal ? L"任务已由用户中止。" : finishMsg);
+    free(targets);
+    free(hops);
+    free((void*)reachedAt);
+    free(pathLen);
+    free(locations);
+    free_thread_params(p);
+    return 0;
+}
+
+// --- [新增] 代理批量检测 ---
+// 候选格式 "host:port" 或 "[IPv6]:port"，经每个代理访问测试站点，按 握手 + 首字节 总耗时排序。
+// [修改] 测试站点可在界面指定 ("主机[:端口]"，端口默认 80)，便于在内网或离线环境检测
+
+#define PROXY_TEST_HOST     L"www.msftconnecttest.com"
+#define PROXY_TEST_PORT     80
+#define PROXY_TEST_INFLIGHT 256
+
+typedef struct {
+    int index;
+    int total;      // 握手 + 首字节，不可用时为 -1
+} ProxyRank;
+
+static int parse_proxy_candidate(const wchar_t* token, wchar_t* host, int hostLen, int* port) {
+    const wchar_t* sep;
+    if (token[0] == L'[') {
+        const wchar_t* end = wcschr(token, L']');
+        if (!end || end[1] != L':') return 0;
+        if (end - token - 1 >= hostLen) return 0;
+        wcsncpy_s(host, hostLen, token + 1, end - token - 1);
+        sep = end + 1;
+    } else {
+        sep = wcsrchr(token, L':');
+        if (!sep || sep - token >= hostLen) return 0;
+        wcsncpy_s(host, hostLen, token, sep - token);
+    }
+    *port = _wtoi(sep + 1);
+    return host[0] && *port > 0 && *port < 65536;
+}
+
+static void on_proxy_progress(void* ctx, int done, int total) {
+    if (done % 64 != 0 && done != total) return;
+    wchar_t msg[128];
+    swprintf_s(msg, 128, L"代理检测中：%d / %d 次握手尝试", done, total);
+    post_log((HWND)ctx, total ? done * 100 / total : 100, msg);
+}
+
+static int compare_proxy_rank(const void* a, const void* b) {
+    const ProxyRank* x = (const ProxyRank*)a;
+    const ProxyRank* y = (const ProxyRank*)b;
+    if ((x->total < 0) != (y->total < 0)) return x->total < 0 ? 1 : -1;
+    if (x->total != y->total) return x->total < y->total ? -1 : 1;
+    return x->index - y->index;
+}
+
+unsigned int __stdcall thread_proxy_test(void* arg) {
+    ThreadParams* p = (ThreadParams*)arg;
+    HWND hwnd = p->hwndNotify;
+    int tokenCount;
+    wchar_t** tokens = split_hosts(&p->arena, p->targetInput, &tokenCount);
+
+    wchar_t** hosts = (wchar_t**)calloc(tokenCount ? tokenCount : 1, sizeof(wchar_t*));
+    int* ports = (int*)calloc(tokenCount ? tokenCount : 1, sizeof(int));
+    ProbeTarget* proxies = (ProbeTarget*)calloc(tokenCount ? tokenCount : 1, sizeof(ProbeTarget));
+    ProxyCheckResult* results = (ProxyCheckResult*)calloc(tokenCount ? tokenCount : 1, sizeof(ProxyCheckResult));
+    ProxyRank* ranks = (ProxyRank*)calloc(tokenCount ? tokenCount : 1, sizeof(ProxyRank));
+    int count = 0, usable = 0;
+
+    // 测试站点：留空用默认站点，未写端口时用 80；SOCKS4 只能请求 IPv4 地址
+    wchar_t testHost[256] = PROXY_TEST_HOST;
+    char testHostA[256];
+    int testPort = PROXY_TEST_PORT;
+    const wchar_t* spec = p->proxyTestTarget;
+    while (spec && (*spec == L' ' || *spec == L'\t')) spec++;
+    if (spec && *spec) {
+        int ok = 1;
+        if (wcschr(spec, L':')) ok = parse_proxy_candidate(spec, testHost, 256, &testPort);
+        else wcsncpy_s(testHost, 256, spec, _TRUNCATE);
+        for (wchar_t* end = testHost + wcslen(testHost); end > testHost && (end[-1] == L' ' || end[-1] == L'\t'); ) *--end = 0;
+        if (!ok || !testHost[0]) {
+            post_finish(hwnd, L"代理测试目标格式应为 主机 或 主机:端口。");
+            goto cleanup;
+        }
+    }
+    struct sockaddr_in6 testAddr = {0};
+    if (resolve_host(testHost, &testAddr) != 4) {
+        wchar_t msg[320];
+        swprintf_s(msg, 320, L"无法把代理测试目标 %s 解析为 IPv4 地址，请检查网络、DNS 或更换测试目标。", testHost);
+        post_finish(hwnd, msg);
+        goto cleanup;
+    }
+    ((struct sockaddr_in*)&testAddr)->sin_port = htons((unsigned short)testPort);
+    testHostA[wide_to_utf8(testHost, testHostA, (int)sizeof(testHostA) - 1)] = 0;
+
+    post_log(hwnd, 0, L"正在解析候选代理...");
+    for (int i = 0; i < tokenCount && !g_stopSignal; i++) {
+        wchar_t host[256];
+        int port;
+        if (!parse_proxy_candidate(tokens[i], host, 256, &port)) continue;
+        int family = resolve_host(host, &proxies[count].addr);
+        if (!family) continue;
+        proxies[count].family = family;
+        if (family == 6) proxies[count].addr.v6.sin6_port = htons((unsigned short)port);
+        else proxies[count].addr.v4.sin_port = htons((unsigned short)port);
+        hosts[count] = arena_wcsdup(&p->arena, host);
+        ports[count] = port;
+        count++;
+    }
+    if (count == 0) {
+        post_finish(hwnd, g_stopSignal ? L"任务已由用户中止。" : L"没有可检测的代理 (格式应为 地址:端口)。");
+        goto cleanup;
+    }
+
+    ProxyCheckConfig cfg = {0};
+    cfg.proxies = proxies;
+    cfg.proxyCount = count;
+    cfg.testAddr = *(struct sockaddr_in*)&testAddr;
+    cfg.testHost = testHostA;
+    cfg.maxInFlight = PROXY_TEST_INFLIGHT;
+    cfg.timeoutMs = p->timeoutMs > 0 ? p->timeoutMs * 5 : 0;   // 含连接、握手和一次往返请求
+    cfg.onProgress = on_proxy_progress;
+    cfg.ctx = hwnd;
+    usable = proxy_check_run(&cfg, results);
+
+    for (int i = 0; i < count; i++) {
+        ranks[i].index = i;
+        ranks[i].total = results[i].protocol ? results[i].handshakeMs + results[i].firstByteMs : -1;
+    }
+    qsort(ranks, count, sizeof(ProxyRank), compare_proxy_rank);
+
+    for (int i = 0; i < count; i++) {
+        const ProxyCheckResult* r = &results[ranks[i].index];
+        wchar_t portStr[16], handshake[16], firstByte[16], total[16];
+        swprintf_s(portStr, 16, L"%d", ports[ranks[i].index]);
+        if (!r->protocol) {
+            post_result(hwnd, hosts[ranks[i].index], portStr, L"不可用", L"-", L"-", L"-");
+            continue;
+        }
+        swprintf_s(handshake, 16, L"%d", r->handshakeMs);
+        swprintf_s(firstByte, 16, L"%d", r->firstByteMs);
+        swprintf_s(total, 16, L"%d", ranks[i].total);
+        // [修改] 最快的协议在前，其后列出其余通过握手的协议 (设置系统代理时据此判断能否使用 SOCKS4)
+        static const int order[] = { PROXY_HTTP, PROXY_SOCKS5, PROXY_SOCKS4 };
+        static const wchar_t* names[] = { L"", L"HTTP", L"SOCKS5", L"SOCKS4" };
+        wchar_t proto[32];
+        int len = swprintf_s(proto, 32, L"%s", names[r->protocol]);
+        for (int k = 0; k < 3; k++) {
+            if (order[k] != r->protocol && (r->protocols & PROXY_BIT(order[k]))) len += swprintf_s(proto + len, 32 - len, L"/%s", names[order[k]]);
+        }
+        post_result(hwnd, hosts[ranks[i].index], portStr, proto, handshake, firstByte, total);
+    }
+
     if (g_stopSignal) post_finish(hwnd, L"任务已由用户中止。");
-    else post_finish(hwnd, L"批量端口扫描完成。");
+    else {
+        wchar_t msg[128];
+        swprintf_s(msg, 128, L"代理检测完成：%d / %d 可用，已按总延迟排序 (首行最快)。", usable, count);
+        post_finish(hwnd, msg);
+    }
+
+cleanup:
+    free(hosts);
+    free(ports);
+    free(proxies);
+    free(results);
+    free(ranks);
+    free_thread_params(p);
     return 0;
 }
 
+typedef struct {
+    HWND hwnd;
+    int showLocation;
+} ExtractJob;
+
+// 提取结果只含 ASCII，在投递到界面时才转为宽字符
+static void on_extract_match(void* ctx, const char* value, int kind) {
+    ExtractJob* job = (ExtractJob*)ctx;
+    wchar_t text[256];
+    utf8_to_wide_buf(value, text, 256);
+    if (kind == EXTRACT_IPV4) {
+        wchar_t location[256] = {0};
+        if (job->showLocation) ipv4_get_location(value, location, 256);
+        post_result(job->hwnd, text, location, L"", L"", L"", L"");
+    } else if (kind == EXTRACT_IPV6) {
+        post_result(job->hwnd, text, L"N/A", L"", L"", L"", L"");
+    } else {
+        post_result(job->hwnd, text, L"域名/主机名", L"", L"", L"", L"");
+    }
+}
+
 unsigned int __stdcall thread_extract_ip(void* arg) {
     ThreadParams* p = (ThreadParams*)arg;
     HWND hwnd = p->hwndNotify;
@@ -311,17 +1627,19 @@ unsigned int __stdcall thread_extract_ip(void* arg) {
     if (p->showLocation) ipv4_init_qqwry();
 
     post_log(hwnd, 0, L"正在分析文本 (IPv4 / IPv6 / 域名)...");
+    ExtractJob job = { hwnd, p->showLocation };
+    if (!p->textInput) goto cleanup;
     
     // 1. 提取 IPv4
-    ipv4_extract_search(p->targetInput, hwnd, p->showLocation);
+    extract_ipv4(p->textInput, on_extract_match, &job);
     if (g_stopSignal) goto cleanup;
 
     // 2. 提取 IPv6
-    ipv6_extract_search(p->targetInput, hwnd);
+    extract_ipv6(p->textInput, on_extract_match, &job);
     if (g_stopSignal) goto cleanup;
 
     // 3. 提取 域名
-    domain_extract_search(p->targetInput, hwnd);
+    extract_domains(p->textInput, on_extract_match, &job);
 
 cleanup:
     if (p->showLocation) ipv4_cleanup_qqwry();
@@ -334,6 +1652,7 @@ cleanup:
 
 unsigned int __stdcall thread_single_scan(void* arg) {
     // 单个扫描复用端口扫描逻辑
+    ((ThreadParams*)arg)->singleScan = 1;
     return thread_port_scan(arg); 
 }
 
@@ -341,6 +1660,9 @@ void free_thread_params(ThreadParams* params) {
     if (params) {
         if (params->targetInput) free(params->targetInput);
         if (params->portsInput) free(params->portsInput);
+        free(params->proxyTestTarget);
+        free(params->textInput);
+        arena_free(&params->arena);
         free(params);
     }
 }
@@ -381,14 +1703,12 @@ void proxy_init_backup() {
     }
 }
 
-int proxy_set_system(const wchar_t* ip, int port) {
+static int proxy_write_server(const wchar_t* server) {
     proxy_init_backup();
     HKEY hKey = open_internet_settings(KEY_WRITE);
     if (!hKey) return 0;
 
     DWORD enable = 1;
-    wchar_t server[128];
-    swprintf_s(server, 128, L"%s:%d", ip, port);
 
     RegSetValueExW(hKey, L"ProxyEnable", 0, REG_DWORD, (BYTE*)&enable, sizeof(enable));
     RegSetValueExW(hKey, L"ProxyServer", 0, REG_SZ, (BYTE*)server, (wcslen(server) + 1) * sizeof(wchar_t));
@@ -398,6 +1718,19 @@ int proxy_set_system(const wchar_t* ip, int port) {
     return 1;
 }
 
+int proxy_set_system(const wchar_t* ip, int port) {
+    wchar_t server[128];
+    swprintf_s(server, 128, L"%s:%d", ip, port);
+    return proxy_write_server(server);
+}
+
+// [新增] WinINet 仅对 "socks=" 前缀的条目走 SOCKS (按 SOCKS4 协议使用)
+int proxy_set_system_socks(const wchar_t* ip, int port) {
+    wchar_t server[128];
+    swprintf_s(server, 128, L"socks=%s:%d", ip, port);
+    return proxy_write_server(server);
+}
+
 int proxy_unset_system() {
     if (!g_hasBackup) return 1;
     HKEY hKey = open_internet_settings(KEY_WRITE);
@@ -4,26 +4,48 @@
 #include <winsock2.h>
 #include <windows.h>
 #include <tchar.h>
+#include "network_modules.h"
 
 // 消息定义
 #define WM_USER_LOG     (WM_USER + 100) 
 #define WM_USER_RESULT  (WM_USER + 101) 
 #define WM_USER_FINISH  (WM_USER + 102) 
+#define WM_USER_UPDATE  (WM_USER + 103) // [新增] 原地刷新已有行："行号|列2|列3...\n" 多行批量
 
 typedef enum {
     TASK_PING = 1,
     TASK_SCAN,
     TASK_SINGLE_SCAN,
-    TASK_EXTRACT
+    TASK_EXTRACT,
+    TASK_PROXY_TEST,  // [新增] 批量检测代理可用性与延迟
+    TASK_TRACE        // [新增] 并行路由追踪
 } TaskType;
 
 typedef struct {
     HWND hwndNotify;
     wchar_t* targetInput;  
+    char* textInput;       // [新增] 文本提取的输入 (UTF-8)，文件内容不经转换直接使用
     wchar_t* portsInput;   
     int retryCount;
+    int tcpingPort;   // [新增] 批量 Ping 时 >0 表示改用 TCP 握手测延迟 (tcping) 的目标端口
+    int monitorIntervalMs; // [新增] >0 时批量 Ping 转为持续监控，按此间隔反复探测直到中止
     int timeoutMs;
+    int minTimeoutMs; // [新增] 端口扫描按 RTT 自适应超时的下限 (上限为 timeoutMs)
     int showLocation; 
+    int udpScan;      // [新增] UDP 扫描模式 (按端口发送协议载荷)
+    int serviceDetect;// [新增] 对开放端口抓取 Banner 并识别服务
+    int singleScan;   // 单目标扫描：服务识别结果直接填入 "服务/备注" 列
+    int pps;          // [新增] 端口扫描发包速率上限 (每秒探测数，0 为不限)
+    unsigned long long scanSeed; // [新增] 探测顺序的置换种子，0 表示随机
+    int resume;       // [新增] 从上次中止的断点继续批量扫描
+    int hostDiscovery;// [新增] 端口扫描前先探测存活主机，只扫描在线主机
+    int shardIndex;   // [新增] 多机分片：本机负责第 shardIndex 片 (从 0 开始)
+    int shardCount;   //        共 shardCount 片，0 或 1 表示不分片
+    int subnetCap;    // [新增] 同一 /24 (IPv6 为 /64) 网段的最大并发探测数，0 为不限
+    ProbeSources* sources; // [新增] 探测源地址 (取自 arena)，NULL 表示由系统选择
+    int deltaScan;    // [新增] 增量扫描：与该目标上次的快照对比，只报告变化 (不续扫、不分片)
+    wchar_t* proxyTestTarget; // [新增] 代理检测的测试目标 "主机[:端口]"，为空时使用默认站点
+    Arena arena;      // [新增] 任务期间的目标拆分与中间字符串，free_thread_params 时整体释放
 } ThreadParams;
 
 // 任务控制
@@ -32,18 +54,25 @@ void reset_stop_task();
 
 // 代理管理
 int proxy_set_system(const wchar_t* ip, int port);
+int proxy_set_system_socks(const wchar_t* ip, int port); // [新增] 以 SOCKS 代理方式写入系统设置
 int proxy_unset_system();
 void proxy_init_backup(); 
 
 // 线程入口
 unsigned int __stdcall thread_ping(void* arg);
 unsigned int __stdcall thread_port_scan(void* arg);
+int port_scan_can_resume(const ThreadParams* p);   // [新增] 存在同一任务的扫描断点时返回 1
+int merge_result_files(const wchar_t** inputs, int count, const wchar_t* output); // [新增] 合并分片导出的 CSV 并按 地址+端口 去重，返回行数，失败返回 -1
 unsigned int __stdcall thread_single_scan(void* arg);
+unsigned int __stdcall thread_trace(void* arg);      // [新增] 并行路由追踪 (各跳同时探测)
+unsigned int __stdcall thread_proxy_test(void* arg); // [新增] 并发检测候选代理并按延迟排序
 unsigned int __stdcall thread_extract_ip(void* arg);
 
 void free_thread_params(ThreadParams* params);
 
 // UI 辅助
 void post_result(HWND hwnd, const wchar_t* col1, const wchar_t* col2, const wchar_t* col3, const wchar_t* col4, const wchar_t* col5, const wchar_t* col6);
+void post_message(HWND hwnd, UINT msg, WPARAM wParam, const wchar_t* text); // [新增] 复制文本后投递，计入界面队列深度
+void free_message(wchar_t* text);   // [新增] 界面处理完 WM_USER_* 消息后归还文本 (取自对象池)
 
 #endif // NETWORK_TOOLS_H
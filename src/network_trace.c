@@ -0,0 +1,295 @@
+#include "network_modules.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// --- 并行路由追踪 ---
+// 不再逐跳等待：每个目标的 1..maxHops 各 TTL 探测同时发出，
+// 由一个原始 ICMP socket 统一接收超时 (Time Exceeded) / 不可达 / 回显应答，
+// 按报文中引用的原始头部 (ICMP 序号或本地源端口) 找回对应的 目标 + TTL。
+// TCP 模式用带 TTL 的非阻塞 connect 发出 SYN，Windows 上同样可用。
+
+#define TRACE_DEFAULT_INFLIGHT 512
+#define TRACE_DEFAULT_TIMEOUT  2000
+#define TRACE_ICMP_ID_SALT     0x4E54
+#define TRACE_TICK_MS          20
+
+#define ICMP_ECHO_REPLY_TYPE   0
+#define ICMP_UNREACH_TYPE      3
+#define ICMP_ECHO_TYPE         8
+#define ICMP_TIME_EXCEEDED     11
+
+typedef struct {
+    SOCKET sock;                    // UDP / TCP 模式下每个探测独占的 socket
+    int probe;                      // 探测编号 = 目标 * maxHops + (TTL - 1)
+    unsigned short key;             // ICMP 序号或本地源端口
+    unsigned long long sentUs;
+    unsigned long long deadline;    // 毫秒
+} TraceSlot;
+
+typedef struct {
+    const TraceConfig* cfg;
+    SOCKET raw;
+    unsigned short icmpId;
+    TraceSlot* slots;
+    int inFlight;
+    int maxInFlight;
+    int nextProbe;
+    int totalProbes;
+    int* owner;                     // key -> 在途槽位下标 + 1 (0 表示空闲)
+} Tracer;
+
+static unsigned short icmp_checksum(const unsigned char* data, int len) {
+    unsigned int sum = 0;
+    for (int i = 0; i + 1 < len; i += 2) sum += (unsigned int)((data[i] << 8) | data[i + 1]);
+    if (len & 1) sum += (unsigned int)(data[len - 1] << 8);
+    while (sum >> 16) sum = (sum & 0xFFFF) + (sum >> 16);
+    return htons((unsigned short)~sum);
+}
+
+static void trace_release(Tracer* t, int idx) {
+    TraceSlot* s = &t->slots[idx];
+    if (s->sock != INVALID_SOCKET) closesocket(s->sock);
+    t->owner[s->key] = 0;
+    t->inFlight--;
+    if (idx != t->inFlight) {
+        t->slots[idx] = t->slots[t->inFlight];
+        t->owner[t->slots[idx].key] = idx + 1;
+    }
+}
+
+static void trace_report(Tracer* t, int idx, unsigned int hop, int reached, unsigned long long nowUs) {
+    const TraceConfig* cfg = t->cfg;
+    const TraceSlot* s = &t->slots[idx];
+    if (cfg->onHop) {
+        cfg->onHop(cfg->ctx, s->probe / cfg->maxHops, s->probe % cfg->maxHops + 1, hop,
+                   nowUs > s->sentUs ? nowUs - s->sentUs : 0, reached);
+    }
+    trace_release(t, idx);
+}
+
+// 发出一个探测；返回 0 表示本地资源不足，应稍后重试
+static int trace_launch(Tracer* t, int probe) {
+    const TraceConfig* cfg = t->cfg;
+    const struct sockaddr_in* dst = &cfg->targets[probe / cfg->maxHops].addr.v4;
+    int ttl = probe % cfg->maxHops + 1;
+    TraceSlot* s = &t->slots[t->inFlight];
+    s->sock = INVALID_SOCKET;
+    s->probe = probe;
+
+    if (cfg->mode == TRACE_ICMP) {
+        // 序号取探测编号的低 16 位：在途探测数远小于 65536，不会冲突
+        unsigned short seq = (unsigned short)(probe & 0xFFFF);
+        if (t->owner[seq]) return 0;
+        unsigned char pkt[16] = {0};
+        pkt[0] = ICMP_ECHO_TYPE;
+        pkt[4] = (unsigned char)(t->icmpId >> 8); pkt[5] = (unsigned char)(t->icmpId & 0xFF);
+        pkt[6] = (unsigned char)(seq >> 8);       pkt[7] = (unsigned char)(seq & 0xFF);
+        memcpy(pkt + 8, "NetTrace", 8);
+        unsigned short sum = icmp_checksum(pkt, sizeof(pkt));
+        memcpy(pkt + 2, &sum, 2);
+        setsockopt(t->raw, IPPROTO_IP, IP_TTL, (const char*)&ttl, sizeof(ttl));
+        s->sentUs = platform_tick_us();
+        sendto(t->raw, (const char*)pkt, sizeof(pkt), 0, (const struct sockaddr*)dst, sizeof(*dst));
+        s->key = seq;
+    } else {
+        int isUdp = (cfg->mode == TRACE_UDP);
+        SOCKET sock = socket(AF_INET, isUdp ? SOCK_DGRAM : SOCK_STREAM, isUdp ? IPPROTO_UDP : IPPROTO_TCP);
+        if (sock == INVALID_SOCKET) return 0;
+        platform_set_nonblock(sock);
+        setsockopt(sock, IPPROTO_IP, IP_TTL, (const char*)&ttl, sizeof(ttl));
+
+        // 先绑定以取得源端口，引用的 UDP / TCP 头部据此对应到探测
+        struct sockaddr_in local = {0};
+        socklen_t len = sizeof(local);
+        local.sin_family = AF_INET;
+        if (bind(sock, (struct sockaddr*)&local, sizeof(local)) == SOCKET_ERROR ||
+            getsockname(sock, (struct sockaddr*)&local, &len) == SOCKET_ERROR ||
+            t->owner[ntohs(local.sin_port)]) {
+            closesocket(sock);
+            return 0;
+        }
+
+        struct sockaddr_in to = *dst;
+        to.sin_port = htons((unsigned short)(isUdp ? cfg->port + ttl - 1 : cfg->port));
+        s->sentUs = platform_tick_us();
+        if (isUdp) {
+            sendto(sock, "NetTrace", 8, PLATFORM_SEND_FLAGS, (struct sockaddr*)&to, sizeof(to));
+        } else if (connect(sock, (struct sockaddr*)&to, sizeof(to)) == SOCKET_ERROR) {
+            int err = platform_last_error();
+            if (err != WSAEWOULDBLOCK && err != WSAEINPROGRESS && err != WSAECONNREFUSED) {
+                closesocket(sock);
+                return 0;
+            }
+        }
+        s->sock = sock;
+        s->key = ntohs(local.sin_port);
+    }
+
+    s->deadline = platform_tick_ms() + cfg->timeoutMs;
+    t->owner[s->key] = ++t->inFlight;
+    return 1;
+}
+
+// 解析一个 ICMP 报文 (含 IP 头)，命中在途探测时上报
+static void trace_receive(Tracer* t, const unsigned char* buf, int n, unsigned long long nowUs) {
+    if (n < 20) return;
+    int ihl = (buf[0] & 0x0F) * 4;
+    if (n < ihl + 8) return;
+    const unsigned char* icmp = buf + ihl;
+    unsigned int from;
+    memcpy(&from, buf + 12, 4);
+
+    if (icmp[0] == ICMP_ECHO_REPLY_TYPE) {
+        if (t->cfg->mode != TRACE_ICMP) return;
+        unsigned short id = (unsigned short)((icmp[4] << 8) | icmp[5]);
+        unsigned short seq = (unsigned short)((icmp[6] << 8) | icmp[7]);
+        if (id != t->icmpId || !t->owner[seq]) return;
+        trace_report(t, t->owner[seq] - 1, from, 1, nowUs);
+        return;
+    }
+    if (icmp[0] != ICMP_TIME_EXCEEDED && icmp[0] != ICMP_UNREACH_TYPE) return;
+
+    // 引用的原始报文：IP 头 + 至少 8 字节传输层头
+    const unsigned char* inner = icmp + 8;
+    if (n < ihl + 8 + 20) return;
+    int innerIhl = (inner[0] & 0x0F) * 4;
+    if (n < ihl + 8 + innerIhl + 8) return;
+    const unsigned char* l4 = inner + innerIhl;
+    unsigned short key;
+    switch (inner[9]) {
+    case IPPROTO_ICMP:
+        if (t->cfg->mode != TRACE_ICMP || ((l4[4] << 8) | l4[5]) != t->icmpId) return;
+        key = (unsigned short)((l4[6] << 8) | l4[7]);
+        break;
+    case IPPROTO_UDP:
+        if (t->cfg->mode != TRACE_UDP) return;
+        key = (unsigned short)((l4[0] << 8) | l4[1]);
+        break;
+    case IPPROTO_TCP:
+        if (t->cfg->mode != TRACE_TCP) return;
+        key = (unsigned short)((l4[0] << 8) | l4[1]);
+        break;
+    default:
+        return;
+    }
+    int slot = t->owner[key] - 1;
+    if (slot < 0) return;
+    const TraceConfig* cfg = t->cfg;
+    if (memcmp(inner + 16, &cfg->targets[t->slots[slot].probe / cfg->maxHops].addr.v4.sin_addr, 4) != 0) return;
+
+    // 超时报文来自中间节点；目标自身返回的不可达 (如 UDP 端口不可达) 表示已到达
+    trace_report(t, slot, from, icmp[0] == ICMP_UNREACH_TYPE && memcmp(&from, inner + 16, 4) == 0, nowUs);
+}
+
+int trace_available() {
+    SOCKET s = socket(AF_INET, SOCK_RAW, IPPROTO_ICMP);
+    if (s == INVALID_SOCKET) return 0;
+    closesocket(s);
+    return 1;
+}
+
+int trace_run(const TraceConfig* cfg) {
+    if (!cfg || cfg->targetCount <= 0 || cfg->maxHops <= 0 || cfg->maxHops > 255) return 0;
+
+    TraceConfig local = *cfg;
+    if (local.timeoutMs <= 0) local.timeoutMs = TRACE_DEFAULT_TIMEOUT;
+    if (local.mode != TRACE_ICMP && local.port <= 0) local.port = local.mode == TRACE_UDP ? 33434 : 80;
+
+    Tracer t;
+    memset(&t, 0, sizeof(t));
+    t.cfg = &local;
+    t.totalProbes = cfg->targetCount * cfg->maxHops;
+    t.maxInFlight = cfg->maxInFlight > 0 ? cfg->maxInFlight : TRACE_DEFAULT_INFLIGHT;
+    if (local.mode == TRACE_TCP && t.maxInFlight > FD_SETSIZE - 16) t.maxInFlight = FD_SETSIZE - 16;
+    if (t.maxInFlight > 32768) t.maxInFlight = 32768;
+    t.icmpId = (unsigned short)((platform_tick_us() & 0xFFFF) ^ TRACE_ICMP_ID_SALT);
+
+    // 接收 ICMP 需要原始 socket (Windows 需管理员，Linux 需 CAP_NET_RAW)
+    t.raw = socket(AF_INET, SOCK_RAW, IPPROTO_ICMP);
+    if (t.raw == INVALID_SOCKET) return -1;
+    struct sockaddr_in any = {0};
+    any.sin_family = AF_INET;
+    bind(t.raw, (struct sockaddr*)&any, sizeof(any));   // Windows 的原始 socket 须绑定后才能接收
+    platform_set_nonblock(t.raw);
+
+    t.slots = (TraceSlot*)malloc(sizeof(TraceSlot) * t.maxInFlight);
+    t.owner = (int*)calloc(65536, sizeof(int));
+    if (!t.slots || !t.owner) {
+        free(t.slots);
+        free(t.owner);
+        closesocket(t.raw);
+        return -1;
+    }
+
+    int completed = 0;
+    while (!is_task_stopped()) {
+        // 按目标顺序发出，同一目标的所有 TTL 同时在途
+        while (t.inFlight < t.maxInFlight && t.nextProbe < t.totalProbes) {
+            const ProbeTarget* target = &cfg->targets[t.nextProbe / cfg->maxHops];
+            if (target->family != 4) { t.nextProbe++; continue; }   // 仅支持 IPv4
+            if (!trace_launch(&t, t.nextProbe)) break;
+            t.nextProbe++;
+        }
+        if (t.inFlight == 0 && t.nextProbe >= t.totalProbes) break;
+
+        fd_set readFds, writeFds, exceptFds;
+        FD_ZERO(&readFds);
+        FD_ZERO(&writeFds);
+        FD_ZERO(&exceptFds);
+        FD_SET(t.raw, &readFds);
+        SOCKET maxFd = t.raw;
+        if (local.mode == TRACE_TCP) {
+            for (int i = 0; i < t.inFlight; i++) {
+                FD_SET(t.slots[i].sock, &writeFds);
+                FD_SET(t.slots[i].sock, &exceptFds);
+                if (t.slots[i].sock > maxFd) maxFd = t.slots[i].sock;
+            }
+        }
+        struct timeval tv;
+        tv.tv_sec = 0;
+        tv.tv_usec = TRACE_TICK_MS * 1000;
+        int ret = select((int)maxFd + 1, &readFds, &writeFds, &exceptFds, &tv);
+        unsigned long long nowUs = platform_tick_us();
+
+        if (ret > 0 && FD_ISSET(t.raw, &readFds)) {
+            unsigned char buf[1500];
+            int n;
+            while ((n = recv(t.raw, (char*)buf, sizeof(buf), 0)) > 0) {
+                int before = t.inFlight;
+                trace_receive(&t, buf, n, nowUs);
+                completed += before - t.inFlight;
+            }
+        }
+
+        unsigned long long now = platform_tick_ms();
+        for (int i = t.inFlight - 1; i >= 0; i--) {
+            TraceSlot* s = &t.slots[i];
+            if (ret > 0 && local.mode == TRACE_TCP &&
+                (FD_ISSET(s->sock, &writeFds) || FD_ISSET(s->sock, &exceptFds))) {
+                // 握手完成或被 RST 都说明 SYN 已到达目标
+                int err = 0;
+                socklen_t len = sizeof(err);
+                getsockopt(s->sock, SOL_SOCKET, SO_ERROR, (char*)&err, &len);
+                if (err == 0 || err == WSAECONNREFUSED) {
+                    unsigned int hop = cfg->targets[s->probe / cfg->maxHops].addr.v4.sin_addr.s_addr;
+                    trace_report(&t, i, hop, 1, nowUs);
+                } else {
+                    trace_release(&t, i);   // 其他错误 (如主机不可达) 视为本跳无应答
+                }
+                completed++;
+                continue;
+            }
+            if (now >= s->deadline) {
+                trace_release(&t, i);
+                completed++;
+            }
+        }
+    }
+
+    while (t.inFlight > 0) trace_release(&t, t.inFlight - 1);
+    closesocket(t.raw);
+    free(t.slots);
+    free(t.owner);
+    return completed;
+}
@@ -0,0 +1,58 @@
+#include "network_modules.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// --- UDP 服务探测载荷 ---
+// UDP 服务通常只回应合法请求，空报文多半石沉大海；
+// 因此对常见端口发送各自协议的最小请求，其余端口发送空报文 (仍可依赖 ICMP 判定关闭)。
+
+typedef struct {
+    int port;
+    const char* data;
+    int len;
+} UdpPayload;
+
+#define PAYLOAD(port, lit) { port, lit, (int)sizeof(lit) - 1 }
+
+static const UdpPayload g_udpPayloads[] = {
+    // DNS: version.bind CH TXT 查询，拒绝应答同样说明端口开放
+    PAYLOAD(53, "\x12\x34\x01\x00\x00\x01\x00\x00\x00\x00\x00\x00"
+                "\x07" "version" "\x04" "bind" "\x00" "\x00\x10\x00\x03"),
+    // NTP: v4 客户端请求 (mode 3)，48 字节
+    PAYLOAD(123, "\xe3\x00\x04\xfa\x00\x01\x00\x00\x00\x01\x00\x00"
+                 "\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"
+                 "\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"
+                 "\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"),
+    // NetBIOS-NS: "*" 节点状态查询
+    PAYLOAD(137, "\x80\xf0\x00\x10\x00\x01\x00\x00\x00\x00\x00\x00"
+                 "\x20" "CKAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA" "\x00\x00\x21\x00\x01"),
+    // SNMP: v1 GetRequest, community "public", sysDescr.0
+    PAYLOAD(161, "\x30\x29\x02\x01\x00\x04\x06" "public"
+                 "\xa0\x1c\x02\x04\x4e\x54\x50\x31\x02\x01\x00\x02\x01\x00"
+                 "\x30\x0e\x30\x0c\x06\x08\x2b\x06\x01\x02\x01\x01\x01\x00\x05\x00"),
+    // MS-SQL Browser
+    PAYLOAD(1434, "\x02"),
+    // SSDP: M-SEARCH 发现请求
+    PAYLOAD(1900, "M-SEARCH * HTTP/1.1\r\n"
+                  "HOST: 239.255.255.250:1900\r\n"
+                  "MAN: \"ssdp:discover\"\r\n"
+                  "MX: 1\r\n"
+                  "ST: ssdp:all\r\n\r\n"),
+    // mDNS: 服务枚举 PTR 查询
+    PAYLOAD(5353, "\x00\x00\x00\x00\x00\x01\x00\x00\x00\x00\x00\x00"
+                  "\x09" "_services" "\x07" "_dns-sd" "\x04" "_udp" "\x05" "local" "\x00"
+                  "\x00\x0c\x00\x01"),
+    // memcached: UDP 帧头 + stats 命令
+    PAYLOAD(11211, "\x00\x01\x00\x00\x00\x01\x00\x00" "stats\r\n"),
+};
+
+const char* udp_probe_payload(int port, int* len) {
+    for (size_t i = 0; i < sizeof(g_udpPayloads) / sizeof(g_udpPayloads[0]); i++) {
+        if (g_udpPayloads[i].port == port) {
+            *len = g_udpPayloads[i].len;
+            return g_udpPayloads[i].data;
+        }
+    }
+    *len = 0;
+    return "";
+}
@@ -0,0 +1,241 @@
+#include "network_modules.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <stdint.h>
+
+// --- io_uring 最小封装 ---
+// 直接使用系统调用 (不依赖 liburing)：提交队列与完成队列映射到用户态，
+// 一次 io_uring_enter 批量提交所有待发操作并收割完成事件。
+// 链接超时的 timespec 与 connect 的目标地址在提交前必须保持有效，按提交队列下标存放在环内。
+
+struct UringRing {
+    int fd;
+    unsigned features;
+    unsigned sqEntries;
+    unsigned* sqHead;
+    unsigned* sqTail;
+    unsigned* sqMask;
+    unsigned* sqArray;
+    struct io_uring_sqe* sqes;
+    unsigned sqLocalTail;           // 已填写但尚未发布给内核的尾指针
+    unsigned toSubmit;
+    unsigned* cqHead;
+    unsigned* cqTail;
+    unsigned* cqMask;
+    struct io_uring_cqe* cqes;
+    void* sqRing;
+    size_t sqRingSize;
+    void* cqRing;
+    size_t cqRingSize;
+    size_t sqesSize;
+    struct __kernel_timespec* ts;   // 与提交队列一一对应
+    struct sockaddr_in6* addrs;
+    unsigned char supported[IORING_OP_LAST];
+};
+
+static int uring_enter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags, void* arg, size_t argSize) {
+    int ret = (int)syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, arg, argSize);
+    return ret < 0 ? -errno : ret;
+}
+
+static void uring_probe_ops(UringRing* r) {
+    size_t size = sizeof(struct io_uring_probe) + IORING_OP_LAST * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe* probe = (struct io_uring_probe*)calloc(1, size);
+    if (!probe) return;
+    if (syscall(__NR_io_uring_register, r->fd, IORING_REGISTER_PROBE, probe, IORING_OP_LAST) == 0) {
+        for (int i = 0; i < probe->ops_len && i < IORING_OP_LAST; i++) {
+            if (probe->ops[i].flags & IO_URING_OP_SUPPORTED) r->supported[i] = 1;
+        }
+    }
+    free(probe);
+}
+
+UringRing* uring_create(unsigned entries) {
+    UringRing* r = (UringRing*)calloc(1, sizeof(UringRing));
+    if (!r) return NULL;
+    r->fd = -1;
+
+    // 单线程提交，允许内核延后处理任务；老内核不认识这些标志时退回默认设置
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    p.flags = IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN | IORING_SETUP_SINGLE_ISSUER;
+    r->fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+    if (r->fd < 0 && errno == EINVAL) {
+        memset(&p, 0, sizeof(p));
+        r->fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+    }
+    if (r->fd < 0) goto fail;
+
+    // 需要带超时的等待 (EXT_ARG) 与完成队列不丢事件 (NODROP)
+    r->features = p.features;
+    if (!(p.features & IORING_FEAT_EXT_ARG) || !(p.features & IORING_FEAT_NODROP)) goto fail;
+
+    r->sqRingSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    r->cqRingSize = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (r->cqRingSize > r->sqRingSize) r->sqRingSize = r->cqRingSize;
+        r->cqRingSize = r->sqRingSize;
+    }
+    r->sqRing = mmap(NULL, r->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQ_RING);
+    if (r->sqRing == MAP_FAILED) { r->sqRing = NULL; goto fail; }
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        r->cqRing = r->sqRing;
+    } else {
+        r->cqRing = mmap(NULL, r->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_CQ_RING);
+        if (r->cqRing == MAP_FAILED) { r->cqRing = NULL; goto fail; }
+    }
+    r->sqesSize = p.sq_entries * sizeof(struct io_uring_sqe);
+    r->sqes = (struct io_uring_sqe*)mmap(NULL, r->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES);
+    if (r->sqes == MAP_FAILED) { r->sqes = NULL; goto fail; }
+
+    char* sq = (char*)r->sqRing;
+    char* cq = (char*)r->cqRing;
+    r->sqEntries = p.sq_entries;
+    r->sqHead = (unsigned*)(sq + p.sq_off.head);
+    r->sqTail = (unsigned*)(sq + p.sq_off.tail);
+    r->sqMask = (unsigned*)(sq + p.sq_off.ring_mask);
+    r->sqArray = (unsigned*)(sq + p.sq_off.array);
+    r->cqHead = (unsigned*)(cq + p.cq_off.head);
+    r->cqTail = (unsigned*)(cq + p.cq_off.tail);
+    r->cqMask = (unsigned*)(cq + p.cq_off.ring_mask);
+    r->cqes = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+    r->sqLocalTail = *r->sqTail;
+
+    r->ts = (struct __kernel_timespec*)calloc(p.sq_entries, sizeof(struct __kernel_timespec));
+    r->addrs = (struct sockaddr_in6*)calloc(p.sq_entries, sizeof(struct sockaddr_in6));
+    if (!r->ts || !r->addrs) goto fail;
+
+    uring_probe_ops(r);
+    return r;
+
+fail:
+    uring_free(r);
+    return NULL;
+}
+
+void uring_free(UringRing* r) {
+    if (!r) return;
+    if (r->sqes) munmap(r->sqes, r->sqesSize);
+    if (r->cqRing && r->cqRing != r->sqRing) munmap(r->cqRing, r->cqRingSize);
+    if (r->sqRing) munmap(r->sqRing, r->sqRingSize);
+    if (r->fd >= 0) close(r->fd);
+    free(r->ts);
+    free(r->addrs);
+    free(r);
+}
+
+int uring_op_supported(const UringRing* r, int op) {
+    return op >= 0 && op < IORING_OP_LAST && r->supported[op];
+}
+
+// 提交队列剩余空间不足 n 个时先提交已填写的操作
+static int uring_reserve(UringRing* r, unsigned n) {
+    if (r->sqLocalTail - __atomic_load_n(r->sqHead, __ATOMIC_ACQUIRE) + n <= r->sqEntries) return 1;
+    uring_submit(r, 0);
+    return r->sqLocalTail - __atomic_load_n(r->sqHead, __ATOMIC_ACQUIRE) + n <= r->sqEntries;
+}
+
+static struct io_uring_sqe* uring_next_sqe(UringRing* r, unsigned* slot) {
+    unsigned idx = r->sqLocalTail & *r->sqMask;
+    struct io_uring_sqe* sqe = &r->sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    r->sqArray[idx] = idx;
+    r->sqLocalTail++;
+    r->toSubmit++;
+    if (slot) *slot = idx;
+    return sqe;
+}
+
+static void uring_publish(UringRing* r) {
+    __atomic_store_n(r->sqTail, r->sqLocalTail, __ATOMIC_RELEASE);
+}
+
+int uring_prep_socket(UringRing* r, int family, int type, int protocol, unsigned long long userData) {
+    if (!uring_reserve(r, 1)) return 0;
+    struct io_uring_sqe* sqe = uring_next_sqe(r, NULL);
+    sqe->opcode = IORING_OP_SOCKET;
+    sqe->fd = family;
+    sqe->off = (unsigned long long)type;
+    sqe->len = (unsigned)protocol;
+    sqe->user_data = userData;
+    uring_publish(r);
+    return 1;
+}
+
+// connect 与链接超时作为一对提交：超时先到则 connect 以 -ECANCELED 完成
+int uring_prep_connect(UringRing* r, int fd, const struct sockaddr* addr, int addrLen, int timeoutMs,
+                       unsigned long long userData, unsigned long long timeoutUserData) {
+    if (addrLen > (int)sizeof(struct sockaddr_in6) || !uring_reserve(r, 2)) return 0;
+    unsigned slot;
+    struct io_uring_sqe* sqe = uring_next_sqe(r, &slot);
+    memcpy(&r->addrs[slot], addr, addrLen);
+    sqe->opcode = IORING_OP_CONNECT;
+    sqe->fd = fd;
+    sqe->addr = (unsigned long long)(uintptr_t)&r->addrs[slot];
+    sqe->off = (unsigned long long)addrLen;
+    sqe->flags = IOSQE_IO_LINK;
+    sqe->user_data = userData;
+
+    sqe = uring_next_sqe(r, &slot);
+    r->ts[slot].tv_sec = timeoutMs / 1000;
+    r->ts[slot].tv_nsec = (long long)(timeoutMs % 1000) * 1000000;
+    sqe->opcode = IORING_OP_LINK_TIMEOUT;
+    sqe->fd = -1;
+    sqe->addr = (unsigned long long)(uintptr_t)&r->ts[slot];
+    sqe->len = 1;
+    sqe->user_data = timeoutUserData;
+    uring_publish(r);
+    return 1;
+}
+
+// 关闭随下一次提交一并执行；成功时不产生完成事件 (内核支持时)
+int uring_prep_close(UringRing* r, int fd, unsigned long long userData) {
+    if (!uring_reserve(r, 1)) return 0;
+    struct io_uring_sqe* sqe = uring_next_sqe(r, NULL);
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->fd = fd;
+    if (r->features & IORING_FEAT_CQE_SKIP) sqe->flags = IOSQE_CQE_SKIP_SUCCESS;
+    sqe->user_data = userData;
+    uring_publish(r);
+    return 1;
+}
+
+int uring_submit(UringRing* r, int waitMs) {
+    unsigned ready = __atomic_load_n(r->cqTail, __ATOMIC_ACQUIRE) - *r->cqHead;
+    if (waitMs <= 0 || ready > 0) {
+        if (r->toSubmit == 0) return 0;
+        int ret = uring_enter(r->fd, r->toSubmit, 0, 0, NULL, 0);
+        if (ret > 0) r->toSubmit -= (unsigned)ret;
+        return ret;
+    }
+
+    struct __kernel_timespec ts;
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    ts.tv_sec = waitMs / 1000;
+    ts.tv_nsec = (long long)(waitMs % 1000) * 1000000;
+    arg.ts = (unsigned long long)(uintptr_t)&ts;
+    int ret = uring_enter(r->fd, r->toSubmit, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+    if (ret > 0) r->toSubmit -= (unsigned)ret;
+    // 等待超时或被信号打断都不算错误
+    if (ret == -ETIME || ret == -EINTR) ret = 0;
+    return ret;
+}
+
+int uring_next_cqe(UringRing* r, unsigned long long* userData, int* res) {
+    unsigned head = *r->cqHead;
+    if (head == __atomic_load_n(r->cqTail, __ATOMIC_ACQUIRE)) return 0;
+    const struct io_uring_cqe* cqe = &r->cqes[head & *r->cqMask];
+    *userData = cqe->user_data;
+    *res = cqe->res;
+    __atomic_store_n(r->cqHead, head + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+#endif